@@ -47,9 +47,9 @@ struct CliParameters {
     int window_width = 0;
     int window_height = 0;
 
-    QString pattern;
+    QString trace_file;
 
-    CliParameters( QCoreApplication& app, bool console = false )
+    explicit CliParameters( QCoreApplication& app )
     {
         QCommandLineParser parser;
         parser.setApplicationDescription( "Klogg log viewer" );
@@ -79,10 +79,6 @@ struct CliParameters {
                                                              << "follow",
                                                "follow initial opened files" );
 
-        const QCommandLineOption patternOption( QStringList() << "e"
-                                                              << "pattern",
-                                                "pattern to search for", "pattern" );
-
         const QCommandLineOption debugOption(
             QStringList() << "d"
                           << "debug",
@@ -90,22 +86,21 @@ struct CliParameters {
 
         parser.addOption( debugOption );
 
-        if ( !console ) {
-            const QCommandLineOption windowWidthOption( "window-width", "new window width",
-                                                        "1024" );
-            const QCommandLineOption windowHeightOption( "window-height", "new window height",
-                                                         "768" );
-            parser.addOption( multiInstanceOption );
-            parser.addOption( loadSessionOption );
-            parser.addOption( newSessionOption );
-            parser.addOption( logToFileOption );
-            parser.addOption( followOption );
-            parser.addOption( windowWidthOption );
-            parser.addOption( windowHeightOption );
-        }
-        else {
-            parser.addOption( patternOption );
-        }
+        const QCommandLineOption windowWidthOption( "window-width", "new window width",
+                                                    "1024" );
+        const QCommandLineOption windowHeightOption( "window-height", "new window height",
+                                                     "768" );
+        const QCommandLineOption traceOption(
+            "trace", "record a performance trace and save it to the file on exit", "file" );
+
+        parser.addOption( multiInstanceOption );
+        parser.addOption( loadSessionOption );
+        parser.addOption( newSessionOption );
+        parser.addOption( logToFileOption );
+        parser.addOption( followOption );
+        parser.addOption( windowWidthOption );
+        parser.addOption( windowHeightOption );
+        parser.addOption( traceOption );
 
         parser.process( app );
 
@@ -124,32 +119,28 @@ struct CliParameters {
 
         log_level += parser.value( debugOption ).toInt();
 
-        if ( !console ) {
-            if ( parser.isSet( multiInstanceOption ) ) {
-                multi_instance = true;
-            }
+        if ( parser.isSet( multiInstanceOption ) ) {
+            multi_instance = true;
+        }
 
-            if ( parser.isSet( loadSessionOption ) ) {
-                load_session = true;
-            }
+        if ( parser.isSet( loadSessionOption ) ) {
+            load_session = true;
+        }
 
-            if ( parser.isSet( newSessionOption ) ) {
-                new_session = true;
-            }
+        if ( parser.isSet( newSessionOption ) ) {
+            new_session = true;
+        }
 
-            if ( parser.isSet( logToFileOption ) ) {
-                log_to_file = true;
-            }
+        if ( parser.isSet( logToFileOption ) ) {
+            log_to_file = true;
+        }
 
-            if ( parser.isSet( followOption ) ) {
-                follow_file = true;
-            }
+        if ( parser.isSet( followOption ) ) {
+            follow_file = true;
         }
-        else {
 
-            if ( parser.isSet( patternOption ) ) {
-                pattern = parser.value( patternOption );
-            }
+        if ( parser.isSet( traceOption ) ) {
+            trace_file = QFileInfo( parser.value( traceOption ) ).absoluteFilePath();
         }
 
         for ( const auto& file : parser.positionalArguments() ) {
@@ -0,0 +1,695 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// klogg_grep searches files with the klogg search engine and prints the
+// selected lines as soon as they are found.
+// Each file is read by blocks of whole lines in its own job. Blocks are
+// split into lines, converted to utf8 and matched in a shared thread pool,
+// then written in order by the job that read them. The number of blocks
+// in flight is bounded for all files together, so memory doesn't depend
+// on the number of files or on how fast the output is consumed.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include <QFile>
+#include <QSemaphore>
+#include <QTextCodec>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include "atomicflag.h"
+#include "configuration.h"
+#include "containers.h"
+#include "encodingdetector.h"
+#include "log.h"
+#include "logdata.h"
+#include "regularexpression.h"
+#include "runnable_lambda.h"
+#include "synchronization.h"
+
+#include "grepcli.h"
+
+namespace {
+
+// Blocks in flight for each matching thread
+constexpr int ChunksPerThread = 2;
+
+// Returns the offset following the line feed with its '\n' byte at pos,
+// 0 if this byte is not part of a line feed (e.g. in utf16 text).
+std::size_t endOfLineFeed( std::string_view data, std::size_t pos,
+                           const EncodingParameters& encodingParams )
+{
+    const auto lineFeedWidth = static_cast<std::size_t>( encodingParams.lineFeedWidth );
+    const auto lineFeedIndex = static_cast<std::size_t>( encodingParams.lineFeedIndex );
+
+    if ( lineFeedWidth == 1 ) {
+        return pos + 1;
+    }
+
+    if ( pos < lineFeedIndex ) {
+        return 0;
+    }
+
+    // Blocks start at the beginning of a line, so characters are aligned on their width
+    const auto start = pos - lineFeedIndex;
+    if ( start % lineFeedWidth != 0 || start + lineFeedWidth > data.size() ) {
+        return 0;
+    }
+
+    for ( auto i = start; i < start + lineFeedWidth; ++i ) {
+        if ( i != pos && data[ i ] != '\0' ) {
+            return 0;
+        }
+    }
+
+    return start + lineFeedWidth;
+}
+
+// Returns the offset following the last line feed found at or after searchFrom,
+// 0 if there is none.
+std::size_t findEndOfLastLine( const klogg::vector<char>& block, std::size_t searchFrom,
+                               const EncodingParameters& encodingParams )
+{
+    const auto data = std::string_view( block.data(), block.size() );
+
+    auto nextLineFeed = data.rfind( '\n' );
+    while ( nextLineFeed != std::string_view::npos && nextLineFeed >= searchFrom ) {
+        const auto endOfLine = endOfLineFeed( data, nextLineFeed, encodingParams );
+        if ( endOfLine > 0 ) {
+            return endOfLine;
+        }
+        if ( nextLineFeed == 0 ) {
+            break;
+        }
+        nextLineFeed = data.rfind( '\n', nextLineFeed - 1 );
+    }
+
+    return 0;
+}
+
+klogg::vector<qint64> findEndsOfLines( const klogg::vector<char>& block,
+                                       const EncodingParameters& encodingParams )
+{
+    const auto data = std::string_view( block.data(), block.size() );
+
+    klogg::vector<qint64> endOfLines;
+    auto nextLineFeed = data.find( '\n' );
+    while ( nextLineFeed != std::string_view::npos ) {
+        const auto endOfLine = endOfLineFeed( data, nextLineFeed, encodingParams );
+        if ( endOfLine > 0 ) {
+            endOfLines.push_back( static_cast<qint64>( endOfLine ) );
+        }
+        nextLineFeed = data.find( '\n', nextLineFeed + 1 );
+    }
+
+    return endOfLines;
+}
+
+// Ends the last line of a file without a line feed, so all lines of a block look the same
+void appendLineFeed( klogg::vector<char>& block, const EncodingParameters& encodingParams )
+{
+    const auto lineFeedWidth = static_cast<std::size_t>( encodingParams.lineFeedWidth );
+    block.resize( ( block.size() + lineFeedWidth - 1 ) / lineFeedWidth * lineFeedWidth
+                      + lineFeedWidth,
+                  '\0' );
+    block[ block.size() - lineFeedWidth + static_cast<std::size_t>( encodingParams.lineFeedIndex ) ]
+        = '\n';
+}
+
+void appendJsonString( std::string& out, std::string_view text )
+{
+    out += '"';
+    for ( const auto c : text ) {
+        switch ( c ) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if ( static_cast<unsigned char>( c ) < 0x20 ) {
+                char escaped[ 8 ];
+                std::snprintf( escaped, sizeof( escaped ), "\\u%04x",
+                               static_cast<unsigned>( c ) );
+                out += escaped;
+            }
+            else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+// Pattern matchers are not thread-safe, each matching task takes one from the pool
+class MatcherPool {
+  public:
+    explicit MatcherPool( const RegularExpression& expression )
+        : expression_( expression )
+    {
+    }
+
+    std::unique_ptr<PatternMatcher> acquire()
+    {
+        ScopedLock lock( mutex_ );
+        if ( matchers_.empty() ) {
+            return expression_.createMatcher();
+        }
+
+        auto matcher = std::move( matchers_.back() );
+        matchers_.pop_back();
+        return matcher;
+    }
+
+    void release( std::unique_ptr<PatternMatcher> matcher )
+    {
+        ScopedLock lock( mutex_ );
+        matchers_.push_back( std::move( matcher ) );
+    }
+
+  private:
+    const RegularExpression& expression_;
+
+    Mutex mutex_;
+    klogg::vector<std::unique_ptr<PatternMatcher>> matchers_;
+};
+
+// State shared by the searches of all files
+struct GrepContext {
+    GrepContext( const GrepParameters& grepParameters, const RegularExpression& expression,
+                 const GrepResources& resources, std::ostream& outStream,
+                 std::ostream& errorStream )
+        : parameters( grepParameters )
+        , matchers( expression )
+        , chunkSlots( resources.threads * ChunksPerThread )
+        , blockSize( resources.blockSize )
+        , out( outStream )
+        , err( errorStream )
+    {
+        matchPool.setMaxThreadCount( resources.threads );
+    }
+
+    void write( const std::string& text )
+    {
+        if ( text.empty() ) {
+            return;
+        }
+
+        ScopedLock lock( outputMutex );
+        out.write( text.data(), static_cast<std::streamsize>( text.size() ) );
+        out.flush();
+    }
+
+    void writeError( const std::string& text )
+    {
+        ScopedLock lock( outputMutex );
+        out.flush();
+        err << "klogg_grep: " << text << std::endl;
+    }
+
+    const GrepParameters& parameters;
+
+    MatcherPool matchers;
+    QThreadPool matchPool;
+    QSemaphore chunkSlots;
+    const qint64 blockSize;
+
+    std::ostream& out;
+    std::ostream& err;
+
+    AtomicFlag stopRequested;
+    AtomicFlag hasSelectedLines;
+    AtomicFlag hasErrors;
+
+    Mutex outputMutex;
+};
+
+// A block of whole lines of a file
+struct Chunk {
+    LogData::RawLines lines;
+    klogg::vector<std::string_view> utf8Lines;
+    // Indexes of the lines selected, in increasing order
+    klogg::vector<std::size_t> selectedLines;
+
+    std::string_view rawLine( std::size_t index ) const
+    {
+        const auto begin = index == 0 ? 0 : lines.endOfLines[ index - 1 ];
+        return std::string_view( lines.buffer.data() + begin,
+                                 static_cast<std::size_t>( lines.endOfLines[ index ] - begin ) );
+    }
+
+    std::string_view utf8Line( std::size_t index ) const
+    {
+        return index < utf8Lines.size() ? utf8Lines[ index ] : std::string_view{};
+    }
+};
+
+using ChunkPtr = std::shared_ptr<Chunk>;
+
+ChunkPtr matchChunk( ChunkPtr chunk, MatcherPool& matchers )
+{
+    chunk->lines.endOfLines
+        = findEndsOfLines( chunk->lines.buffer, chunk->lines.textDecoder.encodingParams );
+    chunk->utf8Lines = chunk->lines.buildUtf8View();
+
+    auto matcher = matchers.acquire();
+    const auto nbLines = std::min( chunk->utf8Lines.size(), chunk->lines.endOfLines.size() );
+    for ( std::size_t index = 0; index < nbLines; ++index ) {
+        if ( matcher->hasMatch( chunk->utf8Lines[ index ] ) ) {
+            chunk->selectedLines.push_back( index );
+        }
+    }
+    matchers.release( std::move( matcher ) );
+
+    return chunk;
+}
+
+class FileSearch {
+  public:
+    FileSearch( GrepContext& context, const GrepInputFile& file, QTextCodec* forcedCodec )
+        : context_( context )
+        , parameters_( context.parameters )
+        , file_( file )
+        , codec_( forcedCodec )
+    {
+    }
+
+    void run()
+    {
+        QFile file( file_.path );
+        if ( !file.open( QIODevice::ReadOnly ) ) {
+            reportError( file.errorString() );
+            return;
+        }
+
+        readFile( file );
+
+        while ( !pendingChunks_.empty() ) {
+            writeFrontChunk();
+        }
+
+        if ( parameters_.countOnly && !parameters_.quiet ) {
+            writeCount();
+        }
+    }
+
+  private:
+    void readFile( QFile& file )
+    {
+        klogg::vector<char> block;
+        while ( !context_.stopRequested ) {
+            const auto previousSize = block.size();
+            block.resize( previousSize + static_cast<std::size_t>( context_.blockSize ) );
+
+            const auto bytesRead = file.read( block.data() + previousSize, context_.blockSize );
+            if ( bytesRead < 0 ) {
+                reportError( file.errorString() );
+                return;
+            }
+            block.resize( previousSize + static_cast<std::size_t>( bytesRead ) );
+
+            if ( codec_ == nullptr ) {
+                codec_ = EncodingDetector::getInstance().detectEncoding( block );
+                LOG_INFO << displayName_ << ": encoding " << codec_->name().toStdString();
+            }
+            const auto encodingParams = EncodingParameters( codec_ );
+
+            if ( bytesRead == 0 ) {
+                if ( !block.empty() ) {
+                    appendLineFeed( block, encodingParams );
+                    submitChunk( std::move( block ) );
+                }
+                return;
+            }
+
+            // A line feed may straddle the previous read
+            const auto lineFeedWidth = static_cast<std::size_t>( encodingParams.lineFeedWidth );
+            const auto searchFrom = previousSize > lineFeedWidth ? previousSize - lineFeedWidth : 0;
+            const auto endOfLastLine = findEndOfLastLine( block, searchFrom, encodingParams );
+            if ( endOfLastLine == 0 ) {
+                // The line is longer than a block, keep reading it
+                continue;
+            }
+
+            klogg::vector<char> nextBlock(
+                block.begin() + static_cast<std::ptrdiff_t>( endOfLastLine ), block.end() );
+            block.resize( endOfLastLine );
+            submitChunk( std::move( block ) );
+            block = std::move( nextBlock );
+        }
+    }
+
+    void submitChunk( klogg::vector<char>&& block )
+    {
+        acquireChunkSlot();
+
+        auto chunk = std::make_shared<Chunk>();
+        chunk->lines.buffer = std::move( block );
+        chunk->lines.textDecoder = TextDecoder{ std::make_unique<QTextDecoder>( codec_ ),
+                                                EncodingParameters( codec_ ) };
+
+        auto& matchers = context_.matchers;
+        pendingChunks_.push_back( QtConcurrent::run(
+            &context_.matchPool,
+            [ chunk, &matchers ] { return matchChunk( chunk, matchers ); } ) );
+
+        // Stream what is already matched
+        while ( !pendingChunks_.empty() && pendingChunks_.front().isFinished() ) {
+            writeFrontChunk();
+        }
+    }
+
+    // The slots are shared by all files: while waiting for one, the chunks
+    // of this file are written to free their slots, so that each file
+    // waiting holds no slot and the others can always progress.
+    void acquireChunkSlot()
+    {
+        while ( !context_.chunkSlots.tryAcquire() ) {
+            if ( pendingChunks_.empty() ) {
+                context_.chunkSlots.acquire();
+                return;
+            }
+            writeFrontChunk();
+        }
+    }
+
+    void writeFrontChunk()
+    {
+        auto future = std::move( pendingChunks_.front() );
+        pendingChunks_.pop_front();
+
+        const auto chunk = future.result();
+        if ( !context_.stopRequested ) {
+            writeChunk( *chunk );
+        }
+
+        context_.chunkSlots.release();
+    }
+
+    void writeChunk( const Chunk& chunk )
+    {
+        const auto nbLines = chunk.lines.endOfLines.size();
+        const auto firstLine = nextLineNumber_;
+        nextLineNumber_ += nbLines;
+
+        if ( chunk.selectedLines.empty() ) {
+            writeAfterContext( chunk, firstLine, 0, nbLines );
+            keepBeforeContext( chunk, firstLine );
+            flushOutput();
+            return;
+        }
+
+        context_.hasSelectedLines.set();
+        selectedCount_ += chunk.selectedLines.size();
+
+        if ( parameters_.quiet ) {
+            context_.stopRequested.set();
+            return;
+        }
+
+        if ( parameters_.countOnly ) {
+            return;
+        }
+
+        const auto beforeContext = static_cast<std::size_t>( parameters_.beforeContext );
+
+        std::size_t nextIndex = 0;
+        for ( const auto index : chunk.selectedLines ) {
+            nextIndex = writeAfterContext( chunk, firstLine, nextIndex, index );
+
+            if ( index < beforeContext ) {
+                const auto selectedLine = firstLine + index;
+                const auto firstContextLine
+                    = selectedLine > beforeContext ? selectedLine - beforeContext : 0;
+                for ( const auto& [ lineNumber, text ] : beforeContextLines_ ) {
+                    if ( lineNumber >= firstContextLine ) {
+                        appendLine( lineNumber, text, false );
+                    }
+                }
+            }
+
+            const auto firstContextIndex = index > beforeContext ? index - beforeContext : 0;
+            for ( auto contextIndex = std::max( firstContextIndex, nextIndex );
+                  contextIndex < index; ++contextIndex ) {
+                appendLine( firstLine + contextIndex, lineText( chunk, contextIndex ), false );
+            }
+
+            appendLine( firstLine + index, lineText( chunk, index ), true );
+            nextIndex = index + 1;
+            afterContextLeft_ = static_cast<std::size_t>( parameters_.afterContext );
+        }
+
+        writeAfterContext( chunk, firstLine, nextIndex, nbLines );
+        keepBeforeContext( chunk, firstLine );
+        flushOutput();
+    }
+
+    void flushOutput()
+    {
+        context_.write( out_ );
+        out_.clear();
+    }
+
+    // Writes the lines following the last selected line until endIndex,
+    // returns the index of the first line not written.
+    std::size_t writeAfterContext( const Chunk& chunk, uint64_t firstLine, std::size_t nextIndex,
+                                   std::size_t endIndex )
+    {
+        if ( parameters_.countOnly || parameters_.quiet ) {
+            return nextIndex;
+        }
+
+        while ( afterContextLeft_ > 0 && nextIndex < endIndex ) {
+            appendLine( firstLine + nextIndex, lineText( chunk, nextIndex ), false );
+            --afterContextLeft_;
+            ++nextIndex;
+        }
+
+        return nextIndex;
+    }
+
+    // Copies the last lines of the chunk, the before context of a selected
+    // line can start in a previous chunk.
+    void keepBeforeContext( const Chunk& chunk, uint64_t firstLine )
+    {
+        const auto beforeContext = static_cast<std::size_t>( parameters_.beforeContext );
+        if ( beforeContext == 0 || parameters_.countOnly || parameters_.quiet ) {
+            return;
+        }
+
+        const auto nbLines = chunk.lines.endOfLines.size();
+        for ( auto index = nbLines > beforeContext ? nbLines - beforeContext : 0; index < nbLines;
+              ++index ) {
+            beforeContextLines_.emplace_back( firstLine + index,
+                                              std::string( lineText( chunk, index ) ) );
+        }
+
+        while ( beforeContextLines_.size() > beforeContext ) {
+            beforeContextLines_.pop_front();
+        }
+    }
+
+    std::string_view lineText( const Chunk& chunk, std::size_t index ) const
+    {
+        return parameters_.rawBytes && !parameters_.jsonLines ? chunk.rawLine( index )
+                                                              : chunk.utf8Line( index );
+    }
+
+    void appendLine( uint64_t lineIndex, std::string_view text, bool isSelected )
+    {
+        if ( lastWrittenLine_ && lineIndex <= *lastWrittenLine_ ) {
+            return;
+        }
+
+        const auto hasContext = parameters_.beforeContext > 0 || parameters_.afterContext > 0;
+        const auto lineNumber = std::to_string( lineIndex + 1 );
+
+        if ( parameters_.jsonLines ) {
+            out_ += "{\"file\":";
+            appendJsonString( out_, file_.displayName.toStdString() );
+            out_ += ",\"line\":";
+            out_ += lineNumber;
+            out_ += isSelected ? ",\"type\":\"match\"" : ",\"type\":\"context\"";
+            out_ += ",\"text\":";
+            appendJsonString( out_, text );
+            out_ += "}\n";
+        }
+        else {
+            if ( hasContext && lastWrittenLine_ && lineIndex > *lastWrittenLine_ + 1 ) {
+                out_ += "--\n";
+            }
+
+            const auto separator = isSelected ? ':' : '-';
+            if ( parameters_.withFilename ) {
+                out_ += displayName_;
+                out_ += separator;
+            }
+            if ( parameters_.lineNumbers ) {
+                out_ += lineNumber;
+                out_ += separator;
+            }
+
+            out_ += text;
+            // Raw lines keep their own line feed
+            if ( !parameters_.rawBytes ) {
+                out_ += '\n';
+            }
+        }
+
+        lastWrittenLine_ = lineIndex;
+    }
+
+    void writeCount()
+    {
+        std::string out;
+        if ( parameters_.jsonLines ) {
+            out += "{\"file\":";
+            appendJsonString( out, displayName_ );
+            out += ",\"count\":" + std::to_string( selectedCount_ ) + "}\n";
+        }
+        else {
+            if ( parameters_.withFilename ) {
+                out += displayName_ + ":";
+            }
+            out += std::to_string( selectedCount_ ) + "\n";
+        }
+        context_.write( out );
+    }
+
+    void reportError( const QString& error )
+    {
+        context_.hasErrors.set();
+        context_.writeError( displayName_ + ": " + error.toStdString() );
+    }
+
+  private:
+    GrepContext& context_;
+    const GrepParameters& parameters_;
+    const GrepInputFile& file_;
+    const std::string displayName_ = file_.displayName.toStdString();
+
+    QTextCodec* codec_;
+
+    std::deque<QFuture<ChunkPtr>> pendingChunks_;
+
+    uint64_t nextLineNumber_ = 0;
+    uint64_t selectedCount_ = 0;
+
+    std::optional<uint64_t> lastWrittenLine_;
+    std::size_t afterContextLeft_ = 0;
+    std::deque<std::pair<uint64_t, std::string>> beforeContextLines_;
+
+    std::string out_;
+};
+
+RegularExpressionPattern makePattern( const GrepParameters& parameters )
+{
+    return RegularExpressionPattern( parameters.pattern, !parameters.ignoreCase,
+                                     parameters.invertMatch, parameters.booleanCombination,
+                                     parameters.fixedStrings );
+}
+
+} // namespace
+
+
+GrepResources grepResources( const GrepParameters& parameters )
+{
+    const auto& configuration = Configuration::get();
+
+    GrepResources resources;
+
+    resources.threads = parameters.threads;
+    if ( resources.threads == 0 ) {
+        resources.threads = configuration.searchThreadPoolSize();
+    }
+    if ( resources.threads == 0 ) {
+        resources.threads = QThread::idealThreadCount();
+    }
+    resources.threads = std::max( resources.threads, 1 );
+
+    resources.jobs = parameters.jobs > 0 ? parameters.jobs : resources.threads;
+
+    const auto bufferSizeMb = parameters.bufferSizeMb > 0 ? parameters.bufferSizeMb
+                                                          : configuration.indexReadBufferSizeMb();
+    resources.blockSize = static_cast<qint64>( std::max( bufferSizeMb, 1 ) ) * 1024 * 1024;
+
+    return resources;
+}
+
+int runGrep( const GrepParameters& parameters, const GrepResources& resources, std::ostream& out,
+             std::ostream& err )
+{
+    QTextCodec* forcedCodec = nullptr;
+    if ( !parameters.encoding.isEmpty() ) {
+        forcedCodec = QTextCodec::codecForName( parameters.encoding.toLatin1() );
+        if ( forcedCodec == nullptr ) {
+            err << "klogg_grep: unknown encoding " << parameters.encoding.toStdString() << "\n";
+            return GrepExitError;
+        }
+    }
+
+    const RegularExpression expression( makePattern( parameters ) );
+    if ( !expression.isValid() ) {
+        err << "klogg_grep: invalid pattern: " << expression.errorString().toStdString() << "\n";
+        return GrepExitError;
+    }
+
+    LOG_INFO << "Searching " << parameters.files.size() << " files, " << resources.threads
+             << " threads, " << resources.jobs << " jobs, blocks of " << resources.blockSize
+             << " bytes";
+
+    GrepContext context( parameters, expression, resources, out, err );
+
+    QThreadPool filesPool;
+    filesPool.setMaxThreadCount( std::min( resources.jobs, klogg::isize( parameters.files ) ) );
+    for ( const auto& file : parameters.files ) {
+        filesPool.start( createRunnable( [ &context, &file, forcedCodec ] {
+            FileSearch search( context, file, forcedCodec );
+            search.run();
+        } ) );
+    }
+    filesPool.waitForDone();
+
+    if ( context.hasSelectedLines && parameters.quiet ) {
+        return GrepExitSelected;
+    }
+    if ( context.hasErrors ) {
+        return GrepExitError;
+    }
+    return context.hasSelectedLines ? GrepExitSelected : GrepExitNotSelected;
+}
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_GREPCLI_H
+#define KLOGG_GREPCLI_H
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QString>
+
+#include "cli.h"
+
+// A file to search, with the name it is reported under
+struct GrepInputFile {
+    QString path;
+    QString displayName;
+};
+
+// Exit status of klogg_grep, the same as grep's
+constexpr int GrepExitSelected = 0;
+constexpr int GrepExitNotSelected = 1;
+constexpr int GrepExitError = 2;
+
+struct GrepParameters {
+    static constexpr int UsageError = GrepExitError;
+
+    QString pattern;
+    bool ignoreCase = false;
+    bool invertMatch = false;
+    bool fixedStrings = false;
+    bool booleanCombination = false;
+
+    bool countOnly = false;
+    bool lineNumbers = false;
+    bool withFilename = false;
+    bool quiet = false;
+    bool jsonLines = false;
+    bool rawBytes = false;
+    int beforeContext = 0;
+    int afterContext = 0;
+
+    // 0 means use the defaults of the configuration
+    int threads = 0;
+    int jobs = 0;
+    int bufferSizeMb = 0;
+    QString engine;
+    QString encoding;
+
+    bool enable_logging = false;
+    int log_level = 3;
+
+    std::vector<GrepInputFile> files;
+
+    GrepParameters() = default;
+
+    explicit GrepParameters( QCoreApplication& app )
+    {
+        if ( const auto error = parse( app.arguments() ) ) {
+            usageError( *error );
+        }
+    }
+
+    // Reads the options from the command line arguments (the first one being
+    // the program), returns the error message of invalid arguments.
+    // Exits after printing the help or the version if they are asked for.
+    std::optional<QString> parse( const QStringList& arguments )
+    {
+        QCommandLineParser parser;
+        parser.setApplicationDescription(
+            "Search files for lines matching a pattern with the klogg search engine.\n"
+            "Matches are printed as they are found, without indexing the files first.\n"
+            "Files are searched in parallel, the output of different files can be\n"
+            "interleaved by blocks of lines.\n"
+            "Exit status is 0 if a line is selected, 1 if no line is selected\n"
+            "and 2 if an error occurred." );
+        // -v is taken by --invert-match, so --version has no short name
+        const auto helpOption = parser.addHelpOption();
+        const QCommandLineOption versionOption( "version", "display version information" );
+
+        const QCommandLineOption patternOption( QStringList() << "e"
+                                                              << "regexp"
+                                                              << "pattern",
+                                                "pattern to search for", "pattern" );
+        const QCommandLineOption ignoreCaseOption( QStringList() << "i"
+                                                                 << "ignore-case",
+                                                   "ignore case distinctions" );
+        const QCommandLineOption invertOption( QStringList() << "v"
+                                                             << "invert-match",
+                                               "select non-matching lines" );
+        const QCommandLineOption fixedStringsOption( QStringList() << "F"
+                                                                   << "fixed-strings",
+                                                     "pattern is a plain string" );
+        const QCommandLineOption booleanOption(
+            "boolean", "pattern is a boolean combination of quoted patterns, e.g. "
+                       "'\"error\" and not \"timeout\"'" );
+
+        const QCommandLineOption countOption( QStringList() << "c"
+                                                            << "count",
+                                              "print only the number of selected lines per file" );
+        const QCommandLineOption lineNumberOption( QStringList() << "n"
+                                                                 << "line-number",
+                                                   "print line numbers" );
+        const QCommandLineOption withFilenameOption(
+            QStringList() << "H"
+                          << "with-filename",
+            "print the file name for each line (default with several files)" );
+        const QCommandLineOption noFilenameOption( "no-filename", "never print file names" );
+        const QCommandLineOption quietOption( QStringList() << "q"
+                                                            << "quiet",
+                                              "print nothing, stop at the first selected line" );
+        const QCommandLineOption jsonOption( "json", "print one JSON object per line" );
+        const QCommandLineOption rawOption(
+            "raw", "print the bytes of the lines as they are in the file instead of utf8" );
+        const QCommandLineOption afterContextOption( QStringList() << "A"
+                                                                   << "after-context",
+                                                     "print lines after each match", "num" );
+        const QCommandLineOption beforeContextOption( QStringList() << "B"
+                                                                    << "before-context",
+                                                      "print lines before each match", "num" );
+        const QCommandLineOption contextOption( QStringList() << "C"
+                                                              << "context",
+                                                "print lines around each match", "num" );
+
+        const QCommandLineOption threadsOption( QStringList() << "t"
+                                                              << "threads",
+                                                "number of threads matching lines", "num" );
+        const QCommandLineOption jobsOption( QStringList() << "j"
+                                                           << "jobs",
+                                             "number of files searched at once", "num" );
+        const QCommandLineOption engineOption( "engine", "regular expression engine",
+                                               "hyperscan|qt" );
+        const QCommandLineOption bufferSizeOption( "buffer-size",
+                                                   "size of the blocks read from files", "MiB" );
+        const QCommandLineOption encodingOption(
+            "encoding", "encoding of the files (detected by default)", "name" );
+
+        const QCommandLineOption debugOption(
+            QStringList() << "d"
+                          << "debug",
+            "output more debug (increase number for more verbosity)", "debug_level", "0" );
+
+        parser.addOptions( { versionOption, patternOption, ignoreCaseOption, invertOption,
+                             fixedStringsOption, booleanOption, countOption, lineNumberOption,
+                             withFilenameOption, noFilenameOption, quietOption, jsonOption,
+                             rawOption, afterContextOption, beforeContextOption, contextOption,
+                             threadsOption, jobsOption, engineOption, bufferSizeOption,
+                             encodingOption, debugOption } );
+        parser.addPositionalArgument( "pattern", "pattern to search for, unless -e is used" );
+        parser.addPositionalArgument( "files", "files or wildcards to search", "files..." );
+
+        if ( !parser.parse( arguments ) ) {
+            return parser.errorText();
+        }
+
+        if ( parser.isSet( helpOption ) ) {
+            parser.showHelp( EXIT_SUCCESS );
+        }
+
+        if ( parser.isSet( versionOption ) ) {
+            CliParameters::print_version();
+            exit( EXIT_SUCCESS );
+        }
+
+        const auto debugLevel = parser.value( debugOption ).toInt();
+        enable_logging = debugLevel > 0;
+        log_level += debugLevel;
+
+        ignoreCase = parser.isSet( ignoreCaseOption );
+        invertMatch = parser.isSet( invertOption );
+        fixedStrings = parser.isSet( fixedStringsOption );
+        booleanCombination = parser.isSet( booleanOption );
+
+        countOnly = parser.isSet( countOption );
+        lineNumbers = parser.isSet( lineNumberOption );
+        quiet = parser.isSet( quietOption );
+        jsonLines = parser.isSet( jsonOption );
+        rawBytes = parser.isSet( rawOption );
+
+        std::optional<QString> error;
+        const auto readInt = [ &parser, &error ]( const QCommandLineOption& option, int& value ) {
+            if ( error || !parser.isSet( option ) ) {
+                return;
+            }
+
+            bool isValid = false;
+            const auto optionValue = parser.value( option ).toInt( &isValid );
+            if ( !isValid || optionValue < 0 ) {
+                error = QString( "invalid value '%1' for --%2" )
+                            .arg( parser.value( option ), option.names().last() );
+                return;
+            }
+            value = optionValue;
+        };
+
+        readInt( contextOption, beforeContext );
+        readInt( contextOption, afterContext );
+        readInt( beforeContextOption, beforeContext );
+        readInt( afterContextOption, afterContext );
+
+        readInt( threadsOption, threads );
+        readInt( jobsOption, jobs );
+        readInt( bufferSizeOption, bufferSizeMb );
+
+        if ( error ) {
+            return error;
+        }
+
+        engine = parser.value( engineOption ).toLower();
+        if ( !engine.isEmpty() && engine != "hyperscan" && engine != "qt" ) {
+            return QString( "unknown engine '%1'" ).arg( engine );
+        }
+        encoding = parser.value( encodingOption );
+
+        auto positionalArguments = parser.positionalArguments();
+        if ( parser.isSet( patternOption ) ) {
+            pattern = parser.value( patternOption );
+        }
+        else if ( !positionalArguments.isEmpty() ) {
+            pattern = positionalArguments.takeFirst();
+        }
+        else {
+            return QString( "no pattern" );
+        }
+
+        for ( const auto& argument : positionalArguments ) {
+            addFiles( argument );
+        }
+
+        if ( files.empty() ) {
+            return QString( "no file to search" );
+        }
+
+        withFilename = ( files.size() > 1 || parser.isSet( withFilenameOption ) )
+                       && !parser.isSet( noFilenameOption );
+
+        return {};
+    }
+
+  private:
+    [[noreturn]] static void usageError( const QString& message )
+    {
+        std::cerr << "klogg_grep: " << message.toStdString() << "\n";
+        std::cerr << "Try 'klogg_grep --help' for more information.\n";
+        exit( UsageError );
+    }
+
+    // Wildcards are expanded here for shells that don't do it,
+    // a wildcard matching nothing is kept to be reported as a missing file.
+    void addFiles( const QString& argument )
+    {
+        const auto fileInfo = QFileInfo( argument );
+        const auto hasWildcard = argument.contains( QRegularExpression( "[*?\\[]" ) );
+        if ( fileInfo.exists() || !hasWildcard ) {
+            files.push_back( { fileInfo.absoluteFilePath(), argument } );
+            return;
+        }
+
+        const auto normalizedArgument = QDir::fromNativeSeparators( argument );
+        const auto directoryPrefix
+            = normalizedArgument.left( normalizedArgument.lastIndexOf( '/' ) + 1 );
+
+        const auto matchingFiles
+            = QDir( fileInfo.path() )
+                  .entryInfoList( QStringList() << fileInfo.fileName(), QDir::Files, QDir::Name );
+        if ( matchingFiles.isEmpty() ) {
+            files.push_back( { fileInfo.absoluteFilePath(), argument } );
+            return;
+        }
+
+        for ( const auto& matchingFile : matchingFiles ) {
+            files.push_back(
+                { matchingFile.absoluteFilePath(), directoryPrefix + matchingFile.fileName() } );
+        }
+    }
+};
+
+// What a search of the files can use
+struct GrepResources {
+    // Threads matching the lines
+    int threads = 1;
+    // Files searched at once
+    int jobs = 1;
+    // Size in bytes of the blocks read from the files
+    qint64 blockSize = 1024 * 1024;
+};
+
+// The resources asked for in the parameters, the configuration gives the others.
+GrepResources grepResources( const GrepParameters& parameters );
+
+// Searches the files of the parameters. Selected lines are written to out as
+// soon as they are found, errors are written to err. Returns the exit status.
+int runGrep( const GrepParameters& parameters, const GrepResources& resources, std::ostream& out,
+             std::ostream& err );
+
+#endif
@@ -17,16 +17,25 @@
  * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// klogg_grep searches files with the klogg search engine and prints the
+// selected lines as soon as they are found, see grepcli.h.
+
 #include <mimalloc.h>
 
+#include <iostream>
+
+#include <QCoreApplication>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 #include "configuration.h"
-#include "logdata.h"
-#include "logfiltereddata.h"
-#include "dispatch_to.h"
 #include "logger.h"
 #include "persistentinfo.h"
 
-#include "cli.h"
+#include "grepcli.h"
 
 const bool PersistentInfo::ForcePortable = true;
 
@@ -35,46 +44,24 @@ int main( int argc, char* argv[] )
 #ifdef KLOGG_USE_MIMALLOC
     mi_stats_reset();
 #endif
-    qRegisterMetaType<LinesCount>( "LinesCount" );
-    qRegisterMetaType<LineNumber>( "LineNumber" );
 
     QCoreApplication app( argc, argv );
-    CliParameters parameters( app, true );
-
-    logging::enableLogging( true, static_cast<logging::LogLevel>( parameters.log_level ) );
+    const GrepParameters parameters( app );
 
-    auto configuration = Configuration::getSynced();
+    logging::enableLogging( parameters.enable_logging,
+                            static_cast<logging::LogLevel>( parameters.log_level ) );
 
-    LogData logData;
-    auto filteredData = logData.getNewFilteredData();
+    auto& configuration = Configuration::getSynced();
+    if ( parameters.engine == "qt" ) {
+        configuration.setRegexpEnging( RegexpEngine::QRegularExpression );
+    }
+    else if ( parameters.engine == "hyperscan" ) {
+        configuration.setRegexpEnging( RegexpEngine::Hyperscan );
+    }
 
-    filteredData->connect(
-        filteredData.get(), &LogFilteredData::searchProgressed,
-        [ & ]( LinesCount nbMatches, int progress, LineNumber ) {
-            if ( progress == 100 ) {
-
-                LOG_INFO << "Searched finished, got " << nbMatches.get() << " matches";
-
-                const auto defaultChunkSize = 1000_lcount;
-                for ( auto chunkStart = 0_lnum; chunkStart < nbMatches;
-                      chunkStart = chunkStart + defaultChunkSize ) {
-                    auto chunkSize
-                        = std::min( defaultChunkSize.get(), nbMatches.get() - chunkStart.get() );
-                    auto lines = filteredData->getLines( chunkStart, LinesCount( chunkSize ) );
-                    for ( const auto& l : lines ) {
-                        std::cout << l.toStdString() << "\n";
-                    }
-                }
-
-                exit( EXIT_SUCCESS );
-            }
-        } );
-
-    logData.connect( &logData, &LogData::loadingFinished, [ & ]() {
-        dispatchToMainThread(
-            [ & ] { filteredData->runSearch( RegularExpressionPattern( parameters.pattern ) ); } );
-    } );
+#ifdef Q_OS_WIN
+    _setmode( _fileno( stdout ), _O_BINARY );
+#endif
 
-    logData.attachFile( parameters.filenames.front() );
-    return app.exec();
-}
\ No newline at end of file
+    return runGrep( parameters, grepResources( parameters ), std::cout, std::cerr );
+}
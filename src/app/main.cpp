@@ -62,6 +62,7 @@
 
 #include "cli.h"
 #include "kloggapp.h"
+#include "tracing.h"
 
 #ifdef KLOGG_PORTABLE
 const bool PersistentInfo::ForcePortable = true;
@@ -135,6 +136,10 @@ int main( int argc, char* argv[] )
 
     app.initCrashHandler();
 
+    if ( !parameters.trace_file.isEmpty() ) {
+        tracing::setEnabled( true );
+    }
+
     auto maxConcurrency
         = tbb::global_control::active_value( tbb::global_control::max_allowed_parallelism );
 
@@ -200,5 +205,14 @@ int main( int argc, char* argv[] )
         app.startBackgroundTasks();
     }
 
-    return app.exec();
+    const auto exitCode = app.exec();
+
+    if ( !parameters.trace_file.isEmpty() ) {
+        tracing::setEnabled( false );
+        if ( !tracing::writeChromeTrace( parameters.trace_file ) ) {
+            LOG_ERROR << "Failed to write trace to " << parameters.trace_file;
+        }
+    }
+
+    return exitCode;
 }
@@ -23,6 +23,7 @@
 #include "dispatch_to.h"
 #include "log.h"
 #include "synchronization.h"
+#include "tracing.h"
 
 #include <KDSignalThrottler.h>
 #include <efsw/efsw.hpp>
@@ -200,6 +201,8 @@ class EfswFileWatcher final : public efsw::FileWatchListener {
 
     void checkWatches()
     {
+        KLOGG_TRACE_SCOPE( "FileWatcher::checkWatches" );
+
         const auto collectChangedFiles = [ this ]() {
             ScopedRecursiveLock lock( mutex_ );
 
@@ -243,6 +246,8 @@ class EfswFileWatcher final : public efsw::FileWatchListener {
         Q_UNUSED( watchid );
         Q_UNUSED( action );
 
+        KLOGG_TRACE_SCOPE( "FileWatcher::handleFileAction" );
+
         LOG_DEBUG << "Notification from esfw for " << dir;
 
         // post to other thread to avoid deadlock between internal esfw lock and our mutex_
@@ -253,6 +258,8 @@ class EfswFileWatcher final : public efsw::FileWatchListener {
     void notifyOnFileAction( const std::string& dir, const std::string& filename,
                              const std::string& oldFilename )
     {
+        KLOGG_TRACE_SCOPE( "FileWatcher::notifyOnFileAction" );
+
         auto qtDir = QString::fromStdString( dir );
         if ( qtDir.endsWith( QDir::separator() ) ) {
             qtDir.chop( 1 );
@@ -364,6 +371,8 @@ void FileWatcher::removeFile( const QString& fileName )
 
 void FileWatcher::fileChangedOnDisk( const QString& fileName )
 {
+    KLOGG_TRACE_SCOPE( "FileWatcher::fileChangedOnDisk" );
+
     if ( std::find( changes_.begin(), changes_.end(), fileName ) == changes_.end() ) {
         changes_.push_back( fileName );
     }
@@ -373,6 +382,8 @@ void FileWatcher::fileChangedOnDisk( const QString& fileName )
 
 void FileWatcher::sendChangesNotifications()
 {
+    KLOGG_TRACE_SCOPE( "FileWatcher::sendChangesNotifications" );
+
     for ( const auto& fileName : changes_ ) {
         Q_EMIT fileChanged( fileName );
     }
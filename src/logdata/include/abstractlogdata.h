@@ -39,6 +39,8 @@
 #ifndef ABSTRACTLOGDATA_H
 #define ABSTRACTLOGDATA_H
 
+#include <optional>
+
 #include <QObject>
 #include <QString>
 #include <QStringList>
@@ -52,6 +54,12 @@ class AbstractLogData : public QObject {
     Q_OBJECT
 
   public:
+    // Range of bytes of a file, from begin to past the end
+    struct ByteRange {
+        qint64 begin;
+        qint64 end;
+    };
+
     // Returns the line passed as a QString
     QString getLineString( LineNumber line ) const;
     // Returns the line passed as a QString, with tabs expanded
@@ -70,6 +78,20 @@ class AbstractLogData : public QObject {
     // Returns the visible length of the passed line
     // Tabs are expanded
     LineLength getLineLength( LineNumber line ) const;
+    // Returns whether the line is too long to be read at once,
+    // it should then be read by windows of columns
+    bool isLongLine( LineNumber line ) const;
+    // Returns nbColumns columns of the line starting at firstColumn
+    // Tabs are expanded
+    QString getExpandedLineWindow( LineNumber line, LineColumn firstColumn,
+                                   LineLength nbColumns ) const;
+    // Returns the bytes of the file holding a set of lines, line endings
+    // included, adjacent lines being merged in a single range.
+    // Returns nothing if the lines can't be copied as they are from the file.
+    std::optional<klogg::vector<ByteRange>> getLinesByteRanges( LineNumber first_line,
+                                                                LinesCount number ) const;
+    // Returns the path of the file holding the lines
+    QString getFileName() const;
 
     // Set the view to use the passed encoding for display
     void setDisplayEncoding( const char* encoding_name );
@@ -110,6 +132,16 @@ class AbstractLogData : public QObject {
     virtual LineLength doGetMaxLength() const = 0;
     // Internal function called to get the line length
     virtual LineLength doGetLineLength( LineNumber line ) const = 0;
+    // Internal function called to know if a line is to be read by windows
+    virtual bool doIsLongLine( LineNumber line ) const = 0;
+    // Internal function called to get a window of columns of a line
+    virtual QString doGetExpandedLineWindow( LineNumber line, LineColumn firstColumn,
+                                             LineLength nbColumns ) const = 0;
+    // Internal function called to get the bytes of a set of lines
+    virtual std::optional<klogg::vector<ByteRange>>
+    doGetLinesByteRanges( LineNumber first_line, LinesCount number ) const = 0;
+    // Internal function called to get the path of the file
+    virtual QString doGetFileName() const = 0;
     // Internal function called to set the encoding
     virtual void doSetDisplayEncoding( const char* encoding ) = 0;
     virtual QTextCodec* doGetDisplayEncoding() const = 0;
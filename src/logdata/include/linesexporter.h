@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_LINESEXPORTER_H
+#define KLOGG_LINESEXPORTER_H
+
+#include <functional>
+
+#include <QFile>
+#include <QFileDevice>
+#include <QString>
+
+#include "abstractlogdata.h"
+#include "atomicflag.h"
+#include "containers.h"
+#include "linetypes.h"
+#include "logfiltereddataworker.h"
+
+class LogData;
+
+// Copies lines of a log data to another file without decoding them: the
+// bytes of the lines, line endings included, are written as they are in
+// the source file. Contiguous lines are copied by the kernel when possible,
+// scattered lines are read by blocks and written with vectored writes.
+// The lines of the file to copy are taken when the exporter is created, it
+// can then run on a worker thread while the log data keeps changing (e.g.
+// the matches of a search still running). Their bytes are found chunk by
+// chunk while exporting. The log data must outlive the exporter.
+class LinesExporter {
+  public:
+    // percent being the percentage of the lines exported
+    using ProgressCallback = std::function<void( int percent )>;
+
+    enum class Result {
+        Done,
+        Interrupted,
+        Failed,
+        // The lines can't be copied as they are (e.g. a prefilter is set)
+        Unsupported,
+    };
+
+    LinesExporter( const AbstractLogData& logData, LineNumber firstLine, LinesCount nbLines );
+
+    // Returns whether the lines can be copied as they are
+    bool isSupported() const;
+
+    // Writes the lines to the destination, which must be open for writing,
+    // at its current position.
+    Result exportTo( QFileDevice& destination, const AtomicFlag& interruptRequest,
+                     const ProgressCallback& progressCallback ) const;
+
+  private:
+    QString fileName_;
+    // Null if the lines can't be copied as they are
+    const LogData* sourceLogData_ = nullptr;
+    SearchResultArray lines_;
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_LINESHISTOGRAM_H
+#define KLOGG_LINESHISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "containers.h"
+#include "linetypes.h"
+#include "logfiltereddataworker.h"
+
+// Counts the lines of a set (e.g. the matches of a search) falling in each
+// bucket of consecutive lines of a file, so the distribution of the set can
+// be drawn without walking it.
+// There is a fixed number of buckets, all of the same size. The size is a
+// power of two, which doubles each time a line past the last bucket is
+// added, pairs of buckets being merged.
+// This class is not thread-safe.
+class LinesHistogram {
+  public:
+    static constexpr std::size_t NbBuckets = 64 * 1024;
+
+    void add( LineNumber line );
+    void add( const SearchResultArray& lines );
+    // The lines removed must have been added before
+    void remove( LineNumber line );
+    void remove( const SearchResultArray& lines );
+    void clear();
+
+    // Rebuilds the histogram from scratch
+    void assign( const SearchResultArray& lines );
+
+    // Returns the number of lines in each of nbBins bins of equal size
+    // splitting the nbLines first lines of the file, in O(NbBuckets).
+    klogg::vector<uint64_t> rescale( LinesCount nbLines, std::size_t nbBins ) const;
+
+    // Number of lines of the file in each bucket
+    LinesCount bucketSize() const
+    {
+        return LinesCount( LinesCount::UnderlyingType{ 1 } << bucketShift_ );
+    }
+
+    uint64_t totalCount() const
+    {
+        return totalCount_;
+    }
+
+  private:
+    // Grows the buckets until the line falls in one of them,
+    // returns the index of its bucket.
+    std::size_t bucketOf( uint64_t line );
+
+  private:
+    unsigned bucketShift_ = 0;
+    uint64_t totalCount_ = 0;
+    // Allocated on first add
+    klogg::vector<uint64_t> counts_;
+};
+
+#endif
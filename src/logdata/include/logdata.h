@@ -39,7 +39,11 @@
 #ifndef LOGDATA_H
 #define LOGDATA_H
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <utility>
 
 #include <QDateTime>
 #include <QFile>
@@ -57,8 +61,11 @@
 #include "loadingstatus.h"
 #include "logdataoperation.h"
 #include "logdataworker.h"
+#include "lrucache.h"
 
 class LogFilteredData;
+class SearchResultsCache;
+class SearchScanCoordinator;
 
 // Thrown when trying to attach an already attached LogData
 class CantReattachErr {
@@ -91,8 +98,14 @@ class LogData : public AbstractLogData {
     // Creates a new filtered data.
     // ownership is passed to the caller
     std::unique_ptr<LogFilteredData> getNewFilteredData() const;
+    // Creates a new filtered data searching only the matches of the parent.
+    // ownership is passed to the caller
+    std::unique_ptr<LogFilteredData>
+    getNewNestedFilteredData( std::shared_ptr<LogFilteredData> parentData ) const;
     // Returns the size if the file in bytes
     qint64 getFileSize() const;
+    // Returns the memory used by the index of the lines, in bytes
+    size_t getIndexAllocatedSize() const;
     // Returns the last modification date for the file.
     // Null if the file is not on disk.
     QDateTime getLastModifiedDate() const;
@@ -116,6 +129,8 @@ class LogData : public AbstractLogData {
 
       public:
         klogg::vector<QString> decodeLines() const;
+        // Decodes only the line at index (relative to startLine)
+        QString decodeLine( size_t index ) const;
         klogg::vector<std::string_view> buildUtf8View() const;
 
       private:
@@ -124,6 +139,32 @@ class LogData : public AbstractLogData {
 
     RawLines getLinesRaw( LineNumber first, LinesCount number ) const;
 
+    // Returns the lines passed, which must be sorted in increasing order.
+    // Nearby lines are read from the file together, so a few large reads
+    // are done instead of one per line.
+    klogg::vector<QString> getScatteredLines( const klogg::vector<LineNumber>& lines ) const;
+    klogg::vector<QString>
+    getScatteredExpandedLines( const klogg::vector<LineNumber>& lines ) const;
+    // Returns the greatest length of the lines passed, which must be sorted
+    // in increasing order, read together like getScatteredLines.
+    LineLength getScatteredLinesMaxLength( const klogg::vector<LineNumber>& lines ) const;
+    // Returns the bytes of the lines passed, which must be sorted in increasing order.
+    std::optional<klogg::vector<ByteRange>>
+    getScatteredLinesByteRanges( const klogg::vector<LineNumber>& lines ) const;
+
+    // Returns the object sharing file reads between
+    // all searches running on this LogData.
+    SearchScanCoordinator& searchScanCoordinator() const;
+
+    // Returns the search results cached for this file,
+    // shared by all its filtered data.
+    SearchResultsCache& searchResultsCache() const;
+
+    // Returns a number changed each time the text of the lines already
+    // read may have changed (reload, truncation, encoding or prefilter),
+    // but not when lines are appended.
+    uint64_t getContentGeneration() const;
+
   Q_SIGNALS:
     // Sent during the 'attach' process to signal progress
     // percent being the percentage of completion.
@@ -152,6 +193,12 @@ class LogData : public AbstractLogData {
     LinesCount doGetNbLine() const override;
     LineLength doGetMaxLength() const override;
     LineLength doGetLineLength( LineNumber line ) const override;
+    bool doIsLongLine( LineNumber line ) const override;
+    QString doGetExpandedLineWindow( LineNumber line, LineColumn firstColumn,
+                                     LineLength nbColumns ) const override;
+    std::optional<klogg::vector<ByteRange>>
+    doGetLinesByteRanges( LineNumber first, LinesCount number ) const override;
+    QString doGetFileName() const override;
     void doSetDisplayEncoding( const char* encoding ) override;
     QTextCodec* doGetDisplayEncoding() const override;
     void doAttachReader() const override;
@@ -161,6 +208,30 @@ class LogData : public AbstractLogData {
 
     klogg::vector<QString> getLinesFromFile( LineNumber first, LinesCount number,
                                            QString ( *processLine )( QString&& ) ) const;
+    klogg::vector<QString> getScatteredLinesFromFile( const klogg::vector<LineNumber>& lines,
+                                                      QString ( *processLine )( QString&& ) ) const;
+
+    // A point of a long line where decoding can start,
+    // the byte offset is relative to the start of the line.
+    struct LongLineCheckpoint {
+        qint64 byteOffset;
+        LineColumn column;
+    };
+
+    // Checkpoints spread along a long line, the last one is at its end
+    struct LongLineIndex {
+        LineNumber line;
+        klogg::vector<LongLineCheckpoint> checkpoints;
+    };
+
+    // Offsets of the first byte and past the last byte of the line, without line feed
+    std::optional<std::pair<qint64, qint64>> getLineByteRange( LineNumber line ) const;
+    klogg::vector<char> readBytes( qint64 offset, qint64 size ) const;
+
+    // Returns the checkpoints of a long line, built on first access
+    std::shared_ptr<const LongLineIndex> getLongLineIndex( LineNumber line ) const;
+    std::shared_ptr<const LongLineIndex> buildLongLineIndex( LineNumber line ) const;
+    void clearLongLineIndexes();
 
   private:
     mutable std::unique_ptr<FileHolder> attached_file_;
@@ -183,6 +254,16 @@ class LogData : public AbstractLogData {
     MonitoredFileStatus fileChangedOnDisk_;
 
     QString prefilterPattern_;
+
+    std::atomic<uint64_t> contentGeneration_{ 0 };
+
+    std::unique_ptr<SearchScanCoordinator> searchScanCoordinator_;
+    std::unique_ptr<SearchResultsCache> searchResultsCache_;
+
+    // Indexes of the long lines accessed recently
+    mutable Mutex longLinesMutex_;
+    mutable LruCache<LineNumber::UnderlyingType, std::shared_ptr<const LongLineIndex>>
+        longLineIndexes_;
 };
 
 #endif
@@ -279,6 +279,12 @@ public:
     // and false if it has been cancelled (results not copied)
     virtual OperationResult run() = 0;
 
+    // Finds the ends of the lines of a block starting at blockBeginning in the file
+    // and updates the state with the line being parsed when the block ends.
+    static FastLinePositionArray parseDataBlock( OffsetInFile::UnderlyingType blockBeginning,
+                                                 const klogg::vector<char>& block,
+                                                 IndexingState& state );
+
 Q_SIGNALS:
     void indexingProgressed( int );
     void indexingFinished( bool );
@@ -298,9 +304,6 @@ protected:
     AtomicFlag& interruptRequest_;
 
 private:
-    FastLinePositionArray parseDataBlock( OffsetInFile::UnderlyingType blockBegining,
-                                          const BlockBuffer& block, IndexingState& state ) const;
-
     void guessEncoding( const BlockBuffer& block, IndexingData::MutateAccessor& scopedAccessor,
                         IndexingState& state ) const;
 
@@ -43,7 +43,6 @@
 #include <functional>
 #include <memory>
 #include <tuple>
-#include <unordered_map>
 
 #include <QByteArray>
 #include <QList>
@@ -54,8 +53,10 @@
 
 #include "abstractlogdata.h"
 #include "hsregularexpression.h"
+#include "lineshistogram.h"
 #include "linetypes.h"
 #include "logfiltereddataworker.h"
+#include "searchresultscursor.h"
 #include "synchronization.h"
 
 class LogData;
@@ -66,23 +67,29 @@ class QTimer;
 // the original line number where they were found.
 // Constructing such objet does not start the search.
 // This object should be constructed by a LogData.
+// A nested LogFilteredData only searches the lines matched by its parent
+// and follows the parent when its matches change.
 class LogFilteredData : public AbstractLogData {
     Q_OBJECT
 
   public:
     // Constructor used by LogData
-    explicit LogFilteredData( const LogData* logData );
+    explicit LogFilteredData( const LogData* logData,
+                              std::shared_ptr<LogFilteredData> parentData = {} );
 
     // Starts the async search, sending newDataAvailable() when new data found.
     // If a search is already in progress this function will block until
     // it is done, so the application should call interruptSearch() first.
+    // If a priority line is passed (e.g. the line on screen), lines around it
+    // are searched first so nearby matches are shown early.
     void runSearch( const RegularExpressionPattern& regExp, LineNumber startLine,
-                    LineNumber endLine );
+                    LineNumber endLine, OptionalLineNumber priorityLine = {} );
     // Shortcut for runSearch on all file
     void runSearch( const RegularExpressionPattern& regExp );
 
     // Add to the existing search, starting at the line when the search was
     // last stopped. Used when the file on disk has been added too.
+    // A nested search forwards the update to its parent.
     void updateSearch( LineNumber startLine, LineNumber endLine );
     // Interrupt the running search if one is in progress.
     // Nothing is done if no search is in progress.
@@ -96,6 +103,9 @@ class LogFilteredData : public AbstractLogData {
     // Returns the line 'index' in filterd log data that matches
     // given original line number
     LineNumber getLineIndexNumber( LineNumber lineNumber ) const;
+    // Returns the first line in the original LogData matched since the
+    // last call, the filtered lines before it have not changed.
+    OptionalLineNumber takeFirstNewMatch();
 
     // Returns the number of lines in the source log data
     LinesCount getNbTotalLines() const;
@@ -111,12 +121,18 @@ class LogFilteredData : public AbstractLogData {
 
     // Add a mark at the given line
     void addMark( LineNumber line );
+    // Add marks at all the given lines at once
+    void addMarks( const klogg::vector<LineNumber>& lines );
+    // Add marks at all the lines of the range at once
+    void addMarks( LineNumber firstLine, LinesCount nbLines );
     // Get the first mark after the line passed
     OptionalLineNumber getMarkAfter( LineNumber line ) const;
     // Get the first mark before the line passed
     OptionalLineNumber getMarkBefore( LineNumber line ) const;
     // Delete the mark present on the passed line
     void deleteMark( LineNumber line );
+    // Delete the marks present on all the given lines at once
+    void deleteMarks( const klogg::vector<LineNumber>& lines );
     // Toggle presence of the mark on the passed line.
     void toggleMark( LineNumber line );
     // Completely clear the marks list.
@@ -137,28 +153,59 @@ class LogFilteredData : public AbstractLogData {
     Visibility visibility() const;
 
     void iterateOverLines( const std::function<void( LineNumber )>& callback ) const;
+
+    // Distribution of the matches and of the marks over the file,
+    // kept up to date as the search progresses and the marks change.
+    const LinesHistogram& matchesHistogram() const;
+    const LinesHistogram& marksHistogram() const;
+
+    // Returns the filtered data this one searches in, null if it searches the whole file.
+    std::shared_ptr<LogFilteredData> parentData() const;
+
+    // Returns the data of the whole file the lines are filtered from.
+    const LogData* sourceLogData() const;
+
+    // Returns a copy of the lines of the source log data at the indexes
+    // [firstIndex, firstIndex + number), which doesn't follow later results.
+    SearchResultArray getSourceLines( LineNumber firstIndex, LinesCount number ) const;
+
   Q_SIGNALS:
     // Sent when the search has progressed, give the number of matches (so far)
     // and the percentage of completion
     void searchProgressed( LinesCount nbMatches, int progress, LineNumber initialLine );
     void searchProgressedThrottled();
+    // Sent when the search of a large file starts, with the estimated
+    // number of matches and its margin of error
+    void searchEstimated( LinesCount estimate, LinesCount margin );
+
+    // Sent when new matching lines have been added to the results
+    void matchesAdded();
+    // Sent when the results have been cleared
+    void matchesCleared();
 
   private Q_SLOTS:
     void handleSearchProgressed( LinesCount nbMatches, int progress, LineNumber initialLine );
     void handleSearchProgressedThrottled();
 
+    void handleParentMatchesAdded();
+    void handleParentMatchesCleared();
+
   private:
     // Implementation of virtual functions
     QString doGetLineString( LineNumber line ) const override;
     QString doGetExpandedLineString( LineNumber line ) const override;
     klogg::vector<QString> doGetLines( LineNumber first, LinesCount number ) const override;
     klogg::vector<QString> doGetExpandedLines( LineNumber first, LinesCount number ) const override;
-    klogg::vector<QString> doGetLines( LineNumber first, LinesCount number,
-                                     const std::function<QString( LineNumber )>& lineGetter ) const;
     LineNumber doGetLineNumber( LineNumber index ) const override;
     LinesCount doGetNbLine() const override;
     LineLength doGetMaxLength() const override;
     LineLength doGetLineLength( LineNumber line ) const override;
+    bool doIsLongLine( LineNumber line ) const override;
+    QString doGetExpandedLineWindow( LineNumber line, LineColumn firstColumn,
+                                     LineLength nbColumns ) const override;
+    std::optional<klogg::vector<ByteRange>>
+    doGetLinesByteRanges( LineNumber first, LinesCount number ) const override;
+    QString doGetFileName() const override;
 
     void doSetDisplayEncoding( const char* encoding ) override;
     QTextCodec* doGetDisplayEncoding() const override;
@@ -174,11 +221,30 @@ class LogFilteredData : public AbstractLogData {
     // Returns wheither the passed line has a mark on it.
     bool isLineMarked( LineNumber line ) const;
 
+    // Search the lines the parent has matched since the last search.
+    void extendSearchToParentMatches();
+
     // List of the matching line numbers
     SearchResultArray matching_lines_;
     SearchResultArray marks_;
     SearchResultArray marks_and_matches_;
 
+    LinesHistogram matchesHistogram_;
+    LinesHistogram marksHistogram_;
+
+    // Lines are also read from background threads (QuickFind, prefetching),
+    // the bitmaps and the visibility are only modified in the main thread
+    // while holding this mutex exclusively, and read from the other
+    // threads while holding it shared.
+    mutable SharedMutex resultsMutex_;
+
+    // Speed up rank and select for scrolling and mark navigation.
+    // The cursors are modified by the readers, they are guarded by their
+    // own mutex, always locked after resultsMutex_.
+    mutable Mutex cursorsMutex_;
+    mutable SearchResultsCursor resultsCursor_;
+    mutable SearchResultsCursor marksCursor_;
+
     const LogData* sourceLogData_;
 
     RegularExpressionPattern currentRegExp_;
@@ -193,38 +259,20 @@ class LogFilteredData : public AbstractLogData {
 
     Mutex searchProgressMutex_;
     std::tuple<LinesCount, int, LineNumber> searchProgress_;
+    OptionalLineNumber firstNewMatch_;
 
     KDToolBox::KDSignalThrottler searchProgressThrottler_;
 
-  private:
-    struct CachedSearchResult {
-        SearchResultArray matching_lines;
-        LineLength maxLength;
-    };
+    // Nested search state
+    std::shared_ptr<LogFilteredData> parentData_;
+    // Parent matches already passed to the worker
+    SearchResultArray searchedDomain_;
+    bool isSearchRunning_ = false;
+    bool hasPendingParentMatches_ = false;
 
+  private:
     using SearchCacheKey = std::tuple<RegularExpressionPattern, LineNumber::UnderlyingType,
                                       LineNumber::UnderlyingType>;
-    struct SearchCacheKeyHash {
-        template <class T>
-        void hash_combine( std::size_t& seed, const T& v ) const
-        {
-            seed ^= std::hash<T>()( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
-        }
-        std::size_t operator()( const SearchCacheKey& k ) const
-        {
-            size_t seed = qHash( std::get<0>( k ).pattern );
-
-            hash_combine( seed, std::get<0>( k ).isPlainText );
-            hash_combine( seed, std::get<0>( k ).isBoolean );
-            hash_combine( seed, std::get<0>( k ).isCaseSensitive );
-            hash_combine( seed, std::get<0>( k ).isExclude );
-            hash_combine( seed, std::get<1>( k ) );
-            hash_combine( seed, std::get<2>( k ) );
-            return seed;
-        }
-    };
-
-    std::unordered_map<SearchCacheKey, CachedSearchResult, SearchCacheKeyHash> searchResultsCache_;
     SearchCacheKey currentSearchKey_;
 
     SearchCacheKey makeCacheKey( const RegularExpressionPattern& regExp, LineNumber startLine,
@@ -233,6 +281,7 @@ class LogFilteredData : public AbstractLogData {
         return std::make_tuple( regExp, startLine.get(), endLine.get() );
     }
 
+    // Store the results in the search results cache of the LogData
     void updateSearchResultsCache();
 
     inline LineNumber getExpectedSearchEnd( const SearchCacheKey& cacheKey ) const
@@ -243,10 +292,27 @@ class LogFilteredData : public AbstractLogData {
     // Utility functions
     const SearchResultArray& currentResultArray() const;
     LineNumber findLogDataLine( LineNumber lineNum ) const;
+    // Returns the lines in the source file of number filtered lines,
+    // walking the results once instead of selecting each line.
+    klogg::vector<LineNumber> findLogDataLines( LineNumber firstLine, LinesCount number ) const;
     LineNumber findFilteredLine( LineNumber lineNum ) const;
 
     // update maxLengthMarks_ when a Marks was changed.
     void updateMaxLengthMarks( OptionalLineNumber added_line, OptionalLineNumber removed_line );
+    void recalculateMaxLengthMarks();
+    // Returns the greatest length of lines, read in batches from the source.
+    LineLength getMaxLineLength( const SearchResultArray& lines ) const;
+
+    // Apply a set of marks to marks_ and marks_and_matches_ in one operation
+    void insertMarks( SearchResultArray newMarks );
+    void removeMarks( SearchResultArray removedMarks );
+
+    // Must be called each time the matches or the marks are modified.
+    void invalidateCursors();
+    // Same when only lines from firstLine on have been modified,
+    // what is known about the lines before it is kept.
+    void invalidateMatchesCursor( LineNumber firstLine );
+    void invalidateCursors( LineNumber firstLine );
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( LogFilteredData::Visibility )
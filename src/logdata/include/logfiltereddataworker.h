@@ -39,6 +39,9 @@
 #ifndef LOGFILTEREDDATAWORKERTHREAD_H
 #define LOGFILTEREDDATAWORKERTHREAD_H
 
+#include <memory>
+#include <optional>
+
 #include <QObject>
 
 #include <qthreadpool.h>
@@ -46,7 +49,6 @@
 #ifndef Q_MOC_RUN
 #include <roaring.hh>
 #include <roaring64map.hh>
-#include <tbb/task_group.h>
 #endif
 
 #include "atomicflag.h"
@@ -126,12 +128,31 @@ private:
     LinesCount nbMatches_{ 0 };
 };
 
+// Keeps the matcher of an auto-refreshing search compiled between updates,
+// so lines appended to a growing file are matched inline in the worker
+// thread instead of setting up a shared scan for each of them.
+// Only used by the search operations, one at a time.
+class SearchStreamingSession {
+public:
+    // Match the lines [initialLine, endLine) and add the results to searchData
+    void matchLines( const LogData& sourceLogData, const RegularExpressionPattern& regExp,
+                     LineNumber initialLine, LineNumber endLine, SearchData& searchData );
+
+private:
+    const PatternMatcher& matcher( const RegularExpressionPattern& regExp );
+
+    std::optional<RegularExpressionPattern> pattern_;
+    std::unique_ptr<RegularExpression> expression_;
+    std::unique_ptr<PatternMatcher> matcher_;
+};
+
 class SearchOperation : public QObject {
     Q_OBJECT
 public:
     SearchOperation( const LogData& sourceLogData, AtomicFlag& interruptRequested,
                      const RegularExpressionPattern& regExp, LineNumber startLine,
-                     LineNumber endLine );
+                     LineNumber endLine, std::optional<SearchResultArray> domain = {},
+                     OptionalLineNumber priorityLine = {} );
 
     // Run the search operation, returns true if it has been done
     // and false if it has been cancelled (results not copied)
@@ -139,11 +160,14 @@ public:
 
 Q_SIGNALS:
     void searchProgressed( LinesCount nbMatches, int percent, LineNumber initialLine );
+    void searchEstimated( LinesCount estimate, LinesCount margin );
     void searchFinished();
 
 protected:
     // Implement the common part of the search, passing
     // the shared results and the line to begin the search from.
+    // The lines are read by the SearchScanCoordinator of the LogData,
+    // so concurrent searches on the same file share a single pass.
     void doSearch( SearchData& result, LineNumber initialLine );
 
     AtomicFlag& interruptRequested_;
@@ -151,6 +175,14 @@ protected:
     const LogData& sourceLogData_;
     LineNumber startLine_;
     LineNumber endLine_;
+
+    // If set, only these lines of the file are searched
+    const std::optional<SearchResultArray> domain_;
+    // If set, lines around it are searched first
+    const OptionalLineNumber priorityLine_;
+
+    // If set, small ranges are matched inline using the session
+    SearchStreamingSession* streamingSession_ = nullptr;
 };
 
 class FullSearchOperation : public SearchOperation {
@@ -158,8 +190,29 @@ class FullSearchOperation : public SearchOperation {
 public:
     FullSearchOperation( const LogData& sourceLogData, AtomicFlag& interruptRequested,
                          const RegularExpressionPattern& regExp, LineNumber startLine,
-                         LineNumber endLine )
-        : SearchOperation( sourceLogData, interruptRequested, regExp, startLine, endLine )
+                         LineNumber endLine, std::optional<SearchResultArray> domain,
+                         OptionalLineNumber priorityLine )
+        : SearchOperation( sourceLogData, interruptRequested, regExp, startLine, endLine,
+                           std::move( domain ), priorityLine )
+    {
+    }
+
+    void run( SearchData& result ) override;
+
+private:
+    // Runs the exact search while the estimate is computed on another thread
+    void doSearchWithEstimate( SearchData& result );
+};
+
+// Adds the matches found in new lines of the domain to the existing results
+class ExtendSearchOperation : public SearchOperation {
+    Q_OBJECT
+public:
+    ExtendSearchOperation( const LogData& sourceLogData, AtomicFlag& interruptRequested,
+                           const RegularExpressionPattern& regExp, LineNumber startLine,
+                           LineNumber endLine, SearchResultArray domain )
+        : SearchOperation( sourceLogData, interruptRequested, regExp, startLine, endLine,
+                           std::move( domain ) )
     {
     }
 
@@ -171,10 +224,12 @@ class UpdateSearchOperation : public SearchOperation {
 public:
     UpdateSearchOperation( const LogData& sourceLogData, AtomicFlag& interruptRequested,
                            const RegularExpressionPattern& regExp, LineNumber startLine,
-                           LineNumber endLine, LineNumber position )
+                           LineNumber endLine, LineNumber position,
+                           SearchStreamingSession& streamingSession )
         : SearchOperation( sourceLogData, interruptRequested, regExp, startLine, endLine )
         , initialPosition_( position )
     {
+        streamingSession_ = &streamingSession;
     }
 
     void run( SearchData& result ) override;
@@ -183,6 +238,30 @@ private:
     LineNumber initialPosition_;
 };
 
+// Restarts a search from the results it had before, e.g. cached results
+// of the file before new lines have been appended
+class ResumeSearchOperation : public SearchOperation {
+    Q_OBJECT
+public:
+    ResumeSearchOperation( const LogData& sourceLogData, AtomicFlag& interruptRequested,
+                           const RegularExpressionPattern& regExp, LineNumber startLine,
+                           LineNumber endLine, LineNumber position, LinesCount nbMatches,
+                           LineLength maxLength )
+        : SearchOperation( sourceLogData, interruptRequested, regExp, startLine, endLine )
+        , initialPosition_( position )
+        , initialMatches_( nbMatches )
+        , initialMaxLength_( maxLength )
+    {
+    }
+
+    void run( SearchData& result ) override;
+
+private:
+    LineNumber initialPosition_;
+    LinesCount initialMatches_;
+    LineLength initialMaxLength_;
+};
+
 class LogFilteredDataWorker : public QObject {
     Q_OBJECT
 
@@ -196,15 +275,32 @@ public:
     LogFilteredDataWorker( LogFilteredDataWorker&& ) = delete;
     LogFilteredDataWorker& operator=( LogFilteredDataWorker&& ) = delete;
 
-    // Start the search with the passed regexp
-    void search( const RegularExpressionPattern& regExp, LineNumber startLine, LineNumber endLine );
+    // Start the search with the passed regexp, only lines of the domain
+    // are searched if one is passed. Lines around the priority line
+    // are searched first.
+    void search( const RegularExpressionPattern& regExp, LineNumber startLine, LineNumber endLine,
+                 std::optional<SearchResultArray> domain = {},
+                 OptionalLineNumber priorityLine = {} );
+    // Search the lines of the domain, adding the matches to the
+    // results of the previous search
+    void extendSearch( const RegularExpressionPattern& regExp, LineNumber startLine,
+                       LineNumber endLine, SearchResultArray domain );
     // Continue the previous search starting at the passed position
     // in the source file (line number)
     void updateSearch( const RegularExpressionPattern& regExp, LineNumber startLine,
                        LineNumber endLine, LineNumber position );
 
+    // Start a search at the passed position, the lines before it
+    // have already been searched and had nbMatches matches
+    void resumeSearch( const RegularExpressionPattern& regExp, LineNumber startLine,
+                       LineNumber endLine, LineNumber position, LinesCount nbMatches,
+                       LineLength maxLength );
+
     // Interrupts the search if one is in progress
     void interrupt();
+    // Interrupts the search and drops its results without waiting for it to stop,
+    // nothing is signaled anymore for the operations requested before.
+    void clearResults();
 
     // get the current indexing data
     SearchResults getSearchResults() const;
@@ -213,12 +309,14 @@ Q_SIGNALS:
     // Sent during the indexing process to signal progress
     // percent being the percentage of completion.
     void searchProgressed( LinesCount nbMatches, int percent, LineNumber initialLine );
+    // Sent before a search of a large file with the estimated number of matches
+    void searchEstimated( LinesCount estimate, LinesCount margin );
     // Sent when indexing is finished, signals the client
     // to copy the new data back.
     void searchFinished();
 
 private:
-    void connectSignalsAndRun( SearchOperation* operationRequested );
+    void connectSignalsAndRun( SearchOperation* operationRequested, uint64_t generation );
 
 private:
     const LogData& sourceLogData_;
@@ -227,8 +325,14 @@ private:
     QThreadPool operationsPool_;
     Mutex operationsMutex_;
 
+    // Changed when the results are cleared, only used in the thread of the worker
+    uint64_t generation_ = 0;
+
     // Shared indexing data
     SearchData searchData_;
+
+    // Matcher kept alive between updates of the search
+    SearchStreamingSession streamingSession_;
 };
 
 #endif
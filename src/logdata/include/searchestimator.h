@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KLOGG_SEARCHESTIMATOR_H
+#define KLOGG_SEARCHESTIMATOR_H
+
+#include <cstdint>
+#include <optional>
+
+#include "atomicflag.h"
+#include "linetypes.h"
+#include "regularexpressionpattern.h"
+
+class LogData;
+
+// Approximate number of matching lines, the exact count is expected
+// to be within estimate +/- margin with 95% confidence.
+struct SearchEstimate {
+    LinesCount estimate;
+    LinesCount margin;
+    LinesCount sampledLines;
+};
+
+struct SearchEstimateParameters {
+    // Ranges smaller than this are searched fast enough not to need an estimate
+    LinesCount minLines = 1000000_lcount;
+    // Share of the lines to search
+    double sampledFraction = 0.02;
+    // The range is split into strata, one chunk is sampled from each of them
+    LinesCount::UnderlyingType nbStrata = 64;
+    // Placement of the chunks is random unless a seed is passed
+    std::optional<uint64_t> seed;
+};
+
+// Estimates the number of lines matching the pattern in [startLine, endLine)
+// by searching a few randomly placed chunks in each part of the range.
+// Returns nothing if the range is too small for sampling to be worth it
+// or the estimation has been interrupted.
+std::optional<SearchEstimate> estimateMatches( const LogData& logData,
+                                               const RegularExpressionPattern& regExp,
+                                               LineNumber startLine, LineNumber endLine,
+                                               const AtomicFlag& interruptRequested,
+                                               const SearchEstimateParameters& parameters = {} );
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KLOGG_SEARCHRESULTSCACHE_H
+#define KLOGG_SEARCHRESULTSCACHE_H
+
+#include <cstdint>
+#include <optional>
+
+#include <QString>
+#include <QThreadPool>
+
+#include "linetypes.h"
+#include "logfiltereddataworker.h"
+#include "lrucache.h"
+#include "regularexpressionpattern.h"
+#include "synchronization.h"
+
+// Least recently used search results of one file, limited by the memory
+// used by the result bitmaps. Results are kept when the file grows, so a
+// search can be resumed from the last line it covered.
+// Results depend on how lines are decoded and prefiltered, they are kept
+// for the search context they were made in.
+// Results are saved to disk next to the path and the digest of the file
+// content as soon as they are inserted, so searches on an unchanged file
+// are instant in later sessions. Saved results of all files are limited
+// in size and age, the least recently saved ones are removed first.
+// This class is thread-safe.
+class SearchResultsCache {
+  public:
+    struct Entry {
+        SearchResultArray matchingLines;
+        LineLength maxLength;
+        // All lines before this one have been searched
+        LineNumber searchedUntil;
+    };
+
+    // Results are persisted in subdirectories of storageRoot,
+    // nothing is saved if it is empty.
+    // Only the default storage root is used by LogData.
+    explicit SearchResultsCache( const QString& storageRoot = {} );
+    ~SearchResultsCache() noexcept;
+
+    SearchResultsCache( const SearchResultsCache& ) = delete;
+    SearchResultsCache& operator=( const SearchResultsCache& ) = delete;
+    SearchResultsCache( SearchResultsCache&& ) = delete;
+    SearchResultsCache& operator=( SearchResultsCache&& ) = delete;
+
+    // Returns the results of the search of [startLine, endLine) if cached.
+    // They might cover only the beginning of the range if the file has grown.
+    std::optional<Entry> find( const RegularExpressionPattern& regExp, LineNumber startLine,
+                               LineNumber endLine );
+
+    // Adds or replaces the results of the search starting at startLine.
+    void insert( const RegularExpressionPattern& regExp, LineNumber startLine, Entry entry );
+
+    // Sets the encoding and the prefilter pattern applied to the lines,
+    // following finds and inserts are for results in this context.
+    void setSearchContext( int encodingMib, const QString& prefilterPattern );
+
+    // Sets the path and the digest of the content of the file and loads the
+    // results saved for it. Results in memory stay valid as the file can only
+    // have grown.
+    void setFileDigest( const QString& fileName, qint64 size, quint64 digest );
+
+    // Drops all results, for instance when the file has been truncated.
+    void clear();
+
+    uint64_t sizeInBytes() const;
+    size_t size() const;
+
+    // Default location of the saved results, the cache directory
+    // of the application unless another one has been set.
+    static QString defaultStorageRoot();
+    static void setDefaultStorageRoot( const QString& storageRoot );
+
+    // Removes the results saved in storageRoot for files not searched for
+    // maxAgeDays, then the least recently saved ones until the rest fits
+    // in maxSizeInBytes. Results in keptDirectory are never removed.
+    static void evictSavedResults( const QString& storageRoot, uint64_t maxSizeInBytes,
+                                   int maxAgeDays, const QString& keptDirectory = {} );
+
+  private:
+    struct SearchContext {
+        int encodingMib = 0;
+        QString prefilterPattern;
+    };
+
+    struct Key {
+        RegularExpressionPattern regExp;
+        LineNumber::UnderlyingType startLine = 0;
+        SearchContext context;
+
+        bool operator==( const Key& other ) const;
+    };
+
+    struct KeyHash {
+        size_t operator()( const Key& key ) const;
+    };
+
+    struct CachedEntry {
+        Entry entry;
+        uint64_t sizeInBytes;
+    };
+
+    bool insertEntry( const Key& key, Entry entry );
+    void evict();
+
+    bool isPersistenceEnabled() const;
+    void loadSavedEntries();
+    void saveEntry( const Key& key, const Entry& entry );
+
+  private:
+    mutable Mutex mutex_;
+
+    const QString storageRoot_;
+    QString storageDirectory_;
+
+    SearchContext context_;
+
+    LruCache<Key, CachedEntry, KeyHash> entries_;
+    uint64_t sizeInBytes_ = 0;
+
+    // Writes and removes saved results in order, out of the callers threads
+    QThreadPool persistencePool_;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_SEARCHRESULTSCURSOR_H
+#define KLOGG_SEARCHRESULTSCURSOR_H
+
+#include <cstdint>
+#include <optional>
+
+#include "containers.h"
+#include "logfiltereddataworker.h"
+
+// Answers rank and select queries on a search results bitmap, with the
+// same semantics as the ones of the bitmap, reusing the position of the
+// previous query. Queries close to the previous one (scrolling, next and
+// previous mark) walk the bitmap from the remembered position.
+// Once several distant queries have been made (dragging the scrollbar),
+// a table of every SkipInterval-th line is built so that random jumps
+// land at most SkipInterval / 2 lines away from their target.
+// The bitmap must outlive the cursor, and invalidate() must be called
+// each time it is modified. When only lines from a given one on have
+// changed (e.g. a search progressing), invalidateFrom() keeps the part
+// of the table before it and the table is extended on the next jump.
+// This class is not thread-safe.
+class SearchResultsCursor {
+  public:
+    SearchResultsCursor() = default;
+
+    SearchResultsCursor( const SearchResultsCursor& ) = delete;
+    SearchResultsCursor& operator=( const SearchResultsCursor& ) = delete;
+
+    // Returns the number of lines in results lower or equal to line.
+    uint64_t rank( const SearchResultArray& results, uint64_t line );
+
+    // Sets line to the rank-th line of results (0-based),
+    // returns false if there is no such line.
+    bool select( const SearchResultArray& results, uint64_t rank, uint64_t* line );
+
+    // Forgets everything known about the results.
+    void invalidate();
+    // Forgets what is known about the results from line on,
+    // the lines before it must not have changed.
+    void invalidateFrom( uint64_t line );
+
+  private:
+    void attach( const SearchResultArray& results );
+
+    // Moves the position to the line of rank, walking from the current
+    // position for at most maxSteps lines. Returns false if too far.
+    bool walkToRank( uint64_t rank, uint64_t maxSteps );
+    // Moves the position to the greatest line lower or equal to line, or
+    // to the first line if there is none, walking for at most maxSteps lines.
+    bool walkToLine( uint64_t line, uint64_t maxSteps );
+
+    void jumpToRank( uint64_t rank );
+    void jumpToLine( uint64_t line );
+    void positionAt( uint64_t line, uint64_t rank );
+
+    void registerJump();
+    bool hasSkipTable() const;
+    void extendSkipTable();
+
+  private:
+    const SearchResultArray* results_ = nullptr;
+    uint64_t cardinality_ = 0;
+    bool isCardinalityStale_ = false;
+
+    std::optional<SearchResultArray::const_iterator> position_;
+    uint64_t positionRank_ = 0;
+
+    uint64_t nbJumps_ = 0;
+    // Line of every SkipInterval-th result
+    klogg::vector<uint64_t> skipTable_;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KLOGG_SEARCHSCANCOORDINATOR_H
+#define KLOGG_SEARCHSCANCOORDINATOR_H
+
+#include <functional>
+#include <memory>
+
+#include <QSemaphore>
+#include <qthreadpool.h>
+
+#include "atomicflag.h"
+#include "containers.h"
+#include "linetypes.h"
+#include "logfiltereddataworker.h"
+#include "regularexpressionpattern.h"
+#include "synchronization.h"
+
+class LogData;
+
+// A request to search a range of lines of the file, submitted
+// to the SearchScanCoordinator by a search operation.
+struct SearchScanRequest {
+    using ProgressCallback = std::function<void( LinesCount nbMatches, int percent )>;
+
+    RegularExpressionPattern regexp;
+    LineNumber initialLine;
+    LineNumber endLine;
+
+    SearchData& searchData;
+    AtomicFlag& interruptRequested;
+
+    // Called from the scanning thread each time the request has progressed
+    ProgressCallback progressCallback;
+
+    // If set, only these lines are searched (e.g. the matches of a parent
+    // filter). Must outlive the call to scan().
+    const SearchResultArray* domain = nullptr;
+
+    // If set, lines around it are searched first, spreading out
+    // in both directions, before the rest of the range.
+    OptionalLineNumber priorityLine;
+};
+
+// Reads the file on behalf of all the searches running concurrently on the
+// same LogData. Each chunk of lines is read and transcoded to utf8 only once,
+// then every attached matcher is run over it and the results are dispatched
+// to the SearchData of each request.
+// A request arriving while a scan is in progress joins it at the current
+// position and the scan wraps around to cover the lines it missed.
+// Requests with a priority line are served first, outward from that line.
+// Requests restricted to a domain of lines are not merged into the shared
+// scan: they read only the lines of their domain in the caller's thread.
+// This class is thread-safe.
+class SearchScanCoordinator {
+  public:
+    explicit SearchScanCoordinator( const LogData& sourceLogData );
+    ~SearchScanCoordinator() noexcept;
+
+    SearchScanCoordinator( const SearchScanCoordinator& ) = delete;
+    SearchScanCoordinator& operator=( const SearchScanCoordinator& ) = delete;
+    SearchScanCoordinator( SearchScanCoordinator&& ) = delete;
+    SearchScanCoordinator& operator=( SearchScanCoordinator&& ) = delete;
+
+    // Scan the lines of the request, blocks until all lines are searched
+    // or the request is interrupted.
+    void scan( const SearchScanRequest& request );
+
+    struct ScanClient;
+    using ScanClientPtr = std::shared_ptr<ScanClient>;
+
+  private:
+    void runScan();
+    void scanDomain( const SearchScanRequest& request ) const;
+
+  private:
+    const LogData& sourceLogData_;
+
+    AtomicFlag shutdownRequested_;
+
+    QThreadPool scanPool_;
+
+    Mutex clientsMutex_;
+    klogg::vector<ScanClientPtr> pendingClients_;
+    bool isScanRunning_ = false;
+};
+
+#endif
@@ -95,6 +95,32 @@ LineLength AbstractLogData::getLineLength( LineNumber line ) const
     return doGetLineLength( line );
 }
 
+// Simple wrapper in order to use a clean Template Method
+bool AbstractLogData::isLongLine( LineNumber line ) const
+{
+    return doIsLongLine( line );
+}
+
+// Simple wrapper in order to use a clean Template Method
+QString AbstractLogData::getExpandedLineWindow( LineNumber line, LineColumn firstColumn,
+                                                LineLength nbColumns ) const
+{
+    return doGetExpandedLineWindow( line, firstColumn, nbColumns );
+}
+
+// Simple wrapper in order to use a clean Template Method
+std::optional<klogg::vector<AbstractLogData::ByteRange>>
+AbstractLogData::getLinesByteRanges( LineNumber first_line, LinesCount number ) const
+{
+    return doGetLinesByteRanges( first_line, number );
+}
+
+// Simple wrapper in order to use a clean Template Method
+QString AbstractLogData::getFileName() const
+{
+    return doGetFileName();
+}
+
 void AbstractLogData::setDisplayEncoding( const char* encoding )
 {
     doSetDisplayEncoding( encoding );
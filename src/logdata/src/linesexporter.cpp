@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include <QtGlobal>
+
+#if defined( Q_OS_UNIX )
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined( Q_OS_LINUX )
+#include <sys/sendfile.h>
+#endif
+
+#include "configuration.h"
+#include "log.h"
+#include "logdata.h"
+#include "logfiltereddata.h"
+
+#include "linesexporter.h"
+
+namespace {
+// Scattered lines separated by less than that are read in one go,
+// with the bytes between them.
+constexpr qint64 MaxGatheredGap = 64 * 1024;
+
+// Maximum size of the blocks read to gather scattered lines
+constexpr qint64 GatherBlockSize = 16 * 1024 * 1024;
+
+// Contiguous lines are copied by spans of that size at most,
+// so the progress is reported while copying large files.
+constexpr qint64 CopySpanSize = 64 * 1024 * 1024;
+
+#if defined( Q_OS_UNIX )
+// Number of buffers passed to a single writev, IOV_MAX is 1024 on
+// the systems we care about.
+constexpr std::size_t MaxIoVectors = 1024;
+#endif
+
+using Slice = std::pair<const char*, qint64>;
+
+// Writes ranges of bytes of the source file to the destination, merging
+// the ranges close to each other in a single read.
+class RangesWriter {
+  public:
+    RangesWriter( QFile& source, QFileDevice& destination, const AtomicFlag& interruptRequest )
+        : source_( source )
+        , destination_( destination )
+        , interruptRequest_( interruptRequest )
+        , sourceSize_( source.size() )
+    {
+    }
+
+    bool add( AbstractLogData::ByteRange range )
+    {
+        // A last line without line feed is indexed as ending past the end of the file
+        range.end = std::min( range.end, sourceSize_ );
+        if ( range.begin >= range.end ) {
+            return true;
+        }
+
+        if ( !pending_.empty() ) {
+            const auto& last = pending_.back();
+            const auto isSingleSpan = pending_.size() == 1 && last.end == range.begin;
+            if ( !isSingleSpan
+                 && ( range.begin - last.end > MaxGatheredGap
+                      || range.end - pending_.front().begin > GatherBlockSize ) ) {
+                if ( !flush() ) {
+                    return false;
+                }
+            }
+        }
+
+        if ( !pending_.empty() && pending_.back().end == range.begin ) {
+            pending_.back().end = range.end;
+        }
+        else {
+            pending_.push_back( range );
+        }
+
+        const auto& first = pending_.front();
+        if ( pending_.size() == 1 && first.end - first.begin >= CopySpanSize ) {
+            return flush();
+        }
+
+        return true;
+    }
+
+    bool finish()
+    {
+        return flush();
+    }
+
+  private:
+    bool flush()
+    {
+        if ( pending_.empty() ) {
+            return true;
+        }
+
+        const auto isWritten = pending_.size() == 1
+                                   ? copySpan( pending_.front().begin, pending_.front().end )
+                                   : gather();
+        pending_.clear();
+        return isWritten;
+    }
+
+    bool gather()
+    {
+        const auto blockBegin = pending_.front().begin;
+        const auto blockSize = pending_.back().end - blockBegin;
+        buffer_.resize( static_cast<std::size_t>( blockSize ) );
+        if ( !readAt( blockBegin, blockSize ) ) {
+            return false;
+        }
+
+        slices_.clear();
+        for ( const auto& range : pending_ ) {
+            slices_.emplace_back( buffer_.data() + ( range.begin - blockBegin ),
+                                  range.end - range.begin );
+        }
+
+        return writeSlices();
+    }
+
+    bool copySpan( qint64 begin, qint64 end )
+    {
+#if defined( Q_OS_LINUX )
+        // Let the kernel copy the bytes, without going through user space
+        loff_t copyOffset = begin;
+        while ( useCopyFileRange_ && copyOffset < end && !interruptRequest_ ) {
+            const auto size = std::min( end - copyOffset, CopySpanSize );
+            const auto copied
+                = ::copy_file_range( source_.handle(), &copyOffset, destination_.handle(),
+                                     nullptr, static_cast<std::size_t>( size ), 0 );
+            if ( copied < 0 && errno == EINTR ) {
+                continue;
+            }
+            if ( copied == 0 ) {
+                break;
+            }
+            if ( copied < 0 ) {
+                // Not supported by the kernel or between these file systems
+                LOG_INFO << "copy_file_range failed: " << std::strerror( errno );
+                useCopyFileRange_ = false;
+            }
+        }
+        begin = copyOffset;
+
+        off_t sendOffset = begin;
+        while ( useSendFile_ && sendOffset < end && !interruptRequest_ ) {
+            const auto size = std::min( end - sendOffset, CopySpanSize );
+            const auto sent = ::sendfile( destination_.handle(), source_.handle(), &sendOffset,
+                                          static_cast<std::size_t>( size ) );
+            if ( sent < 0 && errno == EINTR ) {
+                continue;
+            }
+            if ( sent == 0 ) {
+                break;
+            }
+            if ( sent < 0 ) {
+                LOG_INFO << "sendfile failed: " << std::strerror( errno );
+                useSendFile_ = false;
+            }
+        }
+        begin = sendOffset;
+#endif
+
+        while ( begin < end && !interruptRequest_ ) {
+            const auto blockSize = std::min( end - begin, GatherBlockSize );
+            buffer_.resize( static_cast<std::size_t>( blockSize ) );
+            if ( !readAt( begin, blockSize ) ) {
+                return false;
+            }
+
+            slices_.clear();
+            slices_.emplace_back( buffer_.data(), blockSize );
+            if ( !writeSlices() ) {
+                return false;
+            }
+
+            begin += blockSize;
+        }
+
+        return begin >= end;
+    }
+
+    bool readAt( qint64 offset, qint64 size )
+    {
+        if ( !source_.seek( offset ) || source_.read( buffer_.data(), size ) != size ) {
+            LOG_ERROR << "Failed to read " << size << " bytes at " << offset << " from "
+                      << source_.fileName();
+            return false;
+        }
+        return true;
+    }
+
+#if defined( Q_OS_UNIX )
+    bool writeSlices()
+    {
+        auto slice = slices_.cbegin();
+        while ( slice != slices_.cend() ) {
+            vectors_.clear();
+            for ( ; slice != slices_.cend() && vectors_.size() < MaxIoVectors; ++slice ) {
+                vectors_.push_back( { const_cast<char*>( slice->first ),
+                                      static_cast<std::size_t>( slice->second ) } );
+            }
+
+            auto vector = vectors_.begin();
+            while ( vector != vectors_.end() ) {
+                const auto written
+                    = ::writev( destination_.handle(), &*vector,
+                                static_cast<int>( std::distance( vector, vectors_.end() ) ) );
+                if ( written < 0 ) {
+                    if ( errno == EINTR ) {
+                        continue;
+                    }
+                    LOG_ERROR << "Failed to write to " << destination_.fileName() << ": "
+                              << std::strerror( errno );
+                    return false;
+                }
+
+                // Skip what was written, the last buffer may have been written partially
+                auto remaining = static_cast<std::size_t>( written );
+                while ( vector != vectors_.end() && remaining >= vector->iov_len ) {
+                    remaining -= vector->iov_len;
+                    ++vector;
+                }
+                if ( vector != vectors_.end() ) {
+                    vector->iov_base = static_cast<char*>( vector->iov_base ) + remaining;
+                    vector->iov_len -= remaining;
+                }
+            }
+        }
+
+        return true;
+    }
+#else
+    bool writeSlices()
+    {
+        for ( const auto& slice : slices_ ) {
+            if ( destination_.write( slice.first, slice.second ) != slice.second ) {
+                LOG_ERROR << "Failed to write to " << destination_.fileName() << ": "
+                          << destination_.errorString();
+                return false;
+            }
+        }
+
+        return true;
+    }
+#endif
+
+  private:
+    QFile& source_;
+    QFileDevice& destination_;
+    const AtomicFlag& interruptRequest_;
+    const qint64 sourceSize_;
+
+    klogg::vector<AbstractLogData::ByteRange> pending_;
+    klogg::vector<char> buffer_;
+    klogg::vector<Slice> slices_;
+
+#if defined( Q_OS_UNIX )
+    klogg::vector<iovec> vectors_;
+#endif
+
+#if defined( Q_OS_LINUX )
+    bool useCopyFileRange_ = true;
+    bool useSendFile_ = true;
+#endif
+};
+} // namespace
+
+LinesExporter::LinesExporter( const AbstractLogData& logData, LineNumber firstLine,
+                              LinesCount nbLines )
+    : fileName_( logData.getFileName() )
+{
+    if ( !logData.getLinesByteRanges( firstLine, 0_lcount ) ) {
+        return;
+    }
+
+    // Only the lines are copied here, a copy of the matches is cheap
+    if ( const auto* filteredData = qobject_cast<const LogFilteredData*>( &logData ) ) {
+        sourceLogData_ = filteredData->sourceLogData();
+        lines_ = filteredData->getSourceLines( firstLine, nbLines );
+    }
+    else {
+        sourceLogData_ = qobject_cast<const LogData*>( &logData );
+        lines_.addRange( firstLine.get(), ( firstLine + nbLines ).get() );
+    }
+}
+
+bool LinesExporter::isSupported() const
+{
+    return sourceLogData_ != nullptr;
+}
+
+LinesExporter::Result LinesExporter::exportTo( QFileDevice& destination,
+                                               const AtomicFlag& interruptRequest,
+                                               const ProgressCallback& progressCallback ) const
+{
+    if ( !sourceLogData_ ) {
+        return Result::Unsupported;
+    }
+
+    QFile source( fileName_ );
+    if ( !source.open( QIODevice::ReadOnly | QIODevice::Unbuffered ) ) {
+        LOG_ERROR << "Failed to open " << source.fileName() << " to export lines";
+        return Result::Failed;
+    }
+
+    // Writes bypass the buffer of the device
+    destination.flush();
+
+    RangesWriter writer( source, destination, interruptRequest );
+    const auto failure
+        = [ &interruptRequest ] { return interruptRequest ? Result::Interrupted : Result::Failed; };
+
+    const auto chunkSize
+        = static_cast<std::size_t>( Configuration::get().searchReadBufferSizeLines() );
+    const auto nbLines = lines_.cardinality();
+
+    klogg::vector<LineNumber> chunk;
+    chunk.reserve( chunkSize );
+    uint64_t nbLinesExported = 0;
+    int lastPercent = 0;
+
+    // The bytes of the lines are found for a chunk of lines at a time
+    const auto exportChunk = [ & ] {
+        const auto isContiguous
+            = chunk.back() - chunk.front() == LinesCount( chunk.size() - 1 );
+        const auto byteRanges
+            = isContiguous ? sourceLogData_->getLinesByteRanges( chunk.front(),
+                                                                 LinesCount( chunk.size() ) )
+                           : sourceLogData_->getScatteredLinesByteRanges( chunk );
+        if ( !byteRanges ) {
+            LOG_ERROR << "Lines can no longer be exported as they are";
+            return false;
+        }
+
+        for ( const auto& range : *byteRanges ) {
+            if ( !writer.add( range ) ) {
+                return false;
+            }
+        }
+
+        nbLinesExported += chunk.size();
+        chunk.clear();
+
+        const auto percent = static_cast<int>( nbLinesExported * 100 / nbLines );
+        if ( progressCallback && percent != lastPercent ) {
+            progressCallback( percent );
+            lastPercent = percent;
+        }
+        return true;
+    };
+
+    for ( const auto line : lines_ ) {
+        chunk.push_back( LineNumber( line ) );
+        if ( chunk.size() < chunkSize ) {
+            continue;
+        }
+
+        if ( interruptRequest ) {
+            return Result::Interrupted;
+        }
+        if ( !exportChunk() ) {
+            return failure();
+        }
+    }
+
+    if ( interruptRequest ) {
+        return Result::Interrupted;
+    }
+    if ( !chunk.empty() && !exportChunk() ) {
+        return failure();
+    }
+
+    if ( !writer.finish() ) {
+        return failure();
+    }
+
+    return Result::Done;
+}
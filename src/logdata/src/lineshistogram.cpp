@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+
+#include "lineshistogram.h"
+
+std::size_t LinesHistogram::bucketOf( uint64_t line )
+{
+    if ( counts_.empty() ) {
+        counts_.resize( NbBuckets );
+    }
+
+    while ( ( line >> bucketShift_ ) >= NbBuckets ) {
+        // Merge the buckets by pairs, the upper half becomes empty
+        for ( std::size_t bucket = 0; bucket < NbBuckets / 2; ++bucket ) {
+            counts_[ bucket ] = counts_[ 2 * bucket ] + counts_[ 2 * bucket + 1 ];
+        }
+        std::fill( counts_.begin() + NbBuckets / 2, counts_.end(), 0 );
+        ++bucketShift_;
+    }
+
+    return static_cast<std::size_t>( line >> bucketShift_ );
+}
+
+void LinesHistogram::add( LineNumber line )
+{
+    ++counts_[ bucketOf( line.get() ) ];
+    ++totalCount_;
+}
+
+void LinesHistogram::add( const SearchResultArray& lines )
+{
+    if ( lines.isEmpty() ) {
+        return;
+    }
+
+    // Buckets only grow, sizing them for the last line first
+    // keeps the index of a bucket stable while adding.
+    bucketOf( lines.maximum() );
+
+    for ( const auto line : lines ) {
+        ++counts_[ static_cast<std::size_t>( line >> bucketShift_ ) ];
+    }
+    totalCount_ += lines.cardinality();
+}
+
+void LinesHistogram::remove( LineNumber line )
+{
+    const auto bucket = static_cast<std::size_t>( line.get() >> bucketShift_ );
+    if ( bucket < counts_.size() && counts_[ bucket ] > 0 ) {
+        --counts_[ bucket ];
+        --totalCount_;
+    }
+}
+
+void LinesHistogram::remove( const SearchResultArray& lines )
+{
+    for ( const auto line : lines ) {
+        remove( LineNumber( line ) );
+    }
+}
+
+void LinesHistogram::clear()
+{
+    bucketShift_ = 0;
+    totalCount_ = 0;
+    counts_.clear();
+}
+
+void LinesHistogram::assign( const SearchResultArray& lines )
+{
+    clear();
+    add( lines );
+}
+
+klogg::vector<uint64_t> LinesHistogram::rescale( LinesCount nbLines, std::size_t nbBins ) const
+{
+    klogg::vector<uint64_t> bins( nbBins );
+    if ( nbBins == 0 || nbLines.get() == 0 || totalCount_ == 0 ) {
+        return bins;
+    }
+
+    const auto binsPerLine = static_cast<double>( nbBins ) / static_cast<double>( nbLines.get() );
+    for ( std::size_t bucket = 0; bucket < counts_.size(); ++bucket ) {
+        if ( counts_[ bucket ] == 0 ) {
+            continue;
+        }
+
+        // A bucket goes to the bin of its first line
+        const auto firstLine = static_cast<uint64_t>( bucket ) << bucketShift_;
+        const auto bin = std::min( static_cast<std::size_t>( static_cast<double>( firstLine )
+                                                             * binsPerLine ),
+                                   nbBins - 1 );
+        bins[ bin ] += counts_[ bucket ];
+    }
+
+    return bins;
+}
@@ -56,14 +56,93 @@
 #include "linetypes.h"
 #include "log.h"
 #include "logfiltereddata.h"
+#include "searchresultscache.h"
+#include "searchscancoordinator.h"
+#include "tracing.h"
 
 #include "logdata.h"
 
+namespace {
+// Lines separated by at most this many lines are read together
+constexpr auto MaxCoalescedLinesGap = 32_lcount;
+
+QString chopCarriageReturn( QString&& lineData )
+{
+    if ( lineData.endsWith( QChar::CarriageReturn ) ) {
+        lineData.chop( 1 );
+    }
+    return std::move( lineData );
+}
+
+QString expandTabs( QString&& lineData )
+{
+    return untabify( std::move( lineData ) );
+}
+
+// Lines longer than that are read by windows of columns
+constexpr qint64 LongLineBytes = 1024 * 1024;
+
+// Distance between two checkpoints of a long line
+constexpr qint64 LongLineCheckpointBytes = 64 * 1024;
+
+// Number of long lines which checkpoints are kept
+constexpr std::size_t MaxLongLineIndexes = 16;
+
+// Returns the size of the beginning of data that ends on a character boundary,
+// 0 if there is none close to the end.
+qint64 alignToCharacterEnd( const klogg::vector<char>& data, qint64 size,
+                            const EncodingParameters& encodingParams )
+{
+    const auto codeUnitWidth = encodingParams.lineFeedWidth;
+    if ( codeUnitWidth == 1 ) {
+        // Bytes below 0x40 are never part of a multibyte character, neither in
+        // utf8 nor in the legacy multibyte encodings.
+        constexpr qint64 MaxLookBehind = 4096;
+        for ( auto end = size; end > 0 && end > size - MaxLookBehind; --end ) {
+            if ( static_cast<unsigned char>( data[ static_cast<std::size_t>( end - 1 ) ] )
+                 < 0x40 ) {
+                return end;
+            }
+        }
+        return 0;
+    }
+
+    auto end = size - size % codeUnitWidth;
+    if ( codeUnitWidth == 2 && end >= 2 ) {
+        // Do not split a surrogate pair
+        const auto index = static_cast<std::size_t>( end );
+        const auto first = static_cast<unsigned char>( data[ index - 2 ] );
+        const auto second = static_cast<unsigned char>( data[ index - 1 ] );
+        const auto codeUnit = encodingParams.isUtf16LE ? ( second << 8 ) | first
+                                                       : ( first << 8 ) | second;
+        if ( codeUnit >= 0xD800 && codeUnit <= 0xDBFF ) {
+            end -= 2;
+        }
+    }
+
+    return end;
+}
+
+// Returns the column after text if it starts at column, tabs are expanded
+LineColumn columnAfter( const QString& text, LineColumn column )
+{
+    auto position = column.get();
+    for ( const auto& c : text ) {
+        position += c == QChar::Tabulation ? TabStop - ( position % TabStop ) : 1;
+    }
+    return LineColumn( position );
+}
+} // namespace
+
 LogData::LogData()
     : AbstractLogData()
     , indexing_data_( std::make_shared<IndexingData>() )
     , operationQueue_( [ this ] { attached_file_->attachReader(); } )
     , codec_( QTextCodec::codecForName( "ISO-8859-1" ) )
+    , searchScanCoordinator_( std::make_unique<SearchScanCoordinator>( *this ) )
+    , searchResultsCache_(
+          std::make_unique<SearchResultsCache>( SearchResultsCache::defaultStorageRoot() ) )
+    , longLineIndexes_( MaxLongLineIndexes )
 {
     // Initialise the file watcher
     connect( &FileWatcher::getFileWatcher(), &FileWatcher::fileChanged, this,
@@ -91,18 +170,25 @@ LogData::LogData()
     if ( defaultEncodingMib >= 0 ) {
         codec_.setCodec( QTextCodec::codecForMib( defaultEncodingMib ) );
     }
+    searchResultsCache_->setSearchContext( codec_.mibEnum(), prefilterPattern_ );
 }
 
 LogData::~LogData()
 {
     LOG_DEBUG << "Destroying log data";
+    searchScanCoordinator_.reset();
     operationQueue_.shutdown();
 }
 
 void LogData::setPrefilter( const QString& prefilterPattern )
 {
-    IndexingData::MutateAccessor scopedAccessor{ indexing_data_.get() };
-    prefilterPattern_ = prefilterPattern;
+    {
+        IndexingData::MutateAccessor scopedAccessor{ indexing_data_.get() };
+        prefilterPattern_ = prefilterPattern;
+    }
+    ++contentGeneration_;
+    searchResultsCache_->setSearchContext( codec_.mibEnum(), prefilterPattern );
+    clearLongLineIndexes();
 }
 
 void LogData::attachFile( const QString& fileName )
@@ -131,21 +217,51 @@ qint64 LogData::getFileSize() const
     return IndexingData::ConstAccessor{ indexing_data_.get() }.getIndexedSize();
 }
 
+size_t LogData::getIndexAllocatedSize() const
+{
+    return IndexingData::ConstAccessor{ indexing_data_.get() }.allocatedSize();
+}
+
 QDateTime LogData::getLastModifiedDate() const
 {
     return lastModifiedDate_;
 }
 
+SearchScanCoordinator& LogData::searchScanCoordinator() const
+{
+    return *searchScanCoordinator_;
+}
+
+SearchResultsCache& LogData::searchResultsCache() const
+{
+    return *searchResultsCache_;
+}
+
+uint64_t LogData::getContentGeneration() const
+{
+    return contentGeneration_.load();
+}
+
 // Return an initialised LogFilteredData. The search is not started.
 std::unique_ptr<LogFilteredData> LogData::getNewFilteredData() const
 {
     return std::make_unique<LogFilteredData>( this );
 }
 
+// Return an initialised nested LogFilteredData. The search is not started.
+std::unique_ptr<LogFilteredData>
+LogData::getNewNestedFilteredData( std::shared_ptr<LogFilteredData> parentData ) const
+{
+    return std::make_unique<LogFilteredData>( this, std::move( parentData ) );
+}
+
 void LogData::reload( QTextCodec* forcedEncoding )
 {
     operationQueue_.interrupt();
 
+    ++contentGeneration_;
+    searchResultsCache_->clear();
+
     // Re-open the file, useful in case the file has been moved
     attached_file_->reOpenFile();
 
@@ -200,6 +316,9 @@ void LogData::indexingFinished( LoadingStatus status )
 {
     attached_file_->detachReader();
 
+    // Lines might have changed
+    clearLongLineIndexes();
+
     LOG_INFO << "indexingFinished for: " << indexingFileName_
              << ( status == LoadingStatus::Successful ) << ", found "
              << IndexingData::ConstAccessor{ indexing_data_.get() }.getNbLines() << " lines.";
@@ -212,6 +331,11 @@ void LogData::indexingFinished( LoadingStatus status )
         QFileInfo fileInfo( indexingFileName_ );
         if ( fileInfo.exists() )
             lastModifiedDate_ = fileInfo.lastModified();
+
+        // Cached search results are saved for this content of the file
+        const auto indexedHash = IndexingData::ConstAccessor{ indexing_data_.get() }.getHash();
+        searchResultsCache_->setFileDigest( indexingFileName_, indexedHash.size,
+                                            indexedHash.fullDigest );
     }
 
     fileChangedOnDisk_ = MonitoredFileStatus::Unchanged;
@@ -232,6 +356,8 @@ void LogData::checkFileChangesFinished( MonitoredFileStatus status )
         switch ( status ) {
         case MonitoredFileStatus::Truncated:
             fileChangedOnDisk_ = MonitoredFileStatus::Truncated;
+            ++contentGeneration_;
+            searchResultsCache_->clear();
             operationQueue_.enqueueOperation<FullReindexOperation>();
             break;
         case MonitoredFileStatus::DataAdded:
@@ -244,6 +370,8 @@ void LogData::checkFileChangesFinished( MonitoredFileStatus status )
         }
     }
     else {
+        ++contentGeneration_;
+        searchResultsCache_->clear();
         operationQueue_.enqueueOperation<FullReindexOperation>();
     }
 
@@ -274,13 +402,205 @@ LineLength LogData::doGetLineLength( LineNumber line ) const
         return 0_length; /* exception? */
     }
 
+    if ( doIsLongLine( line ) ) {
+        const auto index = getLongLineIndex( line );
+        if ( index ) {
+            return LineLength{ index->checkpoints.back().column.get() };
+        }
+    }
+
     return LineLength{ doGetExpandedLineString( line ).size() };
 }
 
+bool LogData::doIsLongLine( LineNumber line ) const
+{
+    {
+        IndexingData::ConstAccessor scopedAccessor{ indexing_data_.get() };
+        if ( !prefilterPattern_.isEmpty() ) {
+            // Removing the prefilter pattern changes the columns
+            return false;
+        }
+    }
+
+    const auto byteRange = getLineByteRange( line );
+    return byteRange && byteRange->second - byteRange->first > LongLineBytes;
+}
+
+QString LogData::doGetExpandedLineWindow( LineNumber line, LineColumn firstColumn,
+                                          LineLength nbColumns ) const
+{
+    const auto index = doIsLongLine( line ) ? getLongLineIndex( line ) : nullptr;
+    if ( !index ) {
+        return doGetExpandedLineString( line ).mid( firstColumn.get(), nbColumns.get() );
+    }
+
+    const auto byteRange = getLineByteRange( line );
+    if ( !byteRange ) {
+        return {};
+    }
+
+    // Decode from the last checkpoint before the window
+    // to the first checkpoint after it
+    const auto& checkpoints = index->checkpoints;
+    const auto lastColumn = firstColumn + nbColumns;
+    const auto windowEnd = std::lower_bound(
+        checkpoints.begin(), checkpoints.end(), lastColumn,
+        []( const LongLineCheckpoint& checkpoint, LineColumn column ) {
+            return checkpoint.column < column;
+        } );
+    const auto windowStart = std::prev( std::upper_bound(
+        checkpoints.begin(), checkpoints.end(), firstColumn,
+        []( LineColumn column, const LongLineCheckpoint& checkpoint ) {
+            return column < checkpoint.column;
+        } ) );
+    const auto endCheckpoint = windowEnd != checkpoints.end() ? windowEnd : std::prev( windowEnd );
+
+    LOG_DEBUG << "Reading window of line " << line << " from byte " << windowStart->byteOffset
+              << " to " << endCheckpoint->byteOffset;
+
+    const auto bytes = readBytes( byteRange->first + windowStart->byteOffset,
+                                  endCheckpoint->byteOffset - windowStart->byteOffset );
+
+    auto decoder = codec_.makeDecoder();
+    auto text = untabify(
+        decoder.decoder->toUnicode( bytes.data(), type_safe::narrow_cast<int>( bytes.size() ) ),
+        windowStart->column );
+
+    if ( endCheckpoint == std::prev( checkpoints.end() ) ) {
+        text = chopCarriageReturn( std::move( text ) );
+    }
+
+    return text.mid( ( firstColumn - windowStart->column ).get(), nbColumns.get() );
+}
+
+std::optional<std::pair<qint64, qint64>> LogData::getLineByteRange( LineNumber line ) const
+{
+    IndexingData::ConstAccessor scopedAccessor{ indexing_data_.get() };
+    if ( line >= scopedAccessor.getNbLines() ) {
+        return {};
+    }
+
+    const auto lineFeedWidth = codec_.encodingParameters().lineFeedWidth;
+    const auto firstByte
+        = line == 0_lnum ? 0 : scopedAccessor.getEndOfLineOffset( line - 1_lcount ).get();
+    const auto endByte = scopedAccessor.getEndOfLineOffset( line ).get() - lineFeedWidth;
+
+    return std::make_pair( firstByte, std::max( firstByte, endByte ) );
+}
+
+klogg::vector<char> LogData::readBytes( qint64 offset, qint64 size ) const
+{
+    klogg::vector<char> bytes( static_cast<std::size_t>( size ) );
+
+    ScopedFileHolder<FileHolder> fileHolder( attached_file_.get() );
+    fileHolder.getFile()->seek( offset );
+    const auto bytesRead = fileHolder.getFile()->read( bytes.data(), size );
+    if ( bytesRead != size ) {
+        LOG_WARNING << "failed to read " << size << " bytes, got " << bytesRead;
+        bytes.resize( static_cast<std::size_t>( std::max( bytesRead, qint64{ 0 } ) ) );
+    }
+
+    return bytes;
+}
+
+std::shared_ptr<const LogData::LongLineIndex> LogData::getLongLineIndex( LineNumber line ) const
+{
+    {
+        ScopedLock lock( longLinesMutex_ );
+        if ( const auto* index = longLineIndexes_.find( line.get() ) ) {
+            return *index;
+        }
+    }
+
+    auto index = buildLongLineIndex( line );
+    if ( !index ) {
+        return nullptr;
+    }
+
+    ScopedLock lock( longLinesMutex_ );
+    longLineIndexes_.insert( line.get(), index );
+
+    return index;
+}
+
+// Decodes the whole line once, by blocks, to find where decoding can
+// start again and the column at each of these points.
+std::shared_ptr<const LogData::LongLineIndex> LogData::buildLongLineIndex( LineNumber line ) const
+{
+    const auto byteRange = getLineByteRange( line );
+    if ( !byteRange ) {
+        return nullptr;
+    }
+
+    LOG_INFO << "Building index of long line " << line << ", "
+             << byteRange->second - byteRange->first << " bytes";
+
+    try {
+        auto index = std::make_shared<LongLineIndex>();
+        index->line = line;
+        index->checkpoints.push_back( LongLineCheckpoint{ 0, 0_lcol } );
+
+        auto decoder = codec_.makeDecoder();
+        const auto lineSize = byteRange->second - byteRange->first;
+
+        qint64 position = 0;
+        auto column = 0_lcol;
+        QChar lastChar;
+        while ( position < lineSize ) {
+            const auto blockSize = std::min( LongLineCheckpointBytes, lineSize - position );
+            const auto block = readBytes( byteRange->first + position, blockSize );
+            if ( block.empty() ) {
+                return nullptr;
+            }
+
+            const auto isLastBlock = position + klogg::ssize( block ) >= lineSize;
+            const auto alignedSize
+                = isLastBlock ? klogg::ssize( block )
+                              : alignToCharacterEnd( block, klogg::ssize( block ),
+                                                     decoder.encodingParams );
+            // Without a character boundary the decoder keeps the
+            // partial character and no checkpoint is added here
+            const auto decodedSize = alignedSize > 0 ? alignedSize : klogg::ssize( block );
+
+            const auto text = decoder.decoder->toUnicode(
+                block.data(), type_safe::narrow_cast<int>( decodedSize ) );
+            column = columnAfter( text, column );
+            if ( !text.isEmpty() ) {
+                lastChar = text.back();
+            }
+
+            position += decodedSize;
+            if ( alignedSize > 0 || isLastBlock ) {
+                index->checkpoints.push_back( LongLineCheckpoint{ position, column } );
+            }
+        }
+
+        // The line length does not include the carriage return
+        if ( lastChar == QChar::CarriageReturn ) {
+            auto& lastCheckpoint = index->checkpoints.back();
+            lastCheckpoint.column = lastCheckpoint.column - 1_length;
+        }
+
+        return index;
+    } catch ( const std::bad_alloc& ) {
+        LOG_ERROR << "not enough memory to index long line " << line;
+        return nullptr;
+    }
+}
+
+void LogData::clearLongLineIndexes()
+{
+    ScopedLock lock( longLinesMutex_ );
+    longLineIndexes_.clear();
+}
+
 void LogData::doSetDisplayEncoding( const char* encoding )
 {
     LOG_DEBUG << "AbstractLogData::setDisplayEncoding: " << encoding;
     codec_.setCodec( QTextCodec::codecForName( encoding ) );
+    ++contentGeneration_;
+    searchResultsCache_->setSearchContext( codec_.mibEnum(), prefilterPattern_ );
+    clearLongLineIndexes();
     auto needReload = false;
     auto useGuessedCodec = false;
 
@@ -326,19 +646,127 @@ QString LogData::doGetExpandedLineString( LineNumber line ) const
 // indexingFinished).
 klogg::vector<QString> LogData::doGetLines( LineNumber first_line, LinesCount number ) const
 {
-    return getLinesFromFile( first_line, number, []( QString&& lineData ) {
-        if ( lineData.endsWith( QChar::CarriageReturn ) ) {
-            lineData.chop( 1 );
-        }
-        return std::move( lineData );
-    } );
+    return getLinesFromFile( first_line, number, chopCarriageReturn );
 }
 
 klogg::vector<QString> LogData::doGetExpandedLines( LineNumber first_line, LinesCount number ) const
 {
-    return getLinesFromFile( first_line, number, []( QString&& lineData ) {
-        return untabify( std::move( lineData ) );
-    } );
+    return getLinesFromFile( first_line, number, expandTabs );
+}
+
+klogg::vector<QString> LogData::getScatteredLines( const klogg::vector<LineNumber>& lines ) const
+{
+    return getScatteredLinesFromFile( lines, chopCarriageReturn );
+}
+
+klogg::vector<QString>
+LogData::getScatteredExpandedLines( const klogg::vector<LineNumber>& lines ) const
+{
+    return getScatteredLinesFromFile( lines, expandTabs );
+}
+
+LineLength LogData::getScatteredLinesMaxLength( const klogg::vector<LineNumber>& lines ) const
+{
+    auto maxLength = 0_length;
+    const auto nbLines = getNbLine();
+
+    // Long lines are measured with their index instead of being decoded
+    klogg::vector<LineNumber> shortLines;
+    shortLines.reserve( lines.size() );
+    for ( const auto& line : lines ) {
+        if ( line >= nbLines ) {
+            break;
+        }
+        else if ( doIsLongLine( line ) ) {
+            maxLength = qMax( maxLength, doGetLineLength( line ) );
+        }
+        else {
+            shortLines.push_back( line );
+        }
+    }
+
+    for ( const auto& line : getScatteredExpandedLines( shortLines ) ) {
+        maxLength = qMax( maxLength, LineLength{ line.size() } );
+    }
+
+    return maxLength;
+}
+
+std::optional<klogg::vector<AbstractLogData::ByteRange>>
+LogData::doGetLinesByteRanges( LineNumber first, LinesCount number ) const
+{
+    IndexingData::ConstAccessor scopedAccessor{ indexing_data_.get() };
+    if ( !prefilterPattern_.isEmpty() ) {
+        // The prefilter removes parts of the lines
+        return {};
+    }
+
+    klogg::vector<ByteRange> ranges;
+    if ( number.get() == 0 ) {
+        return ranges;
+    }
+
+    if ( ( first + number ).get() > scopedAccessor.getNbLines().get() ) {
+        LOG_WARNING << "Lines out of bound asked for";
+        return ranges;
+    }
+
+    const auto begin
+        = first == 0_lnum ? 0 : scopedAccessor.getEndOfLineOffset( first - 1_lcount ).get();
+    const auto end = scopedAccessor.getEndOfLineOffset( first + number - 1_lcount ).get();
+    ranges.push_back( { begin, end } );
+
+    return ranges;
+}
+
+std::optional<klogg::vector<AbstractLogData::ByteRange>>
+LogData::getScatteredLinesByteRanges( const klogg::vector<LineNumber>& lines ) const
+{
+    IndexingData::ConstAccessor scopedAccessor{ indexing_data_.get() };
+    if ( !prefilterPattern_.isEmpty() ) {
+        return {};
+    }
+
+    const auto nbLines = scopedAccessor.getNbLines();
+    const auto maxRangeSize = LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+
+    klogg::vector<ByteRange> ranges;
+    auto rangeBegin = lines.cbegin();
+    while ( rangeBegin != lines.cend() && *rangeBegin < nbLines ) {
+        // Offsets of nearby lines are decoded together
+        auto rangeEnd = std::next( rangeBegin );
+        while ( rangeEnd != lines.cend() && *rangeEnd < nbLines
+                && *rangeEnd <= *std::prev( rangeEnd ) + MaxCoalescedLinesGap
+                && *rangeEnd - *rangeBegin < maxRangeSize ) {
+            ++rangeEnd;
+        }
+
+        const auto firstOffset = *rangeBegin == 0_lnum ? 0_lnum : *rangeBegin - 1_lcount;
+        const auto endOfLines = scopedAccessor.getEndOfLineOffsets(
+            firstOffset, ( *std::prev( rangeEnd ) - firstOffset ) + 1_lcount );
+
+        for ( auto line = rangeBegin; line != rangeEnd; ++line ) {
+            const auto index = static_cast<size_t>( ( *line - firstOffset ).get() );
+            const auto begin = *line == 0_lnum ? 0 : endOfLines[ index - 1 ].get();
+            const auto end = endOfLines[ index ].get();
+            if ( !ranges.empty() && ranges.back().end == begin ) {
+                ranges.back().end = end;
+            }
+            else {
+                ranges.push_back( { begin, end } );
+            }
+        }
+
+        rangeBegin = rangeEnd;
+    }
+
+    return ranges;
+}
+
+QString LogData::doGetFileName() const
+{
+    return indexingFileName_;
 }
 
 LineNumber LogData::doGetLineNumber( LineNumber index ) const
@@ -348,6 +776,8 @@ LineNumber LogData::doGetLineNumber( LineNumber index ) const
 
 LogData::RawLines LogData::getLinesRaw( LineNumber firstLine, LinesCount number ) const
 {
+    KLOGG_TRACE_SCOPE( "LogData::getLinesRaw" );
+
     RawLines rawLines;
     rawLines.startLine = firstLine;
 
@@ -437,6 +867,52 @@ klogg::vector<QString> LogData::getLinesFromFile( LineNumber firstLine, LinesCou
     return processedLines;
 }
 
+klogg::vector<QString>
+LogData::getScatteredLinesFromFile( const klogg::vector<LineNumber>& lines,
+                                    QString ( *processLine )( QString&& ) ) const
+{
+    LOG_DEBUG << "scattered lines nb:" << lines.size();
+
+    klogg::vector<QString> processedLines;
+    processedLines.reserve( lines.size() );
+
+    const auto maxRangeSize = LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+
+    try {
+        auto rangeBegin = lines.cbegin();
+        while ( rangeBegin != lines.cend() ) {
+            // Extend the range while the next line is close enough
+            auto rangeEnd = std::next( rangeBegin );
+            while ( rangeEnd != lines.cend()
+                    && *rangeEnd <= *std::prev( rangeEnd ) + MaxCoalescedLinesGap
+                    && *rangeEnd - *rangeBegin < maxRangeSize ) {
+                ++rangeEnd;
+            }
+
+            const auto firstLine = *rangeBegin;
+            const auto rawLines
+                = getLinesRaw( firstLine, ( *std::prev( rangeEnd ) - firstLine ) + 1_lcount );
+
+            for ( auto line = rangeBegin; line != rangeEnd; ++line ) {
+                processedLines.push_back( processLine(
+                    rawLines.decodeLine( static_cast<size_t>( ( *line - firstLine ).get() ) ) ) );
+            }
+
+            rangeBegin = rangeEnd;
+        }
+    } catch ( const std::bad_alloc& e ) {
+        LOG_ERROR << "not enough memory " << e.what();
+        processedLines.emplace_back( "KLOGG WARNING: not enough memory" );
+    }
+
+    while ( processedLines.size() < lines.size() ) {
+        processedLines.emplace_back( "KLOGG WARNING: failed to read some lines before this one" );
+    }
+
+    return processedLines;
+}
+
 QTextCodec* LogData::getDetectedEncoding() const
 {
     return IndexingData::ConstAccessor{ indexing_data_.get() }.getEncodingGuess();
@@ -506,8 +982,40 @@ klogg::vector<QString> LogData::RawLines::decodeLines() const
     return decodedLines;
 }
 
+QString LogData::RawLines::decodeLine( size_t index ) const
+{
+    if ( index >= endOfLines.size() ) {
+        return QString( "KLOGG WARNING: file read failed" );
+    }
+
+    const qint64 lineStart = index == 0 ? 0 : endOfLines[ index - 1 ];
+    const auto length
+        = endOfLines[ index ] - lineStart - textDecoder.encodingParams.lineFeedWidth;
+
+    constexpr auto maxlength = std::numeric_limits<int>::max() / 2;
+    if ( length >= maxlength ) {
+        return QString( "KLOGG WARNING: this line is too long" );
+    }
+
+    if ( lineStart + length > klogg::ssize( buffer ) ) {
+        LOG_WARNING << "not enough data in buffer";
+        return QString( "KLOGG WARNING: file read failed" );
+    }
+
+    auto decodedLine = textDecoder.decoder->toUnicode( buffer.data() + lineStart,
+                                                       type_safe::narrow_cast<int>( length ) );
+
+    if ( !prefilterPattern.pattern().isEmpty() ) {
+        decodedLine.remove( prefilterPattern );
+    }
+
+    return decodedLine;
+}
+
 klogg::vector<std::string_view> LogData::RawLines::buildUtf8View() const
 {
+    KLOGG_TRACE_SCOPE( "RawLines::buildUtf8View" );
+
     klogg::vector<std::string_view> lines;
     if ( this->endOfLines.empty() || textDecoder.decoder == nullptr ) {
         return lines;
@@ -63,6 +63,7 @@
 #include "progress.h"
 #include "readablesize.h"
 #include "runnable_lambda.h"
+#include "tracing.h"
 
 #include "logdataworker.h"
 
@@ -428,7 +429,7 @@ findNextLineFeed( const klogg::vector<char>& block, int posWithinBlock, const In
 
 FastLinePositionArray IndexOperation::parseDataBlock( OffsetInFile::UnderlyingType blockBeginning,
                                                       const klogg::vector<char>& block,
-                                                      IndexingState& state ) const
+                                                      IndexingState& state )
 {
     using namespace parse_data_block;
 
@@ -513,6 +514,8 @@ std::chrono::microseconds IndexOperation::readFileInBlocks( QFile& file,
     using namespace std::chrono;
     using clock = high_resolution_clock;
 
+    KLOGG_TRACE_SCOPE( "IndexOperation::readFileInBlocks" );
+
     LOG_INFO << "Starting IO thread";
 
     int sentBlocksCount = 0;
@@ -527,8 +530,10 @@ std::chrono::microseconds IndexOperation::readFileInBlocks( QFile& file,
         BlockData blockData{ file.pos(), new klogg::vector<char>( IndexingBlockSize ) };
 
         clock::time_point ioT1 = clock::now();
-        const auto readBytes
-            = file.read( blockData.second->data(), klogg::ssize( *blockData.second ) );
+        const auto readBytes = [ &file, &blockData ] {
+            KLOGG_TRACE_SCOPE( "IndexOperation::readBlock" );
+            return file.read( blockData.second->data(), klogg::ssize( *blockData.second ) );
+        }();
 
         if ( readBytes < 0 ) {
             LOG_ERROR << "Reading past the end of file";
@@ -547,8 +552,11 @@ std::chrono::microseconds IndexOperation::readFileInBlocks( QFile& file,
             LOG_INFO << "Sending block " << blockData.first << " size " << blockData.second->size();
         }
 
-        while ( !blockPrefetcher.try_put( std::move( blockData ) ) && !interruptRequest_ ) {
-            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        {
+            KLOGG_TRACE_SCOPE( "IndexOperation::waitForParser" );
+            while ( !blockPrefetcher.try_put( std::move( blockData ) ) && !interruptRequest_ ) {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+            }
         }
         sentBlocksCount++;
     }
@@ -564,6 +572,8 @@ std::chrono::microseconds IndexOperation::readFileInBlocks( QFile& file,
 
 void IndexOperation::indexNextBlock( IndexingState& state, const BlockData& blockData )
 {
+    KLOGG_TRACE_SCOPE( "IndexOperation::indexNextBlock" );
+
     const auto& blockBeginning = blockData.first;
     const auto& block = *blockData.second;
 
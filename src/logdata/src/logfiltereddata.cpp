@@ -46,10 +46,11 @@
 #include <QString>
 #include <QTimer>
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
-#include <numeric>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "logdata.h"
@@ -57,15 +58,18 @@
 
 #include "configuration.h"
 #include "readablesize.h"
+#include "searchresultscache.h"
 #include "synchronization.h"
 
 // Usual constructor: just copy the data, the search is started by runSearch()
-LogFilteredData::LogFilteredData( const LogData* logData )
+LogFilteredData::LogFilteredData( const LogData* logData,
+                                  std::shared_ptr<LogFilteredData> parentData )
     : AbstractLogData()
     , matching_lines_( SearchResultArray() )
     , currentRegExp_()
     , visibility_()
     , workerThread_( *logData )
+    , parentData_( std::move( parentData ) )
 {
     // Starts with an empty result list
     maxLength_ = 0_length;
@@ -79,6 +83,8 @@ LogFilteredData::LogFilteredData( const LogData* logData )
     // Forward the update signal
     connect( &workerThread_, &LogFilteredDataWorker::searchProgressed, this,
              &LogFilteredData::handleSearchProgressed );
+    connect( &workerThread_, &LogFilteredDataWorker::searchEstimated, this,
+             &LogFilteredData::searchEstimated );
 
     searchProgressThrottler_.setTimeout( 100 );
     connect( this, &LogFilteredData::searchProgressedThrottled, &searchProgressThrottler_,
@@ -86,6 +92,13 @@ LogFilteredData::LogFilteredData( const LogData* logData )
 
     connect( &searchProgressThrottler_, &KDToolBox::KDGenericSignalThrottler::triggered, this,
              &LogFilteredData::handleSearchProgressedThrottled );
+
+    if ( parentData_ ) {
+        connect( parentData_.get(), &LogFilteredData::matchesAdded, this,
+                 &LogFilteredData::handleParentMatchesAdded );
+        connect( parentData_.get(), &LogFilteredData::matchesCleared, this,
+                 &LogFilteredData::handleParentMatchesCleared );
+    }
 }
 
 void LogFilteredData::runSearch( const RegularExpressionPattern& regExp )
@@ -95,7 +108,7 @@ void LogFilteredData::runSearch( const RegularExpressionPattern& regExp )
 
 // Run the search and send newDataAvailable() signals.
 void LogFilteredData::runSearch( const RegularExpressionPattern& regExp, LineNumber startLine,
-                                 LineNumber endLine )
+                                 LineNumber endLine, OptionalLineNumber priorityLine )
 {
     LOG_DEBUG << "Entering runSearch";
 
@@ -107,32 +120,78 @@ void LogFilteredData::runSearch( const RegularExpressionPattern& regExp, LineNum
     LOG_INFO << "Search cache key: " << regExp.pattern << "_" << startLine.get() << "_"
              << endLine.get();
 
-    bool shouldRunSearch = true;
+    if ( parentData_ ) {
+        // Results of nested searches depend on the parent, they are not cached
+        searchedDomain_ = parentData_->matching_lines_;
+        isSearchRunning_ = true;
+
+        attachReader();
+        workerThread_.search( currentRegExp_, startLine, endLine, searchedDomain_ );
+        return;
+    }
+
     if ( config.useSearchResultsCache() ) {
-        const auto cachedResults = searchResultsCache_.find( currentSearchKey_ );
-        if ( cachedResults != std::end( searchResultsCache_ ) ) {
-            LOG_INFO << "Got result from cache";
-            shouldRunSearch = false;
-            matching_lines_ = cachedResults->second.matching_lines;
-            maxLength_ = cachedResults->second.maxLength;
+        const auto cachedResults
+            = sourceLogData_->searchResultsCache().find( regExp, startLine, endLine );
+        if ( cachedResults ) {
+            LOG_INFO << "Got result from cache, searched until " << cachedResults->searchedUntil;
+            auto resumeLine = cachedResults->searchedUntil;
+            {
+                UniqueLock lock( resultsMutex_ );
+                matching_lines_ = cachedResults->matchingLines;
+
+                // If the file has grown since, only the new lines are searched. The last
+                // cached line is searched again as it might have been incomplete.
+                if ( resumeLine < endLine && resumeLine > startLine ) {
+                    --resumeLine;
+                    matching_lines_.remove( resumeLine.get() );
+                }
+
+                marks_and_matches_ = matching_lines_ | marks_;
+                invalidateCursors();
+            }
+            matchesHistogram_.assign( matching_lines_ );
+            maxLength_ = cachedResults->maxLength;
+            nbLinesProcessed_ = LinesCount( cachedResults->searchedUntil.get() );
+
+            if ( cachedResults->searchedUntil >= endLine ) {
+                Q_EMIT searchProgressed( LinesCount( matching_lines_.cardinality() ), 100,
+                                         startLine );
+                Q_EMIT matchesAdded();
+                return;
+            }
 
-            marks_and_matches_ = matching_lines_ | marks_;
+            Q_EMIT matchesAdded();
 
-            Q_EMIT searchProgressed( LinesCount( matching_lines_.cardinality() ), 100, startLine );
+            isSearchRunning_ = true;
+            attachReader();
+            workerThread_.resumeSearch( currentRegExp_, startLine, endLine, resumeLine,
+                                        LinesCount( matching_lines_.cardinality() ), maxLength_ );
+            return;
         }
     }
 
-    if ( shouldRunSearch ) {
-        attachReader();
-        workerThread_.search( currentRegExp_, startLine, endLine );
-    }
+    isSearchRunning_ = true;
+    attachReader();
+    workerThread_.search( currentRegExp_, startLine, endLine, {}, priorityLine );
 }
 
 void LogFilteredData::updateSearch( LineNumber startLine, LineNumber endLine )
 {
     LOG_DEBUG << "Entering updateSearch";
 
-    currentSearchKey_ = {};
+    if ( parentData_ ) {
+        // New lines will come from the parent's matches
+        std::get<1>( currentSearchKey_ ) = startLine.get();
+        std::get<2>( currentSearchKey_ ) = endLine.get();
+        parentData_->updateSearch( startLine, endLine );
+        return;
+    }
+
+    // Extended results will replace the cached ones
+    std::get<1>( currentSearchKey_ ) = startLine.get();
+    std::get<2>( currentSearchKey_ ) = endLine.get();
+    isSearchRunning_ = true;
 
     attachReader();
     workerThread_.updateSearch( currentRegExp_, startLine, endLine,
@@ -151,13 +210,98 @@ void LogFilteredData::clearSearch( bool dropCache )
     interruptSearch();
 
     currentRegExp_ = {};
-    matching_lines_ = {};
-    marks_and_matches_ = marks_;
+    {
+        UniqueLock lock( resultsMutex_ );
+        matching_lines_ = {};
+        marks_and_matches_ = marks_;
+        invalidateCursors();
+    }
+    matchesHistogram_.clear();
     maxLength_ = 0_length;
     nbLinesProcessed_ = 0_lcount;
 
+    searchedDomain_ = {};
+    hasPendingParentMatches_ = false;
+
     if ( dropCache ) {
-        searchResultsCache_.clear();
+        sourceLogData_->searchResultsCache().clear();
+    }
+
+    Q_EMIT matchesCleared();
+}
+
+std::shared_ptr<LogFilteredData> LogFilteredData::parentData() const
+{
+    return parentData_;
+}
+
+const LogData* LogFilteredData::sourceLogData() const
+{
+    return sourceLogData_;
+}
+
+SearchResultArray LogFilteredData::getSourceLines( LineNumber firstIndex,
+                                                   LinesCount number ) const
+{
+    SharedLock resultsLock( resultsMutex_ );
+    const auto& currentResults = currentResultArray();
+
+    const auto nbLines = currentResults.cardinality();
+    if ( number.get() == 0 || firstIndex.get() >= nbLines ) {
+        return {};
+    }
+
+    const auto lastIndex = qMin( firstIndex.get() + number.get(), nbLines ) - 1;
+    if ( firstIndex.get() == 0 && lastIndex == nbLines - 1 ) {
+        return currentResults;
+    }
+
+    LineNumber::UnderlyingType firstLine = {};
+    LineNumber::UnderlyingType lastLine = {};
+    {
+        ScopedLock lock( cursorsMutex_ );
+        resultsCursor_.select( currentResults, firstIndex.get(), &firstLine );
+        resultsCursor_.select( currentResults, lastIndex, &lastLine );
+    }
+
+    SearchResultArray lines;
+    lines.addRange( firstLine, lastLine + 1 );
+    lines &= currentResults;
+    return lines;
+}
+
+void LogFilteredData::extendSearchToParentMatches()
+{
+    if ( currentRegExp_.pattern.isEmpty() ) {
+        return;
+    }
+
+    if ( isSearchRunning_ ) {
+        hasPendingParentMatches_ = true;
+        return;
+    }
+    hasPendingParentMatches_ = false;
+
+    auto newDomain = parentData_->matching_lines_ - searchedDomain_;
+    if ( newDomain.isEmpty() ) {
+        return;
+    }
+
+    LOG_DEBUG << "Extending nested search to " << newDomain.cardinality() << " lines";
+
+    const auto isRestart = searchedDomain_.isEmpty();
+    searchedDomain_ |= newDomain;
+    isSearchRunning_ = true;
+
+    attachReader();
+    const auto startLine = LineNumber( std::get<1>( currentSearchKey_ ) );
+    const auto endLine = LineNumber( std::get<2>( currentSearchKey_ ) );
+    if ( isRestart ) {
+        // Nothing is kept from the matches of a cleared parent
+        workerThread_.search( currentRegExp_, startLine, endLine, std::move( newDomain ) );
+    }
+    else {
+        workerThread_.extendSearch( currentRegExp_, startLine, endLine, std::move( newDomain ) );
     }
 }
 
@@ -171,9 +315,16 @@ LineNumber LogFilteredData::getLineIndexNumber( LineNumber lineNumber ) const
     return findFilteredLine( lineNumber );
 }
 
+OptionalLineNumber LogFilteredData::takeFirstNewMatch()
+{
+    ScopedLock lock( searchProgressMutex_ );
+    return std::exchange( firstNewMatch_, {} );
+}
+
 // Scan the list for the 'lineNumber' passed
 bool LogFilteredData::isLineMatched( LineNumber lineNumber ) const
 {
+    SharedLock lock( resultsMutex_ );
     return matching_lines_.contains( lineNumber.get() );
 }
 
@@ -223,16 +374,36 @@ void LogFilteredData::iterateOverLines( const std::function<void( LineNumber )>&
         static_cast<void*>( const_cast<CallbackFn*>( &callback ) ) );
 }
 
+const LinesHistogram& LogFilteredData::matchesHistogram() const
+{
+    return matchesHistogram_;
+}
+
+const LinesHistogram& LogFilteredData::marksHistogram() const
+{
+    return marksHistogram_;
+}
+
 // Delegation to our Marks object
 
 void LogFilteredData::toggleMark( LineNumber line )
 {
     if ( ( line >= 0_lnum ) && line < sourceLogData_->getNbLine() ) {
-        if ( !marks_.addChecked( line.get() ) ) {
-            marks_.remove( line.get() );
-            updateMaxLengthMarks( {}, line );
+        auto isNewMark = false;
+        {
+            UniqueLock lock( resultsMutex_ );
+            isNewMark = marks_.addChecked( line.get() );
+            if ( isNewMark ) {
+                marks_and_matches_.add( line.get() );
+                invalidateCursors( line );
+            }
+        }
+
+        if ( !isNewMark ) {
+            deleteMark( line );
         }
         else {
+            marksHistogram_.add( line );
             updateMaxLengthMarks( line, {} );
         }
     }
@@ -244,7 +415,16 @@ void LogFilteredData::toggleMark( LineNumber line )
 void LogFilteredData::addMark( LineNumber line )
 {
     if ( ( line >= 0_lnum ) && line < sourceLogData_->getNbLine() ) {
-        marks_.add( line.get() );
+        auto isNewMark = false;
+        {
+            UniqueLock lock( resultsMutex_ );
+            isNewMark = marks_.addChecked( line.get() );
+            marks_and_matches_.add( line.get() );
+            invalidateCursors( line );
+        }
+        if ( isNewMark ) {
+            marksHistogram_.add( line );
+        }
         updateMaxLengthMarks( line, {} );
     }
     else {
@@ -252,17 +432,69 @@ void LogFilteredData::addMark( LineNumber line )
     }
 }
 
+void LogFilteredData::addMarks( const klogg::vector<LineNumber>& lines )
+{
+    const auto nbLines = sourceLogData_->getNbLine();
+
+    SearchResultArray newMarks;
+    for ( const auto& line : lines ) {
+        if ( line < nbLines ) {
+            newMarks.add( line.get() );
+        }
+        else {
+            LOG_ERROR << "LogFilteredData::addMarks trying to create a mark outside of the file.";
+        }
+    }
+
+    insertMarks( std::move( newMarks ) );
+}
+
+void LogFilteredData::addMarks( LineNumber firstLine, LinesCount nbLines )
+{
+    const auto endLine
+        = qMin( firstLine + nbLines, LineNumber( sourceLogData_->getNbLine().get() ) );
+    if ( firstLine >= endLine ) {
+        LOG_ERROR << "LogFilteredData::addMarks trying to create marks outside of the file.";
+        return;
+    }
+
+    SearchResultArray newMarks;
+    newMarks.addRange( firstLine.get(), endLine.get() );
+    insertMarks( std::move( newMarks ) );
+}
+
+void LogFilteredData::insertMarks( SearchResultArray newMarks )
+{
+    newMarks -= marks_;
+    if ( newMarks.isEmpty() ) {
+        return;
+    }
+
+    {
+        UniqueLock lock( resultsMutex_ );
+        marks_ |= newMarks;
+        marks_and_matches_ |= newMarks;
+        invalidateCursors( LineNumber( newMarks.minimum() ) );
+    }
+    marksHistogram_.add( newMarks );
+
+    maxLengthMarks_ = qMax( maxLengthMarks_, getMaxLineLength( newMarks ) );
+}
+
 bool LogFilteredData::isLineMarked( LineNumber line ) const
 {
+    SharedLock lock( resultsMutex_ );
     return marks_.contains( line.get() );
 }
 
 OptionalLineNumber LogFilteredData::getMarkAfter( LineNumber line ) const
 {
     OptionalLineNumber marked_line;
-    const LineNumber::UnderlyingType rank = marks_.rank( line.get() );
+    SharedLock resultsLock( resultsMutex_ );
+    ScopedLock lock( cursorsMutex_ );
+    const LineNumber::UnderlyingType rank = marksCursor_.rank( marks_, line.get() );
     LineNumber::UnderlyingType nextMark;
-    if ( marks_.select( rank, &nextMark ) ) {
+    if ( marksCursor_.select( marks_, rank, &nextMark ) ) {
         marked_line = LineNumber( nextMark );
     }
 
@@ -273,14 +505,16 @@ OptionalLineNumber LogFilteredData::getMarkBefore( LineNumber line ) const
 {
     OptionalLineNumber marked_line;
 
-    const LineNumber::UnderlyingType rank = marks_.rank( line.get() );
+    SharedLock resultsLock( resultsMutex_ );
+    ScopedLock lock( cursorsMutex_ );
+    const LineNumber::UnderlyingType rank = marksCursor_.rank( marks_, line.get() );
 
     if ( rank < 2 ) {
         return marked_line;
     }
 
     LineNumber::UnderlyingType nextMark;
-    if ( marks_.select( rank - 2, &nextMark ) ) {
+    if ( marksCursor_.select( marks_, rank - 2, &nextMark ) ) {
         marked_line = LineNumber( nextMark );
     }
 
@@ -289,15 +523,53 @@ OptionalLineNumber LogFilteredData::getMarkBefore( LineNumber line ) const
 
 void LogFilteredData::deleteMark( LineNumber line )
 {
-    marks_.remove( line.get() );
+    if ( marks_.contains( line.get() ) ) {
+        marksHistogram_.remove( line );
+    }
+    {
+        UniqueLock lock( resultsMutex_ );
+        marks_.remove( line.get() );
+        if ( !matching_lines_.contains( line.get() ) ) {
+            marks_and_matches_.remove( line.get() );
+        }
+        invalidateCursors( line );
+    }
     updateMaxLengthMarks( {}, line );
 }
 
+void LogFilteredData::deleteMarks( const klogg::vector<LineNumber>& lines )
+{
+    SearchResultArray removedMarks;
+    for ( const auto& line : lines ) {
+        removedMarks.add( line.get() );
+    }
+
+    removeMarks( std::move( removedMarks ) );
+}
+
+void LogFilteredData::removeMarks( SearchResultArray removedMarks )
+{
+    removedMarks &= marks_;
+    if ( removedMarks.isEmpty() ) {
+        return;
+    }
+
+    {
+        UniqueLock lock( resultsMutex_ );
+        marks_ -= removedMarks;
+        marks_and_matches_ -= removedMarks - matching_lines_;
+        invalidateCursors( LineNumber( removedMarks.minimum() ) );
+    }
+    marksHistogram_.remove( removedMarks );
+
+    if ( getMaxLineLength( removedMarks ) >= maxLengthMarks_ ) {
+        recalculateMaxLengthMarks();
+    }
+}
+
 void LogFilteredData::updateMaxLengthMarks( OptionalLineNumber added_line,
                                             OptionalLineNumber removed_line )
 {
-    marks_and_matches_ = matching_lines_ | marks_;
-
     if ( added_line.has_value() ) {
         maxLengthMarks_ = qMax( maxLengthMarks_, sourceLogData_->getLineLength( *added_line ) );
     }
@@ -305,23 +577,48 @@ void LogFilteredData::updateMaxLengthMarks( OptionalLineNumber added_line,
     // Now update the max length if needed
     if ( removed_line.has_value()
          && sourceLogData_->getLineLength( *removed_line ) >= maxLengthMarks_ ) {
-        LOG_DEBUG << "deleteMark recalculating longest mark";
-        maxLengthMarks_ = 0_length;
-        marks_.iterate(
-            []( uint64_t line, void* context ) -> bool {
-                auto* self = static_cast<LogFilteredData*>( context );
-                self->maxLengthMarks_
-                    = qMax( self->maxLengthMarks_,
-                            self->sourceLogData_->getLineLength( LineNumber( line ) ) );
-                return true;
-            },
-            static_cast<void*>( this ) );
+        recalculateMaxLengthMarks();
     }
 }
 
+void LogFilteredData::recalculateMaxLengthMarks()
+{
+    LOG_DEBUG << "deleteMark recalculating longest mark";
+    maxLengthMarks_ = getMaxLineLength( marks_ );
+}
+
+LineLength LogFilteredData::getMaxLineLength( const SearchResultArray& lines ) const
+{
+    const auto batchSize
+        = static_cast<size_t>( std::max( 1, Configuration::get().searchReadBufferSizeLines() ) );
+
+    auto maxLength = 0_length;
+    klogg::vector<LineNumber> batch;
+    batch.reserve( std::min( batchSize, static_cast<size_t>( lines.cardinality() ) ) );
+    for ( const auto line : lines ) {
+        batch.push_back( LineNumber( line ) );
+        if ( batch.size() == batchSize ) {
+            maxLength = qMax( maxLength, sourceLogData_->getScatteredLinesMaxLength( batch ) );
+            batch.clear();
+        }
+    }
+
+    if ( !batch.empty() ) {
+        maxLength = qMax( maxLength, sourceLogData_->getScatteredLinesMaxLength( batch ) );
+    }
+
+    return maxLength;
+}
+
 void LogFilteredData::clearMarks()
 {
-    marks_ = {};
+    {
+        UniqueLock lock( resultsMutex_ );
+        marks_and_matches_ -= marks_ - matching_lines_;
+        marks_ = {};
+        invalidateCursors();
+    }
+    marksHistogram_.clear();
     maxLengthMarks_ = 0_length;
 }
 
@@ -340,6 +637,7 @@ QList<LineNumber> LogFilteredData::getMarks() const
 
 void LogFilteredData::setVisibility( Visibility visi )
 {
+    UniqueLock lock( resultsMutex_ );
     visibility_ = visi;
 }
 
@@ -359,75 +657,106 @@ void LogFilteredData::updateSearchResultsCache()
         return;
     }
 
-    const uint64_t maxCacheLines = config.searchResultsCacheLines();
-
-    if ( matching_lines_.cardinality() > maxCacheLines ) {
-        LOG_DEBUG << "LogFilteredData: too many matches to place in cache";
-    }
-    else {
-        LOG_INFO << "LogFilteredData: caching results for key "
-                 << std::get<0>( currentSearchKey_ ).pattern << "_"
-                 << std::get<1>( currentSearchKey_ ) << "_" << std::get<2>( currentSearchKey_ );
-
-        searchResultsCache_[ currentSearchKey_ ] = { matching_lines_, maxLength_ };
-        auto cacheSize = std::accumulate( searchResultsCache_.cbegin(), searchResultsCache_.cend(),
-                                          uint64_t{ 0 }, []( const auto& acc, const auto& next ) {
-                                              return acc + next.second.matching_lines.cardinality();
-                                          } );
-
-        LOG_INFO << "LogFilteredData: cache size " << cacheSize;
+    LOG_INFO << "LogFilteredData: caching results for key "
+             << std::get<0>( currentSearchKey_ ).pattern << "_"
+             << std::get<1>( currentSearchKey_ ) << "_" << std::get<2>( currentSearchKey_ );
 
-        auto cachedResult = std::begin( searchResultsCache_ );
-        while ( cachedResult != std::end( searchResultsCache_ ) && cacheSize > maxCacheLines ) {
-
-            if ( cachedResult->first == currentSearchKey_ ) {
-                ++cachedResult;
-                continue;
-            }
-
-            cacheSize -= cachedResult->second.matching_lines.cardinality();
-            cachedResult = searchResultsCache_.erase( cachedResult );
-        }
-    }
+    sourceLogData_->searchResultsCache().insert(
+        std::get<0>( currentSearchKey_ ), LineNumber( std::get<1>( currentSearchKey_ ) ),
+        { matching_lines_, maxLength_, LineNumber( nbLinesProcessed_.get() ) } );
 }
 
 //
 // Q_SLOTS:
 //
-void LogFilteredData::handleSearchProgressed( LinesCount nbMatches, int progress,
-                                              LineNumber initialLine )
+// The number of matches is the one of the merged results: the worker counts
+// the last line of a growing file again when it is searched again.
+void LogFilteredData::handleSearchProgressed( LinesCount, int progress, LineNumber initialLine )
 {
-    assert( nbMatches >= 0_lcount );
-
     const auto searchResults = workerThread_.getSearchResults();
 
-    matching_lines_ |= searchResults.newMatches;
-    marks_and_matches_ |= searchResults.newMatches;
+    const auto hasNewMatches = !searchResults.newMatches.isEmpty();
+    if ( hasNewMatches ) {
+        // Lines searched again (the last one of a growing file) can be matched twice
+        matchesHistogram_.add( searchResults.newMatches - matching_lines_ );
+    }
+    if ( hasNewMatches ) {
+        UniqueLock lock( resultsMutex_ );
+        matching_lines_ |= searchResults.newMatches;
+        marks_and_matches_ |= searchResults.newMatches;
+        invalidateMatchesCursor( LineNumber( searchResults.newMatches.minimum() ) );
+    }
 
     maxLength_ = searchResults.maxLength;
     nbLinesProcessed_ = searchResults.processedLines;
 
-    if ( progress == 100
-         && nbLinesProcessed_.get() == getExpectedSearchEnd( currentSearchKey_ ).get() ) {
+    if ( progress == 100 && !parentData_
+         && nbLinesProcessed_.get() >= getExpectedSearchEnd( currentSearchKey_ ).get() ) {
         updateSearchResultsCache();
     }
 
     {
         ScopedLock lock( searchProgressMutex_ );
-        searchProgress_ = std::make_tuple( nbMatches, progress, initialLine );
+        searchProgress_ = std::make_tuple( LinesCount( matching_lines_.cardinality() ), progress,
+                                           initialLine );
+        if ( hasNewMatches ) {
+            const auto firstNewMatch = LineNumber( searchResults.newMatches.minimum() );
+            firstNewMatch_ = firstNewMatch_ ? qMin( *firstNewMatch_, firstNewMatch )
+                                            : firstNewMatch;
+        }
     }
 
     Q_EMIT searchProgressedThrottled();
 
+    if ( hasNewMatches ) {
+        Q_EMIT matchesAdded();
+    }
+
     if ( progress == 100 ) {
         detachReader();
+        isSearchRunning_ = false;
 
         LOG_INFO << "Matches size " << readableSize( matching_lines_.getSizeInBytes( false ) )
                  << ", marks size " << readableSize( marks_.getSizeInBytes( false ) )
                  << ", union size " << readableSize( marks_and_matches_.getSizeInBytes( false ) );
+
+        if ( hasPendingParentMatches_ ) {
+            extendSearchToParentMatches();
+        }
     }
 }
 
+void LogFilteredData::handleParentMatchesAdded()
+{
+    extendSearchToParentMatches();
+}
+
+void LogFilteredData::handleParentMatchesCleared()
+{
+    LOG_DEBUG << "Parent matches cleared, restarting nested search";
+
+    // Keep the pattern, the search restarts from the new matches of the parent
+    const auto regExp = currentRegExp_;
+    clearSearch();
+    currentRegExp_ = regExp;
+
+    // The stopped search doesn't send its progress anymore
+    workerThread_.clearResults();
+    if ( isSearchRunning_ ) {
+        detachReader();
+        isSearchRunning_ = false;
+    }
+
+    const auto initialLine = LineNumber( std::get<1>( currentSearchKey_ ) );
+    {
+        ScopedLock lock( searchProgressMutex_ );
+        searchProgress_ = std::make_tuple( 0_lcount, 100, initialLine );
+        firstNewMatch_ = {};
+    }
+
+    Q_EMIT searchProgressed( 0_lcount, 100, initialLine );
+}
+
 void LogFilteredData::handleSearchProgressedThrottled()
 {
     LinesCount nbMatches;
@@ -442,10 +771,12 @@ void LogFilteredData::handleSearchProgressedThrottled()
 
 LineNumber LogFilteredData::findLogDataLine( LineNumber index ) const
 {
+    SharedLock resultsLock( resultsMutex_ );
     const auto& currentResults = currentResultArray();
 
     LineNumber::UnderlyingType line = {};
-    if ( currentResults.select( index.get(), &line ) ) {
+    ScopedLock lock( cursorsMutex_ );
+    if ( resultsCursor_.select( currentResults, index.get(), &line ) ) {
         return LineNumber( line );
     }
     else {
@@ -457,6 +788,69 @@ LineNumber LogFilteredData::findLogDataLine( LineNumber index ) const
     }
 }
 
+klogg::vector<LineNumber> LogFilteredData::findLogDataLines( LineNumber firstLine,
+                                                            LinesCount number ) const
+{
+    klogg::vector<LineNumber> lines;
+    if ( number.get() == 0 ) {
+        return lines;
+    }
+
+    SharedLock resultsLock( resultsMutex_ );
+    const auto& currentResults = currentResultArray();
+
+    const auto nbLines = currentResults.cardinality();
+    if ( firstLine.get() + number.get() > nbLines ) {
+        LOG_ERROR << "Index too big in LogFilteredData: " << firstLine + number << " cache size "
+                  << nbLines;
+        if ( firstLine.get() >= nbLines ) {
+            return lines;
+        }
+        number = LinesCount( nbLines - firstLine.get() );
+    }
+
+    LineNumber::UnderlyingType firstLogDataLine = {};
+    LineNumber::UnderlyingType lastLogDataLine = {};
+    {
+        ScopedLock lock( cursorsMutex_ );
+        resultsCursor_.select( currentResults, firstLine.get(), &firstLogDataLine );
+        resultsCursor_.select( currentResults, ( firstLine + number - 1_lcount ).get(),
+                               &lastLogDataLine );
+    }
+
+    // Only the containers covering the requested lines are walked
+    SearchResultArray requestedLines;
+    requestedLines.addRange( firstLogDataLine, lastLogDataLine + 1 );
+    requestedLines &= currentResults;
+
+    lines.reserve( number.get() );
+    for ( const auto line : requestedLines ) {
+        lines.push_back( LineNumber( line ) );
+    }
+
+    return lines;
+}
+
+void LogFilteredData::invalidateCursors()
+{
+    ScopedLock lock( cursorsMutex_ );
+    resultsCursor_.invalidate();
+    marksCursor_.invalidate();
+}
+
+void LogFilteredData::invalidateMatchesCursor( LineNumber firstLine )
+{
+    ScopedLock lock( cursorsMutex_ );
+    resultsCursor_.invalidateFrom( firstLine.get() );
+}
+
+void LogFilteredData::invalidateCursors( LineNumber firstLine )
+{
+    ScopedLock lock( cursorsMutex_ );
+    resultsCursor_.invalidateFrom( firstLine.get() );
+    marksCursor_.invalidateFrom( firstLine.get() );
+}
+
 const SearchResultArray& LogFilteredData::currentResultArray() const
 {
     if ( visibility_.testFlag( VisibilityFlags::Marks )
@@ -473,7 +867,10 @@ const SearchResultArray& LogFilteredData::currentResultArray() const
 
 LineNumber LogFilteredData::findFilteredLine( LineNumber lineNum ) const
 {
-    LineNumber::UnderlyingType index = currentResultArray().rank( lineNum.get() );
+    SharedLock resultsLock( resultsMutex_ );
+    ScopedLock lock( cursorsMutex_ );
+    LineNumber::UnderlyingType index
+        = resultsCursor_.rank( currentResultArray(), lineNum.get() );
 
     if ( index > 0 ) {
         index--;
@@ -498,30 +895,18 @@ QString LogFilteredData::doGetExpandedLineString( LineNumber index ) const
 // Implementation of the virtual function.
 klogg::vector<QString> LogFilteredData::doGetLines( LineNumber first_line, LinesCount number ) const
 {
-    return doGetLines( first_line, number,
-                       [ this ]( const auto& line ) { return doGetLineString( line ); } );
+    auto lines = sourceLogData_->getScatteredLines( findLogDataLines( first_line, number ) );
+    lines.resize( number.get() );
+    return lines;
 }
 
 // Implementation of the virtual function.
 klogg::vector<QString> LogFilteredData::doGetExpandedLines( LineNumber first_line,
                                                           LinesCount number ) const
 {
-    return doGetLines( first_line, number,
-                       [ this ]( const auto& line ) { return doGetExpandedLineString( line ); } );
-}
-
-klogg::vector<QString>
-LogFilteredData::doGetLines( LineNumber first_line, LinesCount number,
-                             const std::function<QString( LineNumber )>& lineGetter ) const
-{
-    klogg::vector<LineNumber::UnderlyingType> lineNumbers( number.get() );
-    std::iota( lineNumbers.begin(), lineNumbers.end(), first_line.get() );
-
-    klogg::vector<QString> lines( number.get() );
-    std::transform(
-        lineNumbers.cbegin(), lineNumbers.cend(), lines.begin(),
-        [ &lineGetter ]( const auto& line ) { return lineGetter( LineNumber( line ) ); } );
-
+    auto lines
+        = sourceLogData_->getScatteredExpandedLines( findLogDataLines( first_line, number ) );
+    lines.resize( number.get() );
     return lines;
 }
 
@@ -533,6 +918,7 @@ LineNumber LogFilteredData::doGetLineNumber(LineNumber index) const
 // Implementation of the virtual function.
 LinesCount LogFilteredData::doGetNbLine() const
 {
+    SharedLock lock( resultsMutex_ );
     const LinesCount::UnderlyingType nbLines = currentResultArray().cardinality();
     return LinesCount( nbLines );
 }
@@ -550,6 +936,33 @@ LineLength LogFilteredData::doGetLineLength( LineNumber lineNum ) const
     return sourceLogData_->getLineLength( line );
 }
 
+// Implementation of the virtual function.
+bool LogFilteredData::doIsLongLine( LineNumber lineNum ) const
+{
+    return sourceLogData_->isLongLine( findLogDataLine( lineNum ) );
+}
+
+// Implementation of the virtual function.
+QString LogFilteredData::doGetExpandedLineWindow( LineNumber lineNum, LineColumn firstColumn,
+                                                  LineLength nbColumns ) const
+{
+    return sourceLogData_->getExpandedLineWindow( findLogDataLine( lineNum ), firstColumn,
+                                                  nbColumns );
+}
+
+// Implementation of the virtual function.
+std::optional<klogg::vector<AbstractLogData::ByteRange>>
+LogFilteredData::doGetLinesByteRanges( LineNumber first, LinesCount number ) const
+{
+    return sourceLogData_->getScatteredLinesByteRanges( findLogDataLines( first, number ) );
+}
+
+// Implementation of the virtual function.
+QString LogFilteredData::doGetFileName() const
+{
+    return sourceLogData_->getFileName();
+}
+
 void LogFilteredData::doSetDisplayEncoding( const char* encoding )
 {
     LOG_DEBUG << "AbstractLogData::setDisplayEncoding: " << encoding;
@@ -36,94 +36,25 @@
  * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <chrono>
-#include <cmath>
 #include <exception>
 #include <qsemaphore.h>
 #include <utility>
 
-#include <robin_hood.h>
-#include <tbb/flow_graph.h>
-#include <vector>
-
-#include "configuration.h"
 #include "dispatch_to.h"
 #include "issuereporter.h"
 #include "linetypes.h"
 #include "log.h"
-#include "progress.h"
 #include "runnable_lambda.h"
+#include "tracing.h"
 
+#include "configuration.h"
 #include "logdata.h"
-#include "regularexpression.h"
+#include "searchestimator.h"
+#include "searchscancoordinator.h"
 
 #include "logfiltereddataworker.h"
 #include "synchronization.h"
 
-namespace {
-struct PartialSearchResults {
-    PartialSearchResults() = default;
-
-    PartialSearchResults( const PartialSearchResults& ) = delete;
-    PartialSearchResults( PartialSearchResults&& ) = default;
-    PartialSearchResults& operator=( const PartialSearchResults& ) = delete;
-    PartialSearchResults& operator=( PartialSearchResults&& ) = default;
-
-    SearchResultArray matchingLines;
-    LineLength maxLength;
-
-    LineNumber chunkStart;
-    LinesCount processedLines;
-};
-
-struct SearchBlockData {
-    SearchBlockData() = default;
-    SearchBlockData( LineNumber start, LogData::RawLines blockLines )
-        : chunkStart( start )
-        , lines( std::move( blockLines ) )
-    {
-    }
-
-    SearchBlockData( const SearchBlockData& ) = delete;
-    SearchBlockData( SearchBlockData&& ) = default;
-
-    SearchBlockData& operator=( const SearchBlockData& ) = delete;
-    SearchBlockData& operator=( SearchBlockData&& ) = default;
-
-    LineNumber chunkStart;
-    LogData::RawLines lines;
-
-    PartialSearchResults searchResults;
-};
-
-PartialSearchResults filterLines( const PatternMatcher& matcher, const LogData::RawLines& rawLines,
-                                  LineNumber chunkStart )
-{
-    LOG_DEBUG << "Filter lines at " << chunkStart;
-    PartialSearchResults results;
-    results.chunkStart = chunkStart;
-    results.processedLines = LinesCount{ rawLines.endOfLines.size() };
-
-    const auto& lines = rawLines.buildUtf8View();
-
-    for ( auto offset = 0u; offset < lines.size(); ++offset ) {
-        const auto& line = lines[ offset ];
-
-        const auto hasMatch = matcher.hasMatch( line );
-
-        if ( hasMatch ) {
-            results.maxLength = qMax( results.maxLength, getUntabifiedLength( line ) );
-            const auto lineNumber = chunkStart + LinesCount{ offset };
-            results.matchingLines.add( lineNumber.get() );
-
-            // LOG_INFO << "Match at " << lineNumber << ": " << line;
-        }
-    }
-    return results;
-}
-
-} // namespace
-
 SearchResults SearchData::takeCurrentResults() const
 {
     UniqueLock lock( dataMutex_ );
@@ -171,6 +102,42 @@ void SearchData::clear()
     newMatches_ = {};
 }
 
+const PatternMatcher& SearchStreamingSession::matcher( const RegularExpressionPattern& regExp )
+{
+    if ( !pattern_ || !( *pattern_ == regExp ) ) {
+        LOG_INFO << "Compiling matcher for streaming search " << regExp.pattern;
+        expression_ = std::make_unique<RegularExpression>( regExp );
+        matcher_ = expression_->createMatcher();
+        pattern_ = regExp;
+    }
+
+    return *matcher_;
+}
+
+void SearchStreamingSession::matchLines( const LogData& sourceLogData,
+                                         const RegularExpressionPattern& regExp,
+                                         LineNumber initialLine, LineNumber endLine,
+                                         SearchData& searchData )
+{
+    const auto& lineMatcher = matcher( regExp );
+
+    const auto lines = sourceLogData.getLinesRaw( initialLine, endLine - initialLine );
+    const auto& utf8Lines = lines.buildUtf8View();
+
+    SearchResultArray matchingLines;
+    LineLength maxLength = 0_length;
+    for ( auto offset = 0u; offset < utf8Lines.size(); ++offset ) {
+        const auto& line = utf8Lines[ offset ];
+        if ( lineMatcher.hasMatch( line ) ) {
+            maxLength = qMax( maxLength, getUntabifiedLength( line ) );
+            matchingLines.add( ( initialLine + LinesCount{ offset } ).get() );
+        }
+    }
+
+    searchData.addAll( maxLength, matchingLines, LinesCount( matchingLines.cardinality() ),
+                       LinesCount( endLine.get() ) );
+}
+
 LogFilteredDataWorker::LogFilteredDataWorker( const LogData& sourceLogData )
     : sourceLogData_( sourceLogData )
 {
@@ -189,19 +156,39 @@ LogFilteredDataWorker::~LogFilteredDataWorker() noexcept
     }
 }
 
-void LogFilteredDataWorker::connectSignalsAndRun( SearchOperation* operationRequested )
+void LogFilteredDataWorker::connectSignalsAndRun( SearchOperation* operationRequested,
+                                                  uint64_t generation )
 {
+    // Signals are delivered in the thread of the worker, where the
+    // generation changes, so none is sent once the results are cleared.
     connect( operationRequested, &SearchOperation::searchProgressed, this,
-             &LogFilteredDataWorker::searchProgressed );
-    connect( operationRequested, &SearchOperation::searchFinished, this,
-             &LogFilteredDataWorker::searchFinished, Qt::QueuedConnection );
+             [ this, generation ]( LinesCount nbMatches, int percent, LineNumber initialLine ) {
+                 if ( generation == generation_ ) {
+                     Q_EMIT searchProgressed( nbMatches, percent, initialLine );
+                 }
+             } );
+    connect( operationRequested, &SearchOperation::searchEstimated, this,
+             [ this, generation ]( LinesCount estimate, LinesCount margin ) {
+                 if ( generation == generation_ ) {
+                     Q_EMIT searchEstimated( estimate, margin );
+                 }
+             } );
+    connect(
+        operationRequested, &SearchOperation::searchFinished, this,
+        [ this, generation ] {
+            if ( generation == generation_ ) {
+                Q_EMIT searchFinished();
+            }
+        },
+        Qt::QueuedConnection );
 
     operationRequested->run( searchData_ );
     operationRequested->disconnect( this );
 }
 
 void LogFilteredDataWorker::search( const RegularExpressionPattern& regExp, LineNumber startLine,
-                                    LineNumber endLine )
+                                    LineNumber endLine, std::optional<SearchResultArray> domain,
+                                    OptionalLineNumber priorityLine )
 {
     ScopedLock locker( operationsMutex_ ); // to protect operationRequested_
     operationsPool_.waitForDone();
@@ -209,13 +196,40 @@ void LogFilteredDataWorker::search( const RegularExpressionPattern& regExp, Line
 
     LOG_INFO << "Search requested";
     QSemaphore operationStarted;
-    operationsPool_.start( createRunnable( [ this, &operationStarted, regExp, startLine, endLine ] {
-        operationStarted.release();
-        ScopedLock operationLock( operationsMutex_ );
-        auto operationRequested = std::make_unique<FullSearchOperation>(
-            sourceLogData_, interruptRequested_, regExp, startLine, endLine );
-        connectSignalsAndRun( operationRequested.get() );
-    } ) );
+    operationsPool_.start( createRunnable(
+        [ this, &operationStarted, generation = generation_, regExp, startLine, endLine,
+          domain = std::move( domain ), priorityLine ] {
+            operationStarted.release();
+            ScopedLock operationLock( operationsMutex_ );
+            auto operationRequested = std::make_unique<FullSearchOperation>(
+                sourceLogData_, interruptRequested_, regExp, startLine, endLine, domain,
+                priorityLine );
+            connectSignalsAndRun( operationRequested.get(), generation );
+        } ) );
+    operationStarted.acquire();
+}
+
+void LogFilteredDataWorker::extendSearch( const RegularExpressionPattern& regExp,
+                                          LineNumber startLine, LineNumber endLine,
+                                          SearchResultArray domain )
+{
+    ScopedLock locker( operationsMutex_ ); // to protect operationRequested_
+    operationsPool_.waitForDone();
+    interruptRequested_.clear();
+
+    LOG_INFO << "Search extension requested for " << domain.cardinality() << " lines";
+
+    QSemaphore operationStarted;
+    operationsPool_.start( createRunnable(
+        [ this, &operationStarted, generation = generation_, regExp, startLine, endLine,
+          domain = std::move( domain ) ] {
+            operationStarted.release();
+            ScopedLock operationLock( operationsMutex_ );
+            auto operationRequested = std::make_unique<ExtendSearchOperation>(
+                sourceLogData_, interruptRequested_, regExp, startLine, endLine, domain );
+            connectSignalsAndRun( operationRequested.get(), generation );
+        } ) );
+
     operationStarted.acquire();
 }
 
@@ -231,23 +245,62 @@ void LogFilteredDataWorker::updateSearch( const RegularExpressionPattern& regExp
 
     QSemaphore operationStarted;
     operationsPool_.start(
-        createRunnable( [ this, &operationStarted, regExp, startLine, endLine, position ] {
+        createRunnable( [ this, &operationStarted, generation = generation_, regExp, startLine,
+                          endLine, position ] {
             operationStarted.release();
             ScopedLock operationLock( operationsMutex_ );
             auto operationRequested = std::make_unique<UpdateSearchOperation>(
-                sourceLogData_, interruptRequested_, regExp, startLine, endLine, position );
-            connectSignalsAndRun( operationRequested.get() );
+                sourceLogData_, interruptRequested_, regExp, startLine, endLine, position,
+                streamingSession_ );
+            connectSignalsAndRun( operationRequested.get(), generation );
         } ) );
 
     operationStarted.acquire();
 }
 
+void LogFilteredDataWorker::resumeSearch( const RegularExpressionPattern& regExp,
+                                          LineNumber startLine, LineNumber endLine,
+                                          LineNumber position, LinesCount nbMatches,
+                                          LineLength maxLength )
+{
+    ScopedLock locker( operationsMutex_ ); // to protect operationRequested_
+    operationsPool_.waitForDone();
+    interruptRequested_.clear();
+
+    LOG_INFO << "Search resume requested from " << position.get();
+
+    QSemaphore operationStarted;
+    operationsPool_.start( createRunnable( [ this, &operationStarted, generation = generation_,
+                                             regExp, startLine, endLine, position, nbMatches,
+                                             maxLength ] {
+        operationStarted.release();
+        ScopedLock operationLock( operationsMutex_ );
+        auto operationRequested = std::make_unique<ResumeSearchOperation>(
+            sourceLogData_, interruptRequested_, regExp, startLine, endLine, position, nbMatches,
+            maxLength );
+        connectSignalsAndRun( operationRequested.get(), generation );
+    } ) );
+
+    operationStarted.acquire();
+}
+
 void LogFilteredDataWorker::interrupt()
 {
     LOG_INFO << "Search interruption requested";
     interruptRequested_.set();
 }
 
+void LogFilteredDataWorker::clearResults()
+{
+    LOG_INFO << "Search results clear requested";
+    ++generation_;
+    interruptRequested_.set();
+
+    // Cleared once the interrupted operation is done, the next operation
+    // waits for it. SearchData is guarded by its own mutex.
+    operationsPool_.start( createRunnable( [ this ] { searchData_.clear(); } ) );
+}
+
 // This will do an atomic copy of the object
 SearchResults LogFilteredDataWorker::getSearchResults() const
 {
@@ -260,242 +313,172 @@ SearchResults LogFilteredDataWorker::getSearchResults() const
 
 SearchOperation::SearchOperation( const LogData& sourceLogData, AtomicFlag& interruptRequested,
                                   const RegularExpressionPattern& regExp, LineNumber startLine,
-                                  LineNumber endLine )
+                                  LineNumber endLine, std::optional<SearchResultArray> domain,
+                                  OptionalLineNumber priorityLine )
 
     : interruptRequested_( interruptRequested )
     , regexp_( regExp )
     , sourceLogData_( sourceLogData )
     , startLine_( startLine )
     , endLine_( endLine )
+    , domain_( std::move( domain ) )
+    , priorityLine_( priorityLine )
 
 {
 }
 
 void SearchOperation::doSearch( SearchData& searchData, LineNumber initialLine )
 {
-    const auto nbSourceLines = sourceLogData_.getNbLine();
-
-    LOG_INFO << "Searching from line " << initialLine << " to " << nbSourceLines;
-
-    using namespace std::chrono;
-    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    KLOGG_TRACE_SCOPE( "SearchOperation::doSearch" );
 
-    const auto& config = Configuration::get();
-    const auto matchingThreadsCount = static_cast<uint32_t>( [ &config ]() {
-        if ( !config.useParallelSearch() ) {
-            return 1;
-        }
-        const auto configuredThreadPoolSize = config.searchThreadPoolSize();
-        return qMax( 1, configuredThreadPoolSize == 0 ? tbb::info::default_concurrency()
-                                                      : configuredThreadPoolSize );
-    }() );
-
-    LOG_INFO << "Using " << matchingThreadsCount << " matching threads";
-
-    tbb::flow::graph searchGraph;
+    const auto nbSourceLines = sourceLogData_.getNbLine();
 
     if ( initialLine < startLine_ ) {
         initialLine = startLine_;
     }
 
     const auto endLine = qMin( LineNumber( nbSourceLines.get() ), endLine_ );
-    const auto nbLinesInChunk = LinesCount(
-        static_cast<LinesCount::UnderlyingType>( config.searchReadBufferSizeLines() ) );
-
-    std::chrono::microseconds fileReadingDuration{ 0 };
-
-    using BlockDataType = SearchBlockData*;
-    auto blockPrefetcher
-        = tbb::flow::limiter_node<BlockDataType>( searchGraph, matchingThreadsCount * 3 );
-
-    auto lineBlocksQueue = tbb::flow::buffer_node<BlockDataType>( searchGraph );
-
-    using RegexMatcherNode
-        = tbb::flow::function_node<BlockDataType, BlockDataType, tbb::flow::rejecting>;
-
-    using PatternMatcherPtr = std::unique_ptr<PatternMatcher>;
-    using MatcherContext = std::tuple<PatternMatcherPtr, microseconds, RegexMatcherNode>;
-
-    klogg::vector<MatcherContext> regexMatchers;
-    regexMatchers.reserve( matchingThreadsCount );
-    RegularExpression regularExpression{ regexp_ };
-    for ( auto index = 0u; index < matchingThreadsCount; ++index ) {
-        regexMatchers.emplace_back(
-            regularExpression.createMatcher(), microseconds{ 0 },
-            RegexMatcherNode(
-                searchGraph, 1, [ &regexMatchers, index, this ]( const BlockDataType& blockData ) {
-                    if ( interruptRequested_ ) {
-                        LOG_INFO << "Matcher " << index << " interrupted";
-                        auto results = std::make_shared<PartialSearchResults>();
-                        blockData->searchResults.chunkStart = blockData->chunkStart;
-                        blockData->searchResults.processedLines
-                            = LinesCount{ blockData->lines.endOfLines.size() };
-                        return blockData;
-                    }
-
-                    const auto& matcher = std::get<PatternMatcherPtr>( regexMatchers.at( index ) );
-                    const auto matchStartTime = high_resolution_clock::now();
-
-                    blockData->searchResults
-                        = filterLines( *matcher, blockData->lines, blockData->chunkStart );
-
-                    const auto matchEndTime = high_resolution_clock::now();
-
-                    microseconds& matchDuration
-                        = std::get<microseconds>( regexMatchers.at( index ) );
-                    matchDuration += duration_cast<microseconds>( matchEndTime - matchStartTime );
-                    LOG_DEBUG << "Searcher " << index << " block " << blockData->chunkStart
-                              << " sending matches "
-                              << blockData->searchResults.matchingLines.cardinality();
-                    return blockData;
-                } ) );
-    }
 
-    auto resultsQueue = tbb::flow::buffer_node<BlockDataType>( searchGraph );
+    LOG_INFO << "Searching from line " << initialLine << " to " << endLine;
 
-    const auto totalLines = endLine - initialLine;
-    LinesCount totalProcessedLines = 0_lcount;
-    LineLength maxLength = 0_length;
-    LinesCount nbMatches = searchData.getNbMatches();
-    auto reportedMatches = nbMatches;
-    int reportedPercentage = 0;
-
-    std::chrono::microseconds matchCombiningDuration{ 0 };
-
-    auto matchProcessor
-        = tbb::flow::function_node<BlockDataType, tbb::flow::continue_msg, tbb::flow::rejecting>(
-            searchGraph, 1, [ & ]( const BlockDataType& blockData ) {
-                if ( interruptRequested_ ) {
-                    LOG_INFO << "Match processor interrupted";
-                    return tbb::flow::continue_msg{};
-                }
-
-                const auto& matchResults = blockData->searchResults;
-
-                const auto matchProcessorStartTime = high_resolution_clock::now();
-
-                if ( matchResults.processedLines.get() ) {
+    // A few lines appended to the file fit in one read and gain nothing from
+    // the parallel scan, match them right away with the session's matcher.
+    const auto inlineSearchMaxLines = LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+    if ( streamingSession_ != nullptr && !domain_ && initialLine < endLine
+         && endLine - initialLine <= inlineSearchMaxLines ) {
+        streamingSession_->matchLines( sourceLogData_, regexp_, initialLine, endLine, searchData );
 
-                    maxLength = qMax( maxLength, matchResults.maxLength );
-                    const LinesCount matchesCount
-                        = LinesCount( matchResults.matchingLines.cardinality() );
-                    nbMatches += matchesCount;
-
-                    const auto processedLines = LinesCount{ matchResults.chunkStart.get()
-                                                            + matchResults.processedLines.get() };
-
-                    totalProcessedLines += matchResults.processedLines;
-
-                    // After each block, copy the data to shared data
-                    // and update the client
-                    searchData.addAll( maxLength, matchResults.matchingLines, matchesCount,
-                                       processedLines );
-
-                    LOG_DEBUG << "done Searching chunk starting at " << matchResults.chunkStart
-                              << ", " << matchResults.processedLines << " lines read.";
-                }
-
-                delete blockData;
-
-                const auto matchProcessorEndTime = high_resolution_clock::now();
-                matchCombiningDuration += duration_cast<microseconds>( matchProcessorEndTime
-                                                                       - matchProcessorStartTime );
-                const int percentage
-                    = calculateProgress( totalProcessedLines.get(), totalLines.get() );
-
-                if ( percentage > reportedPercentage || nbMatches > reportedMatches ) {
-
-                    Q_EMIT searchProgressed( nbMatches, std::min( 99, percentage ), initialLine );
-
-                    reportedPercentage = percentage;
-                    reportedMatches = nbMatches;
-                }
-
-                return tbb::flow::continue_msg{};
-            } );
-
-    tbb::flow::make_edge( blockPrefetcher, lineBlocksQueue );
-
-    for ( auto& regexMatcher : regexMatchers ) {
-        tbb::flow::make_edge( lineBlocksQueue, std::get<RegexMatcherNode>( regexMatcher ) );
-        tbb::flow::make_edge( std::get<RegexMatcherNode>( regexMatcher ), resultsQueue );
+        Q_EMIT searchProgressed( searchData.getNbMatches(), 100, initialLine );
+        Q_EMIT searchFinished();
+        return;
     }
 
-    tbb::flow::make_edge( resultsQueue, matchProcessor );
-    tbb::flow::make_edge( matchProcessor, blockPrefetcher.decrementer() );
-
-    auto chunkStart = initialLine;
-    while ( chunkStart < endLine && !interruptRequested_ ) {
-        const auto lineSourceStartTime = high_resolution_clock::now();
-        LOG_DEBUG << "Reading chunk starting at " << chunkStart;
-
-        const auto linesInChunk
-            = LinesCount( qMin( nbLinesInChunk.get(), ( endLine - chunkStart ).get() ) );
-        auto lines = sourceLogData_.getLinesRaw( chunkStart, linesInChunk );
-
-        /*LOG_DEBUG << "Sending chunk starting at " << chunkStart << ", " <<
-            lines.second.size()
-                << " lines read.";*/
-        BlockDataType blockData = new SearchBlockData{ chunkStart, std::move( lines ) };
-
-        const auto lineSourceEndTime = high_resolution_clock::now();
-        const auto chunkReadTime
-            = duration_cast<microseconds>( lineSourceEndTime - lineSourceStartTime );
-
-        /*LOG_DEBUG << "Sent chunk starting at " << chunkStart << ", " <<
-        blockData->lines.second.size()
-                << " lines read in " << static_cast<float>( chunkReadTime.count() )
-        / 1000.f
-                << " ms";*/
+    const auto request = SearchScanRequest{
+        regexp_,
+        initialLine,
+        endLine,
+        searchData,
+        interruptRequested_,
+        [ this, initialLine ]( LinesCount nbMatches, int percent ) {
+            Q_EMIT searchProgressed( nbMatches, percent, initialLine );
+        },
+        domain_ ? &( *domain_ ) : nullptr,
+        priorityLine_ };
+
+    sourceLogData_.searchScanCoordinator().scan( request );
+
+    Q_EMIT searchProgressed( searchData.getNbMatches(), 100, initialLine );
+    Q_EMIT searchFinished();
+}
 
-        chunkStart = chunkStart + nbLinesInChunk;
-        fileReadingDuration += chunkReadTime;
+// Called in the worker thread's context
+void FullSearchOperation::run( SearchData& searchData )
+{
+    try {
+        // Clear the shared data
+        searchData.clear();
 
-        while ( !blockPrefetcher.try_put( blockData ) && !interruptRequested_ ) {
-            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        // Give a quick idea of the number of matches before the complete search
+        if ( !domain_ && Configuration::get().estimateSearchMatches() ) {
+            doSearchWithEstimate( searchData );
         }
+        else {
+            doSearch( searchData, 0_lnum );
+        }
+    } catch ( const std::exception& err ) {
+        const auto errorString = QString( "FullSearchOperation failed: %1" ).arg( err.what() );
+        LOG_ERROR << errorString;
+        dispatchToMainThread( [ errorString ]() {
+            IssueReporter::askUserAndReportIssue( IssueTemplate::Exception, errorString );
+        } );
+        searchData.clear();
     }
+}
 
-    searchGraph.wait_for_all();
-
-    high_resolution_clock::time_point t2 = high_resolution_clock::now();
-    const auto durationUs = duration_cast<microseconds>( t2 - t1 );
-    const auto durationMs = duration_cast<milliseconds>( t2 - t1 );
+// Called in the worker thread's context
+void FullSearchOperation::doSearchWithEstimate( SearchData& searchData )
+{
+    const auto endLine = qMin( LineNumber( sourceLogData_.getNbLine().get() ), endLine_ );
+
+    // The estimate must not be reported once the search has completed,
+    // so it is dropped as soon as the final progress is sent.
+    Mutex estimateMutex;
+    AtomicFlag searchEnded;
+    QSemaphore estimateDone;
+
+    const auto searchEndedConnection = connect(
+        this, &SearchOperation::searchProgressed, this,
+        [ &estimateMutex, &searchEnded ]( LinesCount, int percent, LineNumber ) {
+            if ( percent == 100 ) {
+                ScopedLock lock( estimateMutex );
+                searchEnded.set();
+            }
+        },
+        Qt::DirectConnection );
+
+    QThreadPool::globalInstance()->start(
+        createRunnable( [ this, endLine, &estimateMutex, &searchEnded, &estimateDone ] {
+            try {
+                const auto estimate
+                    = estimateMatches( sourceLogData_, regexp_, startLine_, endLine, searchEnded );
+
+                ScopedLock lock( estimateMutex );
+                if ( estimate && !searchEnded ) {
+                    Q_EMIT searchEstimated( estimate->estimate, estimate->margin );
+                }
+            } catch ( const std::exception& err ) {
+                LOG_ERROR << "Search estimate failed: " << err.what();
+            }
+            estimateDone.release();
+        } ) );
 
-    LOG_INFO << "Searching done, overall duration " << durationUs;
-    LOG_INFO << "Line reading took " << fileReadingDuration;
-    LOG_INFO << "Results combining took " << matchCombiningDuration;
+    const auto waitForEstimate = [ & ] {
+        {
+            ScopedLock lock( estimateMutex );
+            searchEnded.set();
+        }
+        estimateDone.acquire();
+        disconnect( searchEndedConnection );
+    };
 
-    for ( const auto& regexMatcher : regexMatchers ) {
-        LOG_INFO << "Matching took " << std::get<microseconds>( regexMatcher );
+    try {
+        doSearch( searchData, 0_lnum );
+    } catch ( ... ) {
+        waitForEstimate();
+        throw;
     }
+    waitForEstimate();
+}
 
-    const auto totalFileSize = sourceLogData_.getFileSize();
-
-    LOG_INFO << "Searching perf "
-             << static_cast<uint64_t>(
-                    std::floor( 1000.f * static_cast<float>( ( endLine - initialLine ).get() )
-                                / static_cast<float>( durationMs.count() ) ) )
-             << " lines/s";
-    LOG_INFO << "Searching io perf "
-             << ( 1000.f * static_cast<float>( totalFileSize )
-                  / static_cast<float>( durationMs.count() ) )
-                    / ( 1024 * 1024 )
-             << " MiB/s";
-
-    Q_EMIT searchProgressed( nbMatches, 100, initialLine );
-    Q_EMIT searchFinished();
+// Called in the worker thread's context
+void ExtendSearchOperation::run( SearchData& searchData )
+{
+    try {
+        // Only new lines are in the domain, report them as an update
+        // starting at the first one
+        const auto firstLine = domain_->isEmpty() ? startLine_ : LineNumber( domain_->minimum() );
+        doSearch( searchData, qMax( startLine_, firstLine ) );
+    } catch ( const std::exception& err ) {
+        const auto errorString = QString( "ExtendSearchOperation failed: %1" ).arg( err.what() );
+        LOG_ERROR << errorString;
+        dispatchToMainThread( [ errorString ]() {
+            IssueReporter::askUserAndReportIssue( IssueTemplate::Exception, errorString );
+        } );
+        searchData.clear();
+    }
 }
 
 // Called in the worker thread's context
-void FullSearchOperation::run( SearchData& searchData )
+void ResumeSearchOperation::run( SearchData& searchData )
 {
     try {
-        // Clear the shared data
         searchData.clear();
-        doSearch( searchData, 0_lnum );
+        searchData.addAll( initialMaxLength_, {}, initialMatches_,
+                           LinesCount( initialPosition_.get() ) );
+        doSearch( searchData, initialPosition_ );
     } catch ( const std::exception& err ) {
-        const auto errorString = QString( "FullSearchOperation failed: %1" ).arg( err.what() );
+        const auto errorString = QString( "ResumeSearchOperation failed: %1" ).arg( err.what() );
         LOG_ERROR << errorString;
         dispatchToMainThread( [ errorString ]() {
             IssueReporter::askUserAndReportIssue( IssueTemplate::Exception, errorString );
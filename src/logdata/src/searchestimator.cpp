@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include "log.h"
+
+#include "logdata.h"
+#include "regularexpression.h"
+
+#include "searchestimator.h"
+
+namespace {
+// 95% confidence
+constexpr double ZScore = 1.96;
+} // namespace
+
+std::optional<SearchEstimate> estimateMatches( const LogData& logData,
+                                               const RegularExpressionPattern& regExp,
+                                               LineNumber startLine, LineNumber endLine,
+                                               const AtomicFlag& interruptRequested,
+                                               const SearchEstimateParameters& parameters )
+{
+    // The variance between strata needs at least two of them
+    const auto nbStrata = parameters.nbStrata;
+    if ( endLine <= startLine || nbStrata < 2 ) {
+        return {};
+    }
+
+    const auto totalLines = endLine - startLine;
+    if ( totalLines < parameters.minLines ) {
+        return {};
+    }
+
+    const auto stratumSize = totalLines.get() / nbStrata;
+    if ( stratumSize == 0 ) {
+        return {};
+    }
+
+    const auto chunkSize = std::clamp( static_cast<LinesCount::UnderlyingType>( std::ceil(
+                                           static_cast<double>( stratumSize )
+                                           * parameters.sampledFraction ) ),
+                                       LinesCount::UnderlyingType{ 1 }, stratumSize );
+
+    RegularExpression regularExpression{ regExp };
+    const auto matcher = regularExpression.createMatcher();
+
+    std::mt19937_64 randomEngine{ parameters.seed ? *parameters.seed
+                                                  : std::random_device{}() };
+    std::uniform_int_distribution<LinesCount::UnderlyingType> chunkOffset{
+        0, stratumSize - chunkSize };
+
+    // Proportion of matching lines in the chunk of each stratum
+    klogg::vector<double> proportions;
+    proportions.reserve( nbStrata );
+
+    for ( auto stratum = 0u; stratum < nbStrata; ++stratum ) {
+        if ( static_cast<bool>( interruptRequested ) ) {
+            return {};
+        }
+
+        const auto chunkStart
+            = startLine + LinesCount( stratum * stratumSize + chunkOffset( randomEngine ) );
+
+        const auto lines = logData.getLinesRaw( chunkStart, LinesCount( chunkSize ) );
+        const auto& utf8Lines = lines.buildUtf8View();
+
+        const auto nbMatches = std::count_if(
+            utf8Lines.cbegin(), utf8Lines.cend(),
+            [ &matcher ]( const auto& line ) { return matcher->hasMatch( line ); } );
+
+        proportions.push_back( utf8Lines.empty() ? 0.0
+                                                 : static_cast<double>( nbMatches )
+                                                       / static_cast<double>( utf8Lines.size() ) );
+    }
+
+    // Lines of a chunk are not independent, so each chunk is a single
+    // observation and the variance is taken between strata.
+    const auto nbObservations = static_cast<double>( proportions.size() );
+    const auto mean = std::accumulate( proportions.cbegin(), proportions.cend(), 0.0 )
+                      / nbObservations;
+    const auto sumOfSquares
+        = std::accumulate( proportions.cbegin(), proportions.cend(), 0.0,
+                           [ mean ]( double sum, double proportion ) {
+                               return sum + ( proportion - mean ) * ( proportion - mean );
+                           } );
+    const auto variance = sumOfSquares / ( nbObservations - 1 );
+
+    const auto nbLines = static_cast<double>( totalLines.get() );
+    const auto sampledLines = static_cast<double>( chunkSize ) * nbObservations;
+    const auto standardError
+        = nbLines * std::sqrt( variance / nbObservations * ( 1 - sampledLines / nbLines ) );
+
+    // Even without any match in the sample there might be matches in the file
+    const auto margin = std::max( ZScore * standardError, 3 * nbLines / sampledLines );
+
+    SearchEstimate result;
+    result.estimate = LinesCount( static_cast<LinesCount::UnderlyingType>( mean * nbLines ) );
+    result.margin = LinesCount( static_cast<LinesCount::UnderlyingType>( std::ceil( margin ) ) );
+    result.sampledLines = LinesCount( static_cast<LinesCount::UnderlyingType>( sampledLines ) );
+
+    LOG_INFO << "Estimated " << result.estimate << " +/- " << result.margin << " matches from "
+             << result.sampledLines << " lines";
+
+    return result;
+}
@@ -0,0 +1,477 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "configuration.h"
+#include "log.h"
+#include "readablesize.h"
+#include "runnable_lambda.h"
+
+#include "searchresultscache.h"
+
+namespace {
+constexpr quint32 SavedEntryMagic = 0x4b4c5352;
+constexpr quint32 SavedEntryVersion = 3;
+
+// Saved results of all files may use this many times the memory budget
+constexpr uint64_t SavedResultsSizeFactor = 4;
+constexpr int MaxSavedResultsAgeDays = 30;
+
+QString& storageRootOverride()
+{
+    static QString storageRoot;
+    return storageRoot;
+}
+
+uint64_t maxCacheSizeBytes()
+{
+    return static_cast<uint64_t>( Configuration::get().searchResultsCacheSizeMb() ) * 1024 * 1024;
+}
+
+uint64_t maxSavedResultsSizeBytes()
+{
+    return maxCacheSizeBytes() * SavedResultsSizeFactor;
+}
+
+std::vector<char> serializeResults( const SearchResultArray& matchingLines )
+{
+    std::vector<char> serialized( matchingLines.getSizeInBytes( true ) );
+    matchingLines.write( serialized.data(), true );
+    return serialized;
+}
+
+// Most recent modification of the results saved in a directory
+QDateTime lastSaved( const QDir& directory )
+{
+    QDateTime lastModified;
+    for ( const auto& savedFile : directory.entryInfoList( { "*.results" }, QDir::Files ) ) {
+        if ( !lastModified.isValid() || savedFile.lastModified() > lastModified ) {
+            lastModified = savedFile.lastModified();
+        }
+    }
+    return lastModified;
+}
+
+uint64_t savedSize( const QDir& directory )
+{
+    uint64_t size = 0;
+    for ( const auto& savedFile : directory.entryInfoList( { "*.results" }, QDir::Files ) ) {
+        size += static_cast<uint64_t>( savedFile.size() );
+    }
+    return size;
+}
+} // namespace
+
+bool SearchResultsCache::Key::operator==( const Key& other ) const
+{
+    return std::tie( regExp.pattern, regExp.isCaseSensitive, regExp.isExclude, regExp.isBoolean,
+                     regExp.isPlainText, startLine, context.encodingMib,
+                     context.prefilterPattern )
+           == std::tie( other.regExp.pattern, other.regExp.isCaseSensitive,
+                        other.regExp.isExclude, other.regExp.isBoolean, other.regExp.isPlainText,
+                        other.startLine, other.context.encodingMib,
+                        other.context.prefilterPattern );
+}
+
+size_t SearchResultsCache::KeyHash::operator()( const Key& key ) const
+{
+    const auto hashCombine = []( size_t& seed, const auto& value ) {
+        seed ^= std::hash<std::decay_t<decltype( value )>>()( value ) + 0x9e3779b9 + ( seed << 6 )
+                + ( seed >> 2 );
+    };
+
+    size_t seed = qHash( key.regExp.pattern );
+    hashCombine( seed, key.regExp.isPlainText );
+    hashCombine( seed, key.regExp.isBoolean );
+    hashCombine( seed, key.regExp.isCaseSensitive );
+    hashCombine( seed, key.regExp.isExclude );
+    hashCombine( seed, key.startLine );
+    hashCombine( seed, key.context.encodingMib );
+    hashCombine( seed, qHash( key.context.prefilterPattern ) );
+    return seed;
+}
+
+SearchResultsCache::SearchResultsCache( const QString& storageRoot )
+    : storageRoot_( storageRoot )
+{
+    persistencePool_.setMaxThreadCount( 1 );
+
+    if ( !storageRoot_.isEmpty() && Configuration::get().persistSearchResults() ) {
+        persistencePool_.start(
+            createRunnable( [ storageRoot, maxSize = maxSavedResultsSizeBytes() ] {
+                evictSavedResults( storageRoot, maxSize, MaxSavedResultsAgeDays );
+            } ) );
+    }
+}
+
+SearchResultsCache::~SearchResultsCache() noexcept
+{
+    persistencePool_.waitForDone();
+}
+
+QString SearchResultsCache::defaultStorageRoot()
+{
+    if ( !storageRootOverride().isEmpty() ) {
+        return storageRootOverride();
+    }
+
+    return QDir( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) )
+        .filePath( "search_results" );
+}
+
+void SearchResultsCache::setDefaultStorageRoot( const QString& storageRoot )
+{
+    storageRootOverride() = storageRoot;
+}
+
+std::optional<SearchResultsCache::Entry>
+SearchResultsCache::find( const RegularExpressionPattern& regExp, LineNumber startLine,
+                          LineNumber endLine )
+{
+    ScopedLock lock( mutex_ );
+
+    const auto* cachedEntry = entries_.find( Key{ regExp, startLine.get(), context_ } );
+    if ( cachedEntry == nullptr ) {
+        return {};
+    }
+
+    auto entry = cachedEntry->entry;
+    if ( entry.searchedUntil > endLine ) {
+        // The search is limited to fewer lines than the cached one
+        SearchResultArray searchRange;
+        searchRange.addRange( startLine.get(), endLine.get() );
+        entry.matchingLines &= searchRange;
+        entry.searchedUntil = endLine;
+    }
+
+    return entry;
+}
+
+void SearchResultsCache::insert( const RegularExpressionPattern& regExp, LineNumber startLine,
+                                 Entry entry )
+{
+    ScopedLock lock( mutex_ );
+    const auto key = Key{ regExp, startLine.get(), context_ };
+    if ( insertEntry( key, entry ) && isPersistenceEnabled() ) {
+        saveEntry( key, entry );
+    }
+
+    LOG_INFO << "Search results cache: " << entries_.size() << " entries, "
+             << readableSize( sizeInBytes_ );
+}
+
+bool SearchResultsCache::insertEntry( const Key& key, Entry entry )
+{
+    if ( const auto* existingEntry = entries_.find( key ) ) {
+        sizeInBytes_ -= existingEntry->sizeInBytes;
+        entries_.erase( key );
+    }
+
+    const auto entrySize = entry.matchingLines.getSizeInBytes( true );
+    if ( entrySize > maxCacheSizeBytes() ) {
+        LOG_DEBUG << "Search results too big to be cached: " << readableSize( entrySize );
+        return false;
+    }
+
+    entries_.insert( key, CachedEntry{ std::move( entry ), entrySize } );
+    sizeInBytes_ += entrySize;
+
+    evict();
+    return true;
+}
+
+void SearchResultsCache::evict()
+{
+    const auto maxSize = maxCacheSizeBytes();
+    while ( sizeInBytes_ > maxSize && !entries_.empty() ) {
+        const auto& [ key, leastRecentEntry ] = entries_.leastRecent();
+        LOG_DEBUG << "Evicting search results for " << key.regExp.pattern;
+
+        sizeInBytes_ -= leastRecentEntry.sizeInBytes;
+        entries_.removeLeastRecent();
+    }
+}
+
+void SearchResultsCache::clear()
+{
+    ScopedLock lock( mutex_ );
+    entries_.clear();
+    sizeInBytes_ = 0;
+
+    if ( !storageDirectory_.isEmpty() ) {
+        persistencePool_.start( createRunnable(
+            [ directory = storageDirectory_ ] { QDir( directory ).removeRecursively(); } ) );
+    }
+}
+
+uint64_t SearchResultsCache::sizeInBytes() const
+{
+    ScopedLock lock( mutex_ );
+    return sizeInBytes_;
+}
+
+size_t SearchResultsCache::size() const
+{
+    ScopedLock lock( mutex_ );
+    return entries_.size();
+}
+
+bool SearchResultsCache::isPersistenceEnabled() const
+{
+    const auto& config = Configuration::get();
+    return !storageDirectory_.isEmpty() && config.useSearchResultsCache()
+           && config.persistSearchResults();
+}
+
+void SearchResultsCache::setSearchContext( int encodingMib, const QString& prefilterPattern )
+{
+    ScopedLock lock( mutex_ );
+    context_ = SearchContext{ encodingMib, prefilterPattern };
+}
+
+void SearchResultsCache::setFileDigest( const QString& fileName, qint64 size, quint64 digest )
+{
+    if ( storageRoot_.isEmpty() ) {
+        return;
+    }
+
+    // Copies of a file with the same content keep their own results
+    const auto pathDigest
+        = QCryptographicHash::hash( QFileInfo( fileName ).absoluteFilePath().toUtf8(),
+                                    QCryptographicHash::Sha1 )
+              .toHex()
+              .left( 16 );
+
+    const auto directory = QDir( storageRoot_ )
+                               .filePath( QString( "%1_%2_%3" )
+                                              .arg( digest, 16, 16, QChar( '0' ) )
+                                              .arg( size )
+                                              .arg( QString::fromLatin1( pathDigest ) ) );
+
+    ScopedLock lock( mutex_ );
+    if ( directory == storageDirectory_ ) {
+        return;
+    }
+
+    const auto previousDirectory = std::exchange( storageDirectory_, directory );
+    if ( previousDirectory.isEmpty() ) {
+        if ( isPersistenceEnabled() ) {
+            loadSavedEntries();
+        }
+        return;
+    }
+
+    // Results saved for the previous content stay valid as the file has grown
+    persistencePool_.start( createRunnable( [ previousDirectory, directory ] {
+        QDir( directory ).removeRecursively();
+        QDir().rename( previousDirectory, directory );
+    } ) );
+}
+
+void SearchResultsCache::saveEntry( const Key& key, const Entry& entry )
+{
+    persistencePool_.start( createRunnable( [ key, entry, storageRoot = storageRoot_,
+                                              directoryPath = storageDirectory_,
+                                              maxSize = maxSavedResultsSizeBytes() ] {
+        QDir directory( directoryPath );
+        if ( !directory.mkpath( "." ) ) {
+            LOG_ERROR << "Can't create search results directory " << directoryPath;
+            return;
+        }
+
+        QByteArray serializedKey;
+        {
+            QDataStream stream( &serializedKey, QIODevice::WriteOnly );
+            stream << key.regExp.pattern << key.regExp.isCaseSensitive << key.regExp.isExclude
+                   << key.regExp.isBoolean << key.regExp.isPlainText;
+            stream << static_cast<qint32>( key.context.encodingMib )
+                   << key.context.prefilterPattern << static_cast<quint64>( key.startLine );
+        }
+
+        // Results of the same search replace the ones saved before
+        const auto keyDigest = QCryptographicHash::hash( serializedKey, QCryptographicHash::Sha1 )
+                                   .toHex()
+                                   .left( 16 );
+        QSaveFile file( directory.filePath(
+            QString( "%1.results" ).arg( QString::fromLatin1( keyDigest ) ) ) );
+        if ( !file.open( QIODevice::WriteOnly ) ) {
+            LOG_ERROR << "Can't save search results to " << file.fileName();
+            return;
+        }
+
+        const auto serializedResults = serializeResults( entry.matchingLines );
+
+        QDataStream stream( &file );
+        stream << SavedEntryMagic << SavedEntryVersion;
+        stream.writeRawData( serializedKey.constData(), serializedKey.size() );
+        stream << static_cast<quint64>( entry.searchedUntil.get() )
+               << static_cast<qint64>( entry.maxLength.get() )
+               << static_cast<quint64>( serializedResults.size() );
+        file.write( serializedResults.data(), static_cast<qint64>( serializedResults.size() ) );
+
+        if ( !file.commit() ) {
+            LOG_ERROR << "Can't save search results to " << file.fileName();
+            return;
+        }
+
+        LOG_INFO << "Saved search results of " << readableSize( serializedResults.size() )
+                 << " to " << file.fileName();
+
+        evictSavedResults( storageRoot, maxSize, MaxSavedResultsAgeDays, directoryPath );
+    } ) );
+}
+
+void SearchResultsCache::evictSavedResults( const QString& storageRoot, uint64_t maxSizeInBytes,
+                                            int maxAgeDays, const QString& keptDirectory )
+{
+    struct SavedResults {
+        QString path;
+        QDateTime lastSaved;
+        uint64_t size;
+    };
+
+    const auto keptPath = QFileInfo( keptDirectory ).absoluteFilePath();
+    const auto oldestKept = QDateTime::currentDateTime().addDays( -maxAgeDays );
+
+    std::vector<SavedResults> savedResults;
+    uint64_t totalSize = 0;
+    for ( const auto& directoryInfo :
+          QDir( storageRoot ).entryInfoList( QDir::Dirs | QDir::NoDotAndDotDot ) ) {
+        const auto path = directoryInfo.absoluteFilePath();
+        if ( !keptDirectory.isEmpty() && path == keptPath ) {
+            continue;
+        }
+
+        const QDir directory( path );
+        const auto lastSavedTime = lastSaved( directory );
+        if ( !lastSavedTime.isValid() || lastSavedTime < oldestKept ) {
+            LOG_INFO << "Removing expired search results " << path;
+            QDir( path ).removeRecursively();
+            continue;
+        }
+
+        savedResults.push_back( { path, lastSavedTime, savedSize( directory ) } );
+        totalSize += savedResults.back().size;
+    }
+
+    if ( !keptDirectory.isEmpty() ) {
+        totalSize += savedSize( QDir( keptDirectory ) );
+    }
+
+    std::sort( savedResults.begin(), savedResults.end(),
+               []( const SavedResults& lhs, const SavedResults& rhs ) {
+                   return lhs.lastSaved < rhs.lastSaved;
+               } );
+
+    for ( auto oldest = savedResults.cbegin();
+          totalSize > maxSizeInBytes && oldest != savedResults.cend(); ++oldest ) {
+        LOG_INFO << "Removing search results " << oldest->path << " of "
+                 << readableSize( oldest->size );
+        QDir( oldest->path ).removeRecursively();
+        totalSize -= oldest->size;
+    }
+}
+
+void SearchResultsCache::loadSavedEntries()
+{
+    auto savedFiles = QDir( storageDirectory_ ).entryInfoList( { "*.results" }, QDir::Files );
+
+    // Insert the most recently saved results last
+    // to keep them in front of the cache.
+    std::sort( savedFiles.begin(), savedFiles.end(),
+               []( const QFileInfo& lhs, const QFileInfo& rhs ) {
+                   return lhs.lastModified() < rhs.lastModified();
+               } );
+
+    for ( auto savedFile = savedFiles.cbegin(); savedFile != savedFiles.cend(); ++savedFile ) {
+        QFile file( savedFile->absoluteFilePath() );
+        if ( !file.open( QIODevice::ReadOnly ) ) {
+            continue;
+        }
+
+        QDataStream stream( &file );
+        quint32 magic = 0;
+        quint32 version = 0;
+        stream >> magic >> version;
+        if ( magic != SavedEntryMagic || version != SavedEntryVersion ) {
+            LOG_WARNING << "Ignoring unknown search results file " << file.fileName();
+            continue;
+        }
+
+        Key key;
+        qint32 encodingMib = 0;
+        quint64 startLine = 0;
+        quint64 searchedUntil = 0;
+        qint64 maxLength = 0;
+        quint64 resultsSize = 0;
+
+        stream >> key.regExp.pattern >> key.regExp.isCaseSensitive >> key.regExp.isExclude
+            >> key.regExp.isBoolean >> key.regExp.isPlainText;
+        stream >> encodingMib >> key.context.prefilterPattern >> startLine;
+        stream >> searchedUntil >> maxLength >> resultsSize;
+
+        if ( stream.status() != QDataStream::Ok
+             || resultsSize != static_cast<quint64>( file.size() - file.pos() ) ) {
+            LOG_WARNING << "Ignoring truncated search results file " << file.fileName();
+            continue;
+        }
+
+        std::vector<char> serializedResults( resultsSize );
+        if ( file.read( serializedResults.data(), static_cast<qint64>( resultsSize ) )
+             != static_cast<qint64>( resultsSize ) ) {
+            LOG_WARNING << "Can't read search results file " << file.fileName();
+            continue;
+        }
+
+        try {
+            key.startLine = startLine;
+            key.context.encodingMib = encodingMib;
+            Entry entry;
+            entry.matchingLines
+                = SearchResultArray::readSafe( serializedResults.data(), serializedResults.size() );
+            entry.searchedUntil = LineNumber( searchedUntil );
+            entry.maxLength = LineLength( static_cast<LineLength::UnderlyingType>( maxLength ) );
+
+            if ( !entries_.contains( key ) ) {
+                insertEntry( key, std::move( entry ) );
+            }
+        } catch ( const std::exception& e ) {
+            LOG_WARNING << "Ignoring corrupted search results file " << file.fileName() << ": "
+                        << e.what();
+        }
+    }
+
+    LOG_INFO << "Loaded " << entries_.size() << " search results from " << storageDirectory_;
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+
+#include "searchresultscursor.h"
+
+namespace {
+constexpr uint64_t SkipInterval = 1024;
+
+// Queries further than this from the current position are jumps
+constexpr uint64_t MaxWalkSteps = 256;
+
+// The skip table is only worth building if the queries keep jumping around
+constexpr uint64_t JumpsBeforeSkipTable = 8;
+} // namespace
+
+void SearchResultsCursor::invalidate()
+{
+    results_ = nullptr;
+    cardinality_ = 0;
+    isCardinalityStale_ = false;
+    position_.reset();
+    positionRank_ = 0;
+    nbJumps_ = 0;
+    skipTable_.clear();
+}
+
+void SearchResultsCursor::invalidateFrom( uint64_t line )
+{
+    isCardinalityStale_ = true;
+    position_.reset();
+    positionRank_ = 0;
+
+    // Ranks of the lines before the first modified one have not changed
+    skipTable_.erase( std::lower_bound( skipTable_.begin(), skipTable_.end(), line ),
+                      skipTable_.end() );
+}
+
+void SearchResultsCursor::attach( const SearchResultArray& results )
+{
+    if ( results_ != &results ) {
+        invalidate();
+        results_ = &results;
+        cardinality_ = results.cardinality();
+    }
+    else if ( isCardinalityStale_ ) {
+        cardinality_ = results.cardinality();
+        isCardinalityStale_ = false;
+    }
+}
+
+uint64_t SearchResultsCursor::rank( const SearchResultArray& results, uint64_t line )
+{
+    attach( results );
+    if ( cardinality_ == 0 ) {
+        return 0;
+    }
+
+    if ( !walkToLine( line, MaxWalkSteps ) ) {
+        jumpToLine( line );
+    }
+
+    return **position_ <= line ? positionRank_ + 1 : 0;
+}
+
+bool SearchResultsCursor::select( const SearchResultArray& results, uint64_t rank,
+                                  uint64_t* line )
+{
+    attach( results );
+    if ( rank >= cardinality_ ) {
+        return false;
+    }
+
+    if ( !walkToRank( rank, MaxWalkSteps ) ) {
+        jumpToRank( rank );
+    }
+
+    *line = **position_;
+    return true;
+}
+
+bool SearchResultsCursor::walkToRank( uint64_t rank, uint64_t maxSteps )
+{
+    if ( !position_ ) {
+        return false;
+    }
+
+    const auto distance = rank > positionRank_ ? rank - positionRank_ : positionRank_ - rank;
+    if ( distance > maxSteps ) {
+        return false;
+    }
+
+    for ( ; positionRank_ < rank; ++positionRank_ ) {
+        ++*position_;
+    }
+    for ( ; positionRank_ > rank; --positionRank_ ) {
+        --*position_;
+    }
+
+    return true;
+}
+
+bool SearchResultsCursor::walkToLine( uint64_t line, uint64_t maxSteps )
+{
+    if ( !position_ ) {
+        return false;
+    }
+
+    uint64_t steps = 0;
+    while ( **position_ < line && positionRank_ + 1 < cardinality_ ) {
+        if ( steps++ == maxSteps ) {
+            return false;
+        }
+        ++*position_;
+        ++positionRank_;
+    }
+
+    while ( **position_ > line && positionRank_ > 0 ) {
+        if ( steps++ == maxSteps ) {
+            return false;
+        }
+        --*position_;
+        --positionRank_;
+    }
+
+    return true;
+}
+
+void SearchResultsCursor::jumpToRank( uint64_t rank )
+{
+    registerJump();
+
+    if ( hasSkipTable() ) {
+        auto skipIndex = rank / SkipInterval;
+        if ( rank % SkipInterval > SkipInterval / 2 && skipIndex + 1 < skipTable_.size() ) {
+            ++skipIndex;
+        }
+
+        positionAt( skipTable_[ skipIndex ], skipIndex * SkipInterval );
+        walkToRank( rank, SkipInterval );
+    }
+    else {
+        uint64_t line = 0;
+        results_->select( rank, &line );
+        positionAt( line, rank );
+    }
+}
+
+void SearchResultsCursor::jumpToLine( uint64_t line )
+{
+    registerJump();
+
+    if ( hasSkipTable() ) {
+        const auto nextSkip = std::upper_bound( skipTable_.cbegin(), skipTable_.cend(), line );
+        const auto skipIndex = static_cast<uint64_t>(
+            nextSkip == skipTable_.cbegin() ? 0 : nextSkip - skipTable_.cbegin() - 1 );
+
+        positionAt( skipTable_[ skipIndex ], skipIndex * SkipInterval );
+        walkToLine( line, SkipInterval );
+    }
+    else {
+        const auto rank = results_->rank( line );
+        if ( rank == 0 ) {
+            positionAt( results_->minimum(), 0 );
+        }
+        else {
+            uint64_t previousLine = 0;
+            results_->select( rank - 1, &previousLine );
+            positionAt( previousLine, rank - 1 );
+        }
+    }
+}
+
+void SearchResultsCursor::positionAt( uint64_t line, uint64_t rank )
+{
+    position_.emplace( results_->begin() );
+    position_->move_equalorlarger( line );
+    positionRank_ = rank;
+}
+
+void SearchResultsCursor::registerJump()
+{
+    if ( ++nbJumps_ >= JumpsBeforeSkipTable && cardinality_ > SkipInterval ) {
+        extendSkipTable();
+    }
+}
+
+bool SearchResultsCursor::hasSkipTable() const
+{
+    return !skipTable_.empty()
+           && skipTable_.size() == ( cardinality_ + SkipInterval - 1 ) / SkipInterval;
+}
+
+// Entries are found with select, which sums the cardinalities of the
+// containers before the one holding the line, instead of walking every
+// result. Only the entries after the last one of the table are added.
+void SearchResultsCursor::extendSkipTable()
+{
+    if ( hasSkipTable() ) {
+        return;
+    }
+
+    const auto tableSize
+        = static_cast<size_t>( ( cardinality_ + SkipInterval - 1 ) / SkipInterval );
+    skipTable_.reserve( tableSize );
+
+    for ( auto skipIndex = skipTable_.size(); skipIndex < tableSize; ++skipIndex ) {
+        uint64_t line = 0;
+        results_->select( skipIndex * SkipInterval, &line );
+        skipTable_.push_back( line );
+    }
+}
@@ -0,0 +1,683 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <tbb/flow_graph.h>
+
+#include "configuration.h"
+#include "log.h"
+#include "progress.h"
+#include "runnable_lambda.h"
+
+#include "logdata.h"
+#include "regularexpression.h"
+
+#include "searchscancoordinator.h"
+#include "tracing.h"
+
+namespace {
+struct PartialSearchResults {
+    SearchResultArray matchingLines;
+    LineLength maxLength;
+    LinesCount processedLines;
+};
+
+struct LineRange {
+    LineNumber begin;
+    LineNumber end;
+
+    bool contains( LineNumber line ) const
+    {
+        return begin <= line && line < end;
+    }
+};
+
+PartialSearchResults filterLines( const PatternMatcher& matcher,
+                                  const klogg::vector<std::string_view>& lines, size_t firstLine,
+                                  size_t count, LineNumber sliceStart )
+{
+    LOG_DEBUG << "Filter lines at " << sliceStart;
+    PartialSearchResults results;
+    results.processedLines = LinesCount{ count };
+
+    const auto lastLine = qMin( lines.size(), firstLine + count );
+    for ( auto offset = firstLine; offset < lastLine; ++offset ) {
+        const auto& line = lines[ offset ];
+
+        if ( matcher.hasMatch( line ) ) {
+            results.maxLength = qMax( results.maxLength, getUntabifiedLength( line ) );
+            const auto lineNumber = sliceStart + LinesCount{ offset - firstLine };
+            results.matchingLines.add( lineNumber.get() );
+        }
+    }
+    return results;
+}
+
+// Removes the chunk from the range, leaving at most two parts of it.
+void subtractRange( const LineRange& range, const LineRange& chunk,
+                    klogg::vector<LineRange>& leftovers )
+{
+    if ( chunk.end <= range.begin || range.end <= chunk.begin ) {
+        leftovers.push_back( range );
+        return;
+    }
+
+    if ( range.begin < chunk.begin ) {
+        leftovers.push_back( { range.begin, chunk.begin } );
+    }
+    if ( chunk.end < range.end ) {
+        leftovers.push_back( { chunk.end, range.end } );
+    }
+}
+
+// Lines of a domain closer than this are read together with the lines
+// between them, which is cheaper than reading them one by one.
+constexpr LinesCount MaxCoalescedGap = 32_lcount;
+
+// Groups the lines of the domain that are within the limits into ranges
+// of at most maxRangeSize lines.
+klogg::vector<LineRange> coalesceDomain( const SearchResultArray& domain, const LineRange& limits,
+                                         LinesCount maxRangeSize )
+{
+    klogg::vector<LineRange> ranges;
+    for ( const auto line : domain ) {
+        const auto lineNumber = LineNumber( line );
+        if ( lineNumber >= limits.end ) {
+            break;
+        }
+        if ( !limits.contains( lineNumber ) ) {
+            continue;
+        }
+
+        if ( !ranges.empty() ) {
+            auto& lastRange = ranges.back();
+            if ( lineNumber <= lastRange.end + MaxCoalescedGap
+                 && lineNumber - lastRange.begin < maxRangeSize ) {
+                lastRange.end = lineNumber + 1_lcount;
+                continue;
+            }
+        }
+        ranges.push_back( { lineNumber, lineNumber + 1_lcount } );
+    }
+    return ranges;
+}
+
+} // namespace
+
+struct SearchScanCoordinator::ScanClient {
+    explicit ScanClient( const SearchScanRequest& scanRequest )
+        : request( scanRequest )
+        , searchedUntil( scanRequest.initialLine )
+        , totalLines( scanRequest.endLine - scanRequest.initialLine )
+        , nbMatches( scanRequest.searchData.getNbMatches() )
+        , reportedMatches( nbMatches )
+    {
+        pendingRanges.push_back( { scanRequest.initialLine, scanRequest.endLine } );
+
+        if ( scanRequest.priorityLine ) {
+            priorityLine = qBound( scanRequest.initialLine, *scanRequest.priorityLine,
+                                   scanRequest.endLine );
+        }
+    }
+
+    bool isInterrupted() const
+    {
+        return static_cast<bool>( request.interruptRequested );
+    }
+
+    // Called only from the match processor
+    void addResults( const LineRange& slice, const PartialSearchResults& results )
+    {
+        searchedRanges.emplace( slice.begin, slice.end );
+        auto nextRange = searchedRanges.begin();
+        while ( nextRange != searchedRanges.end() && nextRange->first == searchedUntil ) {
+            searchedUntil = nextRange->second;
+            nextRange = searchedRanges.erase( nextRange );
+        }
+
+        const auto matchesCount = LinesCount( results.matchingLines.cardinality() );
+        maxLength = qMax( maxLength, results.maxLength );
+        nbMatches += matchesCount;
+        processedLines += results.processedLines;
+
+        request.searchData.addAll( maxLength, results.matchingLines, matchesCount,
+                                   LinesCount( searchedUntil.get() ) );
+
+        const int percentage = calculateProgress( processedLines.get(), totalLines.get() );
+        if ( percentage > reportedPercentage || nbMatches > reportedMatches ) {
+            request.progressCallback( nbMatches, std::min( 99, percentage ) );
+            reportedPercentage = percentage;
+            reportedMatches = nbMatches;
+        }
+    }
+
+    // Returns the pending lines closest to the priority line, alternating
+    // between the lines after and before it. Only used by the scanning thread.
+    std::optional<LineRange> nextPriorityChunk( LinesCount nbLinesInChunk )
+    {
+        if ( !priorityLine ) {
+            return {};
+        }
+
+        std::optional<LineRange> forward;
+        std::optional<LineRange> backward;
+        for ( const auto& range : pendingRanges ) {
+            if ( range.end > *priorityLine ) {
+                const auto begin = qMax( range.begin, *priorityLine );
+                if ( !forward || begin < forward->begin ) {
+                    forward = LineRange{ begin, qMin( begin + nbLinesInChunk, range.end ) };
+                }
+            }
+            if ( range.begin < *priorityLine ) {
+                const auto end = qMin( range.end, *priorityLine );
+                if ( !backward || end > backward->end ) {
+                    backward = LineRange{ qMax( range.begin, end - nbLinesInChunk ), end };
+                }
+            }
+        }
+
+        const auto isBackward = isNextChunkBackward;
+        isNextChunkBackward = !isNextChunkBackward;
+
+        return ( ( isBackward && backward ) || !forward ) ? backward : forward;
+    }
+
+    void finish()
+    {
+        if ( !isFinished.exchange( true ) ) {
+            finished.release();
+        }
+    }
+
+    void sliceDone()
+    {
+        if ( slicesInFlight.fetch_sub( 1 ) == 1 && isDispatchComplete ) {
+            finish();
+        }
+    }
+
+    void completeDispatch()
+    {
+        isDispatchComplete = true;
+        if ( slicesInFlight == 0 ) {
+            finish();
+        }
+    }
+
+    const SearchScanRequest request;
+
+    klogg::vector<std::unique_ptr<PatternMatcher>> matchers;
+
+    // Lines not yet sent to matchers, only used by the scanning thread.
+    klogg::vector<LineRange> pendingRanges;
+
+    OptionalLineNumber priorityLine;
+    bool isNextChunkBackward = false;
+
+    // Slices searched out of order waiting for the lines before them.
+    std::map<LineNumber, LineNumber> searchedRanges;
+    LineNumber searchedUntil;
+
+    LinesCount totalLines;
+    LinesCount processedLines;
+    LinesCount nbMatches;
+    LineLength maxLength;
+
+    int reportedPercentage = 0;
+    LinesCount reportedMatches;
+
+    std::atomic<uint32_t> slicesInFlight{ 0 };
+    std::atomic<bool> isDispatchComplete{ false };
+    std::atomic<bool> isFinished{ false };
+    std::atomic<bool> hasFailed{ false };
+
+    QSemaphore finished;
+};
+
+namespace {
+struct ScanSlice {
+    SearchScanCoordinator::ScanClientPtr client;
+    size_t firstLine;
+    LineRange lines;
+
+    PartialSearchResults results;
+};
+
+struct ScanBlockData {
+    ScanBlockData( LineNumber start, LogData::RawLines blockLines )
+        : chunkStart( start )
+        , lines( std::move( blockLines ) )
+    {
+    }
+
+    ScanBlockData( const ScanBlockData& ) = delete;
+    ScanBlockData& operator=( const ScanBlockData& ) = delete;
+
+    LineNumber chunkStart;
+    LogData::RawLines lines;
+
+    klogg::vector<ScanSlice> slices;
+};
+
+// Selects the next lines to read. Lines around the priority line of a client
+// go first. Then the scan continues from the current position if some client
+// still needs it, otherwise it jumps to the nearest needed line after the
+// position, wrapping around to the start of the file.
+std::optional<LineRange>
+nextChunk( const klogg::vector<SearchScanCoordinator::ScanClientPtr>& clients,
+           LineNumber position, LinesCount nbLinesInChunk )
+{
+    for ( const auto& client : clients ) {
+        if ( auto priorityChunk = client->nextPriorityChunk( nbLinesInChunk ) ) {
+            return priorityChunk;
+        }
+    }
+
+    std::optional<LineNumber> nearestAfter;
+    std::optional<LineNumber> nearestBefore;
+    bool isPositionNeeded = false;
+
+    for ( const auto& client : clients ) {
+        for ( const auto& range : client->pendingRanges ) {
+            if ( range.contains( position ) ) {
+                isPositionNeeded = true;
+            }
+            else if ( range.begin > position ) {
+                nearestAfter = qMin( nearestAfter.value_or( range.begin ), range.begin );
+            }
+            else {
+                nearestBefore = qMin( nearestBefore.value_or( range.begin ), range.begin );
+            }
+        }
+    }
+
+    LineNumber chunkStart;
+    if ( isPositionNeeded ) {
+        chunkStart = position;
+    }
+    else if ( nearestAfter ) {
+        chunkStart = *nearestAfter;
+    }
+    else if ( nearestBefore ) {
+        chunkStart = *nearestBefore;
+    }
+    else {
+        return {};
+    }
+
+    LineNumber neededUntil = chunkStart;
+    for ( const auto& client : clients ) {
+        for ( const auto& range : client->pendingRanges ) {
+            if ( range.contains( chunkStart ) ) {
+                neededUntil = qMax( neededUntil, range.end );
+            }
+        }
+    }
+
+    return LineRange{ chunkStart, qMin( chunkStart + nbLinesInChunk, neededUntil ) };
+}
+
+} // namespace
+
+SearchScanCoordinator::SearchScanCoordinator( const LogData& sourceLogData )
+    : sourceLogData_( sourceLogData )
+{
+    scanPool_.setMaxThreadCount( 1 );
+}
+
+SearchScanCoordinator::~SearchScanCoordinator() noexcept
+{
+    try {
+        shutdownRequested_.set();
+        scanPool_.waitForDone();
+        LOG_INFO << "SearchScanCoordinator shutdown";
+    } catch ( const std::exception& e ) {
+        LOG_ERROR << "Failed to destroy SearchScanCoordinator: " << e.what();
+    }
+}
+
+void SearchScanCoordinator::scan( const SearchScanRequest& request )
+{
+    if ( request.endLine <= request.initialLine ) {
+        return;
+    }
+
+    if ( request.domain != nullptr ) {
+        scanDomain( request );
+        return;
+    }
+
+    auto client = std::make_shared<ScanClient>( request );
+    {
+        ScopedLock lock( clientsMutex_ );
+        pendingClients_.push_back( client );
+        LOG_INFO << "Scan requested for lines " << request.initialLine << " to "
+                 << request.endLine << ", scan running " << isScanRunning_;
+
+        if ( !isScanRunning_ ) {
+            isScanRunning_ = true;
+            scanPool_.start( createRunnable( [ this ] { runScan(); } ) );
+        }
+    }
+
+    client->finished.acquire();
+
+    if ( client->hasFailed ) {
+        throw std::runtime_error( "shared search scan failed" );
+    }
+}
+
+void SearchScanCoordinator::scanDomain( const SearchScanRequest& request )
+{
+    KLOGG_TRACE_SCOPE( "SearchScanCoordinator::scanDomain" );
+
+    const auto& config = Configuration::get();
+    const auto nbLinesInChunk = LinesCount(
+        static_cast<LinesCount::UnderlyingType>( config.searchReadBufferSizeLines() ) );
+
+    const auto ranges = coalesceDomain( *request.domain, { request.initialLine, request.endLine },
+                                        nbLinesInChunk );
+
+    const auto totalLines
+        = std::accumulate( ranges.cbegin(), ranges.cend(), 0_lcount,
+                           []( LinesCount total, const LineRange& range ) {
+                               return total + ( range.end - range.begin );
+                           } );
+
+    LOG_INFO << "Searching " << ranges.size() << " ranges of domain, " << totalLines << " lines";
+
+    RegularExpression regularExpression{ request.regexp };
+    const auto matcher = regularExpression.createMatcher();
+
+    LinesCount processedLines = 0_lcount;
+    LinesCount nbMatches = request.searchData.getNbMatches();
+    LineLength maxLength = 0_length;
+    int reportedPercentage = 0;
+
+    for ( const auto& range : ranges ) {
+        if ( static_cast<bool>( request.interruptRequested )
+             || static_cast<bool>( shutdownRequested_ ) ) {
+            break;
+        }
+
+        const auto rangeSize = range.end - range.begin;
+        const auto lines = sourceLogData_.getLinesRaw( range.begin, rangeSize );
+        const auto& utf8Lines = lines.buildUtf8View();
+
+        SearchResultArray matchingLines;
+        for ( auto offset = 0u; offset < utf8Lines.size(); ++offset ) {
+            const auto lineNumber = range.begin + LinesCount{ offset };
+            if ( !request.domain->contains( lineNumber.get() ) ) {
+                continue;
+            }
+
+            const auto& line = utf8Lines[ offset ];
+            if ( matcher->hasMatch( line ) ) {
+                maxLength = qMax( maxLength, getUntabifiedLength( line ) );
+                matchingLines.add( lineNumber.get() );
+            }
+        }
+
+        const auto matchesCount = LinesCount( matchingLines.cardinality() );
+        nbMatches += matchesCount;
+        processedLines += rangeSize;
+
+        request.searchData.addAll( maxLength, matchingLines, matchesCount,
+                                   LinesCount( range.end.get() ) );
+
+        const int percentage = calculateProgress( processedLines.get(), totalLines.get() );
+        if ( percentage > reportedPercentage || matchesCount > 0_lcount ) {
+            request.progressCallback( nbMatches, std::min( 99, percentage ) );
+            reportedPercentage = percentage;
+        }
+    }
+}
+
+void SearchScanCoordinator::runScan()
+{
+    KLOGG_TRACE_SCOPE( "SearchScanCoordinator::runScan" );
+
+    using namespace std::chrono;
+    const auto t1 = high_resolution_clock::now();
+
+    const auto& config = Configuration::get();
+    const auto matchingThreadsCount = static_cast<uint32_t>( [ &config ]() {
+        if ( !config.useParallelSearch() ) {
+            return 1;
+        }
+        const auto configuredThreadPoolSize = config.searchThreadPoolSize();
+        return qMax( 1, configuredThreadPoolSize == 0 ? tbb::info::default_concurrency()
+                                                      : configuredThreadPoolSize );
+    }() );
+
+    const auto nbLinesInChunk = LinesCount(
+        static_cast<LinesCount::UnderlyingType>( config.searchReadBufferSizeLines() ) );
+
+    LOG_INFO << "Starting shared scan using " << matchingThreadsCount << " matching threads";
+
+    klogg::vector<ScanClientPtr> activeClients;
+    klogg::vector<ScanClientPtr> attachedClients;
+
+    LinesCount totalScannedLines = 0_lcount;
+    microseconds fileReadingDuration{ 0 };
+    microseconds matchCombiningDuration{ 0 };
+    klogg::vector<microseconds> matchDurations( matchingThreadsCount, microseconds{ 0 } );
+
+    try {
+        tbb::flow::graph searchGraph;
+
+        using BlockDataType = ScanBlockData*;
+        auto blockPrefetcher
+            = tbb::flow::limiter_node<BlockDataType>( searchGraph, matchingThreadsCount * 3 );
+
+        auto lineBlocksQueue = tbb::flow::buffer_node<BlockDataType>( searchGraph );
+
+        using RegexMatcherNode
+            = tbb::flow::function_node<BlockDataType, BlockDataType, tbb::flow::rejecting>;
+
+        klogg::vector<RegexMatcherNode> regexMatchers;
+        regexMatchers.reserve( matchingThreadsCount );
+        for ( auto index = 0u; index < matchingThreadsCount; ++index ) {
+            regexMatchers.emplace_back(
+                searchGraph, 1, [ &matchDurations, index ]( const BlockDataType& blockData ) {
+                    KLOGG_TRACE_SCOPE( "regex matcher" );
+                    const auto matchStartTime = high_resolution_clock::now();
+
+                    const auto& utf8Lines = blockData->lines.buildUtf8View();
+                    for ( auto& slice : blockData->slices ) {
+                        if ( slice.client->isInterrupted() ) {
+                            slice.results.processedLines
+                                = slice.lines.end - slice.lines.begin;
+                            continue;
+                        }
+
+                        slice.results = filterLines(
+                            *slice.client->matchers.at( index ), utf8Lines, slice.firstLine,
+                            ( slice.lines.end - slice.lines.begin ).get(), slice.lines.begin );
+                    }
+
+                    matchDurations[ index ] += duration_cast<microseconds>(
+                        high_resolution_clock::now() - matchStartTime );
+                    return blockData;
+                } );
+        }
+
+        auto resultsQueue = tbb::flow::buffer_node<BlockDataType>( searchGraph );
+
+        auto matchProcessor = tbb::flow::function_node<BlockDataType, tbb::flow::continue_msg,
+                                                       tbb::flow::rejecting>(
+            searchGraph, 1, [ & ]( const BlockDataType& blockData ) {
+                KLOGG_TRACE_SCOPE( "match processor" );
+                const auto matchProcessorStartTime = high_resolution_clock::now();
+
+                for ( auto& slice : blockData->slices ) {
+                    if ( !slice.client->isInterrupted() ) {
+                        slice.client->addResults( slice.lines, slice.results );
+                    }
+                    slice.client->sliceDone();
+                }
+
+                delete blockData;
+
+                matchCombiningDuration += duration_cast<microseconds>(
+                    high_resolution_clock::now() - matchProcessorStartTime );
+                return tbb::flow::continue_msg{};
+            } );
+
+        tbb::flow::make_edge( blockPrefetcher, lineBlocksQueue );
+
+        for ( auto& regexMatcher : regexMatchers ) {
+            tbb::flow::make_edge( lineBlocksQueue, regexMatcher );
+            tbb::flow::make_edge( regexMatcher, resultsQueue );
+        }
+
+        tbb::flow::make_edge( resultsQueue, matchProcessor );
+        tbb::flow::make_edge( matchProcessor, blockPrefetcher.decrementer() );
+
+        LineNumber position = 0_lnum;
+        for ( ;; ) {
+            klogg::vector<ScanClientPtr> newClients;
+            {
+                ScopedLock lock( clientsMutex_ );
+                newClients = std::exchange( pendingClients_, {} );
+            }
+
+            for ( auto& client : newClients ) {
+                RegularExpression regularExpression{ client->request.regexp };
+                client->matchers.reserve( matchingThreadsCount );
+                for ( auto index = 0u; index < matchingThreadsCount; ++index ) {
+                    client->matchers.push_back( regularExpression.createMatcher() );
+                }
+
+                LOG_INFO << "Client joined shared scan at line " << position;
+                attachedClients.push_back( client );
+                activeClients.push_back( std::move( client ) );
+            }
+
+            const auto lastActiveClient = std::partition(
+                activeClients.begin(), activeClients.end(), [ this ]( const auto& client ) {
+                    return !client->pendingRanges.empty() && !client->isInterrupted()
+                           && !shutdownRequested_;
+                } );
+            std::for_each( lastActiveClient, activeClients.end(),
+                           []( const auto& client ) { client->completeDispatch(); } );
+            activeClients.erase( lastActiveClient, activeClients.end() );
+
+            if ( activeClients.empty() ) {
+                searchGraph.wait_for_all();
+
+                ScopedLock lock( clientsMutex_ );
+                if ( pendingClients_.empty() ) {
+                    isScanRunning_ = false;
+                    break;
+                }
+                continue;
+            }
+
+            const auto chunk = nextChunk( activeClients, position, nbLinesInChunk );
+            if ( !chunk ) {
+                continue;
+            }
+
+            const auto lineSourceStartTime = high_resolution_clock::now();
+            LOG_DEBUG << "Reading chunk starting at " << chunk->begin;
+
+            auto blockData = std::make_unique<ScanBlockData>(
+                chunk->begin,
+                sourceLogData_.getLinesRaw( chunk->begin, chunk->end - chunk->begin ) );
+
+            for ( const auto& client : activeClients ) {
+                klogg::vector<LineRange> leftovers;
+                for ( const auto& range : client->pendingRanges ) {
+                    const auto sliceBegin = qMax( range.begin, chunk->begin );
+                    const auto sliceEnd = qMin( range.end, chunk->end );
+                    if ( sliceBegin < sliceEnd ) {
+                        ++client->slicesInFlight;
+                        blockData->slices.push_back(
+                            { client, ( sliceBegin - chunk->begin ).get(),
+                              LineRange{ sliceBegin, sliceEnd }, {} } );
+                    }
+                    subtractRange( range, *chunk, leftovers );
+                }
+                client->pendingRanges = std::move( leftovers );
+            }
+
+            fileReadingDuration
+                += duration_cast<microseconds>( high_resolution_clock::now() - lineSourceStartTime );
+            totalScannedLines += chunk->end - chunk->begin;
+            position = chunk->end;
+
+            auto* block = blockData.release();
+            {
+                KLOGG_TRACE_SCOPE( "wait for matchers" );
+                while ( !blockPrefetcher.try_put( block ) ) {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                }
+            }
+        }
+    } catch ( const std::exception& err ) {
+        LOG_ERROR << "Shared scan failed: " << err.what();
+
+        ScopedLock lock( clientsMutex_ );
+        for ( const auto& client : pendingClients_ ) {
+            attachedClients.push_back( client );
+        }
+        pendingClients_.clear();
+        isScanRunning_ = false;
+
+        for ( const auto& client : attachedClients ) {
+            if ( !client->isFinished ) {
+                client->hasFailed = true;
+                client->finish();
+            }
+        }
+        return;
+    }
+
+    const auto durationMs = duration_cast<milliseconds>( high_resolution_clock::now() - t1 );
+
+    LOG_INFO << "Shared scan done for " << attachedClients.size() << " searches, duration "
+             << durationMs;
+    LOG_INFO << "Line reading took " << fileReadingDuration;
+    LOG_INFO << "Results combining took " << matchCombiningDuration;
+
+    for ( const auto& matchDuration : matchDurations ) {
+        LOG_INFO << "Matching took " << matchDuration;
+    }
+
+    if ( durationMs.count() > 0 ) {
+        LOG_INFO << "Searching perf "
+                 << static_cast<uint64_t>(
+                        std::floor( 1000.f * static_cast<float>( totalScannedLines.get() )
+                                    / static_cast<float>( durationMs.count() ) ) )
+                 << " lines/s";
+    }
+}
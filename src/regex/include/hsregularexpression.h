@@ -43,6 +43,13 @@
 
 using MatchedPatterns = std::string;
 
+// A match of one of the patterns, as a range of bytes of the scanned utf8 data.
+struct PatternMatchRange {
+    std::size_t patternIndex;
+    std::size_t start;
+    std::size_t end;
+};
+
 class DefaultRegularExpressionMatcher {
   public:
     explicit DefaultRegularExpressionMatcher(
@@ -142,6 +149,75 @@ class HsPrefilterMatcher {
 using MatcherVariant
     = std::variant<DefaultRegularExpressionMatcher, HsNoopMatcher, HsSingleMatcher, HsMultiMatcher, HsPrefilterMatcher>;
 
+// Finds the ranges of the matches of all patterns in a single scan.
+// Hyperscan reports every end of match with its leftmost start, these
+// reports are reduced to the leftmost-longest non-overlapping matches
+// of each pattern. They differ from the leftmost-first matches of PCRE
+// for lazy quantifiers and alternations, callers needing the exact ranges
+// of such patterns only use the matcher to find which lines match.
+class HsRangesMatcher {
+  public:
+    HsRangesMatcher() = default;
+    HsRangesMatcher( HsDatabase database, HsScratch scratch );
+
+    HsRangesMatcher( const HsRangesMatcher& ) = delete;
+    HsRangesMatcher& operator=( const HsRangesMatcher& ) = delete;
+
+    HsRangesMatcher( HsRangesMatcher&& other ) = default;
+    HsRangesMatcher& operator=( HsRangesMatcher&& other ) = default;
+
+    // Fills ranges ordered by pattern index, then by start.
+    void match( std::string_view utf8Data, klogg::vector<PatternMatchRange>& ranges ) const;
+
+    // Returns false if a pattern that can't be located is known not to
+    // match the data of the last call to match.
+    bool mayMatch( std::size_t patternIndex ) const;
+
+    void setPrefilter( HsDatabase database, HsScratch scratch,
+                       const MatchedPatterns& prefilteredPatterns );
+
+  private:
+    HsDatabase database_;
+    HsScratch scratch_;
+
+    HsDatabase prefilterDatabase_;
+    HsScratch prefilterScratch_;
+    MatchedPatterns prefilteredPatterns_;
+    mutable HsMatcherContext prefilterContext_;
+};
+
+// Patterns compiled with start of match reporting, so that matchers
+// locate the matches instead of only telling if a line matches.
+// Patterns hyperscan can't compile in this mode (lookarounds, patterns
+// matching empty strings...) are left out, canLocate tells which
+// patterns the matchers report. Those are compiled in prefilter mode
+// when possible, so that matchers tell which lines they can't match.
+class HsRangesRegularExpression {
+  public:
+    HsRangesRegularExpression() = default;
+    explicit HsRangesRegularExpression( const klogg::vector<RegularExpressionPattern>& patterns );
+
+    HsRangesRegularExpression( const HsRangesRegularExpression& ) = delete;
+    HsRangesRegularExpression& operator=( const HsRangesRegularExpression& ) = delete;
+
+    HsRangesRegularExpression( HsRangesRegularExpression&& other ) = default;
+    HsRangesRegularExpression& operator=( HsRangesRegularExpression&& other ) = default;
+
+    bool canLocate( std::size_t patternIndex ) const;
+
+    HsRangesMatcher createMatcher() const;
+
+  private:
+    HsDatabase database_;
+    HsScratch scratch_;
+
+    HsDatabase prefilterDatabase_;
+    HsScratch prefilterScratch_;
+
+    MatchedPatterns locatedPatterns_;
+    MatchedPatterns prefilteredPatterns_;
+};
+
 
 class HsRegularExpression {
   public:
@@ -222,6 +298,38 @@ class HsRegularExpression {
     klogg::vector<RegularExpressionPattern> patterns_;
 };
 
+class HsRangesMatcher {
+  public:
+    void match( std::string_view, klogg::vector<PatternMatchRange>& ranges ) const
+    {
+        ranges.clear();
+    }
+
+    bool mayMatch( std::size_t ) const
+    {
+        return true;
+    }
+};
+
+class HsRangesRegularExpression {
+  public:
+    HsRangesRegularExpression() = default;
+
+    explicit HsRangesRegularExpression( const klogg::vector<RegularExpressionPattern>& )
+    {
+    }
+
+    bool canLocate( std::size_t ) const
+    {
+        return false;
+    }
+
+    HsRangesMatcher createMatcher() const
+    {
+        return {};
+    }
+};
+
 #endif
 
 #endif
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <numeric>
 #include <qregularexpression.h>
 #include <string_view>
+#include <tuple>
 
 #ifdef KLOGG_HAS_HS
 #include "hsregularexpression.h"
@@ -61,6 +62,107 @@ int matchMultiCallback( unsigned int id, unsigned long long from, unsigned long
     return 0;
 }
 
+int matchRangesCallback( unsigned int id, unsigned long long from, unsigned long long to,
+                         unsigned int flags, void* context )
+{
+    Q_UNUSED( flags );
+
+    auto* ranges = static_cast<klogg::vector<PatternMatchRange>*>( context );
+    ranges->push_back(
+        { static_cast<std::size_t>( id ), static_cast<std::size_t>( from ),
+          static_cast<std::size_t>( to ) } );
+
+    return 0;
+}
+
+bool hasRequiredCpuInstructions()
+{
+    auto requiredInstructuins = CpuInstructions::SSE2;
+    requiredInstructuins |= CpuInstructions::SSSE3;
+
+    return hasRequiredInstructions( supportedCpuInstructions(), requiredInstructuins );
+}
+
+HsScratch allocateScratch( hs_database_t* database )
+{
+    return makeUniqueResource<hs_scratch_t, hs_free_scratch>(
+        []( hs_database_t* db ) -> hs_scratch_t* {
+            hs_scratch_t* scratch = nullptr;
+
+            const auto scratchResult = hs_alloc_scratch( db, &scratch );
+            if ( scratchResult != HS_SUCCESS ) {
+                LOG_ERROR << "Failed to allocate scratch";
+                return nullptr;
+            }
+
+            return scratch;
+        },
+        database );
+}
+
+HsScratch cloneScratch( hs_scratch_t* prototype )
+{
+    return makeUniqueResource<hs_scratch_t, hs_free_scratch>(
+        []( hs_scratch_t* source ) -> hs_scratch_t* {
+            hs_scratch_t* scratch = nullptr;
+
+            const auto err = hs_clone_scratch( source, &scratch );
+            if ( err != HS_SUCCESS ) {
+                LOG_ERROR << "hs_clone_scratch failed";
+                return nullptr;
+            }
+
+            return scratch;
+        },
+        prototype );
+}
+
+// Compiles the patterns of expressionIds in one database. A pattern that
+// can't be compiled fails the whole database, it is dropped from
+// expressionIds and the others are compiled again.
+HsDatabase compileDroppingFailures( const klogg::vector<QByteArray>& utf8Patterns,
+                                    const klogg::vector<unsigned>& flags,
+                                    klogg::vector<unsigned>& expressionIds )
+{
+    HsDatabase database;
+    while ( !expressionIds.empty() && !database ) {
+        klogg::vector<const char*> patternPointers( expressionIds.size() );
+        std::transform( expressionIds.cbegin(), expressionIds.cend(), patternPointers.begin(),
+                        [ &utf8Patterns ]( unsigned id ) { return utf8Patterns[ id ].data(); } );
+
+        klogg::vector<unsigned> expressionFlags( expressionIds.size() );
+        std::transform( expressionIds.cbegin(), expressionIds.cend(), expressionFlags.begin(),
+                        [ &flags ]( unsigned id ) { return flags[ id ]; } );
+
+        hs_compile_error_t* error = nullptr;
+        database = HsDatabase{ makeUniqueResource<hs_database_t, hs_free_database>(
+            [ & ]() -> hs_database_t* {
+                hs_database_t* db = nullptr;
+                const auto compileResult = hs_compile_multi(
+                    patternPointers.data(), expressionFlags.data(), expressionIds.data(),
+                    static_cast<unsigned>( expressionIds.size() ), HS_MODE_BLOCK, nullptr, &db,
+                    &error );
+
+                return compileResult == HS_SUCCESS ? db : nullptr;
+            } ) };
+
+        if ( !database ) {
+            const auto failedExpression = error->expression;
+            LOG_INFO << "Can't compile pattern " << failedExpression << ": " << error->message;
+            hs_free_compile_error( error );
+
+            if ( failedExpression < 0 ) {
+                expressionIds.clear();
+                return {};
+            }
+
+            expressionIds.erase( expressionIds.begin() + failedExpression );
+        }
+    }
+
+    return database;
+}
+
 } // namespace
 
 HsMatcherContext::HsMatcherContext( std::size_t numberOfPatterns )
@@ -148,10 +250,7 @@ HsRegularExpression::HsRegularExpression( const RegularExpressionPattern& patter
 HsRegularExpression::HsRegularExpression( const klogg::vector<RegularExpressionPattern>& patterns )
     : patterns_( patterns )
 {
-    auto requiredInstructuins = CpuInstructions::SSE2;
-    requiredInstructuins |= CpuInstructions::SSSE3;
-
-    if ( hasRequiredInstructions( supportedCpuInstructions(), requiredInstructuins ) ) {
+    if ( hasRequiredCpuInstructions() ) {
         auto compileHsDatabase = []( const klogg::vector<RegularExpressionPattern>& expressions,
                                      QString& errorMessage, bool isPrefilter ) -> hs_database_t* {
             hs_database_t* db = nullptr;
@@ -225,19 +324,7 @@ HsRegularExpression::HsRegularExpression( const klogg::vector<RegularExpressionP
     }
 
     if ( database_ ) {
-        scratch_ = makeUniqueResource<hs_scratch_t, hs_free_scratch>(
-            []( hs_database_t* db ) -> hs_scratch_t* {
-                hs_scratch_t* scratch = nullptr;
-
-                const auto scratchResult = hs_alloc_scratch( db, &scratch );
-                if ( scratchResult != HS_SUCCESS ) {
-                    LOG_ERROR << "Failed to allocate scratch";
-                    return nullptr;
-                }
-
-                return scratch;
-            },
-            database_.get() );
+        scratch_ = allocateScratch( database_.get() );
     }
 
     if ( !isHsValid() ) {
@@ -280,19 +367,7 @@ MatcherVariant HsRegularExpression::createMatcher() const
         return HsNoopMatcher();
     }
 
-    auto matcherScratch = makeUniqueResource<hs_scratch_t, hs_free_scratch>(
-        []( hs_scratch_t* prototype ) -> hs_scratch_t* {
-            hs_scratch_t* scratch = nullptr;
-
-            const auto err = hs_clone_scratch( prototype, &scratch );
-            if ( err != HS_SUCCESS ) {
-                LOG_ERROR << "hs_clone_scratch failed";
-                return nullptr;
-            }
-
-            return scratch;
-        },
-        scratch_.get() );
+    auto matcherScratch = cloneScratch( scratch_.get() );
 
     if ( !isPrefilter_ ) {
         if ( patterns_.size() == 1 ) {
@@ -307,4 +382,161 @@ MatcherVariant HsRegularExpression::createMatcher() const
             patterns_, HsMultiMatcher{ database_, std::move( matcherScratch ), patterns_.size() } );
     }
 }
+
+HsRangesMatcher::HsRangesMatcher( HsDatabase database, HsScratch scratch )
+    : database_{ std::move( database ) }
+    , scratch_{ std::move( scratch ) }
+{
+}
+
+void HsRangesMatcher::setPrefilter( HsDatabase database, HsScratch scratch,
+                                    const MatchedPatterns& prefilteredPatterns )
+{
+    prefilterDatabase_ = std::move( database );
+    prefilterScratch_ = std::move( scratch );
+    prefilterContext_ = HsMatcherContext( prefilteredPatterns.size() );
+    prefilteredPatterns_ = prefilteredPatterns;
+}
+
+bool HsRangesMatcher::mayMatch( std::size_t patternIndex ) const
+{
+    if ( patternIndex >= prefilteredPatterns_.size() || !prefilteredPatterns_[ patternIndex ] ) {
+        return true;
+    }
+
+    return prefilterContext_.matchingPatterns[ patternIndex ] != 0;
+}
+
+void HsRangesMatcher::match( std::string_view utf8Data,
+                             klogg::vector<PatternMatchRange>& ranges ) const
+{
+    ranges.clear();
+
+    if ( prefilterDatabase_ && prefilterScratch_ ) {
+        prefilterContext_.reset();
+        hs_scan( prefilterDatabase_.get(), utf8Data.data(),
+                 static_cast<unsigned int>( utf8Data.size() ), 0, prefilterScratch_.get(),
+                 matchMultiCallback, static_cast<void*>( &prefilterContext_ ) );
+    }
+
+    if ( !database_ || !scratch_ ) {
+        return;
+    }
+
+    hs_scan( database_.get(), utf8Data.data(), static_cast<unsigned int>( utf8Data.size() ), 0,
+             scratch_.get(), matchRangesCallback, static_cast<void*>( &ranges ) );
+
+    // For the same start the longest match comes first
+    std::sort( ranges.begin(), ranges.end(),
+               []( const PatternMatchRange& lhs, const PatternMatchRange& rhs ) {
+                   return std::tie( lhs.patternIndex, lhs.start, rhs.end )
+                          < std::tie( rhs.patternIndex, rhs.start, lhs.end );
+               } );
+
+    auto lastKept = ranges.begin();
+    for ( auto range = ranges.begin(); range != ranges.end(); ++range ) {
+        if ( lastKept != ranges.begin() ) {
+            const auto& previous = *std::prev( lastKept );
+            if ( previous.patternIndex == range->patternIndex && range->start < previous.end ) {
+                continue;
+            }
+        }
+
+        *lastKept = *range;
+        ++lastKept;
+    }
+
+    ranges.erase( lastKept, ranges.end() );
+}
+
+HsRangesRegularExpression::HsRangesRegularExpression(
+    const klogg::vector<RegularExpressionPattern>& patterns )
+    : locatedPatterns_( patterns.size(), 0 )
+    , prefilteredPatterns_( patterns.size(), 0 )
+{
+    if ( !hasRequiredCpuInstructions() ) {
+        LOG_WARNING << "Cpu doesn't have sse2 or ssse3, can't locate matches with hyperscan";
+        return;
+    }
+
+    klogg::vector<QByteArray> utf8Patterns( patterns.size() );
+    std::transform( patterns.cbegin(), patterns.cend(), utf8Patterns.begin(),
+                    []( const auto& expression ) {
+                        auto p = expression.pattern;
+                        if ( expression.isPlainText ) {
+                            p = QRegularExpression::escape( expression.pattern );
+                        }
+                        return p.toUtf8();
+                    } );
+
+    klogg::vector<unsigned> flags( patterns.size() );
+    std::transform( patterns.cbegin(), patterns.cend(), flags.begin(),
+                    []( const auto& expression ) {
+                        auto expressionFlags = HS_FLAG_UTF8 | HS_FLAG_UCP | HS_FLAG_SOM_LEFTMOST;
+                        if ( !expression.isCaseSensitive ) {
+                            expressionFlags |= HS_FLAG_CASELESS;
+                        }
+                        return expressionFlags;
+                    } );
+
+    klogg::vector<unsigned> expressionIds( patterns.size() );
+    std::iota( expressionIds.begin(), expressionIds.end(), 0u );
+
+    database_ = compileDroppingFailures( utf8Patterns, flags, expressionIds );
+    if ( database_ ) {
+        scratch_ = allocateScratch( database_.get() );
+    }
+
+    if ( scratch_ ) {
+        for ( const auto id : expressionIds ) {
+            locatedPatterns_[ id ] = 1;
+        }
+    }
+
+    // The lines the other patterns can match are found by a prefilter
+    // pass, QRegularExpression is only run on them.
+    klogg::vector<unsigned> prefilterIds;
+    for ( auto id = 0u; id < patterns.size(); ++id ) {
+        if ( !locatedPatterns_[ id ] ) {
+            prefilterIds.push_back( id );
+            flags[ id ] = ( flags[ id ] & ~static_cast<unsigned>( HS_FLAG_SOM_LEFTMOST ) )
+                          | HS_FLAG_SINGLEMATCH | HS_FLAG_PREFILTER;
+        }
+    }
+
+    prefilterDatabase_ = compileDroppingFailures( utf8Patterns, flags, prefilterIds );
+    if ( prefilterDatabase_ ) {
+        prefilterScratch_ = allocateScratch( prefilterDatabase_.get() );
+    }
+
+    if ( prefilterScratch_ ) {
+        for ( const auto id : prefilterIds ) {
+            prefilteredPatterns_[ id ] = 1;
+        }
+    }
+
+    LOG_DEBUG << "Finished creating ranges database, patterns: " << patterns.size()
+              << ", located: " << ( scratch_ ? expressionIds.size() : 0 )
+              << ", prefiltered: " << ( prefilterScratch_ ? prefilterIds.size() : 0 );
+}
+
+bool HsRangesRegularExpression::canLocate( std::size_t patternIndex ) const
+{
+    return patternIndex < locatedPatterns_.size() && locatedPatterns_[ patternIndex ] != 0;
+}
+
+HsRangesMatcher HsRangesRegularExpression::createMatcher() const
+{
+    HsRangesMatcher matcher;
+    if ( database_ && scratch_ ) {
+        matcher = HsRangesMatcher{ database_, cloneScratch( scratch_.get() ) };
+    }
+
+    if ( prefilterDatabase_ && prefilterScratch_ ) {
+        matcher.setPrefilter( prefilterDatabase_, cloneScratch( prefilterScratch_.get() ),
+                              prefilteredPatterns_ );
+    }
+
+    return matcher;
+}
 #endif
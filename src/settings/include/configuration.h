@@ -191,13 +191,21 @@ class Configuration final : public Persistable<Configuration> {
     {
         useSearchResultsCache_ = enabled;
     }
-    unsigned searchResultsCacheLines() const
+    unsigned searchResultsCacheSizeMb() const
     {
-        return searchResultsCacheLines_;
+        return searchResultsCacheSizeMb_;
     }
-    void setSearchResultsCacheLines( unsigned lines )
+    void setSearchResultsCacheSizeMb( unsigned sizeMb )
     {
-        searchResultsCacheLines_ = lines;
+        searchResultsCacheSizeMb_ = sizeMb;
+    }
+    bool persistSearchResults() const
+    {
+        return persistSearchResults_;
+    }
+    void setPersistSearchResults( bool enabled )
+    {
+        persistSearchResults_ = enabled;
     }
     int indexReadBufferSizeMb() const
     {
@@ -215,6 +223,31 @@ class Configuration final : public Persistable<Configuration> {
     {
         searchReadBufferSizeLines_ = lines;
     }
+    bool estimateSearchMatches() const
+    {
+        return estimateSearchMatches_;
+    }
+    void setEstimateSearchMatches( bool enabled )
+    {
+        estimateSearchMatches_ = enabled;
+    }
+    // Maximum size of the text copied to the clipboard
+    int clipboardSizeLimitMb() const
+    {
+        return clipboardSizeLimitMb_;
+    }
+    void setClipboardSizeLimitMb( int sizeMb )
+    {
+        clipboardSizeLimitMb_ = sizeMb;
+    }
+    bool searchFromViewport() const
+    {
+        return searchFromViewport_;
+    }
+    void setSearchFromViewport( bool enabled )
+    {
+        searchFromViewport_ = enabled;
+    }
     int searchThreadPoolSize() const
     {
         return searchThreadPoolSize_;
@@ -572,11 +605,15 @@ class Configuration final : public Persistable<Configuration> {
 
     // Performance settings
     bool useSearchResultsCache_ = true;
-    unsigned searchResultsCacheLines_ = 1000000;
+    unsigned searchResultsCacheSizeMb_ = 256;
+    bool persistSearchResults_ = true;
     bool useParallelSearch_ = true;
     int indexReadBufferSizeMb_ = 16;
     int searchReadBufferSizeLines_ = 10000;
     int searchThreadPoolSize_ = 0;
+    bool searchFromViewport_ = true;
+    bool estimateSearchMatches_ = true;
+    int clipboardSizeLimitMb_ = 256;
     bool keepFileClosed_ = false;
     bool useCompressedIndex_ = true;
 
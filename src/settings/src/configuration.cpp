@@ -230,10 +230,13 @@ void Configuration::retrieveFromStorage( QSettings& settings )
         = settings
               .value( "perf.useSearchResultsCache", DefaultConfiguration.useSearchResultsCache_ )
               .toBool();
-    searchResultsCacheLines_ = settings
-                                   .value( "perf.searchResultsCacheLines",
-                                           DefaultConfiguration.searchResultsCacheLines_ )
-                                   .toUInt();
+    searchResultsCacheSizeMb_ = settings
+                                    .value( "perf.searchResultsCacheSizeMb",
+                                            DefaultConfiguration.searchResultsCacheSizeMb_ )
+                                    .toUInt();
+    persistSearchResults_
+        = settings.value( "perf.persistSearchResults", DefaultConfiguration.persistSearchResults_ )
+              .toBool();
     indexReadBufferSizeMb_
         = settings
               .value( "perf.indexReadBufferSizeMb", DefaultConfiguration.indexReadBufferSizeMb_ )
@@ -245,6 +248,17 @@ void Configuration::retrieveFromStorage( QSettings& settings )
     searchThreadPoolSize_
         = settings.value( "perf.searchThreadPoolSize", DefaultConfiguration.searchThreadPoolSize_ )
               .toInt();
+    searchFromViewport_
+        = settings.value( "perf.searchFromViewport", DefaultConfiguration.searchFromViewport_ )
+              .toBool();
+    estimateSearchMatches_ = settings
+                                 .value( "perf.estimateSearchMatches",
+                                         DefaultConfiguration.estimateSearchMatches_ )
+                                 .toBool();
+    clipboardSizeLimitMb_ = settings
+                                .value( "perf.clipboardSizeLimitMb",
+                                        DefaultConfiguration.clipboardSizeLimitMb_ )
+                                .toInt();
     keepFileClosed_
         = settings.value( "perf.keepFileClosed", DefaultConfiguration.keepFileClosed_ ).toBool();
 
@@ -395,10 +409,14 @@ void Configuration::saveToStorage( QSettings& settings ) const
 
     settings.setValue( "perf.useParallelSearch", useParallelSearch_ );
     settings.setValue( "perf.useSearchResultsCache", useSearchResultsCache_ );
-    settings.setValue( "perf.searchResultsCacheLines", searchResultsCacheLines_ );
+    settings.setValue( "perf.searchResultsCacheSizeMb", searchResultsCacheSizeMb_ );
+    settings.setValue( "perf.persistSearchResults", persistSearchResults_ );
     settings.setValue( "perf.indexReadBufferSizeMb", indexReadBufferSizeMb_ );
     settings.setValue( "perf.searchReadBufferSizeLines", searchReadBufferSizeLines_ );
     settings.setValue( "perf.searchThreadPoolSize", searchThreadPoolSize_ );
+    settings.setValue( "perf.searchFromViewport", searchFromViewport_ );
+    settings.setValue( "perf.estimateSearchMatches", estimateSearchMatches_ );
+    settings.setValue( "perf.clipboardSizeLimitMb", clipboardSizeLimitMb_ );
     settings.setValue( "perf.keepFileClosed", keepFileClosed_ );
     settings.setValue( "perf.useCompressedIndex", useCompressedIndex_ );
     settings.setValue( "perf.optimizeForNotLatinEncodings", optimizeForNotLatinEncodings_ );
@@ -42,7 +42,9 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <qchar.h>
 #include <string_view>
 #include <utility>
@@ -53,25 +55,35 @@
 #include <QColor>
 #include <QEvent>
 #include <QFontMetrics>
+#include <QPointer>
 
 #ifdef GLOGG_PERF_MEASURE_FPS
 #include "perfcounter.h"
 #endif
 
 #include "abstractlogdata.h"
+#include "highlighterset.h"
+#include "linehighlighter.h"
+#include "linehighlightscache.h"
+#include "linesprefetcher.h"
 #include "linetypes.h"
 #include "overviewwidget.h"
 #include "quickfind.h"
 #include "quickfindmux.h"
 #include "regularexpressionpattern.h"
 #include "selection.h"
+#include "statictextcache.h"
 #include "viewtools.h"
+#include "wrappedlinesindex.h"
 #include "wrappedstring.h"
 
 class QMenu;
 class QAction;
 class QShortcut;
+class QSaveFile;
 class HighlightersMenu;
+class LinesExporter;
+class SelectionMimeData;
 
 // Utility class representing a buffer for number entered on the keyboard
 // The buffer keep at most 7 digits, and reset itself after a timeout.
@@ -125,8 +137,9 @@ class AbstractLogView : public QAbstractScrollArea, public SearchableWidgetInter
 
     void updateFont( const QFont& font );
 
-    // Refresh the widget when the data set has changed.
-    void updateData();
+    // Refresh the widget when the data set has changed,
+    // the lines before firstChangedLine are still the same.
+    void updateData( LineNumber firstChangedLine = 0_lnum );
     // Instructs the widget to update it's content geometry,
     // used when the font is changed.
     void updateDisplaySize();
@@ -134,6 +147,9 @@ class AbstractLogView : public QAbstractScrollArea, public SearchableWidgetInter
     LineNumber getTopLine() const;
     // Return the text of the current selection.
     QString getSelectedText() const;
+    // Copy the current selection to the clipboard, large selections
+    // are read on a worker thread or when the clipboard is pasted.
+    void copySelection( bool lineNumbers, bool updateSelection );
     // True for partial selection
     bool isPartialSelection() const;
     // Instructs the widget to select the whole text.
@@ -156,6 +172,11 @@ class AbstractLogView : public QAbstractScrollArea, public SearchableWidgetInter
     using QuickHighlighters = QStringList;
     void setQuickHighlighters( const std::vector<QuickHighlighters>& wordHighlighters );
 
+    // Rebuild the highlighters of the search pattern and of the quick
+    // highlighted words, and drop the highlights computed so far.
+    // To be used when the highlighters configuration has changed.
+    void updateHighlighters();
+
     void registerShortcuts();
 
   protected:
@@ -368,11 +389,15 @@ class AbstractLogView : public QAbstractScrollArea, public SearchableWidgetInter
     bool lastLineAligned_ = false;
     bool useTextWrap_ = false;
     LineColumn firstCol_ = 0_lcol;
+    // In text wrap mode, the first rows of firstLine are above the view
+    LinesCount firstWrappedRow_ = 0_lcount;
 
     struct WrappedLineData {
       LineNumber lineNumber;
       size_t wrappedLineIndex;
       WrappedString wrappedString;
+      // Column of the line at which wrappedString starts
+      LineColumn windowStart;
     };
     klogg::vector<WrappedLineData> wrappedLinesInfo_;
 
@@ -415,6 +440,36 @@ class AbstractLogView : public QAbstractScrollArea, public SearchableWidgetInter
     // Our own QuickFind object
     QuickFind* quickFind_;
 
+    // Computes the highlights of the painted lines
+    LineHighlighter lineHighlighter_;
+
+    // Compiled once when the search pattern or the quick highlighters
+    // change, not at each paint, and shared with the prefetching thread
+    std::shared_ptr<const ViewHighlighters> viewHighlighters_
+        = std::make_shared<const ViewHighlighters>();
+
+    // Highlights of the recently painted lines, valid for the current
+    // generation only
+    LineHighlightsCache highlightsCache_;
+    uint64_t highlightsGeneration_ = 0;
+
+    // Colors of the whole long lines drawn by windows, matched on the full
+    // line as a window alone can't tell, in the same generations
+    LineHighlightsCache longLinesColorsCache_{ 64 };
+
+    // Reads and highlights the lines ahead of the view while scrolling
+    LinesPrefetcher linesPrefetcher_;
+
+    // Selections held by the clipboard, their text may still be read
+    klogg::vector<QPointer<SelectionMimeData>> copiedSelections_;
+
+    // Laid out chunks of the lines drawn recently
+    StaticTextCache staticTextCache_;
+
+    // Rows taken by the lines in text wrap mode
+    WrappedLinesIndex wrappedLinesIndex_;
+    bool scrollBarCountsRows_ = false;
+
 #ifdef GLOGG_PERF_MEASURE_FPS
     // Performance measurement
     PerfCounter perfCounter_;
@@ -430,12 +485,13 @@ class AbstractLogView : public QAbstractScrollArea, public SearchableWidgetInter
         LineNumber first_line_;
         LineNumber last_line_;
         LineColumn first_column_;
+        int line_number_digits_;
     };
     struct PullToFollowCache {
         QPixmap pixmap_;
         LineLength nb_columns_;
     };
-    TextAreaCache textAreaCache_ = { {}, true, 0_lnum, 0_lnum, 0_lcol };
+    TextAreaCache textAreaCache_ = { {}, true, 0_lnum, 0_lnum, 0_lcol, 0 };
     PullToFollowCache pullToFollowCache_ = { {}, 0_length };
     QFontMetrics pixmapFontMetrics_;
 
@@ -468,6 +524,8 @@ class AbstractLogView : public QAbstractScrollArea, public SearchableWidgetInter
 
     // Save specified lines in range [begin, end) to a file
     void saveLinesToFile( LineNumber begin, LineNumber end );
+    // Copy the lines as they are in the source file, on a worker thread
+    void saveRawLinesToFile( const LinesExporter& exporter, QSaveFile& saveFile );
 
     // Search functions (for n/N)
     using QuickFindSearchFn = void ( QuickFind::* )( Selection, QuickFindMatcher );
@@ -475,11 +533,24 @@ class AbstractLogView : public QAbstractScrollArea, public SearchableWidgetInter
 
     void updateScrollBars();
 
-    LineNumber verticalScrollToLineNumber( int scrollPosition ) const;
+    // Rows of the view are lines, or the rows of wrapped lines
+    // once the wrapped lines index is ready
+    bool isWrappedLinesIndexUsed() const;
+    LinesCount rowOfLine( LineNumber line ) const;
+    LinesCount nbRows() const;
+
+    WrappedLinesIndex::Position verticalScrollToPosition( int scrollPosition ) const;
     int lineNumberToVerticalScroll( LineNumber line ) const;
+    int rowToVerticalScroll( LinesCount row ) const;
     double verticalScrollMultiplicator() const;
-
-    void drawTextArea( QPaintDevice* paintDevice );
+    void wrappedLinesIndexReady();
+
+    bool scrollTextAreaCache();
+    void drawTextArea( QPaintDevice* paintDevice, LinesCount firstRow, LinesCount nbRows );
+    const LineHighlights& lineHighlights( LineNumber lineNumber, const QString& logLine,
+                                          const HighlighterSet& highlighterSet );
+    std::optional<std::pair<QColor, QColor>>
+    longLineColors( LineNumber lineNumber, const HighlighterSet& highlighterSet );
     QPixmap drawPullToFollowBar( int width, qreal pixelRatio );
 
     void disableFollow();
@@ -89,6 +89,8 @@ class CrawlerWidget : public QSplitter,
     LineNumber getTopLine() const;
     // Get the selected text as a string (from the main window)
     QString getSelectedText() const;
+    // Copy the selection of the active view to the clipboard
+    void copySelectedText();
     // True for partial selection
     bool isPartialSelection() const;
 
@@ -196,6 +198,8 @@ class CrawlerWidget : public QSplitter,
     void exitingQuickFind();
     // Called when new data must be displayed in the filtered window.
     void updateFilteredView( LinesCount nbMatches, int progress, LineNumber initialPosition );
+    // Called when the number of matches of the running search has been estimated.
+    void updateSearchEstimate( LinesCount estimate, LinesCount margin );
     // Called when a new line has been selected in the filtered view,
     // to instruct the main view to jump to the matching line.
     void jumpToMatchingLine( LineNumber filteredLineNb, LinesCount nLines, LineColumn startCol,
@@ -346,6 +350,9 @@ class CrawlerWidget : public QSplitter,
     void updateColorLabels( const ColorLabelsManager::QuickHighlightersCollection& labels );
 
     void connectAllFilteredViewSlots( FilteredView* view);
+    // Set the text of a search tab, the tabs of the searches nested
+    // in it are renamed after it.
+    void setFilteredViewTabText( int tabIndex, const QString& text );
 
     void saveSplitterSizes() const;
 
@@ -387,6 +394,7 @@ class CrawlerWidget : public QSplitter,
     QToolButton* clearButton_;
     QToolButton* searchButton_;
     QToolButton* keepSearchResultsButton_;
+    QToolButton* refineSearchButton_;
     QToolButton* stopButton_;
 
     QToolButton* matchCaseButton_;
@@ -415,6 +423,8 @@ class CrawlerWidget : public QSplitter,
 
     // Current number of matches
     LinesCount nbMatches_;
+    // Estimated number of matches shown while the search is running
+    QString searchEstimateText_;
 
     LineNumber searchStartLine_;
     LineNumber searchEndLine_;
@@ -423,6 +433,8 @@ class CrawlerWidget : public QSplitter,
     // should consider we are loading something.
     bool loadingInProgress_ = true;
     bool firstLoadDone_ = false;
+    // First line changed by the file changes since the last loading
+    OptionalLineNumber firstChangedLine_;
 
     klogg::vector<LineNumber> savedMarkedLines_;
 
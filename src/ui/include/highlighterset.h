@@ -69,6 +69,16 @@ class Highlighter {
 
     bool matchLine( const QString& line, klogg::vector<HighlightedMatch>& matches ) const;
 
+    // Returns the match of the given part of the line, with the colors
+    // it should be rendered in.
+    HighlightedMatch highlightedMatch( const QString& line, LineColumn start,
+                                       LineLength length ) const;
+
+    // Returns true if the parts of the line to highlight can only be found
+    // by QRegularExpression (capture groups, lazy quantifiers, alternations),
+    // not from the ranges located by the hyperscan engine.
+    bool needsRegexpRanges() const;
+
     // Accessor functions
     QString pattern() const;
     void setPattern( const QString& pattern );
@@ -107,6 +117,7 @@ class Highlighter {
     QRegularExpression regexp_;
     
     mutable std::optional<QRegularExpression> optimizedRegexp_;
+    mutable bool needsRegexpRanges_ = false;
 
     bool useRegex_ = true;
     bool highlightOnlyMatch_ = false;
@@ -118,6 +129,8 @@ class Highlighter {
 
 enum class HighlighterMatchType { NoMatch, WordMatch, LineMatch };
 
+class HighlighterSetMatcher;
+
 // Represents an ordered set of filters to be applied to each line displayed.
 class HighlighterSet {
   public:
@@ -135,6 +148,8 @@ class HighlighterSet {
 
     // Returns weither the passed line match a filter of the set,
     // if so, it returns the fore/back colors the line should use.
+    // A new matcher is created for each call, views matching many lines
+    // should keep a HighlighterSetMatcher instead.
     HighlighterMatchType matchLine( const QString& line,
                                     HighlightedMatchRanges& matches ) const;
 
@@ -161,8 +176,39 @@ class HighlighterSet {
     // internal structure directly.
     friend class HighlighterSetEdit;
     friend class HighlighterSetCollection;
+    friend class HighlighterSetMatcher;
+
+    mutable std::shared_ptr<HsRangesRegularExpression> compiledExpression_;
+};
+
+// Matches lines against the highlighters of a set. The matches of all
+// highlighters are located in a single scan of the line, only the
+// highlighters the engine can't locate are run with QRegularExpression,
+// on the lines their prefilter accepts.
+// The matcher owns engine scratch space: views keep one and reuse it for
+// every painted line, it must not be used from several threads.
+class HighlighterSetMatcher {
+  public:
+    HighlighterMatchType matchLine( const HighlighterSet& highlighterSet, const QString& line,
+                                    HighlightedMatchRanges& matches );
+
+    // Returns true if the last lines were matched against the set
+    // as it is compiled now.
+    bool isMatchingWith( const HighlighterSet& highlighterSet ) const;
+
+  private:
+    void buildColumnIndex( std::size_t utf8Size );
+    LineColumn toColumn( std::size_t utf8Offset ) const;
+
+  private:
+    std::shared_ptr<HsRangesRegularExpression> expression_;
+    HsRangesMatcher matcher_;
+
+    klogg::vector<char> utf8Data_;
+    klogg::vector<PatternMatchRange> ranges_;
 
-    mutable std::shared_ptr<MultiRegularExpression> compiledExpression_;
+    // utf16 column of each byte of the utf8 data, empty for ascii lines
+    klogg::vector<int> utf16Columns_;
 };
 
 struct QuickHighlighter {
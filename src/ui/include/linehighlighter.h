@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_LINEHIGHLIGHTER_H
+#define KLOGG_LINEHIGHLIGHTER_H
+
+#include <optional>
+#include <utility>
+
+#include <QColor>
+#include <QString>
+
+#include "containers.h"
+#include "highlighterset.h"
+#include "linehighlightscache.h"
+
+// Highlighters a view applies on top of the active highlighter set:
+// the main search pattern and the quick highlighted words.
+// They are compiled when built and never modified afterwards, so the
+// same instance can be shared with background threads.
+struct ViewHighlighters {
+    std::optional<Highlighter> searchPattern;
+    klogg::vector<Highlighter> quickHighlightWords;
+};
+
+// Computes the highlights of the lines of a view.
+// Holds the matcher scratch space of the highlighter set, so each
+// thread computing highlights needs its own LineHighlighter.
+class LineHighlighter {
+  public:
+    LineHighlights highlight( const QString& line, const HighlighterSet& highlighterSet,
+                              const ViewHighlighters& viewHighlighters );
+
+    // Returns the colors of the whole line if a highlighter of the set
+    // matches it, without computing the highlighted parts.
+    std::optional<std::pair<QColor, QColor>> lineColors( const QString& line,
+                                                         const HighlighterSet& highlighterSet );
+
+    // Returns true if the last lines were highlighted with the set
+    // as it is compiled now.
+    bool isHighlightingWith( const HighlighterSet& highlighterSet ) const;
+
+  private:
+    HighlighterSetMatcher highlighterSetMatcher_;
+    klogg::vector<HighlightedMatch> patternMatches_;
+};
+
+#endif
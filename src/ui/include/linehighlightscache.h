@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_LINEHIGHLIGHTSCACHE_H
+#define KLOGG_LINEHIGHLIGHTSCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include <QColor>
+
+#include "containers.h"
+#include "highlightedmatch.h"
+#include "linetypes.h"
+#include "lrucache.h"
+
+// Highlights computed for a line of a view: the colors of the whole line
+// if a highlighter matches it, and the highlighted parts, as columns of the
+// untabified line.
+struct LineHighlights {
+    std::optional<std::pair<QColor, QColor>> lineColors;
+    klogg::vector<HighlightedMatch> matches;
+};
+
+// Least recently used cache of the highlights of the lines of a view.
+// Entries are keyed by line number and generation: the view moves to a new
+// generation each time its highlighters or its content change, entries
+// of older generations are never returned and get evicted over time.
+class LineHighlightsCache {
+  public:
+    static constexpr std::size_t DefaultCapacity = 2048;
+
+    explicit LineHighlightsCache( std::size_t capacity = DefaultCapacity );
+
+    // Returns the highlights of the line if they were computed in
+    // this generation, nullptr otherwise.
+    const LineHighlights* find( LineNumber line, uint64_t generation );
+
+    const LineHighlights& insert( LineNumber line, uint64_t generation,
+                                  LineHighlights highlights );
+
+    void clear();
+
+    std::size_t size() const;
+
+  private:
+    struct Entry {
+        uint64_t generation;
+        LineHighlights highlights;
+    };
+
+    LruCache<LineNumber::UnderlyingType, Entry> entries_;
+};
+
+#endif
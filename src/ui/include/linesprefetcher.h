@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_LINESPREFETCHER_H
+#define KLOGG_LINESPREFETCHER_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include <QFuture>
+#include <QString>
+
+#include "atomicflag.h"
+#include "containers.h"
+#include "highlighterset.h"
+#include "linehighlighter.h"
+#include "linehighlightscache.h"
+#include "linetypes.h"
+#include "synchronization.h"
+
+class AbstractLogData;
+
+// Reads and highlights in a background thread the lines a view is about
+// to show while it is being scrolled, so that painting finds them ready
+// instead of going to the file.
+// The direction and the speed of scrolling are estimated from the
+// successive positions of the view: the faster it goes, the more screens
+// ahead are prefetched.
+// This class is thread-safe.
+class LinesPrefetcher {
+  public:
+    struct PrefetchedLine {
+        QString text;
+        LineHighlights highlights;
+    };
+
+    explicit LinesPrefetcher( const AbstractLogData& logData );
+    ~LinesPrefetcher();
+
+    LinesPrefetcher( const LinesPrefetcher& ) = delete;
+    LinesPrefetcher& operator=( const LinesPrefetcher& ) = delete;
+
+    // Records the position of the view after a paint and, if the view is
+    // scrolling, schedules prefetching of the lines ahead of it.
+    // The highlighter set must be compiled.
+    void viewMoved( LineNumber firstLine, LinesCount nbVisibleLines, uint64_t generation,
+                    const HighlighterSet& highlighterSet,
+                    std::shared_ptr<const ViewHighlighters> viewHighlighters );
+
+    // Copies the lines [firstLine, firstLine + nbLines) to lines, only if
+    // they have all been prefetched in this generation.
+    bool getLines( LineNumber firstLine, LinesCount nbLines, uint64_t generation,
+                   klogg::vector<PrefetchedLine>& lines ) const;
+
+    // Forgets the prefetched lines, e.g. when the data has changed.
+    void invalidate();
+
+  private:
+    struct Request {
+        LineNumber firstLine;
+        LinesCount nbLines;
+        uint64_t generation;
+        HighlighterSet highlighterSet;
+        std::shared_ptr<const ViewHighlighters> viewHighlighters;
+    };
+
+    struct Page {
+        LineNumber firstLine;
+        uint64_t generation;
+        klogg::vector<PrefetchedLine> lines;
+    };
+
+    enum class Direction { Up, Down };
+
+    LinesCount linesAhead( LinesCount nbVisibleLines ) const;
+    void schedule( Request request );
+    void runPrefetch();
+    void prefetch( const Request& request );
+
+    // Page containing all the lines, mutex_ must be held.
+    const Page* findPage( LineNumber firstLine, LinesCount nbLines, uint64_t generation ) const;
+
+  private:
+    const AbstractLogData& logData_;
+
+    // Scrolling estimation, only used from the view thread
+    OptionalLineNumber lastFirstLine_;
+    std::chrono::steady_clock::time_point lastMoveTime_;
+    double linesPerSecond_ = 0;
+    Direction direction_ = Direction::Down;
+
+    mutable Mutex mutex_;
+    klogg::vector<Page> pages_;
+    std::optional<Request> pendingRequest_;
+    bool isPrefetching_ = false;
+
+    // Only used by the prefetching thread
+    LineHighlighter lineHighlighter_;
+
+    AtomicFlag interruptRequested_;
+    QFuture<void> prefetchFuture_;
+};
+
+#endif
@@ -137,6 +137,7 @@ class MainWindow : public QMainWindow {
     void removeFromFavorites();
     void selectOpenedFile();
     void generateDump();
+    void toggleTracing( bool isEnabled );
 
     // Change the view settings
     void toggleOverviewVisibility( bool isVisible );
@@ -281,6 +282,7 @@ class MainWindow : public QMainWindow {
     QAction* joinDiscordAction;
     QAction* joinTelegramAction;
     QAction* generateDumpAction;
+    QAction* recordTraceAction;
     QActionGroup* encodingGroup;
     QAction* addToFavoritesAction;
     QAction* addToFavoritesMenuAction;
@@ -85,6 +85,8 @@ extern const char* joinTelegramText;
 extern const char* joinTelegramStatusTip;
 extern const char* generateDumpText;
 extern const char* generateDumpStatusTip;
+extern const char* recordTraceText;
+extern const char* recordTraceStatusTip;
 extern const char* showScratchPadText;
 extern const char* showScratchPadStatusTip;
 extern const char* addToFavoritesText;
@@ -22,8 +22,10 @@
 
 #include "linetypes.h"
 #include <QList>
+#include <QtGlobal>
 #include <QVector>
 
+class LinesHistogram;
 class LogFilteredData;
 
 // Class implementing the logic behind the matches overview bar.
@@ -34,10 +36,11 @@ class LogFilteredData;
 // This class is NOT thread-safe.
 class Overview {
   public:
-    // A line with a position in pixel and a weight (darkness)
+    // A line with a position in pixel and a weight (darkness), growing
+    // with the density of lines it stands for.
     class WeightedLine {
       public:
-        static constexpr int WEIGHT_STEPS = 3;
+        static constexpr int WEIGHT_STEPS = 8;
 
         WeightedLine()
         {
@@ -50,6 +53,11 @@ class Overview {
             pos_ = pos;
             weight_ = 0;
         }
+        WeightedLine( int pos, int weight )
+        {
+            pos_ = pos;
+            weight_ = qBound( 0, weight, WEIGHT_STEPS - 1 );
+        }
 
         int position() const
         {
@@ -60,11 +68,6 @@ class Overview {
             return weight_;
         }
 
-        void load()
-        {
-            weight_ = qMin( weight_ + 1, WEIGHT_STEPS - 1 );
-        }
-
       private:
         int pos_;
         int weight_;
@@ -134,6 +137,7 @@ class Overview {
     klogg::vector<WeightedLine> markLines_;
 
     void recalculatesLines();
+    void fillLines( const LinesHistogram& histogram, klogg::vector<WeightedLine>& lines ) const;
 };
 
 #endif
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KLOGG_PROGRESSDIALOGTASK_H
+#define KLOGG_PROGRESSDIALOGTASK_H
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QString>
+#include <QtConcurrent>
+
+#include "atomicflag.h"
+
+// Runs the task on a worker thread while a modal progress dialog is shown,
+// the task is passed the interrupt request set by cancelling the dialog
+// and a callback to report its progress in percents.
+template <typename Task>
+auto runWithProgressDialog( QWidget* parent, const QString& label, AtomicFlag& interruptRequest,
+                            Task&& task )
+{
+    using ProgressCallback = std::function<void( int )>;
+    using Result = std::invoke_result_t<Task, const AtomicFlag&, const ProgressCallback&>;
+
+    QProgressDialog progressDialog( parent );
+    progressDialog.setLabelText( label );
+    progressDialog.setRange( 0, 100 );
+    // The dialog is closed once the worker thread is done
+    progressDialog.setAutoReset( false );
+    progressDialog.setAutoClose( false );
+    progressDialog.setWindowModality( Qt::ApplicationModal );
+
+    QObject::connect( &progressDialog, &QProgressDialog::canceled,
+                      [ &interruptRequest ]() { interruptRequest.set(); } );
+
+    QFutureWatcher<Result> taskWatcher;
+    QObject::connect( &taskWatcher, &QFutureWatcher<Result>::finished, &progressDialog,
+                      [ &progressDialog ]() { progressDialog.done( 0 ); } );
+
+    const ProgressCallback reportProgress = [ &progressDialog ]( int percent ) {
+        QMetaObject::invokeMethod(
+            &progressDialog, [ &progressDialog, percent ]() { progressDialog.setValue( percent ); },
+            Qt::QueuedConnection );
+    };
+
+    taskWatcher.setFuture( QtConcurrent::run( [ &task, &interruptRequest, &reportProgress ]() {
+        return task( std::as_const( interruptRequest ), reportProgress );
+    } ) );
+
+    progressDialog.exec();
+    taskWatcher.waitForFinished();
+
+    return taskWatcher.result();
+}
+
+#endif
@@ -21,6 +21,7 @@
 #define QFNOTIFICATIONS_H
 
 #include <QFontMetrics>
+#include <QLocale>
 #include <QObject>
 #include <QWidget>
 
@@ -88,4 +89,15 @@ class QFNotificationProgress : public QFNotification {
     }
 };
 
+class QFNotificationMatchPosition : public QFNotification {
+  public:
+    // Constructor taking the position of the match (starting at 1)
+    QFNotificationMatchPosition( qulonglong position, qulonglong nbMatches )
+        : QFNotification( QObject::tr( "Match %1 of %2" )
+                              .arg( QLocale().toString( position ),
+                                    QLocale().toString( nbMatches ) ) )
+    {
+    }
+};
+
 #endif
@@ -48,6 +48,7 @@
 #include "atomicflag.h"
 #include "linetypes.h"
 #include "qfnotifications.h"
+#include "quickfindmatchindex.h"
 #include "quickfindpattern.h"
 #include "selection.h"
 
@@ -106,6 +107,8 @@ class QuickFind : public QObject {
 
     // Make the object forget the 'no more match' flag.
     void resetLimits();
+    // Same, when only the lines from firstChangedLine on have changed.
+    void resetLimits( LineNumber firstChangedLine );
 
   public Q_SLOTS:
     // Used for incremental searches
@@ -219,6 +222,10 @@ class QuickFind : public QObject {
 
     SearchingNotifier searchingNotifier_;
 
+    // Matching lines of the current pattern, built when searching
+    // for the next or previous match
+    QuickFindMatchIndex matchIndex_;
+
     // Incremental search status
     IncrementalSearchStatus incrementalSearchStatus_;
 
@@ -230,6 +237,19 @@ class QuickFind : public QObject {
     Portion doSearchBackward( const FilePosition& start_position, const Selection& selection,
                               const QuickFindMatcher& matcher );
 
+    // Scan the lines by chunks, from firstLine forward or from the line
+    // before endLine backward down to firstLine, and return the first line
+    // the scanner matches.
+    OptionalLineNumber findNextMatchingLine( LineNumber firstLine,
+                                             const QuickFindLineScanner& scanner );
+    OptionalLineNumber findPreviousMatchingLine( LineNumber endLine, LineNumber firstLine,
+                                                 const QuickFindLineScanner& scanner );
+    LinesCount scanChunkSize() const;
+
+    // Clear the notifications, or show the position
+    // of the match if the index is ready
+    void notifyMatchFound( LineNumber line, const QuickFindMatcher& matcher );
+
     AtomicFlag interruptRequested_;
     QFuture<Portion> operationFuture_;
     QFutureWatcher<Portion> operationWatcher_;
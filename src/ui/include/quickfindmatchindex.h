@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_QUICKFINDMATCHINDEX_H
+#define KLOGG_QUICKFINDMATCHINDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+#include <QRegularExpression>
+#include <QThreadPool>
+
+#include "linetypes.h"
+#include "logfiltereddataworker.h"
+#include "quickfindpattern.h"
+#include "synchronization.h"
+
+class AbstractLogData;
+
+// Index of all the lines of a log data matching a QuickFind pattern.
+// It is built in the background, scanning chunks of lines in parallel,
+// and then answers which matching line comes after or before a given line
+// without reading the file. When the data grows, only the appended lines
+// are scanned to extend the index.
+// This class is thread-safe.
+class QuickFindMatchIndex {
+  public:
+    explicit QuickFindMatchIndex( const AbstractLogData& logData );
+    ~QuickFindMatchIndex();
+
+    QuickFindMatchIndex( const QuickFindMatchIndex& ) = delete;
+    QuickFindMatchIndex& operator=( const QuickFindMatchIndex& ) = delete;
+
+    // Starts indexing in the background the lines not indexed yet for the
+    // pattern of matcher. Another pattern replaces the index.
+    void build( const QuickFindMatcher& matcher );
+
+    // Stops the build and forgets the index, e.g. when the data has changed.
+    void invalidate();
+    // Stops the build and forgets the lines from firstLine on,
+    // the next build indexes them again.
+    void invalidateFrom( LineNumber firstLine );
+
+    // Returns whether all the lines are indexed for the pattern of matcher.
+    bool isReady( const QuickFindMatcher& matcher ) const;
+    // Returns the number of first lines indexed for the pattern of matcher,
+    // the index doesn't know the lines appended after them.
+    LinesCount indexedLines( const QuickFindMatcher& matcher ) const;
+
+    // First matching line after line
+    OptionalLineNumber nextMatch( LineNumber line ) const;
+    // Last matching line before line
+    OptionalLineNumber previousMatch( LineNumber line ) const;
+
+    // Position (starting at 1) of a matching line among all matches
+    LinesCount matchPosition( LineNumber line ) const;
+    LinesCount nbMatches() const;
+
+  private:
+    void buildIndex( const QuickFindMatcher& matcher, uint64_t generation );
+    SearchResultArray scanLines( const QuickFindMatcher& matcher, LineNumber firstLine,
+                                 LineNumber endLine, uint64_t generation ) const;
+    // Drops the results of the running build, must be called with mutex_ held
+    void stopBuild();
+
+  private:
+    const AbstractLogData& logData_;
+
+    mutable Mutex mutex_;
+    SearchResultArray matches_;
+    QRegularExpression indexedRegexp_;
+    LinesCount indexedLines_;
+    // Lines the running build indexes, raised when the data grows
+    LinesCount requestedLines_;
+    bool isBuilding_ = false;
+
+    // Changed to interrupt the running build, which then drops its results
+    std::atomic<uint64_t> generation_{ 0 };
+    QThreadPool buildPool_;
+};
+
+#endif
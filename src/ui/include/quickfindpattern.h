@@ -39,6 +39,10 @@
 #ifndef QUICKFINDPATTERN_H
 #define QUICKFINDPATTERN_H
 
+#include <functional>
+#include <memory>
+#include <string_view>
+
 #include <QList>
 #include <QObject>
 #include <QRegularExpression>
@@ -48,7 +52,9 @@
 #include "highlightedmatch.h"
 #include "containers.h"
 #include "linetypes.h"
+#include "regularexpression.h"
 
+class AbstractLogData;
 class QuickFind;
 
 class QuickFindMatcher {
@@ -66,6 +72,11 @@ class QuickFindMatcher {
         return isActive_;
     }
 
+    const QRegularExpression& regexp() const
+    {
+        return regexp_;
+    }
+
     // Returns whether there is a match in the passed line, starting at
     // the passed column.
     // Results are stored internally.
@@ -86,6 +97,39 @@ class QuickFindMatcher {
     mutable LineColumn lastMatchEnd_;
 };
 
+// Tells whether lines as returned by AbstractLogData::getLines contain
+// a match of a QuickFind matcher, using the search engine on utf8 text
+// instead of matching the expanded utf16 line. Lines with tabs are
+// expanded and matched with the QuickFindMatcher, so that patterns
+// matching the spaces of expanded tabs are still found.
+// Lines of a LogData are read raw and matched in the utf8 view built for
+// the search, only lines with tabs are decoded.
+// The match columns are not computed, the QuickFindMatcher has to be run
+// on the expanded matching line to get them.
+class QuickFindLineScanner {
+  public:
+    explicit QuickFindLineScanner( const QuickFindMatcher& matcher );
+
+    bool isLineMatching( const QString& line ) const;
+
+    // Reads number lines of logData from first and calls onMatch with the
+    // index (relative to first) of each matching line, from the last one
+    // if backward is set, until onMatch returns false.
+    void scanLines( const AbstractLogData& logData, LineNumber first, LinesCount number,
+                    bool backward, const std::function<bool( size_t )>& onMatch ) const;
+
+  private:
+    // Same as isLineMatching for the utf8 line, decode returns the line
+    // as it would have been returned by getLines.
+    bool isLineMatching( std::string_view utf8Line,
+                         const std::function<QString()>& decode ) const;
+
+  private:
+    QuickFindMatcher matcher_;
+    RegularExpression expression_;
+    std::unique_ptr<PatternMatcher> engineMatcher_;
+};
+
 // Represents a search pattern for QuickFind (without its results)
 class QuickFindPattern : public QObject {
     Q_OBJECT
@@ -23,7 +23,11 @@
 #include <QList>
 #include <QString>
 #include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
 
+#include "atomicflag.h"
 #include "linetypes.h"
 
 class AbstractLogData;
@@ -153,6 +157,32 @@ class Selection {
     // Returns the text selected from the passed AbstractLogData
     QString getSelectedText( const AbstractLogData* logData, bool lineNumbers = false ) const;
 
+    // percent being the percentage of the selected lines read
+    using TextProgressCallback = std::function<void( int percent )>;
+
+    // Returns the text selected from the passed AbstractLogData, the lines
+    // of a range are read by chunks. Returns nothing if interrupted or if
+    // the text would be longer than maxSize characters.
+    std::optional<QString> getSelectedText( const AbstractLogData* logData, bool lineNumbers,
+                                            qint64 maxSize, const AtomicFlag& interruptRequest,
+                                            const TextProgressCallback& progressCallback ) const;
+
+    // First line and number of lines of consecutive lines
+    using LineRuns = klogg::vector<std::pair<LineNumber, LinesCount>>;
+
+    // Returns the lines of the source file (counted from 0) selected in the
+    // passed AbstractLogData, consecutive lines being merged.
+    // Nothing is returned for a portion of line.
+    LineRuns getSourceLines( const AbstractLogData* logData ) const;
+
+    // Returns the text of the lines of the passed AbstractLogData, formatted
+    // as getSelectedText() does. Returns nothing if interrupted or if the
+    // text would be longer than maxSize characters.
+    static std::optional<QString> getLinesText( const AbstractLogData* logData,
+                                                const LineRuns& lines, bool lineNumbers,
+                                                qint64 maxSize, const AtomicFlag& interruptRequest,
+                                                const TextProgressCallback& progressCallback );
+
     // Return the position immediately after the current selection
     // (used for searches).
     // This is the next character or the start of the next line.
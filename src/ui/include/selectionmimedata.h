@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_SELECTIONMIMEDATA_H
+#define KLOGG_SELECTIONMIMEDATA_H
+
+#include <cstdint>
+#include <optional>
+
+#include <QFutureWatcher>
+#include <QMimeData>
+#include <QPointer>
+
+#include "abstractlogdata.h"
+#include "atomicflag.h"
+#include "selection.h"
+
+class LogData;
+
+// Clipboard data holding a selection of a log. Its text is read on a worker
+// thread from the time it is copied, clipboard requests never wait for it:
+// they get nothing until it has been read. A clipboard manager asking for
+// the text right away is then sent it by textRead().
+// The lines of the file holding the selection are found when copying, so
+// the text pasted is the one copied even if the view has changed since,
+// e.g. when more matches have been found.
+// Only used on platforms where the clipboard asks the owner for its
+// content at paste time (X11 and Wayland), elsewhere the text is read
+// before setting the clipboard.
+class SelectionMimeData : public QMimeData {
+    Q_OBJECT
+
+  public:
+    SelectionMimeData( const AbstractLogData* logData, const Selection& selection,
+                       bool lineNumbers, qint64 maxSize );
+    ~SelectionMimeData() override;
+
+    SelectionMimeData( const SelectionMimeData& ) = delete;
+    SelectionMimeData& operator=( const SelectionMimeData& ) = delete;
+
+    // Returns whether the clipboard of the platform reads data lazily
+    static bool isSupported();
+
+    bool hasFormat( const QString& mimeType ) const override;
+    QStringList formats() const override;
+
+    // Stops reading the text and waits for the worker,
+    // must be called before the log data is destroyed.
+    void stopReading();
+
+  Q_SIGNALS:
+    // Sent when the text could not be pasted, with the reason to show
+    void textUnavailable( const QString& message ) const;
+    // Sent once the text has been read if it was requested before
+    void textRead( const QString& text );
+
+  protected:
+#if QT_VERSION >= QT_VERSION_CHECK( 6, 0, 0 )
+    QVariant retrieveData( const QString& mimeType, QMetaType type ) const override;
+#else
+    QVariant retrieveData( const QString& mimeType, QVariant::Type type ) const override;
+#endif
+
+  private:
+    bool isFileChanged() const;
+    void handleTextRead();
+
+  private:
+    // The file may be closed before the clipboard is pasted
+    QPointer<LogData> sourceLogData_;
+    // The lines are not the copied ones anymore if the file has changed
+    uint64_t contentGeneration_ = 0;
+    Selection::LineRuns lines_;
+    bool lineNumbers_;
+    qint64 maxSize_;
+
+    AtomicFlag interruptRequest_;
+    // Nothing if the text is larger than maxSize_
+    QFutureWatcher<std::optional<QString>> readWatcher_;
+
+    // Kept once read so all pastes are the same
+    std::optional<QString> text_;
+    // Why the text can't be pasted, kept so all pastes report it
+    std::optional<QString> unavailableMessage_;
+    mutable bool isRequestedEarly_ = false;
+};
+
+#endif
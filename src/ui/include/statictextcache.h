@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_STATICTEXTCACHE_H
+#define KLOGG_STATICTEXTCACHE_H
+
+#include <cstddef>
+
+#include <QFont>
+#include <QHash>
+#include <QStaticText>
+#include <QString>
+#include <QStringView>
+
+#include "lrucache.h"
+
+// Least recently used cache of laid out pieces of text, so that the chunks
+// of lines that stay on screen are not shaped again each time they are drawn.
+// All the texts are laid out with the same font, changing the font
+// empties the cache.
+class StaticTextCache {
+  public:
+    static constexpr std::size_t DefaultCapacity = 4096;
+
+    explicit StaticTextCache( std::size_t capacity = DefaultCapacity );
+
+    // Returns the text laid out with the font, ready to be drawn.
+    // The reference is valid until the next call.
+    const QStaticText& get( QStringView text, const QFont& font );
+
+    void clear();
+
+    std::size_t size() const;
+
+  private:
+    struct TextHash {
+        std::size_t operator()( const QString& text ) const
+        {
+            return qHash( text );
+        }
+    };
+
+    QFont font_;
+    LruCache<QString, QStaticText, TextHash> entries_;
+};
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_WRAPPEDLINESINDEX_H
+#define KLOGG_WRAPPEDLINESINDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include <QFuture>
+
+#include "atomicflag.h"
+#include "containers.h"
+#include "linetypes.h"
+#include "synchronization.h"
+
+class AbstractLogData;
+
+// Number of rows taken on screen by each line of a log data in text wrap
+// mode, for a number of visible columns.
+// It is built in the background, wrapping chunks of lines in parallel.
+// Only the lines wrapped on several rows are stored, along with the row
+// they start at, so that converting between lines and rows is a binary
+// search over these lines.
+// The expanded length of each line is kept from the first build. When the
+// width changes, lines no wider than it take one row without being read
+// again, only the wider ones are read and wrapped as lines break at spaces.
+// When lines are appended or changed after some line, only the lines from
+// there are read again.
+// The last complete index keeps answering while it is being updated, lines
+// it does not know of are counted as one row.
+// This class is thread-safe.
+class WrappedLinesIndex {
+  public:
+    // Called from the building thread each time a new index is complete
+    using ReadyCallback = std::function<void()>;
+
+    // Row of the screen within the rows of the whole data
+    struct Position {
+        LineNumber line;
+        LinesCount wrappedRow;
+    };
+
+    WrappedLinesIndex( const AbstractLogData& logData, ReadyCallback readyCallback );
+    ~WrappedLinesIndex();
+
+    WrappedLinesIndex( const WrappedLinesIndex& ) = delete;
+    WrappedLinesIndex& operator=( const WrappedLinesIndex& ) = delete;
+
+    // Starts building the index for visibleColumns in the background,
+    // unless it is already built or being built for them.
+    void build( LineLength visibleColumns );
+
+    // Stops the build, the lines from firstChangedLine will be wrapped
+    // again by the next call to build(), e.g. after lines have been appended.
+    // Does not wait for the stopped build to finish.
+    void update( LineNumber firstChangedLine );
+
+    // Same as update() for all the lines, e.g. when the data is truncated.
+    void invalidate();
+
+    // Returns whether a complete index for visibleColumns is available.
+    bool isReady( LineLength visibleColumns ) const;
+
+    // Number of rows taken by the lines before line
+    LinesCount rowOfLine( LineNumber line ) const;
+
+    // Line displayed at row, and the row within that line
+    Position lineAtRow( LinesCount row ) const;
+
+  private:
+    struct Build {
+        LineLength visibleColumns;
+        LineNumber firstLine;
+        // Lines before this one have a known length
+        LineNumber firstUnmeasuredLine;
+        LineNumber endLine;
+        uint64_t generation;
+        std::shared_ptr<AtomicFlag> interruptRequested;
+    };
+
+    void buildIndex( const Build& build );
+
+    // Lines of known length in [firstLine, endLine) wider than the build
+    // width, none if the build has been stopped.
+    klogg::vector<LineNumber> linesWiderThan( LineNumber firstLine, LineNumber endLine,
+                                              const Build& build ) const;
+
+    // Must be called with mutex_ held
+    void stopBuild();
+
+  private:
+    struct WrappedLine {
+        LineNumber line;
+        LinesCount firstRow;
+        LinesCount nbRows;
+    };
+
+    struct Layout {
+        LineLength visibleColumns;
+        LinesCount nbLines;
+        klogg::vector<WrappedLine> wrappedLines;
+    };
+
+    const AbstractLogData& logData_;
+    ReadyCallback readyCallback_;
+
+    mutable SharedMutex mutex_;
+    std::optional<Layout> layout_;
+    OptionalLineNumber firstChangedLine_;
+
+    // Expanded lengths of the first lines, whatever the width
+    klogg::vector<LineLength> lineLengths_;
+
+    // Only the build of the current generation updates the layout
+    std::optional<Build> currentBuild_;
+    uint64_t generation_ = 0;
+
+    // Stopped builds may still be finishing their chunk
+    klogg::vector<QFuture<void>> buildFutures_;
+};
+
+#endif
@@ -56,6 +56,7 @@
 #include <qchar.h>
 #include <qcolor.h>
 #include <qscreen.h>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -66,6 +67,7 @@
 #include <QGestureEvent>
 #include <QInputDialog>
 #include <QMenu>
+#include <QMessageBox>
 #include <QPaintEvent>
 #include <QPainter>
 #include <QPalette>
@@ -74,6 +76,7 @@
 #include <QScrollBar>
 #include <QShortcut>
 #include <QStringView>
+#include <QtConcurrent>
 #include <QtCore>
 
 #include <tbb/flow_graph.h>
@@ -88,12 +91,16 @@
 #include "configuration.h"
 #include "highlighterset.h"
 #include "highlightersmenu.h"
+#include "linesexporter.h"
 #include "log.h"
 #include "overview.h"
+#include "progressdialogtask.h"
 #include "quickfind.h"
 #include "quickfindpattern.h"
 #include "regularexpressionpattern.h"
+#include "selectionmimedata.h"
 #include "shortcuts.h"
+#include "tracing.h"
 
 #ifdef Q_OS_WIN
 
@@ -292,12 +299,14 @@ public:
     // leftExtraBackgroundPx is the an extra margin to start drawing
     // the coloured // background, going all the way to the element
     // left of the line looks better.
+    // The chunks are laid out through staticTexts, so that the text
+    // of lines drawn again is not shaped again.
     void draw( QPainter* painter, int initialXPos, int initialYPos, int lineWidth,
-               const WrappedString& wrappedLines, int leftExtraBackgroundPx )
+               const WrappedString& wrappedLines, int leftExtraBackgroundPx,
+               StaticTextCache& staticTexts )
     {
         QFontMetrics fm = painter->fontMetrics();
         const int fontHeight = fm.height();
-        const int fontAscent = fm.ascent();
 
         int xPos = initialXPos;
         int yPos = initialYPos;
@@ -333,9 +342,8 @@ public:
                 }
 
                 painter->setPen( chunk.foreColor() );
-                painter->drawText(
-                    xPos, yPos + fontAscent,
-                    QString::fromRawData( chunkText.data(), klogg::isize( chunkText ) ) );
+                painter->drawStaticText( xPos, yPos,
+                                         staticTexts.get( chunkText, painter->font() ) );
 
                 xPos += chunkWidth;
             }
@@ -402,6 +410,13 @@ AbstractLogView::AbstractLogView( const AbstractLogData* newLogData,
     , searchEnd_( newLogData->getNbLine().get() )
     , quickFindPattern_( quickFindPattern )
     , quickFind_( new QuickFind( *newLogData ) )
+    , linesPrefetcher_( *newLogData )
+    , wrappedLinesIndex_( *newLogData,
+                          [ this ] {
+                              QMetaObject::invokeMethod(
+                                  this, [ this ] { wrappedLinesIndexReady(); },
+                                  Qt::QueuedConnection );
+                          } )
     , pixmapFontMetrics_( this->font() )
 {
     setViewport( nullptr );
@@ -440,6 +455,13 @@ AbstractLogView::AbstractLogView( const AbstractLogData* newLogData,
 
 AbstractLogView::~AbstractLogView()
 {
+    // The clipboard keeps the copied selections, they can't read the data anymore
+    for ( const auto& copiedSelection : copiedSelections_ ) {
+        if ( copiedSelection ) {
+            copiedSelection->stopReading();
+        }
+    }
+
     try {
         if ( quickFind_ ) {
             quickFind_->stopSearch();
@@ -1006,16 +1028,43 @@ bool AbstractLogView::event( QEvent* e )
     return QAbstractScrollArea::event( e );
 }
 
+bool AbstractLogView::isWrappedLinesIndexUsed() const
+{
+    return useTextWrap_ && wrappedLinesIndex_.isReady( getNbVisibleCols() );
+}
+
+LinesCount AbstractLogView::rowOfLine( LineNumber line ) const
+{
+    return isWrappedLinesIndexUsed() ? wrappedLinesIndex_.rowOfLine( line )
+                                     : LinesCount( line.get() );
+}
+
+LinesCount AbstractLogView::nbRows() const
+{
+    return rowOfLine( LineNumber( logData_->getNbLine().get() ) );
+}
+
 int AbstractLogView::lineNumberToVerticalScroll( LineNumber line ) const
+{
+    return rowToVerticalScroll( rowOfLine( line ) );
+}
+
+int AbstractLogView::rowToVerticalScroll( LinesCount row ) const
 {
     return static_cast<int>(
-        std::round( static_cast<double>( line.get() ) * verticalScrollMultiplicator() ) );
+        std::round( static_cast<double>( row.get() ) * verticalScrollMultiplicator() ) );
 }
 
-LineNumber AbstractLogView::verticalScrollToLineNumber( int scrollPosition ) const
+WrappedLinesIndex::Position AbstractLogView::verticalScrollToPosition( int scrollPosition ) const
 {
-    return LineNumber( static_cast<LineNumber::UnderlyingType>(
+    const auto row = LinesCount( static_cast<LinesCount::UnderlyingType>(
         std::round( static_cast<double>( scrollPosition ) / verticalScrollMultiplicator() ) ) );
+
+    if ( isWrappedLinesIndexUsed() ) {
+        return wrappedLinesIndex_.lineAtRow( row );
+    }
+
+    return { LineNumber( row.get() ), 0_lcount };
 }
 
 double AbstractLogView::verticalScrollMultiplicator() const
@@ -1023,25 +1072,40 @@ double AbstractLogView::verticalScrollMultiplicator() const
     return verticalScrollBar()->maximum() < std::numeric_limits<int>::max()
                ? 1.0
                : static_cast<double>( std::numeric_limits<int>::max() )
-                     / static_cast<double>( logData_->getNbLine().get() );
+                     / static_cast<double>( nbRows().get() );
+}
+
+void AbstractLogView::wrappedLinesIndexReady()
+{
+    if ( useTextWrap_ ) {
+        updateScrollBars();
+        forceRefresh();
+    }
 }
 
 void AbstractLogView::scrollContentsBy( int dx, int dy )
 {
     LOG_DEBUG << "scrollContentsBy received " << dy << "position " << verticalScrollBar()->value();
 
-    const auto lastTopLine = ( logData_->getNbLine() - getNbVisibleLines() );
+    const auto lastTopRow = nbRows() - getNbVisibleLines();
 
-    const auto scrollPosition = verticalScrollToLineNumber( verticalScrollBar()->value() );
+    const auto scrollPosition = verticalScrollToPosition( verticalScrollBar()->value() );
+    const auto scrollRow = rowOfLine( scrollPosition.line ) + scrollPosition.wrappedRow;
 
-    if ( ( lastTopLine.get() > 0 ) && scrollPosition.get() > lastTopLine.get() ) {
+    if ( scrollPosition.wrappedRow != firstWrappedRow_ ) {
+        // The cache only knows about the first line
+        textAreaCache_.invalid_ = true;
+    }
+    firstWrappedRow_ = scrollPosition.wrappedRow;
+
+    if ( ( lastTopRow.get() > 0 ) && scrollRow.get() > lastTopRow.get() ) {
         // The user is going further than the last line, we need to lock the last line at the bottom
         LOG_DEBUG << "scrollContentsBy beyond!";
-        firstLine_ = scrollPosition;
+        firstLine_ = scrollPosition.line;
         lastLineAligned_ = true;
     }
     else {
-        firstLine_ = scrollPosition;
+        firstLine_ = scrollPosition.line;
         lastLineAligned_ = false;
     }
 
@@ -1085,20 +1149,20 @@ void AbstractLogView::paintEvent( QPaintEvent* paintEvent )
     auto start = std::chrono::system_clock::now();
 
     // Can we use our cache?
-    auto deltaY = textAreaCache_.first_line_.get() - firstLine_.get();
-
-    if ( textAreaCache_.invalid_ || ( textAreaCache_.first_column_ != firstCol_ ) ) {
-        // Force a full redraw
-        deltaY = std::numeric_limits<decltype( deltaY )>::max();
-    }
-
-    if ( deltaY != 0 ) {
-        // Full or partial redraw
-        drawTextArea( &textAreaCache_.pixmap_ );
+    const auto isCacheValid
+        = !textAreaCache_.invalid_ && ( textAreaCache_.first_column_ == firstCol_ );
+
+    if ( !isCacheValid || textAreaCache_.first_line_ != firstLine_ ) {
+        // Partial redraw if we have just scrolled, full redraw otherwise
+        if ( !isCacheValid || !scrollTextAreaCache() ) {
+            wrappedLinesInfo_.clear();
+            drawTextArea( &textAreaCache_.pixmap_, 0_lcount, getNbVisibleLines() );
+        }
 
         textAreaCache_.invalid_ = false;
         textAreaCache_.first_line_ = firstLine_;
         textAreaCache_.first_column_ = firstCol_;
+        textAreaCache_.line_number_digits_ = countDigits( maxDisplayLineNumber().get() );
 
         LOG_DEBUG << "End of writing "
                   << std::chrono::duration_cast<std::chrono::microseconds>(
@@ -1270,13 +1334,63 @@ void AbstractLogView::allowFollowMode( bool allow )
 void AbstractLogView::setSearchPattern( const RegularExpressionPattern& pattern )
 {
     searchPattern_ = pattern;
-    forceRefresh();
+    updateHighlighters();
 }
 
 void AbstractLogView::setQuickHighlighters(
     const std::vector<QuickHighlighters>& quickHighlighters )
 {
     quickHighlighters_ = quickHighlighters;
+    updateHighlighters();
+}
+
+void AbstractLogView::updateHighlighters()
+{
+    const auto& config = Configuration::get();
+
+    auto viewHighlighters = std::make_shared<ViewHighlighters>();
+
+    if ( config.mainSearchHighlight() && !searchPattern_.isBoolean && !searchPattern_.isExclude
+         && !searchPattern_.pattern.isEmpty() ) {
+        Highlighter patternHighlight;
+        patternHighlight.setHighlightOnlyMatch( true );
+        patternHighlight.setVariateColors( config.variateMainSearchHighlight() );
+        patternHighlight.setPattern( searchPattern_.pattern );
+        patternHighlight.setIgnoreCase( !searchPattern_.isCaseSensitive );
+        patternHighlight.setUseRegex( !searchPattern_.isPlainText );
+
+        patternHighlight.setBackColor( config.mainSearchBackColor() );
+        patternHighlight.setForeColor( Qt::black );
+
+        patternHighlight.compile();
+        viewHighlighters->searchPattern = std::move( patternHighlight );
+    }
+
+    const auto quickHighlighters = HighlighterSetCollection::get().quickHighlighters();
+    for ( auto i = 0u; i < quickHighlighters_.size(); ++i ) {
+        const auto quickHighlighterIndex = static_cast<int>( i );
+        if ( quickHighlighterIndex >= quickHighlighters.size() ) {
+            LOG_WARNING << "Not enough quickHighlighters configured";
+            break;
+        }
+
+        const auto quickHighlighter = quickHighlighters.at( quickHighlighterIndex );
+
+        std::transform( quickHighlighters_[ i ].begin(), quickHighlighters_[ i ].end(),
+                        std::back_inserter( viewHighlighters->quickHighlightWords ),
+                        [ quickHighlighter ]( const QString& word ) {
+                            Highlighter h{ word, false, true, quickHighlighter.color.foreColor,
+                                           quickHighlighter.color.backColor };
+                            h.setUseRegex( false );
+                            h.compile();
+                            return h;
+                        } );
+    }
+
+    viewHighlighters_ = std::move( viewHighlighters );
+
+    ++highlightsGeneration_;
+    linesPrefetcher_.invalidate();
     forceRefresh();
 }
 
@@ -1293,6 +1407,7 @@ void AbstractLogView::followSet( bool checked )
 void AbstractLogView::textWrapSet( bool checked )
 {
     useTextWrap_ = checked;
+    firstWrappedRow_ = 0_lcount;
     updateScrollBars();
     forceRefresh();
 }
@@ -1378,23 +1493,96 @@ void AbstractLogView::findPreviousSelected()
 // Copy the selection to the clipboard
 void AbstractLogView::copy()
 {
-
-    try {
-        auto text = selection_.getSelectedText( logData_ );
-        text.replace( QChar::Null, QChar::Space );
-        sendTextToClipboard( text );
-    } catch ( std::exception& err ) {
-        LOG_ERROR << "failed to copy data to clipboard " << err.what();
-    }
+    copySelection( false, false );
 }
 
 // Copy the selection with line numbers to the clipboard
 void AbstractLogView::copyWithLineNumbers()
 {
+    copySelection( true, false );
+}
+
+void AbstractLogView::copySelection( bool lineNumbers, bool updateSelection )
+{
+    const auto& config = Configuration::get();
+    const auto maxSize = static_cast<qint64>( config.clipboardSizeLimitMb() ) * 1024 * 1024
+                         / static_cast<qint64>( sizeof( QChar ) );
+
+    const auto warnSizeLimit = [ this, &config ]() {
+        QMessageBox::warning( this, tr( "klogg - copy" ),
+                              tr( "The selection is larger than the clipboard limit of %1 MiB." )
+                                  .arg( config.clipboardSizeLimitMb() ) );
+    };
+
     try {
-        auto text = selection_.getSelectedText( logData_, true );
-        text.replace( QChar::Null, QChar::Space );
-        sendTextToClipboard( text );
+        const auto nbLines = selection_.getSelectedLinesCount();
+
+        // Small selections are copied on the spot
+        if ( nbLines.get()
+             <= static_cast<LinesCount::UnderlyingType>( config.searchReadBufferSizeLines() ) ) {
+            auto text
+                = selection_.getSelectedText( logData_, lineNumbers, maxSize, AtomicFlag{}, {} );
+            if ( !text ) {
+                warnSizeLimit();
+                return;
+            }
+
+            text->replace( QChar::Null, QChar::Space );
+            sendTextToClipboard( *text, updateSelection );
+            return;
+        }
+
+        // The clipboard asks for the text when it is pasted, it is read in the meantime
+        if ( SelectionMimeData::isSupported() && !selection_.isPortion() ) {
+            auto* mimeData = new SelectionMimeData( logData_, selection_, lineNumbers, maxSize );
+            connect(
+                mimeData, &SelectionMimeData::textUnavailable, this,
+                [ this ]( const QString& message ) {
+                    QMessageBox::warning( this, tr( "klogg - paste" ), message );
+                },
+                Qt::QueuedConnection );
+            // A clipboard manager asked for the text before it was read
+            connect(
+                mimeData, &SelectionMimeData::textRead, this,
+                [ mimeData = QPointer<SelectionMimeData>( mimeData ),
+                  updateSelection ]( const QString& text ) {
+                    if ( mimeData && QApplication::clipboard()->mimeData() == mimeData.data() ) {
+                        sendTextToClipboard( text, updateSelection );
+                    }
+                },
+                Qt::QueuedConnection );
+            copiedSelections_.erase( std::remove_if( copiedSelections_.begin(),
+                                                     copiedSelections_.end(),
+                                                     []( const auto& copiedSelection ) {
+                                                         return copiedSelection.isNull();
+                                                     } ),
+                                     copiedSelections_.end() );
+            copiedSelections_.emplace_back( mimeData );
+            sendMimeDataToClipboard( mimeData, updateSelection );
+            return;
+        }
+
+        AtomicFlag interruptRequest;
+        auto text = runWithProgressDialog(
+            this, tr( "Copying %1 lines" ).arg( nbLines.get() ), interruptRequest,
+            [ logData = logData_, selection = selection_, lineNumbers,
+              maxSize ]( const AtomicFlag& interrupt,
+                         const Selection::TextProgressCallback& progressCallback ) {
+                return selection.getSelectedText( logData, lineNumbers, maxSize, interrupt,
+                                                  progressCallback );
+            } );
+
+        if ( interruptRequest ) {
+            return;
+        }
+
+        if ( !text ) {
+            warnSizeLimit();
+            return;
+        }
+
+        text->replace( QChar::Null, QChar::Space );
+        sendTextToClipboard( *text, updateSelection );
     } catch ( std::exception& err ) {
         LOG_ERROR << "failed to copy data to clipboard " << err.what();
     }
@@ -1444,6 +1632,15 @@ void AbstractLogView::saveLinesToFile( LineNumber begin, LineNumber end )
         return;
     }
 
+    // Without a prefilter the lines are saved with the encoding of the file,
+    // their bytes can be copied without decoding them. The lines are taken
+    // here, the matches of a running search can change while saving.
+    const LinesExporter exporter( *logData_, begin, end - begin );
+    if ( exporter.isSupported() ) {
+        saveRawLinesToFile( exporter, saveFile );
+        return;
+    }
+
     QProgressDialog progressDialog( this );
     progressDialog.setLabelText( tr( "Saving content to %1" ).arg( filename ) );
     klogg::vector<std::pair<LineNumber, LinesCount>> offsets;
@@ -1535,6 +1732,33 @@ void AbstractLogView::saveLinesToFile( LineNumber begin, LineNumber end )
     saveFileGraph.wait_for_all();
 }
 
+void AbstractLogView::saveRawLinesToFile( const LinesExporter& exporter, QSaveFile& saveFile )
+{
+    AtomicFlag interruptRequest;
+    const auto result = runWithProgressDialog(
+        this, tr( "Saving content to %1" ).arg( saveFile.fileName() ), interruptRequest,
+        [ &exporter, &saveFile ]( const AtomicFlag& interrupt,
+                                  const LinesExporter::ProgressCallback& progressCallback ) {
+            return exporter.exportTo( saveFile, interrupt, progressCallback );
+        } );
+
+    switch ( result ) {
+    case LinesExporter::Result::Done:
+        if ( !saveFile.commit() ) {
+            LOG_ERROR << "Failed to commit saved file " << saveFile.errorString();
+        }
+        break;
+    case LinesExporter::Result::Interrupted:
+        saveFile.cancelWriting();
+        break;
+    case LinesExporter::Result::Failed:
+    case LinesExporter::Result::Unsupported:
+        LOG_ERROR << "Saving file failed";
+        saveFile.cancelWriting();
+        break;
+    }
+}
+
 void AbstractLogView::updateSearchLimits()
 {
     forceRefresh();
@@ -1579,7 +1803,7 @@ void AbstractLogView::setSelectionEnd()
 // Public functions
 //
 
-void AbstractLogView::updateData()
+void AbstractLogView::updateData( LineNumber firstChangedLine )
 {
     LOG_DEBUG << "AbstractLogView::updateData";
 
@@ -1596,11 +1820,14 @@ void AbstractLogView::updateData()
     // Crop selection if it become out of range
     selection_.crop( lastLineNumber - 1_lcount );
 
+    // Rows of wrapped lines will be counted again from the first changed line
+    wrappedLinesIndex_.update( firstChangedLine );
+
     // Adapt the scroll bars to the new content
     updateScrollBars();
 
     // Reset the QuickFind in case we have new stuff to search into
-    quickFind_->resetLimits();
+    quickFind_->resetLimits( firstChangedLine );
 
     if ( followMode_ )
         jumpToBottom();
@@ -1612,6 +1839,10 @@ void AbstractLogView::updateData()
         overview_->updateCurrentPosition( firstLine_, lastLine );
     }
 
+    // Lines might have changed, highlights have to be computed again
+    ++highlightsGeneration_;
+    linesPrefetcher_.invalidate();
+
     forceRefresh();
 }
 
@@ -1711,9 +1942,11 @@ void AbstractLogView::selectPortionAndDisplayLine( LineNumber line, LinesCount n
 void AbstractLogView::jumpToLine( LineNumber line )
 {
     // Put the selected line in the middle if possible
-    const auto newTopLine = line - LinesCount( getNbVisibleLines().get() / 2 );
+    const auto lineRow = rowOfLine( line );
+    const auto halfScreen = LinesCount( getNbVisibleLines().get() / 2 );
+    const auto newTopRow = lineRow > halfScreen ? lineRow - halfScreen : 0_lcount;
     // This will also trigger a scrollContents event
-    verticalScrollBar()->setValue( lineNumberToVerticalScroll( newTopLine ) );
+    verticalScrollBar()->setValue( rowToVerticalScroll( newTopRow ) );
 }
 
 void AbstractLogView::setLineNumbersVisible( bool lineNumbersVisible )
@@ -1782,7 +2015,7 @@ FilePosition AbstractLogView::convertCoordToFilePos( const QPoint& pos ) const
                                                         size_t{ 0 }, wrappedLinesInfo_.size() - 1 )
                                           : 0;
 
-    const auto [ lineIndex, wrappedLineIndex, wrappedString ]
+    const auto [ lineIndex, wrappedLineIndex, wrappedString, windowStart ]
         = wrappedLinesInfo_[ wrappedLineInfoIndex ];
 
     auto clampedLineIndex = lineIndex;
@@ -1798,7 +2031,8 @@ FilePosition AbstractLogView::convertCoordToFilePos( const QPoint& pos ) const
 
     const WrappedString::WrappedStringPart visibleText
         = useTextWrap_ ? wrappedString.wrappedLine( wrappedLineIndex )
-                       : lineText.mid( firstCol_.get(), getNbVisibleCols().get() );
+                       : lineText.mid( ( firstCol_ - windowStart ).get(),
+                                       getNbVisibleCols().get() );
 
     klogg::vector<LineColumn> possibleColumns( static_cast<size_t>( visibleText.size() ) );
     klogg::vector<int> columnsWidth( static_cast<size_t>( visibleText.size() ), -1 );
@@ -1834,7 +2068,7 @@ FilePosition AbstractLogView::convertCoordToFilePos( const QPoint& pos ) const
         = LineColumn( type_safe::narrow_cast<LineColumn::UnderlyingType>( std::min(
               lineText.size(), static_cast<decltype( lineText.size() )>(
                                    std::numeric_limits<LineColumn::UnderlyingType>::max() ) ) ) )
-          - 1_length;
+          + LineLength{ windowStart.get() } - 1_length;
 
     column = std::clamp( column, 0_lcol, maxColumn );
 
@@ -2169,9 +2403,31 @@ void AbstractLogView::updateScrollBars()
 {
     const LinesCount visibleLines = getNbVisibleLines();
     const LineLength visibleColumns = getNbVisibleCols();
+
+    if ( useTextWrap_ ) {
+        // Only built when needed, and again when the width changes
+        wrappedLinesIndex_.build( visibleColumns );
+    }
+
+    // Keep the same top line when switching between lines and rows
+    const auto countsRows = isWrappedLinesIndexUsed();
+    const auto isSwitchingUnits = countsRows != scrollBarCountsRows_;
+    const auto topLine = firstLine_;
+    scrollBarCountsRows_ = countsRows;
+
     if ( logData_->getNbLine() < visibleLines ) {
         verticalScrollBar()->setRange( 0, 0 );
     }
+    else if ( countsRows ) {
+        const auto totalRows = nbRows();
+        const auto maxTopRow = totalRows >= visibleLines
+                                   ? ( totalRows - visibleLines + 1_lcount ).get()
+                                   : LinesCount::UnderlyingType{ 0 };
+        verticalScrollBar()->setRange(
+            0, static_cast<int>( std::min(
+                   maxTopRow, static_cast<LinesCount::UnderlyingType>(
+                                  std::numeric_limits<int>::max() ) ) ) );
+    }
     else {
         const auto visibleWrappedLines = getNbBottomWrappedVisibleLines();
         const auto wrappedLinesScrollAdjust = ( visibleWrappedLines - visibleLines ).get();
@@ -2183,6 +2439,10 @@ void AbstractLogView::updateScrollBars()
                                            maxValue<LinesCount>().get() ) ) );
     }
 
+    if ( isSwitchingUnits ) {
+        verticalScrollBar()->setValue( lineNumberToVerticalScroll( topLine ) );
+    }
+
     int64_t hScrollMaxValue = 0;
     if ( !useTextWrap_ && logData_->getMaxLength().get() >= visibleColumns.get() ) {
         hScrollMaxValue = logData_->getMaxLength().get() - visibleColumns.get() + 1;
@@ -2196,8 +2456,66 @@ void AbstractLogView::updateScrollBars()
         type_safe::narrow_cast<int>( visibleColumns.get() * 7 / 8 ) );
 }
 
-void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
+bool AbstractLogView::scrollTextAreaCache()
+{
+    const auto nbVisibleLines = getNbVisibleLines();
+    const auto linesInFile = logData_->getNbLine();
+    const auto previousFirstLine = textAreaCache_.first_line_;
+
+    const auto isScreenFull = [ & ]( LineNumber firstLine ) {
+        return firstLine.get() + nbVisibleLines.get() <= linesInFile.get();
+    };
+
+    // Rows must stay aligned on device pixels once shifted
+    auto& pixmap = textAreaCache_.pixmap_;
+    const auto lineHeightPx = charHeight_ * pixmap.devicePixelRatio();
+
+    // Wrapped lines have different heights, and partial screens at the end of the
+    // file or a change of the margins or of the highlighters need a full redraw
+    if ( useTextWrap_ || !isScreenFull( previousFirstLine ) || !isScreenFull( firstLine_ )
+         || wrappedLinesInfo_.size() != nbVisibleLines.get()
+         || lineHeightPx != std::floor( lineHeightPx )
+         || textAreaCache_.line_number_digits_ != countDigits( maxDisplayLineNumber().get() )
+         || !lineHighlighter_.isHighlightingWith(
+             HighlighterSetCollection::get().currentActiveSet() ) ) {
+        return false;
+    }
+
+    const auto isScrollingDown = firstLine_ > previousFirstLine;
+    const auto scrolledLines
+        = isScrollingDown ? firstLine_ - previousFirstLine : previousFirstLine - firstLine_;
+    if ( scrolledLines >= nbVisibleLines ) {
+        return false;
+    }
+
+    LOG_DEBUG << "scrolling text area cache by " << scrolledLines << " lines";
+
+    const auto scrolledPx
+        = static_cast<int>( scrolledLines.get() ) * static_cast<int>( lineHeightPx );
+    pixmap.scroll( 0, isScrollingDown ? -scrolledPx : scrolledPx, pixmap.rect() );
+
+    // Then only draw the lines that have just become visible
+    const auto keptLines = nbVisibleLines - scrolledLines;
+    const auto scrolledRows = static_cast<std::ptrdiff_t>( scrolledLines.get() );
+    if ( isScrollingDown ) {
+        wrappedLinesInfo_.erase( wrappedLinesInfo_.begin(),
+                                 wrappedLinesInfo_.begin() + scrolledRows );
+        drawTextArea( &pixmap, keptLines, scrolledLines );
+    }
+    else {
+        wrappedLinesInfo_.erase( wrappedLinesInfo_.end() - scrolledRows,
+                                 wrappedLinesInfo_.end() );
+        drawTextArea( &pixmap, 0_lcount, scrolledLines );
+    }
+
+    return true;
+}
+
+void AbstractLogView::drawTextArea( QPaintDevice* paintDevice, LinesCount firstRow,
+                                    LinesCount nbRows )
 {
+    KLOGG_TRACE_SCOPE( "AbstractLogView::drawTextArea" );
+
     // LOG_DEBUG << "devicePixelRatio: " << viewport()->devicePixelRatio();
     // LOG_DEBUG << "viewport size: " << viewport()->size().width();
     // LOG_DEBUG << "pixmap size: " << textPixmap.width();
@@ -2217,7 +2535,6 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
 
     const QPalette& palette = viewport()->palette();
     const HighlighterSet& highlighterSet = HighlighterSetCollection::get().currentActiveSet();
-    const auto& quickHighlighters = HighlighterSetCollection::get().quickHighlighters();
     QColor foreColor, backColor;
 
     static const QBrush normalBulletBrush = QBrush( Qt::white );
@@ -2241,7 +2558,16 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
 
     const int bottomOfTextPx = static_cast<int>( nbLines.get() ) * fontHeight;
 
-    LOG_DEBUG << "drawing lines from " << firstLine_ << " (" << nbLines << " lines)";
+    // Rows of the screen to draw, the rest of the device is left untouched
+    const auto firstLineRow = qMin( firstRow, nbLines );
+    const auto endLineRow = qMin( firstRow + nbRows, nbLines );
+    if ( firstRow > 0_lcount || nbRows < getNbVisibleLines() ) {
+        painter->setClipRect( 0, static_cast<int>( firstRow.get() ) * fontHeight,
+                              paintDeviceWidth, static_cast<int>( nbRows.get() ) * fontHeight );
+    }
+
+    LOG_DEBUG << "drawing lines from " << firstLine_ + firstLineRow << " ("
+              << endLineRow - firstLineRow << " lines)";
     LOG_DEBUG << "bottomOfTextPx: " << bottomOfTextPx;
     LOG_DEBUG << "Height: " << paintDeviceHeight;
 
@@ -2303,58 +2629,83 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
         return index;
     }();
 
-    // Lines to write
-    const auto logLines = logData_->getLines( firstLine_, nbLines );
-
-    const auto highlightPatternMatches = Configuration::get().mainSearchHighlight();
-    const auto variateHighlightPatternMatches = Configuration::get().variateMainSearchHighlight();
+    if ( !lineHighlighter_.isHighlightingWith( highlighterSet ) ) {
+        // The active highlighters have changed since the last paint
+        ++highlightsGeneration_;
+        linesPrefetcher_.invalidate();
+    }
 
-    std::optional<Highlighter> patternHighlight;
-    if ( highlightPatternMatches && !searchPattern_.isBoolean && !searchPattern_.isExclude
-         && !searchPattern_.pattern.isEmpty() ) {
-        const auto mainSearchBackColor = Configuration::get().mainSearchBackColor();
-        patternHighlight = Highlighter{};
-        patternHighlight->setHighlightOnlyMatch( true );
-        patternHighlight->setVariateColors( variateHighlightPatternMatches );
-        patternHighlight->setPattern( searchPattern_.pattern );
-        patternHighlight->setIgnoreCase( !searchPattern_.isCaseSensitive );
-        patternHighlight->setUseRegex( !searchPattern_.isPlainText );
+    const auto firstDrawnLine = firstLine_ + firstLineRow;
+    const auto nbDrawnLines = endLineRow - firstLineRow;
 
-        patternHighlight->setBackColor( mainSearchBackColor );
-        patternHighlight->setForeColor( Qt::black );
+    // Unless they are wrapped, long lines are only read around the visible columns
+    const auto lineWindowStart = std::max( 0_lcol, firstCol_ - nbVisibleCols );
+    const auto lineWindowLength = LineLength{ nbVisibleCols.get() * 3 };
+    klogg::vector<bool> isLineWindow( nbDrawnLines.get(), false );
+    if ( !useTextWrap_ ) {
+        for ( auto i = 0u; i < isLineWindow.size(); ++i ) {
+            isLineWindow[ i ] = logData_->isLongLine( firstDrawnLine + LinesCount( i ) );
+        }
     }
+    const auto hasLineWindows
+        = std::find( isLineWindow.begin(), isLineWindow.end(), true ) != isLineWindow.end();
+
+    // Lines to write, prefetched ones come with their highlights
+    klogg::vector<QString> logLines;
+    klogg::vector<LinesPrefetcher::PrefetchedLine> prefetchedLines;
+    if ( hasLineWindows ) {
+        logLines.reserve( nbDrawnLines.get() );
+        auto runStart = 0u;
+        for ( auto i = 0u; i <= isLineWindow.size(); ++i ) {
+            if ( i < isLineWindow.size() && !isLineWindow[ i ] ) {
+                continue;
+            }
 
-    klogg::vector<Highlighter> additionalHighlighters;
-    for ( auto i = 0u; i < quickHighlighters_.size(); ++i ) {
-        const auto quickHighlighterIndex = static_cast<int>( i );
-        if ( quickHighlighterIndex >= quickHighlighters.size() ) {
-            LOG_WARNING << "Not enough quickHighlighters configured";
-            break;
+            // Other lines are still read together
+            if ( runStart < i ) {
+                auto runLines = logData_->getLines( firstDrawnLine + LinesCount( runStart ),
+                                                    LinesCount( i - runStart ) );
+                std::move( runLines.begin(), runLines.end(), std::back_inserter( logLines ) );
+            }
+            if ( i < isLineWindow.size() ) {
+                logLines.push_back( logData_->getExpandedLineWindow(
+                    firstDrawnLine + LinesCount( i ), lineWindowStart, lineWindowLength ) );
+            }
+            runStart = i + 1;
         }
-
-        const auto quickHighlighter = quickHighlighters.at( quickHighlighterIndex );
-
-        std::transform( quickHighlighters_[ i ].begin(), quickHighlighters_[ i ].end(),
-                        std::back_inserter( additionalHighlighters ),
-                        [ quickHighlighter ]( const QString& word ) {
-                            Highlighter h{ word, false, true, quickHighlighter.color.foreColor,
-                                           quickHighlighter.color.backColor };
-                            h.setUseRegex( false );
-                            return h;
-                        } );
+    }
+    else if ( linesPrefetcher_.getLines( firstDrawnLine, nbDrawnLines, highlightsGeneration_,
+                                         prefetchedLines ) ) {
+        logLines.reserve( prefetchedLines.size() );
+        for ( auto i = 0u; i < prefetchedLines.size(); ++i ) {
+            const auto lineNumber = firstDrawnLine + LinesCount( i );
+            if ( highlightsCache_.find( lineNumber, highlightsGeneration_ ) == nullptr ) {
+                highlightsCache_.insert( lineNumber, highlightsGeneration_,
+                                         std::move( prefetchedLines[ i ].highlights ) );
+            }
+            logLines.push_back( std::move( prefetchedLines[ i ].text ) );
+        }
+    }
+    else {
+        logLines = logData_->getLines( firstDrawnLine, nbDrawnLines );
     }
 
     // Position in pixel of the base line of the line to print
-    int yPos = 0;
-    wrappedLinesInfo_.clear();
-    klogg::vector<std::pair<QColor, QColor>> highlightColors;
-    for ( auto currentLine = 0_lcount; currentLine < nbLines; ++currentLine ) {
+    int yPos = static_cast<int>( firstLineRow.get() ) * fontHeight;
+    klogg::vector<WrappedLineData> drawnLinesInfo;
+    for ( auto currentLine = firstLineRow; currentLine < endLineRow; ++currentLine ) {
         const auto lineNumber = firstLine_ + currentLine;
-        QString logLine = logLines[ currentLine.get() ];
+        const auto drawnLineIndex = ( currentLine - firstLineRow ).get();
+        QString logLine = logLines[ drawnLineIndex ];
+
+        // Columns of a window are relative to its start
+        const auto isWindow = isLineWindow[ drawnLineIndex ];
+        const auto windowStart = isWindow ? lineWindowStart : 0_lcol;
+        const auto lineFirstCol = firstCol_ - LineLength{ windowStart.get() };
 
         const int xPos = contentStartPosX + ContentMarginWidth;
 
-        HighlightedMatchRanges highlighterMatches;
+        klogg::vector<HighlightedMatch> highlighterMatches;
 
         if ( selection_.isLineSelected( lineNumber ) && !selection_.isSingleLine() ) {
             // Reverse the selected line
@@ -2370,59 +2721,28 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
                 foreColor = palette.brush( QPalette::Disabled, QPalette::Text ).color();
             }
             else {
-                const auto highlightType = highlighterSet.matchLine( logLine, highlighterMatches );
-
-                if ( highlightType == HighlighterMatchType::LineMatch ) {
-                    // color applies to whole line
-                    foreColor = highlighterMatches.front().foreColor();
-                    backColor = highlighterMatches.front().backColor();
+                // Highlights of a window depend on where it starts, they are not cached
+                LineHighlights windowHighlights;
+                if ( isWindow ) {
+                    windowHighlights
+                        = lineHighlighter_.highlight( logLine, highlighterSet, *viewHighlighters_ );
+                    windowHighlights.lineColors = longLineColors( lineNumber, highlighterSet );
                 }
+                const auto& highlights
+                    = isWindow ? windowHighlights
+                               : lineHighlights( lineNumber, logLine, highlighterSet );
 
-                if ( patternHighlight ) {
-                    klogg::vector<HighlightedMatch> patternMatches;
-                    patternHighlight->matchLine( logLine, patternMatches );
-                    highlighterMatches.addMatches( patternMatches );
+                if ( highlights.lineColors ) {
+                    // color applies to whole line
+                    foreColor = highlights.lineColors->first;
+                    backColor = highlights.lineColors->second;
                 }
 
-                // highlighterMatches.reserve( additionalHighlighters.size() );
-                for ( const auto& highlighter : additionalHighlighters ) {
-                    klogg::vector<HighlightedMatch> patternMatches;
-                    highlighter.matchLine( logLine, patternMatches );
-                    highlighterMatches.addMatches( patternMatches );
-                }
+                highlighterMatches = highlights.matches;
             }
         }
 
-        const auto untabifyHighlight = [ &logLine ]( const auto& match ) {
-            const auto prefix = QStringView{ logLine }.left( match.startColumn().get() );
-            const auto matchPart
-                = QStringView{ logLine }.mid( match.startColumn().get(), match.size().get() );
-            const auto expandedPrefixLength = untabify( prefix.toString() ).size();
-            const LineLength startDelta
-                = LineLength{ type_safe::narrow_cast<LineLength::UnderlyingType>(
-                    expandedPrefixLength - prefix.size() ) };
-
-            const LineLength expandedMatchLength = LineLength{
-                untabify( matchPart.toString(),
-                          LineColumn{ type_safe::narrow_cast<LineColumn::UnderlyingType>(
-                              expandedPrefixLength ) } )
-                    .size()
-            };
-
-            const auto lengthDelta
-                = expandedMatchLength
-                  - LineLength{ type_safe::narrow_cast<LineLength::UnderlyingType>(
-                      matchPart.size() ) };
-
-            return HighlightedMatch{ match.startColumn() + startDelta, match.size() + lengthDelta,
-                                     match.foreColor(), match.backColor() };
-        };
-
-        klogg::vector<HighlightedMatch> sortedHighlights = highlighterMatches.matches();
-        std::transform( sortedHighlights.begin(), sortedHighlights.end(), sortedHighlights.begin(),
-                        untabifyHighlight );
-
-        HighlightedMatchRanges allHighlights{ std::move( sortedHighlights ) };
+        HighlightedMatchRanges allHighlights{ std::move( highlighterMatches ) };
 
         // string to print, cut to fit the length and position of the view
         const QString& expandedLine = untabify( std::move( logLine ) );
@@ -2435,7 +2755,8 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
         // Is there something selected in the line?
         const auto selectionPortion = selection_.getPortionForLine( lineNumber );
         if ( selectionPortion.isValid() ) {
-            allHighlights.addMatch( HighlightedMatch{ selectionPortion.startColumn(),
+            allHighlights.addMatch( HighlightedMatch{ selectionPortion.startColumn()
+                                                          - LineLength{ windowStart.get() },
                                                       selectionPortion.size(),
                                                       palette.color( QPalette::HighlightedText ),
                                                       palette.color( QPalette::Highlight ) } );
@@ -2448,14 +2769,23 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
             = fontHeight * static_cast<int>( wrappedLineView.wrappedLinesCount() );
         // LOG_INFO << "Draw line " << lineNumber << ": " << expandedLine;
 
+        // The first rows of the top line can be scrolled above the view
+        const auto hiddenRows
+            = ( useTextWrap_ && currentLine == 0_lcount )
+                  ? std::min( static_cast<size_t>( firstWrappedRow_.get() ),
+                              wrappedLineView.wrappedLinesCount() - 1 )
+                  : size_t{ 0 };
+        yPos -= static_cast<int>( hiddenRows ) * fontHeight;
+
         painter->fillRect( xPos - ContentMarginWidth, yPos, viewport()->width(), finalLineHeight,
                            backColor );
 
         LineDrawer lineDrawer( backColor );
-        const auto firstVisibleColumn = std::clamp( useTextWrap_ ? 0_lcol : firstCol_, 0_lcol,
+        const auto firstVisibleColumn = std::clamp( useTextWrap_ ? 0_lcol : lineFirstCol, 0_lcol,
                                                     LineColumn{ klogg::isize( expandedLine ) } );
         const auto lastVisibleColumn
-            = useTextWrap_ ? LineColumn{ klogg::isize( expandedLine ) } : firstCol_ + nbVisibleCols;
+            = useTextWrap_ ? LineColumn{ klogg::isize( expandedLine ) }
+                           : lineFirstCol + nbVisibleCols;
         allHighlights.clamp( firstVisibleColumn, lastVisibleColumn );
 
         if ( !allHighlights.empty() && !expandedLine.isEmpty() ) {
@@ -2500,11 +2830,12 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
                                      backColor );
             }
             else {
-                lineDrawer.addChunk( firstCol_, firstCol_ + nbVisibleCols, foreColor, backColor );
+                lineDrawer.addChunk( lineFirstCol, lineFirstCol + nbVisibleCols, foreColor,
+                                     backColor );
             }
         }
         lineDrawer.draw( painter.get(), xPos, yPos, viewport()->width(), wrappedLineView,
-                         ContentMarginWidth );
+                         ContentMarginWidth, staticTextCache_ );
 
         if ( ( selection_.isLineSelected( lineNumber ) && selection_.isSingleLine() )
              || selection_.getPortionForLine( lineNumber ).isValid() ) {
@@ -2562,8 +2893,9 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
             painter->drawText( lineNumberAreaStartX + LineNumberPadding, yPos + fontAscent,
                                lineNumberStr );
         }
-        for ( size_t i = 0u; i < wrappedLineView.wrappedLinesCount(); ++i ) {
-            wrappedLinesInfo_.emplace_back( WrappedLineData{ lineNumber, i, wrappedLineView } );
+        for ( size_t i = hiddenRows; i < wrappedLineView.wrappedLinesCount(); ++i ) {
+            drawnLinesInfo.emplace_back(
+                WrappedLineData{ lineNumber, i, wrappedLineView, windowStart } );
         }
 
         yPos += finalLineHeight;
@@ -2571,6 +2903,49 @@ void AbstractLogView::drawTextArea( QPaintDevice* paintDevice )
             break;
         }
     } // For each line
+
+    // The lines kept from a previous drawing are already in the wrapped lines info
+    const auto insertPosition = static_cast<std::ptrdiff_t>(
+        qMin( static_cast<std::size_t>( firstLineRow.get() ), wrappedLinesInfo_.size() ) );
+    wrappedLinesInfo_.insert( wrappedLinesInfo_.begin() + insertPosition,
+                              std::make_move_iterator( drawnLinesInfo.begin() ),
+                              std::make_move_iterator( drawnLinesInfo.end() ) );
+
+    if ( lineHighlighter_.isHighlightingWith( highlighterSet ) ) {
+        linesPrefetcher_.viewMoved( firstLine_, getNbVisibleLines(), highlightsGeneration_,
+                                    highlighterSet, viewHighlighters_ );
+    }
+}
+
+const LineHighlights& AbstractLogView::lineHighlights( LineNumber lineNumber,
+                                                      const QString& logLine,
+                                                      const HighlighterSet& highlighterSet )
+{
+    if ( const auto* cachedHighlights = highlightsCache_.find( lineNumber, highlightsGeneration_ );
+         cachedHighlights != nullptr ) {
+        return *cachedHighlights;
+    }
+
+    return highlightsCache_.insert(
+        lineNumber, highlightsGeneration_,
+        lineHighlighter_.highlight( logLine, highlighterSet, *viewHighlighters_ ) );
+}
+
+std::optional<std::pair<QColor, QColor>>
+AbstractLogView::longLineColors( LineNumber lineNumber, const HighlighterSet& highlighterSet )
+{
+    if ( const auto* cachedColors
+         = longLinesColorsCache_.find( lineNumber, highlightsGeneration_ );
+         cachedColors != nullptr ) {
+        return cachedColors->lineColors;
+    }
+
+    LineHighlights lineColors;
+    lineColors.lineColors
+        = lineHighlighter_.lineColors( logData_->getLineString( lineNumber ), highlighterSet );
+    return longLinesColorsCache_
+        .insert( lineNumber, highlightsGeneration_, std::move( lineColors ) )
+        .lineColors;
 }
 
 // Draw the "pull to follow" bar and return a pixmap.
@@ -181,6 +181,14 @@ QString CrawlerWidget::getSelectedText() const
         return logMainView_->getSelectedText();
 }
 
+void CrawlerWidget::copySelectedText()
+{
+    if ( filteredView_->hasFocus() )
+        filteredView_->copySelection( false, true );
+    else
+        logMainView_->copySelection( false, true );
+}
+
 bool CrawlerWidget::isPartialSelection() const
 {
     if ( filteredView_->hasFocus() )
@@ -374,11 +382,14 @@ std::shared_ptr<const ViewContextInterface> CrawlerWidget::doGetViewContext() co
 
 void CrawlerWidget::startNewSearch()
 {
-    if ( keepSearchResultsButton_->isChecked() ) {
+    if ( keepSearchResultsButton_->isChecked() || refineSearchButton_->isChecked() ) {
+        const auto parentData = refineSearchButton_->isChecked() ? logFilteredData_ : nullptr;
         keepSearchResultsButton_->setChecked( false );
+        refineSearchButton_->setChecked( false );
 
         logFilteredData_->interruptSearch();
-        logFilteredData_ = logData_->getNewFilteredData();
+        logFilteredData_ = parentData ? logData_->getNewNestedFilteredData( parentData )
+                                      : logData_->getNewFilteredData();
 
         filteredView_ = new FilteredView( logFilteredData_.get(), quickFindPattern_.get() );
         filteredViewsData_[ filteredView_ ] = logFilteredData_;
@@ -390,14 +401,27 @@ void CrawlerWidget::startNewSearch()
 
         connect( logFilteredData_.get(), &LogFilteredData::searchProgressed, this,
                  &CrawlerWidget::updateFilteredView, Qt::QueuedConnection );
+        connect( logFilteredData_.get(), &LogFilteredData::searchEstimated, this,
+                 &CrawlerWidget::updateSearchEstimate, Qt::QueuedConnection );
 
         logMainView_->useNewFiltering( logFilteredData_.get() );
 
         applyConfiguration();
     }
 
-    tabbedFilteredView_->setTabText( tabbedFilteredView_->currentIndex(),
-                                     "Find \"" + searchLineEdit_->currentText() + "\"" );
+    auto tabText = "Find \"" + searchLineEdit_->currentText() + "\"";
+    if ( const auto parentData = logFilteredData_->parentData() ) {
+        // Nested searches are named after the search they refine
+        const auto parentView = std::find_if(
+            filteredViewsData_.cbegin(), filteredViewsData_.cend(),
+            [ &parentData ]( const auto& viewData ) { return viewData.second == parentData; } );
+        if ( parentView != filteredViewsData_.cend() ) {
+            const auto parentIndex = tabbedFilteredView_->indexOf( parentView->first );
+            tabText = tabbedFilteredView_->tabText( parentIndex ) + " > \""
+                      + searchLineEdit_->currentText() + "\"";
+        }
+    }
+    setFilteredViewTabText( tabbedFilteredView_->currentIndex(), tabText );
 
     // Record the search line in the recent list
     // (reload the list first in case another glogg changed it)
@@ -477,6 +501,24 @@ void CrawlerWidget::showSearchContextMenu()
         searchLineContextMenu_->exec( QCursor::pos( activeScreen( this ) ) );
 }
 
+// When receiving the 'searchEstimated' signal from LogFilteredData
+void CrawlerWidget::updateSearchEstimate( LinesCount estimate, LinesCount margin )
+{
+    LOG_DEBUG << "updateSearchEstimate received.";
+
+    if ( !stopButton_->isEnabled() ) {
+        // The search is already done
+        return;
+    }
+
+    searchEstimateText_ = tr( " About %1 (+/- %2) matches expected." )
+                              .arg( QString::number( estimate.get() ),
+                                    QString::number( margin.get() ) );
+
+    searchInfoLine_->setText( tr( "Search in progress..." ) + searchEstimateText_ );
+    searchInfoLine_->show();
+}
+
 // When receiving the 'newDataAvailable' signal from LogFilteredData
 void CrawlerWidget::updateFilteredView( LinesCount nbMatches, int progress,
                                         LineNumber initialPosition )
@@ -487,6 +529,7 @@ void CrawlerWidget::updateFilteredView( LinesCount nbMatches, int progress,
 
     if ( progress == 100 ) {
         // Searching done
+        searchEstimateText_.clear();
         printSearchInfoMessage( nbMatches );
         searchInfoLine_->hideGauge();
         // De-activate the stop button
@@ -506,18 +549,23 @@ void CrawlerWidget::updateFilteredView( LinesCount nbMatches, int progress,
                 + ( nbMatches.get() > 1 ? tr( " %1 matches found so far." )
                                               .arg( QString::number( nbMatches.get() ) )
                                         : tr( " %1 match found so far." )
-                                              .arg( QString::number( nbMatches.get() ) ) ) );
+                                              .arg( QString::number( nbMatches.get() ) ) )
+                + searchEstimateText_ );
 
             searchInfoLine_->displayGauge( progress );
         }
     }
 
+    const auto firstNewMatch = logFilteredData_->takeFirstNewMatch();
+
     // If more (or less, e.g. come back to 0) matches have been found
     if ( nbMatches != nbMatches_ ) {
         nbMatches_ = nbMatches;
 
-        // Recompute the content of the filtered window.
-        filteredView_->updateData();
+        // Recompute the content of the filtered window from the first new match.
+        filteredView_->updateData( firstNewMatch
+                                       ? logFilteredData_->getLineIndexNumber( *firstNewMatch )
+                                       : 0_lnum );
 
         // Update the match overview
         overview_.updateData( logData_->getNbLine() );
@@ -562,9 +610,10 @@ void CrawlerWidget::updateLineNumberHandler( LineNumber line, LinesCount nLines,
 void CrawlerWidget::markLinesFromMain( const klogg::vector<LineNumber>& lines )
 {
     klogg::vector<LineNumber> alreadyMarkedLines;
+    klogg::vector<LineNumber> notMarkedLines;
     alreadyMarkedLines.reserve( lines.size() );
+    notMarkedLines.reserve( lines.size() );
 
-    bool markAdded = false;
     for ( const auto& line : lines ) {
         if ( line >= logData_->getNbLine() ) {
             continue;
@@ -572,23 +621,30 @@ void CrawlerWidget::markLinesFromMain( const klogg::vector<LineNumber>& lines )
 
         if ( !logFilteredData_->lineTypeByLine( line ).testFlag(
                  AbstractLogData::LineTypeFlags::Mark ) ) {
-            logFilteredData_->addMark( line );
-            markAdded = true;
+            notMarkedLines.push_back( line );
         }
         else {
             alreadyMarkedLines.push_back( line );
         }
     }
 
-    if ( !markAdded ) {
-        for ( const auto& line : alreadyMarkedLines ) {
-            logFilteredData_->toggleMark( line );
-        }
+    // Mark the whole selection if some lines are not marked,
+    // otherwise unmark it.
+    const auto& changedLines = !notMarkedLines.empty() ? notMarkedLines : alreadyMarkedLines;
+    if ( !notMarkedLines.empty() ) {
+        logFilteredData_->addMarks( notMarkedLines );
+    }
+    else {
+        logFilteredData_->deleteMarks( alreadyMarkedLines );
     }
 
-    // Recompute the content of both window.
-    filteredView_->updateData();
-    logMainView_->updateData();
+    // Recompute the content of both window, the lines of the main one are the same.
+    filteredView_->updateData(
+        !changedLines.empty()
+            ? logFilteredData_->getLineIndexNumber(
+                *std::min_element( changedLines.begin(), changedLines.end() ) )
+            : 0_lnum );
+    logMainView_->updateData( LineNumber( logData_->getNbLine().get() ) );
 
     // Update the match overview
     overview_.updateData( logData_->getNbLine() );
@@ -647,12 +703,14 @@ void CrawlerWidget::applyConfiguration()
     overview_.setVisible( config.isOverviewVisible() );
     logMainView_->refreshOverview();
     logMainView_->updateFont( font );
+    logMainView_->updateHighlighters();
 
     for ( auto i = 0; i < tabbedFilteredView_->count(); ++i ) {
         auto fv = qobject_cast<FilteredView*>( tabbedFilteredView_->widget( i ) );
         fv->setLineNumbersVisible( config.filteredLineNumbersVisible() );
         fv->allowFollowMode( isFollowModeAllowed );
         fv->updateFont( font );
+        fv->updateHighlighters();
     }
 
     // Update the SearchLine (history)
@@ -697,7 +755,8 @@ void CrawlerWidget::loadingFinishedHandler( LoadingStatus status )
 
     // FIXME, handle topLine
     // logMainView_->updateData( logData_, topLine );
-    logMainView_->updateData();
+    logMainView_->updateData( firstChangedLine_.value_or( 0_lnum ) );
+    firstChangedLine_.reset();
 
     // Shall we Forbid starting a search when loading in progress?
     // searchButton_->setEnabled( false );
@@ -725,9 +784,7 @@ void CrawlerWidget::loadingFinishedHandler( LoadingStatus status )
     }
     else {
         firstLoadDone_ = true;
-        for ( const auto& m : savedMarkedLines_ ) {
-            logFilteredData_->addMark( m );
-        }
+        logFilteredData_->addMarks( savedMarkedLines_ );
         logMainView_->setFocus();
     }
 
@@ -737,6 +794,15 @@ void CrawlerWidget::loadingFinishedHandler( LoadingStatus status )
 
 void CrawlerWidget::fileChangedHandler( MonitoredFileStatus status )
 {
+    // Lines before the last one are the same when data is added,
+    // the last one might have been incomplete
+    const auto firstChangedLine
+        = status == MonitoredFileStatus::DataAdded && logData_->getNbLine() > 0_lcount
+              ? LineNumber( logData_->getNbLine().get() - 1 )
+              : 0_lnum;
+    firstChangedLine_ = firstChangedLine_ ? qMin( *firstChangedLine_, firstChangedLine )
+                                            : firstChangedLine;
+
     // Handle the case where the file has been truncated
     if ( status == MonitoredFileStatus::Truncated ) {
         // Clear all marks (TODO offer the option to keep them)
@@ -749,6 +815,7 @@ void CrawlerWidget::fileChangedHandler( MonitoredFileStatus status )
             searchState_.truncateFile();
             printSearchInfoMessage();
             nbMatches_ = 0_lcount;
+            searchEstimateText_.clear();
         }
     }
 }
@@ -1116,6 +1183,13 @@ void CrawlerWidget::setup()
     keepSearchResultsButton_->setCheckable( true );
     keepSearchResultsButton_->setContentsMargins( 2, 2, 2, 2 );
 
+    refineSearchButton_ = new QToolButton();
+    refineSearchButton_->setText( tr( "Refine Results" ) );
+    refineSearchButton_->setToolTip(
+        tr( "Search only in these results and show subsequent results in a new window" ) );
+    refineSearchButton_->setCheckable( true );
+    refineSearchButton_->setContentsMargins( 2, 2, 2, 2 );
+
     stopButton_ = new QToolButton();
     stopButton_->setAutoRaise( true );
     stopButton_->setEnabled( false );
@@ -1138,6 +1212,7 @@ void CrawlerWidget::setup()
     searchLineLayout->addWidget( clearButton_ );
     searchLineLayout->addWidget( searchButton_ );
     searchLineLayout->addWidget( keepSearchResultsButton_ );
+    searchLineLayout->addWidget( refineSearchButton_ );
     searchLineLayout->addWidget( stopButton_ );
     searchLineLayout->addWidget( searchInfoLine_ );
 
@@ -1252,6 +1327,8 @@ void CrawlerWidget::setup()
 
     connect( logFilteredData_.get(), &LogFilteredData::searchProgressed, this,
              &CrawlerWidget::updateFilteredView, Qt::QueuedConnection );
+    connect( logFilteredData_.get(), &LogFilteredData::searchEstimated, this,
+             &CrawlerWidget::updateSearchEstimate, Qt::QueuedConnection );
 
     // Sent load file update to MainWindow (for status update)
     connect( logData_.get(), &LogData::loadingProgressed, this, &CrawlerWidget::loadingProgressed );
@@ -1362,6 +1439,30 @@ void CrawlerWidget::changeFontSize( bool increase )
     }
 }
 
+void CrawlerWidget::setFilteredViewTabText( int tabIndex, const QString& text )
+{
+    const auto previousText = tabbedFilteredView_->tabText( tabIndex );
+    tabbedFilteredView_->setTabText( tabIndex, text );
+
+    const auto view = qobject_cast<FilteredView*>( tabbedFilteredView_->widget( tabIndex ) );
+    const auto viewData = filteredViewsData_.find( view );
+    if ( previousText.isEmpty() || viewData == filteredViewsData_.end() ) {
+        return;
+    }
+
+    // Nested searches follow the new search of their parent
+    const auto nestedPrefix = previousText + " > ";
+    for ( const auto& [ nestedView, nestedData ] : filteredViewsData_ ) {
+        const auto nestedIndex = tabbedFilteredView_->indexOf( nestedView );
+        const auto nestedText = tabbedFilteredView_->tabText( nestedIndex );
+        if ( nestedData->parentData() == viewData->second
+             && nestedText.startsWith( nestedPrefix ) ) {
+            setFilteredViewTabText( nestedIndex,
+                                    text + " > " + nestedText.mid( nestedPrefix.size() ) );
+        }
+    }
+}
+
 void CrawlerWidget::connectAllFilteredViewSlots( FilteredView* view )
 {
     connect( view, &FilteredView::newSelection, view, [ view ]( auto ) { view->update(); } );
@@ -1552,6 +1653,7 @@ void CrawlerWidget::loadIcons()
     clearButton_->setIcon( iconLoader_.load( "icons8-delete" ) );
     searchButton_->setIcon( iconLoader_.load( "icons8-search" ) );
     keepSearchResultsButton_->setIcon( iconLoader_.load( "icons8-lock" ) );
+    refineSearchButton_->setIcon( iconLoader_.load( "icons8-down-arrow" ) );
     matchCaseButton_->setIcon( iconLoader_.load( "icons8-font-size" ) );
     stopButton_->setIcon( iconLoader_.load( "icons8-close-window" ) );
 }
@@ -1604,8 +1706,14 @@ void CrawlerWidget::replaceCurrentSearch( const QString& searchText )
             stopButton_->show();
             clearButton_->hide();
             searchButton_->hide();
+            // Search around the part of the file on screen first
+            OptionalLineNumber priorityLine;
+            if ( Configuration::get().searchFromViewport() ) {
+                priorityLine = isFollowEnabled() ? searchEndLine_ : logMainView_->getTopLine();
+            }
             // Start a new asynchronous search
-            logFilteredData_->runSearch( regexpPattern, searchStartLine_, searchEndLine_ );
+            logFilteredData_->runSearch( regexpPattern, searchStartLine_, searchEndLine_,
+                                         priorityLine );
             // Accept auto-refresh of the search
             searchState_.startSearch();
             searchInfoLine_->hide();
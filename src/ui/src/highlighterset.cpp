@@ -70,6 +70,38 @@ QRegularExpression::PatternOptions getPatternOptions( bool ignoreCase )
     return options;
 }
 
+namespace {
+// PCRE takes the first alternative that matches, hyperscan
+// reports the longest one, e.g. "ab" for a|ab.
+bool hasAlternation( const QString& pattern )
+{
+    auto isInClass = false;
+    for ( auto index = 0; index < pattern.size(); ++index ) {
+        const auto c = pattern.at( index );
+        if ( c == QChar( '\\' ) ) {
+            ++index;
+        }
+        else if ( isInClass ) {
+            isInClass = c != QChar( ']' );
+        }
+        else if ( c == QChar( '[' ) ) {
+            isInClass = true;
+            // A closing bracket right after the opening one is part of the class
+            if ( index + 1 < pattern.size() && pattern.at( index + 1 ) == QChar( '^' ) ) {
+                ++index;
+            }
+            if ( index + 1 < pattern.size() && pattern.at( index + 1 ) == QChar( ']' ) ) {
+                ++index;
+            }
+        }
+        else if ( c == QChar( '|' ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
 Highlighter::Highlighter( const QString& pattern, bool ignoreCase, bool onlyMatch,
                           const QColor& foreColor, const QColor& backColor )
     : regexp_( pattern, getPatternOptions( ignoreCase ) )
@@ -180,7 +212,6 @@ RegularExpressionPattern Highlighter::expressionPattern() const
     result.pattern
         = useRegex_ ? regexp_.pattern() : QRegularExpression::escape( regexp_.pattern() );
     result.isCaseSensitive = !ignoreCase();
-    result.isPrefilter = true;
 
     return result;
 }
@@ -192,6 +223,14 @@ void Highlighter::compile() const
 
     optimizedRegexp_ = QRegularExpression( pattern, regexp_.patternOptions() );
     optimizedRegexp_->optimize();
+
+    // Hyperscan has no capture groups and reports the longest match
+    // where a lazy quantifier or an earlier alternative would stop early.
+    static const QRegularExpression lazyQuantifier( R"([*+?}]\?)" );
+    needsRegexpRanges_ = optimizedRegexp_->captureCount() > 0
+                         || ( useRegex_
+                              && ( lazyQuantifier.match( pattern ).hasMatch()
+                                   || hasAlternation( pattern ) ) );
 }
 
 bool Highlighter::matchLine( const QString& line, klogg::vector<HighlightedMatch>& matches ) const
@@ -209,26 +248,35 @@ bool Highlighter::matchLine( const QString& line, klogg::vector<HighlightedMatch
         if ( optimizedRegexp_->captureCount() > 0 ) {
             matches.reserve( static_cast<size_t>( match.lastCapturedIndex() ) );
             for ( int i = 1; i <= match.lastCapturedIndex(); ++i ) {
-
-                const auto colors = vairateColors( match.captured( i ) );
-
-                matches.emplace_back( LineColumn{ match.capturedStart( i ) },
-                                      LineLength{ match.capturedLength( i ) }, colors.first,
-                                      colors.second );
+                matches.push_back( highlightedMatch( line, LineColumn{ match.capturedStart( i ) },
+                                                     LineLength{ match.capturedLength( i ) } ) );
             }
         }
         else {
-            const auto colors = vairateColors( match.captured( 0 ) );
-
-            matches.emplace_back( LineColumn{ match.capturedStart( 0 ) },
-                                  LineLength{ match.capturedLength( 0 ) }, colors.first,
-                                  colors.second );
+            matches.push_back( highlightedMatch( line, LineColumn{ match.capturedStart( 0 ) },
+                                                 LineLength{ match.capturedLength( 0 ) } ) );
         }
     }
 
     return ( !matches.empty() );
 }
 
+HighlightedMatch Highlighter::highlightedMatch( const QString& line, LineColumn start,
+                                                LineLength length ) const
+{
+    const auto colors = vairateColors( line.mid( start.get(), length.get() ) );
+    return HighlightedMatch{ start, length, colors.first, colors.second };
+}
+
+bool Highlighter::needsRegexpRanges() const
+{
+    if ( !optimizedRegexp_ ) {
+        compile();
+    }
+
+    return needsRegexpRanges_;
+}
+
 HighlighterSet HighlighterSet::createNewSet( const QString& name )
 {
     return HighlighterSet{ name };
@@ -260,45 +308,101 @@ void HighlighterSet::compile() const
     klogg::vector<RegularExpressionPattern> patterns(
         static_cast<size_t>( highlighterList_.size() ) );
     std::transform( highlighterList_.begin(), highlighterList_.end(), patterns.begin(),
-                    []( const Highlighter& hl ) { return hl.expressionPattern(); } );
+                    []( const Highlighter& hl ) {
+                        hl.compile();
+                        return hl.expressionPattern();
+                    } );
 
-    compiledExpression_ = std::make_shared<MultiRegularExpression>( patterns );
+    compiledExpression_ = std::make_shared<HsRangesRegularExpression>( patterns );
 }
 
 HighlighterMatchType HighlighterSet::matchLine( const QString& line,
                                                 HighlightedMatchRanges& matches ) const
 {
-    if ( highlighterList_.empty() ) {
-        return HighlighterMatchType::NoMatch;
+    HighlighterSetMatcher matcher;
+    return matcher.matchLine( *this, line, matches );
+}
+
+HighlighterMatchType HighlighterSetMatcher::matchLine( const HighlighterSet& highlighterSet,
+                                                       const QString& line,
+                                                       HighlightedMatchRanges& matches )
+{
+    if ( !highlighterSet.compiledExpression_ ) {
+        highlighterSet.compile();
     }
 
-    if ( !compiledExpression_ ) {
-        compile();
+    if ( expression_ != highlighterSet.compiledExpression_ ) {
+        expression_ = highlighterSet.compiledExpression_;
+        matcher_ = expression_->createMatcher();
     }
 
-    klogg::vector<char> utf8Data( static_cast<size_t>( line.size() * 4 ) );
-    const auto resultSize
+    const auto& highlighters = highlighterSet.highlighterList_;
+    if ( highlighters.empty() ) {
+        return HighlighterMatchType::NoMatch;
+    }
+
+    // Each utf16 code unit takes at most 3 bytes in utf8
+    utf8Data_.resize( static_cast<size_t>( line.size() ) * 3 );
+    const auto utf8Size
         = simdutf::convert_utf16_to_utf8( reinterpret_cast<const char16_t*>( line.utf16() ),
-                                          static_cast<size_t>( line.size() ), utf8Data.data() );
+                                          static_cast<size_t>( line.size() ), utf8Data_.data() );
+
+    // Invalid utf16 is not converted, leave the line to QRegularExpression
+    const auto isScanned = utf8Size > 0 || line.isEmpty();
 
-    auto matcher = compiledExpression_->createMatcher();
-    klogg::vector<std::pair<RegularExpressionPattern, bool>> matchedPatterns
-        = matcher->match( std::string_view{ utf8Data.data(), resultSize } );
+    matcher_.match( std::string_view{ utf8Data_.data(), utf8Size }, ranges_ );
+
+    if ( utf8Size != static_cast<size_t>( line.size() ) ) {
+        buildColumnIndex( utf8Size );
+    }
+    else {
+        utf16Columns_.clear();
+    }
 
     auto matchType = HighlighterMatchType::NoMatch;
 
-    for ( int index = static_cast<int>( highlighterList_.size() ) - 1; index >= 0; --index ) {
-        const Highlighter& hl = highlighterList_[ index ];
-        if ( !matchedPatterns[ static_cast<size_t>( index ) ].second ) {
-            continue;
-        }
+    klogg::vector<HighlightedMatch> thisMatches;
+    for ( int index = static_cast<int>( highlighters.size() ) - 1; index >= 0; --index ) {
+        const Highlighter& hl = highlighters[ index ];
+        const auto patternIndex = static_cast<size_t>( index );
+
+        thisMatches.clear();
+        if ( isScanned && expression_->canLocate( patternIndex ) ) {
+            const auto patternRanges = std::equal_range(
+                ranges_.cbegin(), ranges_.cend(), PatternMatchRange{ patternIndex, 0, 0 },
+                []( const PatternMatchRange& lhs, const PatternMatchRange& rhs ) {
+                    return lhs.patternIndex < rhs.patternIndex;
+                } );
+
+            if ( patternRanges.first == patternRanges.second ) {
+                continue;
+            }
 
-        klogg::vector<HighlightedMatch> thisMatches;
-        if ( !hl.matchLine( line, thisMatches ) ) {
+            if ( hl.highlightOnlyMatch() && hl.needsRegexpRanges() ) {
+                hl.matchLine( line, thisMatches );
+            }
+            else if ( hl.highlightOnlyMatch() ) {
+                std::transform( patternRanges.first, patternRanges.second,
+                                std::back_inserter( thisMatches ),
+                                [ this, &hl, &line ]( const PatternMatchRange& range ) {
+                                    const auto start = toColumn( range.start );
+                                    const auto end = toColumn( range.end );
+                                    return hl.highlightedMatch(
+                                        line, start, LineLength{ end.get() - start.get() } );
+                                } );
+            }
+        }
+        else if ( ( isScanned && !matcher_.mayMatch( patternIndex ) )
+                  || !hl.matchLine( line, thisMatches ) ) {
+            // Lines rejected by the prefilter are not matched again
             continue;
         }
 
-        if (hl.highlightOnlyMatch()) {
+        if ( hl.highlightOnlyMatch() ) {
+            if ( thisMatches.empty() ) {
+                continue;
+            }
+
             if ( matchType != HighlighterMatchType::LineMatch ) {
                 matchType = HighlighterMatchType::WordMatch;
             }
@@ -315,6 +419,39 @@ HighlighterMatchType HighlighterSet::matchLine( const QString& line,
     return matchType;
 }
 
+bool HighlighterSetMatcher::isMatchingWith( const HighlighterSet& highlighterSet ) const
+{
+    return expression_ != nullptr && expression_ == highlighterSet.compiledExpression_;
+}
+
+void HighlighterSetMatcher::buildColumnIndex( std::size_t utf8Size )
+{
+    utf16Columns_.resize( utf8Size + 1 );
+
+    int column = 0;
+    for ( auto offset = 0u; offset < utf8Size; ++offset ) {
+        utf16Columns_[ offset ] = column;
+
+        // Continuation bytes belong to the character already counted,
+        // 4 bytes sequences are surrogate pairs in utf16
+        const auto byte = static_cast<unsigned char>( utf8Data_[ offset ] );
+        if ( ( byte & 0xC0 ) != 0x80 ) {
+            column += byte >= 0xF0 ? 2 : 1;
+        }
+    }
+
+    utf16Columns_[ utf8Size ] = column;
+}
+
+LineColumn HighlighterSetMatcher::toColumn( std::size_t utf8Offset ) const
+{
+    if ( utf16Columns_.empty() ) {
+        return LineColumn{ static_cast<LineColumn::UnderlyingType>( utf8Offset ) };
+    }
+
+    return LineColumn{ utf16Columns_[ utf8Offset ] };
+}
+
 //
 // Persistable virtual functions implementation
 //
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "linehighlighter.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <QStringView>
+
+#include "highlightedmatch.h"
+#include "linetypes.h"
+#include "tracing.h"
+
+LineHighlights LineHighlighter::highlight( const QString& line,
+                                           const HighlighterSet& highlighterSet,
+                                           const ViewHighlighters& viewHighlighters )
+{
+    KLOGG_TRACE_SCOPE( "LineHighlighter::highlight" );
+
+    LineHighlights highlights;
+
+    HighlightedMatchRanges highlighterMatches;
+    const auto highlightType
+        = highlighterSetMatcher_.matchLine( highlighterSet, line, highlighterMatches );
+
+    if ( highlightType == HighlighterMatchType::LineMatch ) {
+        highlights.lineColors = std::make_pair( highlighterMatches.front().foreColor(),
+                                                highlighterMatches.front().backColor() );
+    }
+
+    if ( viewHighlighters.searchPattern ) {
+        viewHighlighters.searchPattern->matchLine( line, patternMatches_ );
+        highlighterMatches.addMatches( patternMatches_ );
+    }
+
+    for ( const auto& highlighter : viewHighlighters.quickHighlightWords ) {
+        highlighter.matchLine( line, patternMatches_ );
+        highlighterMatches.addMatches( patternMatches_ );
+    }
+
+    const auto untabifyHighlight = [ &line ]( const auto& match ) {
+        const auto prefix = QStringView{ line }.left( match.startColumn().get() );
+        const auto matchPart
+            = QStringView{ line }.mid( match.startColumn().get(), match.size().get() );
+        const auto expandedPrefixLength = untabify( prefix.toString() ).size();
+        const LineLength startDelta
+            = LineLength{ type_safe::narrow_cast<LineLength::UnderlyingType>(
+                expandedPrefixLength - prefix.size() ) };
+
+        const LineLength expandedMatchLength = LineLength{
+            untabify( matchPart.toString(),
+                      LineColumn{ type_safe::narrow_cast<LineColumn::UnderlyingType>(
+                          expandedPrefixLength ) } )
+                .size()
+        };
+
+        const auto lengthDelta
+            = expandedMatchLength
+              - LineLength{ type_safe::narrow_cast<LineLength::UnderlyingType>(
+                  matchPart.size() ) };
+
+        return HighlightedMatch{ match.startColumn() + startDelta, match.size() + lengthDelta,
+                                 match.foreColor(), match.backColor() };
+    };
+
+    highlights.matches = highlighterMatches.matches();
+    std::transform( highlights.matches.begin(), highlights.matches.end(),
+                    highlights.matches.begin(), untabifyHighlight );
+
+    return highlights;
+}
+
+std::optional<std::pair<QColor, QColor>>
+LineHighlighter::lineColors( const QString& line, const HighlighterSet& highlighterSet )
+{
+    KLOGG_TRACE_SCOPE( "LineHighlighter::lineColors" );
+
+    HighlightedMatchRanges highlighterMatches;
+    if ( highlighterSetMatcher_.matchLine( highlighterSet, line, highlighterMatches )
+         != HighlighterMatchType::LineMatch ) {
+        return {};
+    }
+
+    return std::make_pair( highlighterMatches.front().foreColor(),
+                           highlighterMatches.front().backColor() );
+}
+
+bool LineHighlighter::isHighlightingWith( const HighlighterSet& highlighterSet ) const
+{
+    return highlighterSetMatcher_.isMatchingWith( highlighterSet );
+}
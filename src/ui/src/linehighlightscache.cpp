@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "linehighlightscache.h"
+
+LineHighlightsCache::LineHighlightsCache( std::size_t capacity )
+    : entries_( capacity )
+{
+}
+
+const LineHighlights* LineHighlightsCache::find( LineNumber line, uint64_t generation )
+{
+    const auto* entry = entries_.find( line.get() );
+    if ( entry == nullptr || entry->generation != generation ) {
+        return nullptr;
+    }
+
+    return &entry->highlights;
+}
+
+const LineHighlights& LineHighlightsCache::insert( LineNumber line, uint64_t generation,
+                                                   LineHighlights highlights )
+{
+    return entries_.insert( line.get(), Entry{ generation, std::move( highlights ) } ).highlights;
+}
+
+void LineHighlightsCache::clear()
+{
+    entries_.clear();
+}
+
+std::size_t LineHighlightsCache::size() const
+{
+    return entries_.size();
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "linesprefetcher.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QtConcurrent>
+
+#include "abstractlogdata.h"
+#include "log.h"
+
+namespace {
+// The page being read and the previous one
+constexpr std::size_t MaxPages = 2;
+
+constexpr double MaxScreensAhead = 4;
+
+// The prefetched lines should last that long at the current scrolling speed
+constexpr double LookaheadSeconds = 0.5;
+
+// A longer pause between two moves ends the scrolling
+constexpr double ScrollPauseSeconds = 0.5;
+
+// Lines read at once, interruptions are checked between chunks
+constexpr LinesCount ChunkSize = 256_lcount;
+} // namespace
+
+LinesPrefetcher::LinesPrefetcher( const AbstractLogData& logData )
+    : logData_( logData )
+{
+}
+
+LinesPrefetcher::~LinesPrefetcher()
+{
+    interruptRequested_.set();
+    prefetchFuture_.waitForFinished();
+}
+
+void LinesPrefetcher::viewMoved( LineNumber firstLine, LinesCount nbVisibleLines,
+                                 uint64_t generation, const HighlighterSet& highlighterSet,
+                                 std::shared_ptr<const ViewHighlighters> viewHighlighters )
+{
+    if ( lastFirstLine_ == firstLine ) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto previousFirstLine = lastFirstLine_;
+    const auto elapsed = std::chrono::duration<double>( now - lastMoveTime_ ).count();
+
+    lastFirstLine_ = firstLine;
+    lastMoveTime_ = now;
+
+    if ( !previousFirstLine || nbVisibleLines == 0_lcount ) {
+        return;
+    }
+
+    const auto distance = firstLine > *previousFirstLine ? firstLine - *previousFirstLine
+                                                         : *previousFirstLine - firstLine;
+    if ( static_cast<double>( distance.get() )
+         > MaxScreensAhead * static_cast<double>( nbVisibleLines.get() ) ) {
+        // Jumped somewhere else, not scrolling
+        linesPerSecond_ = 0;
+        return;
+    }
+
+    if ( elapsed > ScrollPauseSeconds ) {
+        linesPerSecond_ = 0;
+    }
+    else {
+        const auto speed = static_cast<double>( distance.get() ) / std::max( elapsed, 0.001 );
+        linesPerSecond_ = linesPerSecond_ > 0 ? ( linesPerSecond_ + speed ) / 2 : speed;
+    }
+    direction_ = firstLine > *previousFirstLine ? Direction::Down : Direction::Up;
+
+    const auto totalLines = logData_.getNbLine().get();
+    if ( firstLine.get() >= totalLines ) {
+        return;
+    }
+
+    const auto visibleStart = firstLine.get();
+    const auto visibleEnd = std::min( visibleStart + nbVisibleLines.get(), totalLines );
+    const auto ahead = linesAhead( nbVisibleLines ).get();
+
+    {
+        // Nothing to do while at least a screen is already prefetched ahead
+        SharedLock lock( mutex_ );
+        const auto* page
+            = findPage( firstLine, LinesCount( visibleEnd - visibleStart ), generation );
+        if ( page != nullptr ) {
+            const auto pageStart = page->firstLine.get();
+            const auto pageEnd = pageStart + page->lines.size();
+            const auto screen = nbVisibleLines.get();
+
+            const auto isBufferedAhead
+                = direction_ == Direction::Down
+                      ? pageEnd >= std::min( visibleEnd + screen, totalLines )
+                      : pageStart <= ( visibleStart > screen ? visibleStart - screen : 0 );
+            if ( isBufferedAhead ) {
+                return;
+            }
+        }
+    }
+
+    // The page includes the visible lines, so that they can
+    // all be found in one page while the view moves through it.
+    const auto requestStart = direction_ == Direction::Down
+                                  ? visibleStart
+                                  : ( visibleStart > ahead ? visibleStart - ahead : 0 );
+    const auto requestEnd
+        = direction_ == Direction::Down ? std::min( visibleEnd + ahead, totalLines ) : visibleEnd;
+
+    schedule( Request{ LineNumber( requestStart ), LinesCount( requestEnd - requestStart ),
+                       generation, highlighterSet, std::move( viewHighlighters ) } );
+}
+
+bool LinesPrefetcher::getLines( LineNumber firstLine, LinesCount nbLines, uint64_t generation,
+                                klogg::vector<PrefetchedLine>& lines ) const
+{
+    SharedLock lock( mutex_ );
+
+    const auto* page = findPage( firstLine, nbLines, generation );
+    if ( page == nullptr ) {
+        return false;
+    }
+
+    const auto first = page->lines.begin()
+                       + static_cast<std::ptrdiff_t>( ( firstLine - page->firstLine ).get() );
+    lines.assign( first, first + static_cast<std::ptrdiff_t>( nbLines.get() ) );
+    return true;
+}
+
+void LinesPrefetcher::invalidate()
+{
+    ScopedLock lock( mutex_ );
+    pages_.clear();
+    pendingRequest_.reset();
+}
+
+LinesCount LinesPrefetcher::linesAhead( LinesCount nbVisibleLines ) const
+{
+    const auto screens = std::ceil( linesPerSecond_ * LookaheadSeconds
+                                    / static_cast<double>( nbVisibleLines.get() ) );
+    const auto clampedScreens = std::clamp( screens, 1.0, MaxScreensAhead );
+
+    return LinesCount( nbVisibleLines.get()
+                       * static_cast<LinesCount::UnderlyingType>( clampedScreens ) );
+}
+
+void LinesPrefetcher::schedule( Request request )
+{
+    {
+        ScopedLock lock( mutex_ );
+        // Only the latest request matters, the view has moved since the older ones
+        pendingRequest_ = std::move( request );
+        if ( isPrefetching_ ) {
+            return;
+        }
+        isPrefetching_ = true;
+    }
+
+    prefetchFuture_ = QtConcurrent::run( [ this ] { runPrefetch(); } );
+}
+
+void LinesPrefetcher::runPrefetch()
+{
+    while ( !interruptRequested_ ) {
+        std::optional<Request> request;
+        {
+            ScopedLock lock( mutex_ );
+            request.swap( pendingRequest_ );
+            if ( !request ) {
+                isPrefetching_ = false;
+                return;
+            }
+        }
+
+        prefetch( *request );
+    }
+
+    ScopedLock lock( mutex_ );
+    isPrefetching_ = false;
+}
+
+void LinesPrefetcher::prefetch( const Request& request )
+{
+    LOG_DEBUG << "Prefetching " << request.nbLines << " lines from " << request.firstLine;
+
+    Page page{ request.firstLine, request.generation, {} };
+    page.lines.reserve( request.nbLines.get() );
+
+    const auto endLine = request.firstLine + request.nbLines;
+    auto chunkStart = request.firstLine;
+    while ( chunkStart < endLine ) {
+        if ( interruptRequested_ ) {
+            return;
+        }
+
+        const auto chunkLines = std::min( ChunkSize, endLine - chunkStart );
+        const auto lines = logData_.getLines( chunkStart, chunkLines );
+        for ( const auto& line : lines ) {
+            page.lines.push_back( PrefetchedLine{
+                line, lineHighlighter_.highlight( line, request.highlighterSet,
+                                                  *request.viewHighlighters ) } );
+        }
+
+        if ( lines.size() < chunkLines.get() ) {
+            // The data has shrunk
+            break;
+        }
+
+        chunkStart = chunkStart + chunkLines;
+    }
+
+    ScopedLock lock( mutex_ );
+    pages_.erase( std::remove_if( pages_.begin(), pages_.end(),
+                                  [ &page ]( const Page& oldPage ) {
+                                      return oldPage.generation != page.generation;
+                                  } ),
+                  pages_.end() );
+
+    pages_.push_back( std::move( page ) );
+    if ( pages_.size() > MaxPages ) {
+        pages_.erase( pages_.begin() );
+    }
+}
+
+const LinesPrefetcher::Page* LinesPrefetcher::findPage( LineNumber firstLine,
+                                                        LinesCount nbLines,
+                                                        uint64_t generation ) const
+{
+    const auto page = std::find_if( pages_.rbegin(), pages_.rend(), [ & ]( const Page& p ) {
+        return p.generation == generation && p.firstLine <= firstLine
+               && firstLine.get() + nbLines.get() <= p.firstLine.get() + p.lines.size();
+    } );
+
+    return page != pages_.rend() ? &( *page ) : nullptr;
+}
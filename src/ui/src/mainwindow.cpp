@@ -110,6 +110,7 @@
 #include "streamsession.h"
 #include "styles.h"
 #include "tabbedcrawlerwidget.h"
+#include "tracing.h"
 
 namespace {
 
@@ -405,6 +406,9 @@ void MainWindow::reTranslateUI()
     generateDumpAction->setText( transAction( action::generateDumpText ) );
     generateDumpAction->setStatusTip( transAction( action::generateDumpStatusTip ) );
 
+    recordTraceAction->setText( transAction( action::recordTraceText ) );
+    recordTraceAction->setStatusTip( transAction( action::recordTraceStatusTip ) );
+
     showScratchPadAction->setText( transAction( action::showScratchPadText ) );
     showScratchPadAction->setStatusTip( transAction( action::showScratchPadStatusTip ) );
 
@@ -640,6 +644,12 @@ void MainWindow::createActions()
     connect( generateDumpAction, &QAction::triggered, this,
              [ this ]( auto ) { this->generateDump(); } );
 
+    recordTraceAction = new QAction( tr( action::recordTraceText ), this );
+    recordTraceAction->setStatusTip( tr( action::recordTraceStatusTip ) );
+    recordTraceAction->setCheckable( true );
+    recordTraceAction->setChecked( tracing::isEnabled() );
+    connect( recordTraceAction, &QAction::toggled, this, &MainWindow::toggleTracing );
+
     showScratchPadAction = new QAction( tr( action::showScratchPadText ), this );
     showScratchPadAction->setStatusTip( tr( action::showScratchPadStatusTip ) );
     connect( showScratchPadAction, &QAction::triggered, this,
@@ -839,6 +849,7 @@ void MainWindow::createMenus()
     helpMenu->addAction( joinTelegramAction );
     helpMenu->addSeparator();
     helpMenu->addAction( generateDumpAction );
+    helpMenu->addAction( recordTraceAction );
     helpMenu->addSeparator();
     helpMenu->addAction( aboutQtAction );
     helpMenu->addAction( aboutAction );
@@ -1169,10 +1180,7 @@ void MainWindow::copy()
         }
 
         if ( auto current = currentCrawlerWidget(); current != nullptr ) {
-            auto text = current->getSelectedText();
-            text.replace( QChar::Null, QChar::Space );
-
-            sendTextToClipboard( text, true );
+            current->copySelectedText();
         }
     } catch ( std::exception& err ) {
         LOG_ERROR << "failed to copy data to clipboard " << err.what();
@@ -2358,3 +2366,26 @@ void MainWindow::generateDump()
         throw std::logic_error( "test dump" );
     }
 }
+
+void MainWindow::toggleTracing( bool isEnabled )
+{
+    if ( isEnabled ) {
+        tracing::clear();
+        tracing::setEnabled( true );
+        return;
+    }
+
+    tracing::setEnabled( false );
+
+    const auto fileName = QFileDialog::getSaveFileName(
+        this, tr( "Save performance trace" ), QDir::home().filePath( "klogg-trace.json" ),
+        tr( "Trace files (*.json)" ) );
+    if ( fileName.isEmpty() ) {
+        return;
+    }
+
+    if ( !tracing::writeChromeTrace( fileName ) ) {
+        QMessageBox::warning( this, tr( "klogg - save performance trace" ),
+                              tr( "Can't write the trace to %1" ).arg( fileName ) );
+    }
+}
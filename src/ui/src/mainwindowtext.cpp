@@ -90,6 +90,9 @@ const char* action::joinTelegramStatusTip
     = QT_TR_NOOP( "Join Klogg development community at Telegram" );
 const char* action::generateDumpText = QT_TR_NOOP( "Generate crash dump" );
 const char* action::generateDumpStatusTip = QT_TR_NOOP( "Generate diagnostic crash dump" );
+const char* action::recordTraceText = QT_TR_NOOP( "Record performance trace" );
+const char* action::recordTraceStatusTip
+    = QT_TR_NOOP( "Record the timings of loading, searching and drawing to a trace file" );
 const char* action::showScratchPadText = QT_TR_NOOP( "Scratchpad" );
 const char* action::showScratchPadStatusTip = QT_TR_NOOP( "Show the scratchpad" );
 const char* action::addToFavoritesText = QT_TR_NOOP( "Add to favorites" );
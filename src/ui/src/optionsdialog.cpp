@@ -203,6 +203,7 @@ void OptionsDialog::setupPolling()
 void OptionsDialog::setupSearchResultsCache()
 {
     searchCacheSpinBox->setEnabled( searchResultsCacheCheckBox->isChecked() );
+    persistSearchResultsCheckBox->setEnabled( searchResultsCacheCheckBox->isChecked() );
 }
 
 void OptionsDialog::setupLogging()
@@ -361,7 +362,8 @@ void OptionsDialog::updateDialogFromConfig()
     // Perf
     parallelSearchCheckBox->setChecked( config.useParallelSearch() );
     searchResultsCacheCheckBox->setChecked( config.useSearchResultsCache() );
-    searchCacheSpinBox->setValue( static_cast<int>( config.searchResultsCacheLines() ) );
+    searchCacheSpinBox->setValue( static_cast<int>( config.searchResultsCacheSizeMb() ) );
+    persistSearchResultsCheckBox->setChecked( config.persistSearchResults() );
     indexReadBufferSpinBox->setValue( config.indexReadBufferSizeMb() );
     searchReadBufferSpinBox->setValue( config.searchReadBufferSizeLines() );
     keepFileClosedCheckBox->setChecked( config.keepFileClosed() );
@@ -533,7 +535,8 @@ void OptionsDialog::updateConfigFromDialog()
 
     config.setUseParallelSearch( parallelSearchCheckBox->isChecked() );
     config.setUseSearchResultsCache( searchResultsCacheCheckBox->isChecked() );
-    config.setSearchResultsCacheLines( static_cast<unsigned>( searchCacheSpinBox->value() ) );
+    config.setSearchResultsCacheSizeMb( static_cast<unsigned>( searchCacheSpinBox->value() ) );
+    config.setPersistSearchResults( persistSearchResultsCheckBox->isChecked() );
     config.setIndexReadBufferSizeMb( indexReadBufferSpinBox->value() );
     config.setSearchReadBufferSizeLines( searchReadBufferSpinBox->value() );
     config.setKeepFileClosed( keepFileClosedCheckBox->isChecked() );
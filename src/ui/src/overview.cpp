@@ -21,9 +21,13 @@
 // It provides support for drawing the match overview sidebar but
 // the actual drawing is done in AbstractLogView which uses this class.
 
+#include <algorithm>
+#include <cmath>
+
 #include "linetypes.h"
 #include "log.h"
 
+#include "lineshistogram.h"
 #include "logfiltereddata.h"
 
 #include "overview.h"
@@ -115,31 +119,16 @@ void Overview::recalculatesLines()
         matchLines_.clear();
         markLines_.clear();
 
-        if ( linesInFile_.get() > 0 ) {
-            logFilteredData_->iterateOverLines( [ this ]( LineNumber line ) {
-                const auto lineType = logFilteredData_->lineTypeByLine( line );
-                const auto position = yFromFileLine( line );
-                if ( lineType.testFlag( LogFilteredData::LineTypeFlags::Match ) ) {
-                    if ( ( !matchLines_.empty() ) && matchLines_.back().position() == position ) {
-                        // If the line is already there, we increase its weight
-                        matchLines_.back().load();
-                    }
-                    else {
-                        // If not we just add it
-                        matchLines_.emplace_back( position );
-                    }
-                }
-                else {
-                    if ( ( !markLines_.empty() ) && markLines_.back().position() == position ) {
-                        // If the line is already there, we increase its weight
-                        markLines_.back().load();
-                    }
-                    else {
-                        // If not we just add it
-                        markLines_.emplace_back( position );
-                    }
-                }
-            } );
+        if ( linesInFile_.get() > 0 && height_ > 0 ) {
+            // The histograms are kept up to date by the filtered data, so the cost
+            // here does not depend on the number of matches.
+            const auto visibility = logFilteredData_->visibility();
+            if ( visibility.testFlag( LogFilteredData::VisibilityFlags::Matches ) ) {
+                fillLines( logFilteredData_->matchesHistogram(), matchLines_ );
+            }
+            if ( visibility.testFlag( LogFilteredData::VisibilityFlags::Marks ) ) {
+                fillLines( logFilteredData_->marksHistogram(), markLines_ );
+            }
         }
     }
     else
@@ -147,3 +136,30 @@ void Overview::recalculatesLines()
 
     dirty_ = false;
 }
+
+void Overview::fillLines( const LinesHistogram& histogram,
+                          klogg::vector<WeightedLine>& lines ) const
+{
+    if ( histogram.totalCount() == 0 ) {
+        return;
+    }
+
+    const auto bins = histogram.rescale( linesInFile_, height_ );
+
+    // The weight grows with the log of the fraction of lines of the pixel
+    // that are in the set, so a single match stays visible next to a dense area.
+    const auto linesPerPixel
+        = std::max( 1.0, static_cast<double>( linesInFile_.get() ) / height_ );
+    const auto maxDensity = std::log1p( linesPerPixel );
+
+    for ( auto position = 0u; position < bins.size(); ++position ) {
+        if ( bins[ position ] == 0 ) {
+            continue;
+        }
+
+        const auto density = std::log1p( static_cast<double>( bins[ position ] ) ) / maxDensity;
+        const auto weight
+            = static_cast<int>( std::ceil( density * WeightedLine::WEIGHT_STEPS ) ) - 1;
+        lines.emplace_back( static_cast<int>( position ), weight );
+    }
+}
@@ -22,7 +22,9 @@
 
 #include <QMouseEvent>
 #include <QPainter>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 #include "log.h"
 
@@ -129,6 +131,31 @@ const char* const highlight_xpm[][ 14 ] = {
     },
 };
 
+namespace {
+
+// Hue (in degrees) added to the match colour for the lightest weight
+constexpr int MatchHueSpread = 30;
+
+qreal heatmapLevel( int weight )
+{
+    return static_cast<qreal>( weight + 1 ) / Overview::WeightedLine::WEIGHT_STEPS;
+}
+
+QColor heatmapColor( const QColor& color, int weight, int hueSpread )
+{
+    const auto hueShift
+        = static_cast<int>( std::lround( hueSpread * ( 1 - heatmapLevel( weight ) ) ) );
+    const auto hue = ( std::max( color.hsvHue(), 0 ) + hueShift ) % 360;
+    return QColor::fromHsv( hue, color.hsvSaturation(), color.value() );
+}
+
+qreal heatmapOpacity( int weight )
+{
+    return 0.25 + 0.75 * heatmapLevel( weight );
+}
+
+} // namespace
+
 OverviewWidget::OverviewWidget( QWidget* parent )
     : QWidget( parent )
     , highlightTimer_()
@@ -163,13 +190,12 @@ void OverviewWidget::paintEvent( QPaintEvent* /* paintEvent */ )
         painter.setPen( palette().color( QPalette::Text ) );
         painter.drawLine( 0, 0, 0, height() );
 
-        // The 'match' lines
-        painter.setPen( match_color );
+        // The 'match' lines, going from orange for sparse matches to red
+        // for the densest areas.
         const auto matchLines = *( overview_->getMatchLines() );
         for ( const auto& line : matchLines ) {
-            painter.setOpacity( ( 1.0 / Overview::WeightedLine::WEIGHT_STEPS )
-                                * ( line.weight() + 1 ) );
-            // (allow multiple matches to look 'darker' than a single one.)
+            painter.setPen( heatmapColor( match_color, line.weight(), MatchHueSpread ) );
+            painter.setOpacity( heatmapOpacity( line.weight() ) );
             painter.drawLine( 1 + LINE_MARGIN, line.position(), width() - LINE_MARGIN - 1,
                               line.position() );
         }
@@ -178,9 +204,8 @@ void OverviewWidget::paintEvent( QPaintEvent* /* paintEvent */ )
         painter.setPen( mark_color );
         const auto markLines = *( overview_->getMarkLines() );
         for ( const auto& line : markLines ) {
-            painter.setOpacity( ( 1.0 / Overview::WeightedLine::WEIGHT_STEPS )
-                                * ( line.weight() + 1 ) );
-            // (allow multiple matches to look 'darker' than a single one.)
+            painter.setOpacity( heatmapOpacity( line.weight() ) );
+            // (allow multiple marks to look 'darker' than a single one.)
             painter.drawLine( 1 + LINE_MARGIN, line.position(), width() - LINE_MARGIN - 1,
                               line.position() );
         }
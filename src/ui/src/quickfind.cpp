@@ -45,6 +45,7 @@
 #include <QtConcurrent>
 
 #include "abstractlogdata.h"
+#include "configuration.h"
 #include "dispatch_to.h"
 #include "linetypes.h"
 #include "log.h"
@@ -121,6 +122,7 @@ bool QuickFind::LastMatchPosition::isSooner( const FilePosition& position ) cons
 QuickFind::QuickFind( const AbstractLogData& logData )
     : logData_( logData )
     , searchingNotifier_()
+    , matchIndex_( logData )
     , incrementalSearchStatus_()
 {
     connect( &searchingNotifier_, &SearchingNotifier::notify, this, &QuickFind::sendNotification,
@@ -252,6 +254,8 @@ void QuickFind::searchForward( Selection selection, QuickFindMatcher matcher )
     interruptRequested_.set();
     operationWatcher_.waitForFinished();
 
+    matchIndex_.build( matcher );
+
 #if QT_VERSION < QT_VERSION_CHECK( 6, 0, 0 )
     operationFuture_ = QtConcurrent::run( this, &QuickFind::doSearchForward, selection, matcher );
 #else
@@ -268,6 +272,8 @@ void QuickFind::searchBackward( Selection selection, QuickFindMatcher matcher )
     interruptRequested_.set();
     operationWatcher_.waitForFinished();
 
+    matchIndex_.build( matcher );
+
 #if QT_VERSION < QT_VERSION_CHECK( 6, 0, 0 )
     operationFuture_ = QtConcurrent::run( this, &QuickFind::doSearchBackward, selection, matcher );
 #else
@@ -316,30 +322,45 @@ Portion QuickFind::doSearchForward( const FilePosition& start_position, const Se
         found = true;
     }
     else {
+        auto scanStart = line + 1_lcount;
+
+        const auto indexedLines = matchIndex_.indexedLines( matcher );
+        if ( indexedLines > 0_lcount ) {
+            // The index knows the next matching line, no need to read the others
+            auto nextMatch = matchIndex_.nextMatch( line );
+            while ( nextMatch.has_value() && !interruptRequested_ ) {
+                if ( matcher.isLineMatching( logData_.getExpandedLineString( *nextMatch ) ) ) {
+                    line = *nextMatch;
+                    std::tie( found_start_col, found_end_col ) = matcher.getLastMatch();
+                    found = true;
+                    break;
+                }
+                nextMatch = matchIndex_.nextMatch( *nextMatch );
+            }
+
+            // Only the lines appended since the index was built are read
+            scanStart = qMax( scanStart, LineNumber( indexedLines.get() ) );
+        }
+
         searchingNotifier_.reset();
         // And then the rest of the file
-        const auto nb_lines = logData_.getNbLine();
-        ++line;
-        while ( line < nb_lines ) {
-            if ( matcher.isLineMatching( logData_.getExpandedLineString( line ) ) ) {
+        const QuickFindLineScanner scanner( matcher );
+        auto candidateLine
+            = found ? OptionalLineNumber{} : findNextMatchingLine( scanStart, scanner );
+        while ( candidateLine.has_value() ) {
+            // Only the matching line is expanded to find the match columns
+            if ( matcher.isLineMatching( logData_.getExpandedLineString( *candidateLine ) ) ) {
+                line = *candidateLine;
                 std::tie( found_start_col, found_end_col ) = matcher.getLastMatch();
                 found = true;
                 break;
             }
-            ++line;
-
-            // See if we need to notify of the ongoing search
-            searchingNotifier_.ping( line, nb_lines, false );
-
-            if ( interruptRequested_ ) {
-                break;
-            }
+            candidateLine = findNextMatchingLine( *candidateLine + 1_lcount, scanner );
         }
     }
 
     if ( found ) {
-        // Clear any notification
-        Q_EMIT clearNotification();
+        notifyMatchFound( line, matcher );
 
         return Portion{ line, found_start_col, found_end_col };
     }
@@ -400,36 +421,43 @@ Portion QuickFind::doSearchBackward( const FilePosition& start_position, const S
         found = true;
     }
     else {
+        // Only the lines appended since the index was built are read
+        const auto indexedLines = LineNumber( matchIndex_.indexedLines( matcher ).get() );
+
         searchingNotifier_.reset();
         // And then the rest of the file
-        const auto nb_lines = logData_.getNbLine();
-        if ( line > 0_lnum ) {
-            --line;
-            while ( true ) {
-                if ( matcher.isLineMatchingBackward( logData_.getExpandedLineString( line ) ) ) {
+        const QuickFindLineScanner scanner( matcher );
+        auto candidateLine = findPreviousMatchingLine( line, indexedLines, scanner );
+        while ( candidateLine.has_value() ) {
+            // Only the matching line is expanded to find the match columns
+            if ( matcher.isLineMatchingBackward(
+                     logData_.getExpandedLineString( *candidateLine ) ) ) {
+                line = *candidateLine;
+                std::tie( start_col, end_col ) = matcher.getLastMatch();
+                found = true;
+                break;
+            }
+            candidateLine = findPreviousMatchingLine( *candidateLine, indexedLines, scanner );
+        }
+
+        if ( !found && indexedLines > 0_lnum ) {
+            // The index knows the previous matching line, no need to read the others
+            auto previousMatch = matchIndex_.previousMatch( qMin( line, indexedLines ) );
+            while ( previousMatch.has_value() && !interruptRequested_ ) {
+                if ( matcher.isLineMatchingBackward(
+                         logData_.getExpandedLineString( *previousMatch ) ) ) {
+                    line = *previousMatch;
                     std::tie( start_col, end_col ) = matcher.getLastMatch();
                     found = true;
                     break;
                 }
-                if ( line == 0_lnum ) {
-                    break;
-                }
-
-                --line;
-
-                // See if we need to notify of the ongoing search
-                searchingNotifier_.ping( line, nb_lines, true );
-
-                if ( interruptRequested_ ) {
-                    break;
-                }
+                previousMatch = matchIndex_.previousMatch( *previousMatch );
             }
         }
     }
 
     if ( found ) {
-        // Clear any notification
-        Q_EMIT clearNotification();
+        notifyMatchFound( line, matcher );
 
         return Portion{ line, start_col, end_col };
     }
@@ -451,10 +479,95 @@ Portion QuickFind::doSearchBackward( const FilePosition& start_position, const S
     }
 }
 
+LinesCount QuickFind::scanChunkSize() const
+{
+    return LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+}
+
+OptionalLineNumber QuickFind::findNextMatchingLine( LineNumber firstLine,
+                                                    const QuickFindLineScanner& scanner )
+{
+    const auto nbLines = logData_.getNbLine();
+    const auto endLine = LineNumber( nbLines.get() );
+    const auto chunkSize = scanChunkSize();
+
+    auto chunkStart = firstLine;
+    while ( chunkStart < endLine && !interruptRequested_ ) {
+        const auto nbChunkLines = qMin( chunkSize, endLine - chunkStart );
+
+        OptionalLineNumber matchingLine;
+        scanner.scanLines( logData_, chunkStart, nbChunkLines, false,
+                           [ &matchingLine, chunkStart ]( size_t index ) {
+                               matchingLine = chunkStart + LinesCount( index );
+                               return false;
+                           } );
+        if ( matchingLine.has_value() ) {
+            return matchingLine;
+        }
+
+        chunkStart = chunkStart + nbChunkLines;
+
+        // See if we need to notify of the ongoing search
+        searchingNotifier_.ping( chunkStart, nbLines, false );
+    }
+
+    return {};
+}
+
+OptionalLineNumber QuickFind::findPreviousMatchingLine( LineNumber endLine, LineNumber firstLine,
+                                                        const QuickFindLineScanner& scanner )
+{
+    const auto nbLines = logData_.getNbLine();
+    const auto chunkSize = scanChunkSize();
+
+    auto chunkEnd = qMin( endLine, LineNumber( nbLines.get() ) );
+    while ( chunkEnd > firstLine && !interruptRequested_ ) {
+        const auto chunkStart = qMax( chunkEnd - chunkSize, firstLine );
+
+        OptionalLineNumber matchingLine;
+        scanner.scanLines( logData_, chunkStart, chunkEnd - chunkStart, true,
+                           [ &matchingLine, chunkStart ]( size_t index ) {
+                               matchingLine = chunkStart + LinesCount( index );
+                               return false;
+                           } );
+        if ( matchingLine.has_value() ) {
+            return matchingLine;
+        }
+
+        chunkEnd = chunkStart;
+
+        // See if we need to notify of the ongoing search
+        searchingNotifier_.ping( chunkEnd, nbLines, true );
+    }
+
+    return {};
+}
+
 void QuickFind::resetLimits()
 {
     lastMatch_.reset();
     firstMatch_.reset();
+    matchIndex_.invalidate();
+}
+
+void QuickFind::resetLimits( LineNumber firstChangedLine )
+{
+    lastMatch_.reset();
+    firstMatch_.reset();
+    matchIndex_.invalidateFrom( firstChangedLine );
+}
+
+void QuickFind::notifyMatchFound( LineNumber line, const QuickFindMatcher& matcher )
+{
+    if ( matchIndex_.isReady( matcher ) ) {
+        sendNotification( QFNotificationMatchPosition( matchIndex_.matchPosition( line ).get(),
+                                                       matchIndex_.nbMatches().get() ) );
+    }
+    else {
+        // Clear any notification
+        Q_EMIT clearNotification();
+    }
 }
 
 void QuickFind::sendNotification( QFNotification notification )
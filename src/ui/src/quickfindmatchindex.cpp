@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtConcurrent>
+
+#include "abstractlogdata.h"
+#include "configuration.h"
+#include "containers.h"
+#include "log.h"
+#include "runnable_lambda.h"
+
+#include "quickfindmatchindex.h"
+
+QuickFindMatchIndex::QuickFindMatchIndex( const AbstractLogData& logData )
+    : logData_( logData )
+{
+    // Builds are run in order, the one of an older pattern stops at once
+    buildPool_.setMaxThreadCount( 1 );
+}
+
+QuickFindMatchIndex::~QuickFindMatchIndex()
+{
+    {
+        ScopedLock lock( mutex_ );
+        stopBuild();
+    }
+    buildPool_.waitForDone();
+}
+
+void QuickFindMatchIndex::build( const QuickFindMatcher& matcher )
+{
+    if ( !matcher.isActive() ) {
+        return;
+    }
+
+    const auto nbLines = logData_.getNbLine();
+
+    ScopedLock lock( mutex_ );
+    if ( indexedRegexp_ != matcher.regexp() ) {
+        stopBuild();
+        matches_ = {};
+        indexedRegexp_ = matcher.regexp();
+        indexedLines_ = 0_lcount;
+    }
+
+    // A running build goes on with the lines appended since it started
+    requestedLines_ = nbLines;
+    if ( isBuilding_ || indexedLines_ >= nbLines ) {
+        return;
+    }
+
+    LOG_INFO << "Building QuickFind index for " << matcher.regexp().pattern() << " from line "
+             << indexedLines_ << " to " << nbLines;
+
+    isBuilding_ = true;
+    buildPool_.start( createRunnable( [ this, matcher, generation = generation_.load() ] {
+        buildIndex( matcher, generation );
+    } ) );
+}
+
+void QuickFindMatchIndex::invalidate()
+{
+    ScopedLock lock( mutex_ );
+    stopBuild();
+    matches_ = {};
+    indexedRegexp_ = {};
+    indexedLines_ = 0_lcount;
+}
+
+void QuickFindMatchIndex::invalidateFrom( LineNumber firstLine )
+{
+    ScopedLock lock( mutex_ );
+    stopBuild();
+    if ( indexedLines_.get() > firstLine.get() ) {
+        SearchResultArray changedLines;
+        changedLines.addRange( firstLine.get(), indexedLines_.get() );
+        matches_ -= changedLines;
+        indexedLines_ = LinesCount( firstLine.get() );
+    }
+}
+
+void QuickFindMatchIndex::stopBuild()
+{
+    ++generation_;
+    isBuilding_ = false;
+}
+
+bool QuickFindMatchIndex::isReady( const QuickFindMatcher& matcher ) const
+{
+    ScopedLock lock( mutex_ );
+    return indexedRegexp_ == matcher.regexp() && indexedLines_ == logData_.getNbLine();
+}
+
+LinesCount QuickFindMatchIndex::indexedLines( const QuickFindMatcher& matcher ) const
+{
+    ScopedLock lock( mutex_ );
+    return indexedRegexp_ == matcher.regexp() ? indexedLines_ : 0_lcount;
+}
+OptionalLineNumber QuickFindMatchIndex::nextMatch( LineNumber line ) const
+{
+    ScopedLock lock( mutex_ );
+
+    LineNumber::UnderlyingType nextLine = {};
+    if ( matches_.select( matches_.rank( line.get() ), &nextLine ) ) {
+        return LineNumber( nextLine );
+    }
+
+    return {};
+}
+
+OptionalLineNumber QuickFindMatchIndex::previousMatch( LineNumber line ) const
+{
+    ScopedLock lock( mutex_ );
+
+    auto nbMatchesBefore = matches_.rank( line.get() );
+    if ( matches_.contains( line.get() ) ) {
+        --nbMatchesBefore;
+    }
+
+    LineNumber::UnderlyingType previousLine = {};
+    if ( nbMatchesBefore > 0 && matches_.select( nbMatchesBefore - 1, &previousLine ) ) {
+        return LineNumber( previousLine );
+    }
+
+    return {};
+}
+
+LinesCount QuickFindMatchIndex::matchPosition( LineNumber line ) const
+{
+    ScopedLock lock( mutex_ );
+    return LinesCount( matches_.rank( line.get() ) );
+}
+
+LinesCount QuickFindMatchIndex::nbMatches() const
+{
+    ScopedLock lock( mutex_ );
+    return LinesCount( matches_.cardinality() );
+}
+
+void QuickFindMatchIndex::buildIndex( const QuickFindMatcher& matcher, uint64_t generation )
+{
+    for ( ;; ) {
+        LineNumber firstLine;
+        LineNumber endLine;
+        {
+            ScopedLock lock( mutex_ );
+            if ( generation != generation_ ) {
+                LOG_INFO << "QuickFind index build interrupted";
+                return;
+            }
+
+            if ( indexedLines_ >= requestedLines_ ) {
+                LOG_INFO << "QuickFind index built, " << matches_.cardinality() << " matches";
+                isBuilding_ = false;
+                return;
+            }
+
+            firstLine = LineNumber( indexedLines_.get() );
+            endLine = LineNumber( requestedLines_.get() );
+        }
+
+        auto newMatches = scanLines( matcher, firstLine, endLine, generation );
+
+        ScopedLock lock( mutex_ );
+        if ( generation == generation_ ) {
+            matches_ |= newMatches;
+            indexedLines_ = LinesCount( endLine.get() );
+        }
+    }
+}
+
+SearchResultArray QuickFindMatchIndex::scanLines( const QuickFindMatcher& matcher,
+                                                  LineNumber firstLine, LineNumber endLine,
+                                                  uint64_t generation ) const
+{
+    const auto chunkSize = LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+
+    klogg::vector<LineNumber> chunkStarts;
+    for ( auto chunkStart = firstLine; chunkStart < endLine; chunkStart = chunkStart + chunkSize ) {
+        chunkStarts.push_back( chunkStart );
+    }
+
+    Mutex matchesMutex;
+    SearchResultArray matches;
+
+    QtConcurrent::blockingMap( chunkStarts, [ & ]( const LineNumber& chunkStart ) {
+        if ( generation != generation_ ) {
+            return;
+        }
+
+        // Engine matchers can't be shared between threads
+        const QuickFindLineScanner scanner( matcher );
+
+        SearchResultArray chunkMatches;
+        scanner.scanLines( logData_, chunkStart, qMin( chunkSize, endLine - chunkStart ), false,
+                           [ &chunkMatches, chunkStart ]( size_t index ) {
+                               chunkMatches.add( chunkStart.get() + index );
+                               return true;
+                           } );
+
+        ScopedLock lock( matchesMutex );
+        matches |= chunkMatches;
+    } );
+
+    return matches;
+}
@@ -47,6 +47,7 @@
 #include "quickfindpattern.h"
 
 #include "configuration.h"
+#include "logdata.h"
 
 #include "quickfind.h"
 
@@ -99,6 +100,93 @@ std::pair<LineColumn, LineColumn> QuickFindMatcher::getLastMatch() const
     return std::make_pair( lastMatchStart_, lastMatchEnd_ );
 }
 
+namespace {
+template <typename IsMatching>
+void forEachMatch( size_t nbLines, bool backward, IsMatching isMatching,
+                   const std::function<bool( size_t )>& onMatch )
+{
+    for ( auto position = 0u; position < nbLines; ++position ) {
+        const auto index = backward ? nbLines - 1 - position : position;
+        if ( isMatching( index ) && !onMatch( index ) ) {
+            return;
+        }
+    }
+}
+
+RegularExpressionPattern makeEnginePattern( const QuickFindMatcher& matcher )
+{
+    const auto& regexp = matcher.regexp();
+    const auto isCaseSensitive
+        = !regexp.patternOptions().testFlag( QRegularExpression::CaseInsensitiveOption );
+    return RegularExpressionPattern( regexp.pattern(), isCaseSensitive, false, false, false );
+}
+} // namespace
+
+QuickFindLineScanner::QuickFindLineScanner( const QuickFindMatcher& matcher )
+    : matcher_( matcher )
+    , expression_( makeEnginePattern( matcher ) )
+{
+    if ( matcher_.isActive() && expression_.isValid() ) {
+        engineMatcher_ = expression_.createMatcher();
+    }
+}
+
+bool QuickFindLineScanner::isLineMatching( const QString& line ) const
+{
+    if ( !engineMatcher_ || line.contains( QChar::Tabulation ) ) {
+        return matcher_.isLineMatching( untabify( QString( line ) ) );
+    }
+
+    const auto utf8Line = line.toUtf8();
+    return engineMatcher_->hasMatch(
+        std::string_view( utf8Line.constData(), static_cast<size_t>( utf8Line.size() ) ) );
+}
+
+bool QuickFindLineScanner::isLineMatching( std::string_view utf8Line,
+                                           const std::function<QString()>& decode ) const
+{
+    if ( utf8Line.find( '\t' ) != std::string_view::npos ) {
+        return isLineMatching( decode() );
+    }
+
+    // getLines removes the carriage return of the line ending
+    if ( !utf8Line.empty() && utf8Line.back() == '\r' ) {
+        utf8Line.remove_suffix( 1 );
+    }
+    return engineMatcher_->hasMatch( utf8Line );
+}
+
+void QuickFindLineScanner::scanLines( const AbstractLogData& logData, LineNumber first,
+                                      LinesCount number, bool backward,
+                                      const std::function<bool( size_t )>& onMatch ) const
+{
+    const auto* sourceLogData = dynamic_cast<const LogData*>( &logData );
+    if ( sourceLogData != nullptr && engineMatcher_ ) {
+        const auto rawLines = sourceLogData->getLinesRaw( first, number );
+        const auto utf8Lines = rawLines.buildUtf8View();
+
+        if ( utf8Lines.size() == rawLines.endOfLines.size() ) {
+            const auto isMatching = [ this, &rawLines, &utf8Lines ]( size_t index ) {
+                return isLineMatching( utf8Lines[ index ], [ &rawLines, index ] {
+                    auto line = rawLines.decodeLine( index );
+                    if ( line.endsWith( QChar::CarriageReturn ) ) {
+                        line.chop( 1 );
+                    }
+                    return line;
+                } );
+            };
+            forEachMatch( utf8Lines.size(), backward, isMatching, onMatch );
+            return;
+        }
+    }
+
+    const auto lines = logData.getLines( first, number );
+    forEachMatch(
+        lines.size(), backward,
+        [ this, &lines ]( size_t index ) { return isLineMatching( lines[ index ] ); },
+        onMatch );
+}
+
 void QuickFindPattern::changeSearchPattern( const QString& pattern, bool isRegex )
 {
     // Determine the type of regexp depending on the config
@@ -23,14 +23,68 @@
 // There are three types of selection, only one type might be active
 // at any time.
 
-#include <numeric>
+#include <algorithm>
+#include <limits>
 
 #include "abstractlogdata.h"
+#include "configuration.h"
 #include "containers.h"
 #include "linetypes.h"
 #include "log.h"
 #include "selection.h"
 
+namespace {
+#if defined( Q_OS_WIN )
+const QString LineSeparator = QStringLiteral( "\r\n" );
+#else
+const QString LineSeparator = QStringLiteral( "\n" );
+#endif
+
+// Joins the lines of a selection, up to a maximum number of characters
+class SelectedTextBuilder {
+  public:
+    SelectedTextBuilder( bool lineNumbers, qint64 maxSize )
+        : lineNumbers_( lineNumbers )
+        , maxSize_( maxSize )
+    {
+    }
+
+    // Returns false if the text would be larger than the maximum size
+    bool append( LineNumber lineNumber, const QString& line )
+    {
+        const auto separatorSize = isFirstLine_ ? 0 : LineSeparator.size();
+        if ( static_cast<qint64>( text_.size() ) + separatorSize + line.size() > maxSize_ ) {
+            LOG_WARNING << "Selected text is larger than " << maxSize_ << " characters";
+            return false;
+        }
+
+        if ( !isFirstLine_ ) {
+            text_.append( LineSeparator );
+        }
+        isFirstLine_ = false;
+
+        if ( lineNumbers_ ) {
+            text_.append( QStringLiteral( "%1: %2" ).arg( lineNumber.get() ).arg( line ) );
+        }
+        else {
+            text_.append( line );
+        }
+        return true;
+    }
+
+    QString take()
+    {
+        return std::move( text_ );
+    }
+
+  private:
+    bool lineNumbers_;
+    qint64 maxSize_;
+    QString text_;
+    bool isFirstLine_ = true;
+};
+} // namespace
+
 Selection::Selection()
 {
     selectedPartial_.startColumn = 0_lcol;
@@ -160,33 +214,149 @@ LinesCount Selection::getSelectedLinesCount() const
 // but partials (part of line) are, they probably should not ideally.
 QString Selection::getSelectedText( const AbstractLogData* logData, bool lineNumbers ) const
 {
-    const auto selectionData = getSelectionWithLineNumbers( logData );
+    return getSelectedText( logData, lineNumbers, std::numeric_limits<qint64>::max(),
+                            AtomicFlag{}, {} )
+        .value_or( QString{} );
+}
 
-    QString text;
+std::optional<QString>
+Selection::getSelectedText( const AbstractLogData* logData, bool lineNumbers, qint64 maxSize,
+                            const AtomicFlag& interruptRequest,
+                            const TextProgressCallback& progressCallback ) const
+{
+    SelectedTextBuilder text( lineNumbers, maxSize );
 
-    const auto selectionSizeEstimate = std::accumulate(
-        selectionData.begin(), selectionData.end(), klogg::isize( selectionData ),
-        []( const auto& acc, const auto& next ) { return acc + next.second.size(); } );
+    if ( !selectedRange_.startLine.has_value() ) {
+        for ( const auto& [ lineNumber, line ] : getSelectionWithLineNumbers( logData ) ) {
+            if ( !text.append( lineNumber, line ) ) {
+                return {};
+            }
+        }
+        return text.take();
+    }
 
-    text.reserve( selectionSizeEstimate );
+    // Lines of a range are read by chunks, so the whole selection
+    // is never held twice in memory.
+    const auto chunkSize = LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+    const auto startLine = *selectedRange_.startLine;
+    const auto endLine = selectedRange_.endLine + 1_lcount;
 
-    for ( const auto& [ lineNumber, line ] : selectionData ) {
-        if ( !text.isEmpty() ) {
-#if defined( Q_OS_WIN )
-            text.append( QChar::CarriageReturn );
-#endif
-            text.append( QChar::LineFeed );
+    for ( auto chunkStart = startLine; chunkStart < endLine; chunkStart += chunkSize ) {
+        if ( interruptRequest ) {
+            return {};
         }
 
-        if ( lineNumbers ) {
-            text.append( QStringLiteral( "%1: %2" ).arg( lineNumber.get() ).arg( line ) );
+        const auto lines
+            = logData->getLines( chunkStart, std::min( chunkSize, endLine - chunkStart ) );
+        auto line = chunkStart;
+        for ( const auto& lineText : lines ) {
+            if ( !text.append( logData->getLineNumber( line ), lineText ) ) {
+                return {};
+            }
+            ++line;
+        }
+
+        if ( progressCallback ) {
+            progressCallback( static_cast<int>( ( line - startLine ).get() * 100
+                                                / selectedRange_.size().get() ) );
+        }
+    }
+
+    return text.take();
+}
+
+Selection::LineRuns Selection::getSourceLines( const AbstractLogData* logData ) const
+{
+    // getLineNumber() counts lines from 1
+    const auto sourceLine
+        = [ logData ]( LineNumber line ) { return logData->getLineNumber( line ) - 1_lcount; };
+
+    LineRuns runs;
+    const auto addRun = [ &runs ]( LineNumber firstLine, LinesCount nbLines ) {
+        if ( !runs.empty() && runs.back().first + runs.back().second == firstLine ) {
+            runs.back().second = runs.back().second + nbLines;
         }
         else {
-            text.append( line );
+            runs.emplace_back( firstLine, nbLines );
+        }
+    };
+
+    if ( selectedLine_.has_value() ) {
+        addRun( sourceLine( *selectedLine_ ), 1_lcount );
+        return runs;
+    }
+
+    if ( !selectedRange_.startLine.has_value() ) {
+        return runs;
+    }
+
+    const auto chunkSize = LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+    const auto endLine = selectedRange_.endLine + 1_lcount;
+
+    for ( auto chunkStart = *selectedRange_.startLine; chunkStart < endLine;
+          chunkStart += chunkSize ) {
+        const auto nbLines = std::min( chunkSize, endLine - chunkStart );
+
+        // Source lines are increasing, a chunk spanning as many lines is contiguous
+        const auto firstLine = sourceLine( chunkStart );
+        const auto lastLine = sourceLine( chunkStart + nbLines - 1_lcount );
+        if ( lastLine - firstLine == nbLines - 1_lcount ) {
+            addRun( firstLine, nbLines );
+            continue;
+        }
+
+        for ( auto line = chunkStart; line < chunkStart + nbLines; ++line ) {
+            addRun( sourceLine( line ), 1_lcount );
+        }
+    }
+
+    return runs;
+}
+
+std::optional<QString> Selection::getLinesText( const AbstractLogData* logData,
+                                                const LineRuns& lines, bool lineNumbers,
+                                                qint64 maxSize,
+                                                const AtomicFlag& interruptRequest,
+                                                const TextProgressCallback& progressCallback )
+{
+    SelectedTextBuilder text( lineNumbers, maxSize );
+
+    const auto chunkSize = LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+
+    auto nbLines = 0_lcount;
+    for ( const auto& run : lines ) {
+        nbLines = nbLines + run.second;
+    }
+
+    auto nbLinesRead = 0_lcount;
+    for ( const auto& [ firstLine, runSize ] : lines ) {
+        const auto endLine = firstLine + runSize;
+        for ( auto chunkStart = firstLine; chunkStart < endLine; chunkStart += chunkSize ) {
+            if ( interruptRequest ) {
+                return {};
+            }
+
+            const auto chunkLines = std::min( chunkSize, endLine - chunkStart );
+            auto line = chunkStart;
+            for ( const auto& lineText : logData->getLines( chunkStart, chunkLines ) ) {
+                if ( !text.append( logData->getLineNumber( line ), lineText ) ) {
+                    return {};
+                }
+                ++line;
+            }
+
+            nbLinesRead = nbLinesRead + chunkLines;
+            if ( progressCallback ) {
+                progressCallback(
+                    static_cast<int>( nbLinesRead.get() * 100 / nbLines.get() ) );
+            }
         }
     }
 
-    return text;
+    return text.take();
 }
 
 std::map<LineNumber, QString>
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QGuiApplication>
+#include <QtConcurrent>
+
+#include "log.h"
+#include "logdata.h"
+#include "logfiltereddata.h"
+
+#include "selectionmimedata.h"
+
+namespace {
+const QString TextMimeType = QStringLiteral( "text/plain" );
+
+// Data of the whole file holding the lines of a log data
+const LogData* getSourceLogData( const AbstractLogData* logData )
+{
+    if ( const auto* filteredData = qobject_cast<const LogFilteredData*>( logData ) ) {
+        return filteredData->sourceLogData();
+    }
+    return qobject_cast<const LogData*>( logData );
+}
+} // namespace
+
+SelectionMimeData::SelectionMimeData( const AbstractLogData* logData,
+                                      const Selection& selection, bool lineNumbers,
+                                      qint64 maxSize )
+    : sourceLogData_( const_cast<LogData*>( getSourceLogData( logData ) ) )
+    , lineNumbers_( lineNumbers )
+    , maxSize_( maxSize )
+{
+    if ( sourceLogData_.isNull() ) {
+        unavailableMessage_ = tr( "The file of the copied lines has been closed." );
+        return;
+    }
+
+    contentGeneration_ = sourceLogData_->getContentGeneration();
+    lines_ = selection.getSourceLines( logData );
+
+    auto nbLines = 0_lcount;
+    for ( const auto& run : lines_ ) {
+        nbLines = nbLines + run.second;
+    }
+    LOG_INFO << "Reading copied selection of " << nbLines << " lines";
+
+    connect( &readWatcher_, &QFutureWatcher<std::optional<QString>>::finished, this,
+             &SelectionMimeData::handleTextRead );
+    readWatcher_.setFuture( QtConcurrent::run(
+        [ logData = sourceLogData_.data(), lines = lines_, lineNumbers, maxSize,
+          &interruptRequest = interruptRequest_ ]() -> std::optional<QString> {
+            auto text = Selection::getLinesText( logData, lines, lineNumbers, maxSize,
+                                                 interruptRequest, {} );
+            if ( text ) {
+                text->replace( QChar::Null, QChar::Space );
+            }
+            return text;
+        } ) );
+}
+
+SelectionMimeData::~SelectionMimeData()
+{
+    stopReading();
+}
+
+void SelectionMimeData::stopReading()
+{
+    if ( readWatcher_.isFinished() ) {
+        return;
+    }
+
+    interruptRequest_.set();
+    readWatcher_.waitForFinished();
+    if ( !text_.has_value() && !unavailableMessage_.has_value() ) {
+        unavailableMessage_ = tr( "The file of the copied lines has been closed." );
+    }
+}
+
+bool SelectionMimeData::isSupported()
+{
+    const auto platform = QGuiApplication::platformName();
+    return platform.startsWith( QLatin1String( "xcb" ) )
+           || platform.startsWith( QLatin1String( "wayland" ) );
+}
+
+bool SelectionMimeData::hasFormat( const QString& mimeType ) const
+{
+    return mimeType == TextMimeType;
+}
+
+QStringList SelectionMimeData::formats() const
+{
+    return { TextMimeType };
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK( 6, 0, 0 )
+QVariant SelectionMimeData::retrieveData( const QString& mimeType, QMetaType ) const
+#else
+QVariant SelectionMimeData::retrieveData( const QString& mimeType, QVariant::Type ) const
+#endif
+{
+    if ( mimeType != TextMimeType ) {
+        return {};
+    }
+
+    if ( unavailableMessage_.has_value() ) {
+        Q_EMIT textUnavailable( *unavailableMessage_ );
+        return QString{};
+    }
+
+    // Waiting for the text would block the clipboard request
+    if ( !text_.has_value() ) {
+        LOG_INFO << "Copied selection requested while it is being read";
+        isRequestedEarly_ = true;
+        return QString{};
+    }
+
+    return *text_;
+}
+
+bool SelectionMimeData::isFileChanged() const
+{
+    return sourceLogData_.isNull()
+           || sourceLogData_->getContentGeneration() != contentGeneration_;
+}
+
+void SelectionMimeData::handleTextRead()
+{
+    // Stopped, the reason is already set
+    if ( interruptRequest_ ) {
+        return;
+    }
+
+    auto text = readWatcher_.result();
+    if ( !text ) {
+        const auto maxSizeMb = maxSize_ * static_cast<qint64>( sizeof( QChar ) ) / 1024 / 1024;
+        unavailableMessage_
+            = tr( "The selection is larger than the clipboard limit of %1 MiB." ).arg( maxSizeMb );
+    }
+    else if ( isFileChanged() ) {
+        LOG_WARNING << "File of the copied selection has changed while reading it";
+        unavailableMessage_
+            = tr( "The file of the copied lines has been closed or has changed since copying." );
+    }
+    else {
+        text_ = std::move( text );
+    }
+
+    if ( !isRequestedEarly_ ) {
+        return;
+    }
+
+    if ( text_.has_value() ) {
+        Q_EMIT textRead( *text_ );
+    }
+    else {
+        Q_EMIT textUnavailable( *unavailableMessage_ );
+    }
+}
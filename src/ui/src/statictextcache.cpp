@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "statictextcache.h"
+
+StaticTextCache::StaticTextCache( std::size_t capacity )
+    : entries_( capacity )
+{
+}
+
+const QStaticText& StaticTextCache::get( QStringView text, const QFont& font )
+{
+    if ( font != font_ ) {
+        clear();
+        font_ = font;
+    }
+
+    const auto key = text.toString();
+    if ( const auto* staticText = entries_.find( key ) ) {
+        return *staticText;
+    }
+
+    QStaticText staticText( key );
+    staticText.setTextFormat( Qt::PlainText );
+    staticText.setPerformanceHint( QStaticText::AggressiveCaching );
+    staticText.prepare( QTransform{}, font_ );
+
+    return entries_.insert( key, std::move( staticText ) );
+}
+
+void StaticTextCache::clear()
+{
+    entries_.clear();
+}
+
+std::size_t StaticTextCache::size() const
+{
+    return entries_.size();
+}
@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <utility>
+
+#include <QtConcurrent>
+
+#include "abstractlogdata.h"
+#include "configuration.h"
+#include "log.h"
+#include "wrappedstring.h"
+
+#include "wrappedlinesindex.h"
+
+WrappedLinesIndex::WrappedLinesIndex( const AbstractLogData& logData,
+                                      ReadyCallback readyCallback )
+    : logData_( logData )
+    , readyCallback_( std::move( readyCallback ) )
+{
+}
+
+WrappedLinesIndex::~WrappedLinesIndex()
+{
+    {
+        ScopedLock lock( mutex_ );
+        stopBuild();
+    }
+
+    // Builds use this index and the data, they stop at the next chunk
+    for ( auto& buildFuture : buildFutures_ ) {
+        buildFuture.waitForFinished();
+    }
+}
+
+void WrappedLinesIndex::build( LineLength visibleColumns )
+{
+    ScopedLock lock( mutex_ );
+    if ( currentBuild_ && currentBuild_->visibleColumns == visibleColumns ) {
+        return;
+    }
+
+    const auto nbLines = logData_.getNbLine();
+    const auto endLine = LineNumber( nbLines.get() );
+    const auto firstUnmeasuredLine
+        = qMin( LineNumber( static_cast<LineNumber::UnderlyingType>( lineLengths_.size() ) ),
+                endLine );
+
+    // Lines known by an index for the same width are only wrapped again if they have changed
+    auto firstLine = 0_lnum;
+    if ( layout_ && layout_->visibleColumns == visibleColumns ) {
+        firstLine = qMin( LineNumber( layout_->nbLines.get() ), endLine );
+        if ( firstChangedLine_ ) {
+            firstLine = qMin( firstLine, *firstChangedLine_ );
+        }
+        firstLine = qMin( firstLine, firstUnmeasuredLine );
+
+        if ( firstLine == endLine && layout_->nbLines == nbLines ) {
+            return;
+        }
+    }
+
+    stopBuild();
+
+    LOG_INFO << "Building wrapped lines index for " << visibleColumns << " columns, lines "
+             << firstLine << " to " << endLine;
+
+    currentBuild_ = Build{ visibleColumns, firstLine, firstUnmeasuredLine, endLine,
+                           ++generation_, std::make_shared<AtomicFlag>() };
+
+    buildFutures_.erase( std::remove_if( buildFutures_.begin(), buildFutures_.end(),
+                                         []( const QFuture<void>& buildFuture ) {
+                                             return buildFuture.isFinished();
+                                         } ),
+                         buildFutures_.end() );
+    buildFutures_.push_back(
+        QtConcurrent::run( [ this, build = *currentBuild_ ] { buildIndex( build ); } ) );
+}
+
+void WrappedLinesIndex::update( LineNumber firstChangedLine )
+{
+    ScopedLock lock( mutex_ );
+    stopBuild();
+
+    firstChangedLine_ = firstChangedLine_ ? qMin( *firstChangedLine_, firstChangedLine )
+                                          : firstChangedLine;
+
+    if ( lineLengths_.size() > firstChangedLine.get() ) {
+        lineLengths_.erase( lineLengths_.begin()
+                                + static_cast<std::ptrdiff_t>( firstChangedLine.get() ),
+                            lineLengths_.end() );
+    }
+}
+
+void WrappedLinesIndex::invalidate()
+{
+    update( 0_lnum );
+}
+
+void WrappedLinesIndex::stopBuild()
+{
+    if ( currentBuild_ ) {
+        currentBuild_->interruptRequested->set();
+        currentBuild_.reset();
+    }
+}
+
+bool WrappedLinesIndex::isReady( LineLength visibleColumns ) const
+{
+    SharedLock lock( mutex_ );
+    return layout_.has_value() && layout_->visibleColumns == visibleColumns;
+}
+
+LinesCount WrappedLinesIndex::rowOfLine( LineNumber line ) const
+{
+    SharedLock lock( mutex_ );
+    if ( !layout_ ) {
+        return LinesCount( line.get() );
+    }
+
+    const auto& wrappedLines = layout_->wrappedLines;
+    const auto nextWrappedLine = std::lower_bound(
+        wrappedLines.begin(), wrappedLines.end(), line,
+        []( const WrappedLine& wrappedLine, LineNumber l ) { return wrappedLine.line < l; } );
+
+    if ( nextWrappedLine == wrappedLines.begin() ) {
+        return LinesCount( line.get() );
+    }
+
+    // Lines after the last wrapped one take one row each
+    const auto& previous = *std::prev( nextWrappedLine );
+    return previous.firstRow + previous.nbRows + ( line - previous.line ) - 1_lcount;
+}
+
+WrappedLinesIndex::Position WrappedLinesIndex::lineAtRow( LinesCount row ) const
+{
+    SharedLock lock( mutex_ );
+    if ( !layout_ ) {
+        return { LineNumber( row.get() ), 0_lcount };
+    }
+
+    const auto& wrappedLines = layout_->wrappedLines;
+    const auto nextWrappedLine = std::upper_bound(
+        wrappedLines.begin(), wrappedLines.end(), row,
+        []( LinesCount r, const WrappedLine& wrappedLine ) { return r < wrappedLine.firstRow; } );
+
+    if ( nextWrappedLine == wrappedLines.begin() ) {
+        return { LineNumber( row.get() ), 0_lcount };
+    }
+
+    const auto& previous = *std::prev( nextWrappedLine );
+    const auto rowInLine = row - previous.firstRow;
+    if ( rowInLine < previous.nbRows ) {
+        return { previous.line, rowInLine };
+    }
+
+    return { previous.line + ( rowInLine - previous.nbRows ) + 1_lcount, 0_lcount };
+}
+
+klogg::vector<LineNumber> WrappedLinesIndex::linesWiderThan( LineNumber firstLine,
+                                                             LineNumber endLine,
+                                                             const Build& build ) const
+{
+    klogg::vector<LineNumber> wideLines;
+
+    SharedLock lock( mutex_ );
+    // Lengths are only dropped after the build has been stopped
+    if ( *build.interruptRequested ) {
+        return wideLines;
+    }
+
+    for ( auto line = firstLine; line < endLine; ++line ) {
+        if ( lineLengths_[ line.get() ] > build.visibleColumns ) {
+            wideLines.push_back( line );
+        }
+    }
+
+    return wideLines;
+}
+
+void WrappedLinesIndex::buildIndex( const Build& build )
+{
+    const auto chunkSize = LinesCount( static_cast<LinesCount::UnderlyingType>(
+        Configuration::get().searchReadBufferSizeLines() ) );
+    const auto& interruptRequested = *build.interruptRequested;
+
+    struct Chunk {
+        LineNumber firstLine;
+        LineNumber endLine;
+        // Lines wrapped on several rows and their number of rows
+        klogg::vector<std::pair<LineNumber, LinesCount>> wrappedLines;
+        // Lengths of the lines read for the first time
+        klogg::vector<LineLength> lineLengths;
+    };
+
+    // Chunks of lines of known length come first, they are not all read
+    klogg::vector<Chunk> chunks;
+    const auto addChunks = [ &chunks, chunkSize ]( LineNumber firstLine, LineNumber endLine ) {
+        for ( auto chunkStart = firstLine; chunkStart < endLine;
+              chunkStart = chunkStart + chunkSize ) {
+            const auto chunkEnd = qMin( chunkStart + chunkSize, endLine );
+            chunks.push_back( Chunk{ chunkStart, chunkEnd, {}, {} } );
+        }
+    };
+    addChunks( build.firstLine, build.firstUnmeasuredLine );
+    addChunks( build.firstUnmeasuredLine, build.endLine );
+
+    const auto wrapLine = [ &build ]( Chunk& chunk, LineNumber line, const QString& text ) {
+        const WrappedString wrappedLine{ text, build.visibleColumns };
+        if ( wrappedLine.wrappedLinesCount() > 1 ) {
+            chunk.wrappedLines.emplace_back(
+                line, LinesCount( static_cast<LinesCount::UnderlyingType>(
+                          wrappedLine.wrappedLinesCount() ) ) );
+        }
+    };
+
+    QtConcurrent::blockingMap( chunks, [ & ]( Chunk& chunk ) {
+        if ( interruptRequested ) {
+            return;
+        }
+
+        if ( chunk.firstLine >= build.firstUnmeasuredLine ) {
+            const auto lines
+                = logData_.getExpandedLines( chunk.firstLine, chunk.endLine - chunk.firstLine );
+            chunk.lineLengths.reserve( lines.size() );
+            for ( auto index = 0u; index < lines.size(); ++index ) {
+                chunk.lineLengths.push_back( LineLength( lines[ index ].size() ) );
+                wrapLine( chunk, chunk.firstLine + LinesCount( index ), lines[ index ] );
+            }
+            return;
+        }
+
+        // Lines no wider than the view take one row
+        const auto wideLines = linesWiderThan( chunk.firstLine, chunk.endLine, build );
+
+        // Reading lines one by one is slower once many of them are wide
+        const auto nbChunkLines = ( chunk.endLine - chunk.firstLine ).get();
+        if ( wideLines.size() * 4 > nbChunkLines ) {
+            const auto lines
+                = logData_.getExpandedLines( chunk.firstLine, chunk.endLine - chunk.firstLine );
+            for ( const auto& line : wideLines ) {
+                wrapLine( chunk, line, lines[ ( line - chunk.firstLine ).get() ] );
+            }
+        }
+        else {
+            for ( const auto& line : wideLines ) {
+                wrapLine( chunk, line, logData_.getExpandedLineString( line ) );
+            }
+        }
+    } );
+
+    {
+        ScopedLock lock( mutex_ );
+        if ( interruptRequested || build.generation != generation_ ) {
+            LOG_INFO << "Wrapped lines index build interrupted";
+            return;
+        }
+
+        if ( build.firstLine == 0_lnum || !layout_ ) {
+            layout_ = Layout{ build.visibleColumns, 0_lcount, {} };
+        }
+
+        // Keep the lines before the first one wrapped again
+        auto& wrappedLines = layout_->wrappedLines;
+        wrappedLines.erase( std::lower_bound( wrappedLines.begin(), wrappedLines.end(),
+                                              build.firstLine,
+                                              []( const WrappedLine& wrappedLine, LineNumber l ) {
+                                                  return wrappedLine.line < l;
+                                              } ),
+                            wrappedLines.end() );
+
+        auto extraRows = 0_lcount;
+        if ( !wrappedLines.empty() ) {
+            const auto& last = wrappedLines.back();
+            extraRows = last.firstRow + last.nbRows - LinesCount( last.line.get() ) - 1_lcount;
+        }
+
+        lineLengths_.erase( lineLengths_.begin()
+                                + static_cast<std::ptrdiff_t>( build.firstUnmeasuredLine.get() ),
+                            lineLengths_.end() );
+
+        for ( const auto& chunk : chunks ) {
+            for ( const auto& [ line, nbRows ] : chunk.wrappedLines ) {
+                wrappedLines.push_back(
+                    WrappedLine{ line, LinesCount( line.get() ) + extraRows, nbRows } );
+                extraRows = extraRows + nbRows - 1_lcount;
+            }
+            lineLengths_.insert( lineLengths_.end(), chunk.lineLengths.begin(),
+                                 chunk.lineLengths.end() );
+        }
+
+        layout_->nbLines = LinesCount( build.endLine.get() );
+        firstChangedLine_.reset();
+        currentBuild_.reset();
+
+        LOG_INFO << "Wrapped lines index built, " << wrappedLines.size() << " wrapped lines, "
+                 << extraRows << " extra rows";
+    }
+
+    readyCallback_();
+}
@@ -26,21 +26,32 @@
 #include <QMimeData>
 #include <QTimer>
 
-static inline void sendTextToClipboard(QString text, bool updateSelection = false) {
+// Takes ownership of the mime data
+static inline void sendMimeDataToClipboard(QMimeData* mime, bool updateSelection = false) {
     auto clipboard = QApplication::clipboard();
     if (!clipboard) {
         LOG_WARNING << "Unable to access the clipboard.";
+        delete mime;
         return;
     }
-    
+
     try {
-        auto* mime = new QMimeData;
-        mime->setText(text);
         clipboard->setMimeData(mime, QClipboard::Clipboard);
         if (updateSelection && clipboard->supportsSelection()) {
             clipboard->setMimeData(mime, QClipboard::Selection);
         }
     }
+    catch(const std::exception& ex) {
+        LOG_ERROR << "Failed to send data to clipboard: " << ex.what();
+    }
+}
+
+static inline void sendTextToClipboard(QString text, bool updateSelection = false) {
+    try {
+        auto* mime = new QMimeData;
+        mime->setText(text);
+        sendMimeDataToClipboard(mime, updateSelection);
+    }
     catch(const std::exception& ex) {
         LOG_ERROR << "Failed to send text to clipboard: " << ex.what();
     }
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_LRUCACHE_H
+#define KLOGG_LRUCACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// Values kept in least recently used order, at most capacity of them.
+// Callers limiting the cache with another measure than the number of
+// entries use an unbounded cache and remove the least recent entries.
+// This class is not thread-safe.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+  public:
+    using Entry = std::pair<Key, Value>;
+
+    static constexpr std::size_t Unbounded = std::numeric_limits<std::size_t>::max();
+
+    explicit LruCache( std::size_t capacity = Unbounded )
+        : capacity_( capacity > 0 ? capacity : 1 )
+    {
+    }
+
+    // Returns the value and makes it the most recently used one,
+    // nullptr if the key is not in the cache.
+    Value* find( const Key& key )
+    {
+        const auto entry = index_.find( key );
+        if ( entry == index_.end() ) {
+            return nullptr;
+        }
+
+        entries_.splice( entries_.begin(), entries_, entry->second );
+        return &entries_.front().second;
+    }
+
+    bool contains( const Key& key ) const
+    {
+        return index_.find( key ) != index_.end();
+    }
+
+    // Adds or replaces the value of the key, evicting the least recently
+    // used entry if the cache is full.
+    Value& insert( const Key& key, Value value )
+    {
+        erase( key );
+        if ( entries_.size() >= capacity_ ) {
+            removeLeastRecent();
+        }
+
+        entries_.emplace_front( key, std::move( value ) );
+        index_.emplace( key, entries_.begin() );
+        return entries_.front().second;
+    }
+
+    bool erase( const Key& key )
+    {
+        const auto entry = index_.find( key );
+        if ( entry == index_.end() ) {
+            return false;
+        }
+
+        entries_.erase( entry->second );
+        index_.erase( entry );
+        return true;
+    }
+
+    // The cache must not be empty
+    const Entry& leastRecent() const
+    {
+        return entries_.back();
+    }
+
+    void removeLeastRecent()
+    {
+        index_.erase( entries_.back().first );
+        entries_.pop_back();
+    }
+
+    void clear()
+    {
+        entries_.clear();
+        index_.clear();
+    }
+
+    std::size_t size() const
+    {
+        return entries_.size();
+    }
+
+    bool empty() const
+    {
+        return entries_.empty();
+    }
+
+  private:
+    using EntryList = std::list<Entry>;
+
+    std::size_t capacity_;
+
+    // Most recently used first
+    EntryList entries_;
+    std::unordered_map<Key, typename EntryList::iterator, Hash> index_;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_TRACING_H
+#define KLOGG_TRACING_H
+
+#include <atomic>
+#include <cstdint>
+
+#include <QString>
+
+// Records how long the steps of the data pipelines take, on all threads,
+// to look for stalls in a trace viewer such as Perfetto or chrome://tracing.
+// Each thread records spans to its own ring buffer, so only the latest
+// events are kept. When tracing is disabled a span costs a relaxed load.
+namespace tracing {
+
+namespace detail {
+extern std::atomic<bool> isEnabled;
+
+int64_t now();
+void recordSpan( const char* name, int64_t start, int64_t end );
+} // namespace detail
+
+inline bool isEnabled()
+{
+    return detail::isEnabled.load( std::memory_order_relaxed );
+}
+
+void setEnabled( bool enabled );
+
+// Drops the events recorded so far
+void clear();
+
+// Writes the events recorded by all threads in the Chrome trace event format.
+bool writeChromeTrace( const QString& fileName );
+
+// Records the time between its construction and destruction,
+// name must be a string literal.
+class Span {
+  public:
+    explicit Span( const char* name )
+        : name_( name )
+        , start_( isEnabled() ? detail::now() : -1 )
+    {
+    }
+
+    ~Span()
+    {
+        if ( start_ >= 0 ) {
+            detail::recordSpan( name_, start_, detail::now() );
+        }
+    }
+
+    Span( const Span& ) = delete;
+    Span& operator=( const Span& ) = delete;
+    Span( Span&& ) = delete;
+    Span& operator=( Span&& ) = delete;
+
+  private:
+    const char* name_;
+    int64_t start_;
+};
+
+} // namespace tracing
+
+#define KLOGG_TRACE_CONCAT_IMPL( a, b ) a##b
+#define KLOGG_TRACE_CONCAT( a, b ) KLOGG_TRACE_CONCAT_IMPL( a, b )
+
+// Traces the enclosing scope
+#define KLOGG_TRACE_SCOPE( name )                                                                  \
+    const tracing::Span KLOGG_TRACE_CONCAT( traceSpan, __LINE__ )( name )
+
+#endif
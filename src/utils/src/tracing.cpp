@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "tracing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QThread>
+
+#include "containers.h"
+#include "synchronization.h"
+
+namespace tracing {
+
+namespace detail {
+std::atomic<bool> isEnabled{ false };
+} // namespace detail
+
+namespace {
+
+// Events kept for each thread, about 400 KiB of memory per thread
+constexpr size_t BufferCapacity = 16 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    const char* name;
+    int64_t start;
+    int64_t end;
+};
+
+struct ThreadBuffer {
+    Mutex mutex;
+    uint64_t threadId = 0;
+    QString threadName;
+    klogg::vector<Event> events;
+    uint64_t recordedEvents = 0;
+};
+
+struct Registry {
+    Mutex mutex;
+    klogg::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint64_t lastThreadId = 0;
+};
+
+Registry& registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+Clock::time_point origin()
+{
+    static const auto origin = Clock::now();
+    return origin;
+}
+
+QString currentThreadName( uint64_t threadId )
+{
+    const auto* thread = QThread::currentThread();
+    if ( const auto* app = QCoreApplication::instance(); app && app->thread() == thread ) {
+        return "Main";
+    }
+
+    const auto name = thread->objectName();
+    return name.isEmpty() ? QString( "Thread %1" ).arg( threadId ) : name;
+}
+
+// Buffers are registered by the first event of each thread and kept after
+// the thread has finished, until clear() is called.
+ThreadBuffer& threadBuffer()
+{
+    thread_local const auto buffer = [] {
+        auto newBuffer = std::make_shared<ThreadBuffer>();
+        newBuffer->events.resize( BufferCapacity );
+
+        auto& threadsRegistry = registry();
+        ScopedLock lock( threadsRegistry.mutex );
+        newBuffer->threadId = ++threadsRegistry.lastThreadId;
+        newBuffer->threadName = currentThreadName( newBuffer->threadId );
+        threadsRegistry.buffers.push_back( newBuffer );
+        return newBuffer;
+    }();
+
+    return *buffer;
+}
+
+// JSON string content, control characters can't appear unescaped
+QByteArray escaped( const QString& text )
+{
+    const auto utf8 = text.toUtf8();
+
+    QByteArray result;
+    result.reserve( utf8.size() );
+    for ( const auto c : utf8 ) {
+        if ( c == '\\' || c == '"' ) {
+            result.append( '\\' );
+            result.append( c );
+        }
+        else if ( static_cast<unsigned char>( c ) < 0x20 ) {
+            result.append( "\\u00" );
+            result.append( QByteArray::number( static_cast<int>( c ), 16 )
+                               .rightJustified( 2, '0' ) );
+        }
+        else {
+            result.append( c );
+        }
+    }
+    return result;
+}
+
+QByteArray microseconds( int64_t nanoseconds )
+{
+    return QByteArray::number( static_cast<double>( nanoseconds ) / 1000.0, 'f', 3 );
+}
+
+} // namespace
+
+namespace detail {
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - origin() )
+        .count();
+}
+
+void recordSpan( const char* name, int64_t start, int64_t end )
+{
+    auto& buffer = threadBuffer();
+    ScopedLock lock( buffer.mutex );
+    buffer.events[ buffer.recordedEvents % BufferCapacity ] = Event{ name, start, end };
+    ++buffer.recordedEvents;
+}
+
+} // namespace detail
+
+void setEnabled( bool enabled )
+{
+    // Start the clock before any span is recorded
+    origin();
+    detail::isEnabled.store( enabled, std::memory_order_relaxed );
+}
+
+void clear()
+{
+    auto& threadsRegistry = registry();
+    ScopedLock lock( threadsRegistry.mutex );
+
+    // Buffers of finished threads are only referenced by the registry
+    threadsRegistry.buffers.erase(
+        std::remove_if( threadsRegistry.buffers.begin(), threadsRegistry.buffers.end(),
+                        []( const auto& buffer ) { return buffer.use_count() == 1; } ),
+        threadsRegistry.buffers.end() );
+
+    for ( const auto& buffer : threadsRegistry.buffers ) {
+        ScopedLock bufferLock( buffer->mutex );
+        buffer->recordedEvents = 0;
+    }
+}
+
+bool writeChromeTrace( const QString& fileName )
+{
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        return false;
+    }
+
+    const auto pid = QByteArray::number( QCoreApplication::applicationPid() );
+
+    file.write( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    file.write( "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid
+                + ",\"args\":{\"name\":\"klogg\"}}" );
+
+    auto& threadsRegistry = registry();
+    ScopedLock lock( threadsRegistry.mutex );
+
+    for ( const auto& buffer : threadsRegistry.buffers ) {
+        klogg::vector<Event> events;
+        {
+            ScopedLock bufferLock( buffer->mutex );
+            const auto first = buffer->recordedEvents > BufferCapacity
+                                   ? buffer->recordedEvents - BufferCapacity
+                                   : 0;
+            for ( auto index = first; index < buffer->recordedEvents; ++index ) {
+                events.push_back( buffer->events[ index % BufferCapacity ] );
+            }
+        }
+
+        const auto tid = QByteArray::number( static_cast<qulonglong>( buffer->threadId ) );
+        file.write( ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":"
+                    + tid + ",\"args\":{\"name\":\"" + escaped( buffer->threadName ) + "\"}}" );
+
+        for ( const auto& event : events ) {
+            file.write( ",\n{\"name\":\"" + escaped( event.name ) + "\",\"cat\":\"klogg\","
+                        + "\"ph\":\"X\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"ts\":"
+                        + microseconds( event.start )
+                        + ",\"dur\":" + microseconds( event.end - event.start ) + "}" );
+        }
+    }
+
+    file.write( "\n]}\n" );
+    return file.commit();
+}
+
+} // namespace tracing
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string_view>
+
+#include <QDate>
+#include <QFile>
+#include <QTextCodec>
+
+#include "benchcorpus.h"
+
+namespace {
+
+constexpr std::array<const char*, 8> Services
+    = { "api", "auth", "billing", "cache", "db", "gateway", "scheduler", "storage" };
+
+constexpr std::array<const char*, 16> Words
+    = { "request",  "handled", "user",    "session", "connection", "query",
+        "response", "retry",   "latency", "queue",   "worker",     "commit",
+        "token",    "payload", "client",  "timeout" };
+
+constexpr std::array<const char*, 8> CyrillicWords
+    = { "запрос", "пользователь", "ошибка",  "соединение",
+        "ответ",  "таймаут",      "очередь", "сессия" };
+
+constexpr std::string_view PayloadAlphabet
+    = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+constexpr qint64 WriteBlockSize = 4 * 1024 * 1024;
+
+constexpr uint64_t MillisecondsPerDay = 86'400'000;
+
+} // namespace
+
+CorpusGenerator::CorpusGenerator( const CorpusOptions& options )
+    : options_( options )
+    , random_( options.seed )
+{
+}
+
+QByteArray CorpusGenerator::nextBlock( qint64 sizeBytes )
+{
+    const auto bytesPerChar = options_.encoding == CorpusOptions::Encoding::Utf16LE ? 2 : 1;
+
+    std::string text;
+    while ( static_cast<qint64>( text.size() ) * bytesPerChar < sizeBytes ) {
+        appendLine( text );
+    }
+
+    return encode( text );
+}
+
+void CorpusGenerator::appendLine( std::string& out )
+{
+    const auto lineStart = out.size();
+    const auto isJson = options_.format == CorpusOptions::Format::JsonLines;
+    const auto separator = options_.tabs ? '\t' : ' ';
+
+    const auto service = Services[ next( Services.size() ) ];
+
+    // 80% INFO, 12% WARN, 5% ERROR, 3% DEBUG
+    const auto levelDraw = next( 100 );
+    const auto level = levelDraw < 80   ? "INFO"
+                       : levelDraw < 92 ? "WARN"
+                       : levelDraw < 97 ? "ERROR"
+                                        : "DEBUG";
+
+    const auto id = std::to_string( next( 1'000'000 ) );
+
+    if ( isJson ) {
+        out += "{\"time\":\"";
+        appendTimestamp( out, 'T' );
+        out += "\",\"service\":\"";
+        out += service;
+        out += "\",\"level\":\"";
+        out += level;
+        out += "\",\"message\":\"";
+        appendMessage( out );
+        out += "\",\"id\":";
+        out += id;
+    }
+    else {
+        appendTimestamp( out, ' ' );
+        out += separator;
+        out += '[';
+        out += service;
+        out += ']';
+        out += separator;
+        out += level;
+        out += separator;
+        appendMessage( out );
+        out += " id=";
+        out += id;
+    }
+
+    // Dumps of requests or stack traces, that make a few lines very long
+    const auto isHugeLine = options_.hugeLinesPerMillion > 0
+                            && next( 1'000'000 ) < options_.hugeLinesPerMillion;
+    const auto paddedLength
+        = isHugeLine ? options_.hugeLineLength : std::max( options_.longLineLength, 0 );
+
+    if ( paddedLength > 0 ) {
+        out += isJson ? ",\"payload\":\"" : " payload=";
+
+        const auto payloadEnd = lineStart + static_cast<std::size_t>( paddedLength );
+        auto character = next( PayloadAlphabet.size() );
+        while ( out.size() < payloadEnd ) {
+            out += PayloadAlphabet[ character++ % PayloadAlphabet.size() ];
+        }
+
+        if ( isJson ) {
+            out += '"';
+        }
+    }
+
+    if ( isJson ) {
+        out += '}';
+    }
+
+    out += options_.crlf ? "\r\n" : "\n";
+    ++lines_;
+}
+
+void CorpusGenerator::appendMessage( std::string& out )
+{
+    // Most messages are short, a few are much longer
+    const auto lengthDraw = next( 1000 );
+    const auto nbWords = lengthDraw < 900   ? 4 + next( 12 )
+                         : lengthDraw < 990 ? 16 + next( 48 )
+                                            : 64 + next( 192 );
+
+    const auto hasToken = options_.tokenLinesPerMillion > 0
+                          && next( 1'000'000 ) < options_.tokenLinesPerMillion;
+    const auto tokenPosition = hasToken ? next( nbWords ) : nbWords;
+
+    for ( auto index = 0u; index < nbWords; ++index ) {
+        if ( index > 0 ) {
+            out += ' ';
+        }
+        out += index == tokenPosition ? options_.token.c_str() : word();
+    }
+}
+
+void CorpusGenerator::appendTimestamp( std::string& out, char dateTimeSeparator )
+{
+    const auto day = static_cast<int64_t>( timestamp_ / MillisecondsPerDay );
+    if ( day != currentDay_ ) {
+        currentDay_ = day;
+        date_ = QDate( 2024, 3, 5 ).addDays( day ).toString( Qt::ISODate ).toStdString();
+    }
+
+    const auto millis = timestamp_ % 1000;
+    const auto seconds = ( timestamp_ / 1000 ) % 60;
+    const auto minutes = ( timestamp_ / 60'000 ) % 60;
+    const auto hours = ( timestamp_ / 3'600'000 ) % 24;
+    timestamp_ += 1 + next( 50 );
+
+    char time[ 16 ];
+    std::snprintf( time, sizeof( time ), "%02u:%02u:%02u.%03u", static_cast<unsigned>( hours ),
+                   static_cast<unsigned>( minutes ), static_cast<unsigned>( seconds ),
+                   static_cast<unsigned>( millis ) );
+
+    out += date_;
+    out += dateTimeSeparator;
+    out += time;
+}
+
+const char* CorpusGenerator::word()
+{
+    if ( options_.nonAscii && next( 4 ) == 0 ) {
+        return CyrillicWords[ next( CyrillicWords.size() ) ];
+    }
+    return Words[ next( Words.size() ) ];
+}
+
+// Standard distributions are implementation defined, the generator output
+// is used directly so the corpus is the same with all standard libraries.
+uint32_t CorpusGenerator::next( std::size_t bound )
+{
+    return static_cast<uint32_t>( random_() % bound );
+}
+
+QByteArray CorpusGenerator::encode( const std::string& text ) const
+{
+    const auto textSize = static_cast<int>( text.size() );
+
+    if ( options_.encoding == CorpusOptions::Encoding::Utf8 ) {
+        return QByteArray( text.data(), textSize );
+    }
+
+    if ( options_.encoding == CorpusOptions::Encoding::Utf16LE && !options_.nonAscii ) {
+        // Lines are ascii, utf16 code units are the bytes followed by 0
+        QByteArray utf16( textSize * 2, '\0' );
+        for ( auto i = 0; i < textSize; ++i ) {
+            utf16[ 2 * i ] = text[ static_cast<std::size_t>( i ) ];
+        }
+        return utf16;
+    }
+
+    auto* codec = QTextCodec::codecForName( options_.encoding == CorpusOptions::Encoding::Utf16LE
+                                                ? QByteArray( "UTF-16LE" )
+                                                : options_.codepage );
+    if ( codec == nullptr ) {
+        return QByteArray( text.data(), textSize );
+    }
+
+    const auto unicodeText = QString::fromUtf8( text.data(), textSize );
+    QTextCodec::ConverterState state( QTextCodec::IgnoreHeader );
+    return codec->fromUnicode( unicodeText.constData(), unicodeText.size(), &state );
+}
+
+QByteArray corpusByteOrderMark( const CorpusOptions& options )
+{
+    return options.encoding == CorpusOptions::Encoding::Utf16LE ? QByteArray( "\xFF\xFE", 2 )
+                                                                : QByteArray{};
+}
+
+CorpusStats writeCorpus( const QString& path, const CorpusOptions& options, bool append )
+{
+    QFile file( path );
+    if ( !file.open( append ? QIODevice::Append : QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        return {};
+    }
+
+    CorpusStats stats;
+    if ( !append ) {
+        stats.bytes += file.write( corpusByteOrderMark( options ) );
+    }
+
+    CorpusGenerator generator( options );
+    while ( stats.bytes < options.sizeBytes ) {
+        const auto written = file.write(
+            generator.nextBlock( std::min( WriteBlockSize, options.sizeBytes - stats.bytes ) ) );
+        if ( written < 0 ) {
+            break;
+        }
+        stats.bytes += written;
+    }
+    stats.lines = generator.lines();
+
+    return stats;
+}
+
+QByteArray generateCorpus( const CorpusOptions& options )
+{
+    return CorpusGenerator( options ).nextBlock( options.sizeBytes );
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KLOGG_BENCHCORPUS_H
+#define KLOGG_BENCHCORPUS_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include <QByteArray>
+#include <QString>
+
+// Synthetic log files used by the benchmarks.
+// The content only depends on the options, so results of different
+// machines and runs are comparable.
+struct CorpusOptions {
+    enum class Encoding { Utf8, Utf16LE, Codepage };
+    enum class Format { Text, JsonLines };
+
+    qint64 sizeBytes = 0;
+    Format format = Format::Text;
+    Encoding encoding = Encoding::Utf8;
+    // Name of the text codec used with Encoding::Codepage
+    QByteArray codepage = "windows-1251";
+    // Use cyrillic words in some of the messages
+    bool nonAscii = false;
+    bool crlf = false;
+    // Separate the fields of lines with tabs
+    bool tabs = false;
+    // If not 0, all lines are padded to about this number of characters
+    int longLineLength = 0;
+    // Lines with a payload of hugeLineLength characters, per million lines
+    uint32_t hugeLinesPerMillion = 0;
+    int hugeLineLength = 1024 * 1024;
+    // Lines containing the token, per million lines
+    uint32_t tokenLinesPerMillion = 0;
+    std::string token = "klogg_needle";
+    uint32_t seed = 42;
+};
+
+struct CorpusStats {
+    qint64 bytes = 0;
+    uint64_t lines = 0;
+};
+
+// Generates the lines of a corpus block after block. Each call continues
+// where the previous one stopped, so a file can be grown over time with
+// the same content as if it was written at once.
+class CorpusGenerator {
+  public:
+    explicit CorpusGenerator( const CorpusOptions& options );
+
+    // Returns whole lines, about sizeBytes once encoded,
+    // without byte order mark.
+    QByteArray nextBlock( qint64 sizeBytes );
+
+    uint64_t lines() const
+    {
+        return lines_;
+    }
+
+  private:
+    void appendLine( std::string& out );
+    void appendMessage( std::string& out );
+    void appendTimestamp( std::string& out, char dateTimeSeparator );
+
+    const char* word();
+    uint32_t next( std::size_t bound );
+
+    QByteArray encode( const std::string& text ) const;
+
+  private:
+    CorpusOptions options_;
+    std::mt19937 random_;
+
+    uint64_t lines_ = 0;
+    uint64_t timestamp_ = 0;
+
+    int64_t currentDay_ = -1;
+    std::string date_;
+};
+
+// Returns the byte order mark written at the beginning of files
+// with the encoding of the options, if any.
+QByteArray corpusByteOrderMark( const CorpusOptions& options );
+
+// Writes sizeBytes of log lines to the file, after its current content
+// if append is set.
+CorpusStats writeCorpus( const QString& path, const CorpusOptions& options, bool append = false );
+
+// Returns about sizeBytes of whole log lines, without byte order mark.
+QByteArray generateCorpus( const CorpusOptions& options );
+
+#endif
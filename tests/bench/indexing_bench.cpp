@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include "encodingdetector.h"
+#include "logdataworker.h"
+
+#include "microbench.h"
+
+namespace {
+
+constexpr qint64 IndexBlockSize = 16 * microbench::BlockSize;
+
+struct IndexInput {
+    std::string name;
+    CorpusOptions options;
+    const char* codecName;
+};
+
+klogg::vector<IndexInput> indexInputs()
+{
+    CorpusOptions utf8;
+    utf8.sizeBytes = IndexBlockSize;
+
+    auto crlf = utf8;
+    crlf.crlf = true;
+
+    auto tabs = utf8;
+    tabs.tabs = true;
+
+    auto longLines = utf8;
+    longLines.longLineLength = 10'000;
+
+    auto utf16 = utf8;
+    utf16.encoding = CorpusOptions::Encoding::Utf16LE;
+
+    return { { "utf8", utf8, "UTF-8" },
+             { "crlf", crlf, "UTF-8" },
+             { "tabs", tabs, "UTF-8" },
+             { "long lines", longLines, "UTF-8" },
+             { "utf16", utf16, "UTF-16LE" } };
+}
+
+struct DecodeInput {
+    std::string name;
+    CorpusOptions::Encoding encoding;
+    const char* codecName;
+};
+
+} // namespace
+
+TEST_CASE( "Parse data block", "[indexing]" )
+{
+    for ( const auto& input : indexInputs() ) {
+        const auto data = generateCorpus( input.options );
+        const klogg::vector<char> block( data.begin(), data.end() );
+        const auto encodingParams
+            = EncodingParameters( QTextCodec::codecForName( input.codecName ) );
+
+        BENCHMARK( "parse data block/" + input.name )
+        {
+            IndexingState state;
+            state.encodingParams = encodingParams;
+            return IndexOperation::parseDataBlock( 0, block, state ).size();
+        };
+    }
+}
+
+TEST_CASE( "Decode lines", "[decoding]" )
+{
+    const klogg::vector<DecodeInput> inputs
+        = { { "utf8", CorpusOptions::Encoding::Utf8, "UTF-8" },
+            { "cp1251", CorpusOptions::Encoding::Codepage, "windows-1251" },
+            { "utf16", CorpusOptions::Encoding::Utf16LE, "UTF-16LE" } };
+
+    for ( const auto& input : inputs ) {
+        CorpusOptions options;
+        options.sizeBytes = microbench::BlockSize;
+        options.encoding = input.encoding;
+        options.codepage = input.codecName;
+        // Some of the text has to be transcoded
+        options.nonAscii = true;
+
+        const auto rawLines = microbench::makeRawLines(
+            generateCorpus( options ), QTextCodec::codecForName( input.codecName ) );
+
+        BENCHMARK( "decode lines/" + input.name )
+        {
+            return rawLines.decodeLines().size();
+        };
+
+        BENCHMARK( "build utf8 view/" + input.name )
+        {
+            return rawLines.buildUtf8View().size();
+        };
+    }
+}
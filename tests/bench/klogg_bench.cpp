@@ -0,0 +1,510 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// klogg_bench measures the main data paths of klogg on synthetic files:
+// indexing, searching, reading pages of the filtered view and saving lines.
+// Results are printed as JSON so they can be compared between builds.
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "atomicflag.h"
+#include "configuration.h"
+#include "klogg_version.h"
+#include "linesexporter.h"
+#include "logdata.h"
+#include "logfiltereddata.h"
+#include "logger.h"
+#include "persistentinfo.h"
+
+#include "benchcorpus.h"
+
+const bool PersistentInfo::ForcePortable = true;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double MiB = 1024.0 * 1024.0;
+
+constexpr int FilteredPagesCount = 1000;
+constexpr int FilteredPageSize = 100;
+
+struct Measurement {
+    qint64 bytes = 0;
+    uint64_t lines = 0;
+    double seconds = 0;
+    QJsonObject extra;
+};
+
+struct Scenario {
+    QString name;
+    std::function<Measurement()> run;
+};
+
+double secondsSince( Clock::time_point start )
+{
+    return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+uint64_t peakRssBytes()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if ( !GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) ) {
+        return 0;
+    }
+    return static_cast<uint64_t>( counters.PeakWorkingSetSize );
+#else
+    rusage usage{};
+    getrusage( RUSAGE_SELF, &usage );
+#ifdef Q_OS_MACOS
+    return static_cast<uint64_t>( usage.ru_maxrss );
+#else
+    return static_cast<uint64_t>( usage.ru_maxrss ) * 1024;
+#endif
+#endif
+}
+
+// Runs start and the event loop until the loading it started is finished
+LoadingStatus runLoading( LogData& logData, const std::function<void()>& start )
+{
+    QEventLoop loop;
+    auto status = LoadingStatus::Interrupted;
+    QObject::connect( &logData, &LogData::loadingFinished, &loop,
+                      [ &status, &loop ]( LoadingStatus finishedStatus ) {
+                          status = finishedStatus;
+                          loop.quit();
+                      } );
+    start();
+    loop.exec();
+    return status;
+}
+
+LinesCount runSearch( LogFilteredData& filteredData, const RegularExpressionPattern& pattern )
+{
+    QEventLoop loop;
+    auto nbMatches = 0_lcount;
+    QObject::connect( &filteredData, &LogFilteredData::searchProgressed, &loop,
+                      [ &nbMatches, &loop ]( LinesCount matches, int progress, LineNumber ) {
+                          if ( progress == 100 ) {
+                              nbMatches = matches;
+                              loop.quit();
+                          }
+                      } );
+    filteredData.runSearch( pattern );
+    loop.exec();
+    return nbMatches;
+}
+
+// The synthetic files, generated the first time a scenario needs them,
+// and the LogData indexing them shared by the scenarios not measuring indexing.
+class Corpora {
+  public:
+    Corpora( const QString& directory, qint64 sizeBytes )
+        : directory_( directory )
+        , sizeBytes_( sizeBytes )
+    {
+    }
+
+    static QStringList names()
+    {
+        return { "utf8", "utf16", "crlf", "tabs", "longlines" };
+    }
+
+    QString path( const QString& name )
+    {
+        auto corpus = paths_.find( name );
+        if ( corpus == paths_.end() ) {
+            const auto corpusPath = QDir( directory_ ).filePath( name + ".log" );
+            std::cerr << "Generating " << corpusPath.toStdString() << std::endl;
+            writeCorpus( corpusPath, options( name ) );
+            corpus = paths_.emplace( name, corpusPath ).first;
+        }
+        return corpus->second;
+    }
+
+    LogData& loaded( const QString& name )
+    {
+        auto& logData = loaded_[ name ];
+        if ( !logData ) {
+            logData = std::make_unique<LogData>();
+            const auto corpusPath = path( name );
+            runLoading( *logData,
+                        [ &logData, &corpusPath ] { logData->attachFile( corpusPath ); } );
+        }
+        return *logData;
+    }
+
+    CorpusOptions options( const QString& name ) const
+    {
+        CorpusOptions corpusOptions;
+        corpusOptions.sizeBytes = sizeBytes_;
+        if ( name == "utf16" ) {
+            corpusOptions.encoding = CorpusOptions::Encoding::Utf16LE;
+        }
+        else if ( name == "crlf" ) {
+            corpusOptions.crlf = true;
+        }
+        else if ( name == "tabs" ) {
+            corpusOptions.tabs = true;
+        }
+        else if ( name == "longlines" ) {
+            corpusOptions.longLineLength = 64 * 1024;
+        }
+        return corpusOptions;
+    }
+
+    QString directory() const
+    {
+        return directory_;
+    }
+
+  private:
+    QString directory_;
+    qint64 sizeBytes_;
+
+    std::map<QString, QString> paths_;
+    std::map<QString, std::unique_ptr<LogData>> loaded_;
+};
+
+Measurement measureIndexing( Corpora& corpora, const QString& name )
+{
+    const auto corpusPath = corpora.path( name );
+
+    LogData logData;
+    const auto start = Clock::now();
+    runLoading( logData, [ &logData, &corpusPath ] { logData.attachFile( corpusPath ); } );
+
+    Measurement measurement;
+    measurement.seconds = secondsSince( start );
+    measurement.bytes = logData.getFileSize();
+    measurement.lines = logData.getNbLine().get();
+    measurement.extra[ "index_bytes" ] = static_cast<qint64>( logData.getIndexAllocatedSize() );
+    measurement.extra[ "index_bytes_per_line" ]
+        = static_cast<double>( logData.getIndexAllocatedSize() )
+          / static_cast<double>( std::max( measurement.lines, uint64_t{ 1 } ) );
+    return measurement;
+}
+
+// Indexes the second half of a file after the first one is indexed,
+// as when following a growing file.
+Measurement measurePartialIndexing( Corpora& corpora )
+{
+    const auto corpusPath = QDir( corpora.directory() ).filePath( "partial.log" );
+
+    auto corpusOptions = corpora.options( "utf8" );
+    corpusOptions.sizeBytes /= 2;
+    writeCorpus( corpusPath, corpusOptions );
+
+    LogData logData;
+    runLoading( logData, [ &logData, &corpusPath ] { logData.attachFile( corpusPath ); } );
+    const auto initialSize = logData.getFileSize();
+    const auto initialLines = logData.getNbLine();
+
+    corpusOptions.seed += 1;
+    writeCorpus( corpusPath, corpusOptions, true );
+
+    // Do what the file watcher does when it sees the file change
+    const auto start = Clock::now();
+    runLoading( logData, [ &logData, &corpusPath ] {
+        QMetaObject::invokeMethod( &logData, "fileChangedOnDisk", Qt::DirectConnection,
+                                   Q_ARG( QString, corpusPath ) );
+    } );
+
+    Measurement measurement;
+    measurement.seconds = secondsSince( start );
+    measurement.bytes = logData.getFileSize() - initialSize;
+    measurement.lines = logData.getNbLine().get() - initialLines.get();
+
+    const auto nbLines = std::max( logData.getNbLine().get(), LinesCount::UnderlyingType{ 1 } );
+    measurement.extra[ "index_bytes_per_line" ]
+        = static_cast<double>( logData.getIndexAllocatedSize() ) / static_cast<double>( nbLines );
+    return measurement;
+}
+
+Measurement measureSearch( Corpora& corpora, const RegularExpressionPattern& pattern, int threads )
+{
+    auto& config = Configuration::get();
+    config.setSearchThreadPoolSize( threads );
+    config.setUseParallelSearch( threads > 1 );
+
+    auto& logData = corpora.loaded( "utf8" );
+    auto filteredData = logData.getNewFilteredData();
+
+    const auto start = Clock::now();
+    const auto nbMatches = runSearch( *filteredData, pattern );
+
+    Measurement measurement;
+    measurement.seconds = secondsSince( start );
+    measurement.bytes = logData.getFileSize();
+    measurement.lines = logData.getNbLine().get();
+    measurement.extra[ "matches" ] = static_cast<qint64>( nbMatches.get() );
+    return measurement;
+}
+
+RegularExpressionPattern warningsPattern()
+{
+    return RegularExpressionPattern( "WARN", true, false, false, true );
+}
+
+// Reads pages of lines at random positions of the matches, as when
+// scrolling the filtered view. Bytes are counted as characters.
+Measurement measureFilteredPages( Corpora& corpora )
+{
+    auto& logData = corpora.loaded( "utf8" );
+    auto filteredData = logData.getNewFilteredData();
+    const auto nbMatches = runSearch( *filteredData, warningsPattern() );
+
+    std::mt19937 random( 42 );
+    const auto maxPosition
+        = std::max( nbMatches.get(), LinesCount::UnderlyingType{ FilteredPageSize } )
+          - FilteredPageSize + 1;
+
+    Measurement measurement;
+    const auto start = Clock::now();
+    for ( auto page = 0; page < FilteredPagesCount; ++page ) {
+        const auto firstLine = LineNumber( random() % maxPosition );
+        const auto lines = filteredData->getLines( firstLine, LinesCount( FilteredPageSize ) );
+        for ( const auto& line : lines ) {
+            measurement.bytes += line.size();
+        }
+        measurement.lines += lines.size();
+    }
+    measurement.seconds = secondsSince( start );
+    measurement.extra[ "pages" ] = FilteredPagesCount;
+    return measurement;
+}
+
+Measurement measureSave( Corpora& corpora, bool filtered )
+{
+    auto& logData = corpora.loaded( "utf8" );
+    auto filteredData = logData.getNewFilteredData();
+    if ( filtered ) {
+        runSearch( *filteredData, warningsPattern() );
+    }
+
+    const AbstractLogData& source
+        = filtered ? static_cast<const AbstractLogData&>( *filteredData ) : logData;
+
+    QFile destination( QDir( corpora.directory() ).filePath( "saved.log" ) );
+    destination.open( QIODevice::WriteOnly | QIODevice::Truncate );
+
+    const LinesExporter exporter( source, 0_lnum, source.getNbLine() );
+    const AtomicFlag noInterruption;
+
+    const auto start = Clock::now();
+    const auto result = exporter.exportTo( destination, noInterruption, []( int ) {} );
+    destination.close();
+
+    Measurement measurement;
+    measurement.seconds = secondsSince( start );
+    measurement.bytes = destination.size();
+    measurement.lines = source.getNbLine().get();
+    measurement.extra[ "done" ] = result == LinesExporter::Result::Done;
+    return measurement;
+}
+
+klogg::vector<int> threadCounts()
+{
+    const auto idealCount = QThread::idealThreadCount();
+    klogg::vector<int> counts;
+    for ( const auto count : { 1, 2, 4, idealCount } ) {
+        if ( count <= idealCount
+             && std::find( counts.begin(), counts.end(), count ) == counts.end() ) {
+            counts.push_back( count );
+        }
+    }
+    return counts;
+}
+
+klogg::vector<Scenario> makeScenarios( Corpora& corpora )
+{
+    klogg::vector<Scenario> scenarios;
+
+    for ( const auto& name : Corpora::names() ) {
+        scenarios.push_back(
+            { "index/" + name, [ &corpora, name ] { return measureIndexing( corpora, name ); } } );
+    }
+    scenarios.push_back(
+        { "index-partial/utf8", [ &corpora ] { return measurePartialIndexing( corpora ); } } );
+
+    const std::map<QString, RegularExpressionPattern> patterns = {
+        { "plain", RegularExpressionPattern( "timeout", true, false, false, true ) },
+        { "regex", RegularExpressionPattern( "(ERROR|WARN).*id=[0-9]+7$" ) },
+        { "boolean", RegularExpressionPattern( "\"ERROR\" and not \"timeout\"", true, false,
+                                               true, false ) },
+        { "inverse", RegularExpressionPattern( "INFO", true, true, false, true ) },
+    };
+    for ( const auto& [ kind, pattern ] : patterns ) {
+        for ( const auto threads : threadCounts() ) {
+            scenarios.push_back( { QString( "search/%1/threads-%2" ).arg( kind ).arg( threads ),
+                                   [ &corpora, pattern = pattern, threads ] {
+                                       return measureSearch( corpora, pattern, threads );
+                                   } } );
+        }
+    }
+
+    scenarios.push_back(
+        { "filtered-pages/utf8", [ &corpora ] { return measureFilteredPages( corpora ); } } );
+    scenarios.push_back(
+        { "save/all", [ &corpora ] { return measureSave( corpora, false ); } } );
+    scenarios.push_back(
+        { "save/filtered", [ &corpora ] { return measureSave( corpora, true ); } } );
+
+    return scenarios;
+}
+
+// The median run is reported, with the spread of all runs
+QJsonObject runScenario( const Scenario& scenario, int repeat )
+{
+    klogg::vector<Measurement> measurements;
+    for ( auto run = 0; run < repeat; ++run ) {
+        measurements.push_back( scenario.run() );
+    }
+
+    std::sort( measurements.begin(), measurements.end(),
+               []( const auto& lhs, const auto& rhs ) { return lhs.seconds < rhs.seconds; } );
+    const auto& median = measurements[ measurements.size() / 2 ];
+    const auto seconds = std::max( median.seconds, 1e-9 );
+
+    auto result = median.extra;
+    result[ "scenario" ] = scenario.name;
+    result[ "runs" ] = repeat;
+    result[ "seconds" ] = median.seconds;
+    result[ "min_seconds" ] = measurements.front().seconds;
+    result[ "max_seconds" ] = measurements.back().seconds;
+    result[ "bytes" ] = median.bytes;
+    result[ "lines" ] = static_cast<qint64>( median.lines );
+    result[ "mib_per_s" ] = static_cast<double>( median.bytes ) / MiB / seconds;
+    result[ "lines_per_s" ] = static_cast<double>( median.lines ) / seconds;
+    result[ "peak_rss_bytes" ] = static_cast<qint64>( peakRssBytes() );
+    return result;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Measures klogg indexing, search, filtered view and save throughput "
+        "on synthetic files and prints the results as JSON." );
+    parser.addHelpOption();
+
+    const QCommandLineOption sizeOption( "size", "size of the generated files", "MiB", "256" );
+    const QCommandLineOption repeatOption( "repeat", "runs of each scenario", "count", "3" );
+    const QCommandLineOption scenarioOption(
+        "scenario", "run only scenarios matching this regular expression", "regexp" );
+    const QCommandLineOption listOption( "list", "list the scenarios and exit" );
+    const QCommandLineOption directoryOption(
+        "dir", "directory of the generated files (temporary by default)", "path" );
+    const QCommandLineOption outputOption( "output", "write the results to a file", "path" );
+    const QCommandLineOption debugOption( "debug", "enable klogg logging" );
+    parser.addOptions( { sizeOption, repeatOption, scenarioOption, listOption, directoryOption,
+                         outputOption, debugOption } );
+    parser.process( app );
+
+    logging::enableLogging( parser.isSet( debugOption ) );
+
+    auto& config = Configuration::getSynced();
+    // Every search must scan the file
+    config.setUseSearchResultsCache( false );
+
+    QTemporaryDir temporaryDirectory;
+    const auto directory = parser.isSet( directoryOption ) ? parser.value( directoryOption )
+                                                           : temporaryDirectory.path();
+    QDir().mkpath( directory );
+
+    const auto sizeBytes = parser.value( sizeOption ).toLongLong() * 1024 * 1024;
+    const auto repeat = std::max( 1, parser.value( repeatOption ).toInt() );
+
+    Corpora corpora( directory, sizeBytes );
+    const auto scenarios = makeScenarios( corpora );
+    const QRegularExpression filter( parser.value( scenarioOption ) );
+
+    QJsonArray results;
+    for ( const auto& scenario : scenarios ) {
+        if ( !filter.match( scenario.name ).hasMatch() ) {
+            continue;
+        }
+
+        if ( parser.isSet( listOption ) ) {
+            std::cout << scenario.name.toStdString() << "\n";
+            continue;
+        }
+
+        const auto result = runScenario( scenario, repeat );
+        std::cerr << scenario.name.toStdString() << ": " << result[ "mib_per_s" ].toDouble()
+                  << " MiB/s, " << result[ "lines_per_s" ].toDouble() << " lines/s" << std::endl;
+        results.append( result );
+    }
+
+    if ( parser.isSet( listOption ) ) {
+        return EXIT_SUCCESS;
+    }
+
+    QJsonObject report;
+    report[ "version" ] = QString( kloggVersion() );
+    report[ "size_bytes" ] = sizeBytes;
+    report[ "threads" ] = QThread::idealThreadCount();
+    report[ "results" ] = results;
+
+    const auto json = QJsonDocument( report ).toJson();
+    if ( parser.isSet( outputOption ) ) {
+        QFile output( parser.value( outputOption ) );
+        if ( !output.open( QIODevice::WriteOnly | QIODevice::Truncate )
+             || output.write( json ) != json.size() ) {
+            std::cerr << "Can't write " << output.fileName().toStdString() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    else {
+        std::cout << json.toStdString();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// klogg_gencorpus writes synthetic log files for benchmarks and manual tests:
+//   klogg_gencorpus --size 10G big.log
+//   klogg_gencorpus --encoding windows-1251 --non-ascii --crlf cp1251.log
+//   klogg_gencorpus --token-density 0.001 --huge-lines 10 sparse.log
+//   klogg_gencorpus --size 0 --rate 1M --duration 600 growing.log
+// The same options and seed always produce the same file.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <optional>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextCodec>
+#include <QThread>
+
+#include "benchcorpus.h"
+
+namespace {
+
+constexpr qint64 WriteBlockSize = 4 * 1024 * 1024;
+constexpr unsigned long RateIntervalMs = 100;
+
+// Parses sizes like 512, 64K, 100M or 2G (powers of 1024)
+std::optional<qint64> parseSize( const QString& value )
+{
+    auto number = value.trimmed().toUpper();
+    qint64 multiplier = 1;
+    if ( number.endsWith( 'B' ) ) {
+        number.chop( 1 );
+    }
+
+    const QString units = "KMGT";
+    if ( !number.isEmpty() && units.contains( number.back() ) ) {
+        for ( auto unit = 0; unit <= units.indexOf( number.back() ); ++unit ) {
+            multiplier *= 1024;
+        }
+        number.chop( 1 );
+    }
+
+    bool isValid = false;
+    const auto size = number.toLongLong( &isValid );
+    if ( !isValid || size < 0 ) {
+        return {};
+    }
+    return size * multiplier;
+}
+
+int usageError( const QString& message )
+{
+    std::cerr << "klogg_gencorpus: " << message.toStdString() << std::endl;
+    return 2;
+}
+
+bool writeBlock( QFile& file, const QByteArray& block, CorpusStats& stats )
+{
+    if ( file.write( block ) != block.size() ) {
+        std::cerr << "Can't write " << file.fileName().toStdString() << ": "
+                  << file.errorString().toStdString() << std::endl;
+        return false;
+    }
+    stats.bytes += block.size();
+    return true;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Writes a synthetic log file of timestamped lines from several services. "
+        "The content only depends on the options and the seed." );
+    parser.addHelpOption();
+    parser.addPositionalArgument( "output", "file to write, - for the standard output" );
+
+    const QCommandLineOption sizeOption( { "s", "size" }, "size of the file (K, M, G, T suffixes)",
+                                         "size", "100M" );
+    const QCommandLineOption seedOption( "seed", "seed of the generator", "number", "42" );
+    const QCommandLineOption formatOption( "format", "format of the lines", "text|json", "text" );
+    const QCommandLineOption encodingOption(
+        "encoding", "utf8, utf16le or the name of a codepage such as windows-1251", "encoding",
+        "utf8" );
+    const QCommandLineOption nonAsciiOption( "non-ascii", "use cyrillic words in messages" );
+    const QCommandLineOption tabsOption( "tabs", "separate fields with tabs" );
+    const QCommandLineOption crlfOption( "crlf", "end lines with CR LF" );
+    const QCommandLineOption longLinesOption( "long-lines", "pad all lines to this length",
+                                              "chars", "0" );
+    const QCommandLineOption hugeLinesOption( "huge-lines", "huge lines per million lines",
+                                              "count", "0" );
+    const QCommandLineOption hugeLineLengthOption(
+        "huge-line-length", "length of huge lines (K, M suffixes)", "chars", "1M" );
+    const QCommandLineOption tokenOption( "token", "token planted in messages", "text",
+                                          "klogg_needle" );
+    const QCommandLineOption tokenDensityOption(
+        "token-density", "fraction of lines containing the token", "fraction", "0" );
+    const QCommandLineOption appendOption( "append", "append to the file instead of replacing it" );
+    const QCommandLineOption rateOption(
+        "rate", "after writing the initial size, keep appending this much per second", "size" );
+    const QCommandLineOption durationOption(
+        "duration", "stop appending after this time, 0 to append until interrupted", "seconds",
+        "0" );
+    parser.addOptions( { sizeOption, seedOption, formatOption, encodingOption, nonAsciiOption,
+                         tabsOption, crlfOption, longLinesOption, hugeLinesOption,
+                         hugeLineLengthOption, tokenOption, tokenDensityOption, appendOption,
+                         rateOption, durationOption } );
+    parser.process( app );
+
+    if ( parser.positionalArguments().size() != 1 ) {
+        return usageError( "exactly one output file expected" );
+    }
+
+    CorpusOptions options;
+
+    const auto size = parseSize( parser.value( sizeOption ) );
+    if ( !size ) {
+        return usageError( "invalid size " + parser.value( sizeOption ) );
+    }
+    options.sizeBytes = *size;
+
+    bool isValidSeed = false;
+    options.seed = parser.value( seedOption ).toUInt( &isValidSeed );
+    if ( !isValidSeed ) {
+        return usageError( "invalid seed " + parser.value( seedOption ) );
+    }
+
+    const auto format = parser.value( formatOption );
+    if ( format == "json" ) {
+        options.format = CorpusOptions::Format::JsonLines;
+    }
+    else if ( format != "text" ) {
+        return usageError( "unknown format " + format );
+    }
+
+    const auto encoding = parser.value( encodingOption ).toLower();
+    if ( encoding == "utf16le" || encoding == "utf-16le" ) {
+        options.encoding = CorpusOptions::Encoding::Utf16LE;
+    }
+    else if ( encoding != "utf8" && encoding != "utf-8" ) {
+        options.encoding = CorpusOptions::Encoding::Codepage;
+        options.codepage = parser.value( encodingOption ).toLatin1();
+        if ( QTextCodec::codecForName( options.codepage ) == nullptr ) {
+            return usageError( "unknown encoding " + parser.value( encodingOption ) );
+        }
+    }
+
+    options.nonAscii = parser.isSet( nonAsciiOption );
+    options.tabs = parser.isSet( tabsOption );
+    options.crlf = parser.isSet( crlfOption );
+    options.longLineLength = std::max( 0, parser.value( longLinesOption ).toInt() );
+    options.hugeLinesPerMillion = parser.value( hugeLinesOption ).toUInt();
+
+    const auto hugeLineLength = parseSize( parser.value( hugeLineLengthOption ) );
+    if ( !hugeLineLength || *hugeLineLength > std::numeric_limits<int>::max() / 4 ) {
+        return usageError( "invalid huge line length " + parser.value( hugeLineLengthOption ) );
+    }
+    options.hugeLineLength = static_cast<int>( *hugeLineLength );
+
+    options.token = parser.value( tokenOption ).toStdString();
+    const auto tokenDensity = parser.value( tokenDensityOption ).toDouble();
+    if ( tokenDensity < 0 || tokenDensity > 1 ) {
+        return usageError( "token density must be between 0 and 1" );
+    }
+    options.tokenLinesPerMillion = static_cast<uint32_t>( tokenDensity * 1'000'000 + 0.5 );
+
+    std::optional<qint64> rate;
+    if ( parser.isSet( rateOption ) ) {
+        rate = parseSize( parser.value( rateOption ) );
+        if ( !rate || *rate == 0 ) {
+            return usageError( "invalid rate " + parser.value( rateOption ) );
+        }
+    }
+    const auto durationMs = static_cast<qint64>( parser.value( durationOption ).toDouble() * 1000 );
+
+    const auto outputPath = parser.positionalArguments().front();
+    QFile file( outputPath );
+    const auto openMode = parser.isSet( appendOption )
+                              ? QIODevice::Append
+                              : QIODevice::WriteOnly | QIODevice::Truncate;
+    const auto isOpen = outputPath == "-" ? file.open( stdout, QIODevice::WriteOnly )
+                                          : file.open( openMode );
+    if ( !isOpen ) {
+        std::cerr << "Can't open " << outputPath.toStdString() << ": "
+                  << file.errorString().toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    CorpusStats stats;
+    if ( file.size() == 0 && !writeBlock( file, corpusByteOrderMark( options ), stats ) ) {
+        return EXIT_FAILURE;
+    }
+
+    CorpusGenerator generator( options );
+    while ( stats.bytes < options.sizeBytes ) {
+        const auto blockSize = std::min( WriteBlockSize, options.sizeBytes - stats.bytes );
+        if ( !writeBlock( file, generator.nextBlock( blockSize ), stats ) ) {
+            return EXIT_FAILURE;
+        }
+    }
+    file.flush();
+
+    if ( rate ) {
+        // Lines are written as a whole, a reader never sees a partial one
+        QElapsedTimer timer;
+        timer.start();
+        qint64 appendedBytes = 0;
+        while ( durationMs == 0 || timer.elapsed() < durationMs ) {
+            const auto dueBytes = *rate * timer.elapsed() / 1000 - appendedBytes;
+            if ( dueBytes > 0 ) {
+                const auto block = generator.nextBlock( std::min( WriteBlockSize, dueBytes ) );
+                if ( !writeBlock( file, block, stats ) ) {
+                    return EXIT_FAILURE;
+                }
+                file.flush();
+                appendedBytes += block.size();
+            }
+            QThread::msleep( RateIntervalMs );
+        }
+    }
+
+    std::cerr << "Wrote " << stats.bytes << " bytes, " << generator.lines() << " lines to "
+              << outputPath.toStdString() << std::endl;
+
+    return EXIT_SUCCESS;
+}
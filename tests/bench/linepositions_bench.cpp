@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <random>
+
+#include "linepositionarray.h"
+
+namespace {
+
+constexpr uint64_t NumberOfLines = 1'000'000;
+constexpr uint64_t NumberOfLookups = 10'000;
+constexpr LinesCount PageSize = 50_lcount;
+
+// Mostly short lines with a long (>16384) one from time to time,
+// so both the short and long line blocks of the compressed storage are used.
+klogg::vector<OffsetInFile> generatePositions()
+{
+    std::mt19937 random( 42 );
+
+    klogg::vector<OffsetInFile> positions;
+    positions.reserve( NumberOfLines );
+
+    OffsetInFile::UnderlyingType position = 0;
+    for ( auto line = 0u; line < NumberOfLines; ++line ) {
+        const auto length
+            = random() % 1000 == 0 ? 20'000 + random() % 50'000 : 20 + random() % 200;
+        position += static_cast<OffsetInFile::UnderlyingType>( length );
+        positions.push_back( OffsetInFile( position ) );
+    }
+    return positions;
+}
+
+klogg::vector<LineNumber> generateLookups()
+{
+    std::mt19937 random( 7 );
+
+    klogg::vector<LineNumber> lookups;
+    lookups.reserve( NumberOfLookups );
+    for ( auto i = 0u; i < NumberOfLookups; ++i ) {
+        lookups.push_back( LineNumber( random() % ( NumberOfLines - PageSize.get() ) ) );
+    }
+    return lookups;
+}
+
+template <typename Storage>
+void fill( Storage& storage, const klogg::vector<OffsetInFile>& positions )
+{
+    for ( const auto& position : positions ) {
+        storage.append( position );
+    }
+}
+
+template <typename Storage>
+void benchmarkStorage( const std::string& name, const klogg::vector<OffsetInFile>& positions,
+                       const klogg::vector<LineNumber>& lookups )
+{
+    BENCHMARK( name + "/append" )
+    {
+        Storage storage;
+        fill( storage, positions );
+        return storage.size();
+    };
+
+    Storage storage;
+    fill( storage, positions );
+
+    BENCHMARK( name + "/at sequential" )
+    {
+        OffsetInFile::UnderlyingType sum = 0;
+        for ( auto line = 0u; line < NumberOfLookups; ++line ) {
+            sum += storage.at( LineNumber( line ) ).get();
+        }
+        return sum;
+    };
+
+    BENCHMARK( name + "/at random" )
+    {
+        OffsetInFile::UnderlyingType sum = 0;
+        for ( const auto& line : lookups ) {
+            sum += storage.at( line ).get();
+        }
+        return sum;
+    };
+
+    BENCHMARK( name + "/range random" )
+    {
+        OffsetInFile::UnderlyingType sum = 0;
+        for ( const auto& line : lookups ) {
+            sum += storage.range( line, PageSize ).back().get();
+        }
+        return sum;
+    };
+}
+
+} // namespace
+
+TEST_CASE( "Line positions storage", "[linepositions]" )
+{
+    const auto positions = generatePositions();
+    const auto lookups = generateLookups();
+
+    benchmarkStorage<CompressedLinePositionStorage>( "compressed", positions, lookups );
+    benchmarkStorage<SimpleLinePositionStorage>( "simple", positions, lookups );
+}
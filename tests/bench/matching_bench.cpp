@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <variant>
+
+#include "booleanevaluator.h"
+#include "hsregularexpression.h"
+
+#include "microbench.h"
+
+namespace {
+
+const LogData::RawLines& rawLines()
+{
+    static const auto lines = [] {
+        CorpusOptions options;
+        options.sizeBytes = microbench::BlockSize;
+        return microbench::makeRawLines( generateCorpus( options ),
+                                         QTextCodec::codecForName( "UTF-8" ) );
+    }();
+    return lines;
+}
+
+template <typename Matcher>
+uint64_t countMatchingLines( const Matcher& matcher, const klogg::vector<std::string_view>& lines )
+{
+    uint64_t matchingLines = 0;
+    for ( const auto& line : lines ) {
+        const auto matchedPatterns = matcher.match( line );
+        if ( matchedPatterns.find_first_not_of( '\0' ) != MatchedPatterns::npos ) {
+            ++matchingLines;
+        }
+    }
+    return matchingLines;
+}
+
+void benchmarkMatcher( const std::string& name,
+                       const klogg::vector<RegularExpressionPattern>& patterns )
+{
+    const auto lines = rawLines().buildUtf8View();
+
+    HsRegularExpression regularExpression( patterns );
+    REQUIRE( regularExpression.isValid() );
+
+    const auto matcher = regularExpression.createMatcher();
+    BENCHMARK( name )
+    {
+        return std::visit(
+            [ &lines ]( const auto& m ) { return countMatchingLines( m, lines ); }, matcher );
+    };
+}
+
+} // namespace
+
+TEST_CASE( "Matchers", "[matching]" )
+{
+    const RegularExpressionPattern plainText( "timeout", true, false, false, true );
+    const RegularExpressionPattern regex( "id=\\d+7\\b" );
+    const RegularExpressionPattern caseInsensitive( "Retry.*LATENCY", false, false, false,
+                                                    false );
+    // Backreferences are only supported by hyperscan in prefilter mode
+    const RegularExpressionPattern backReference( "(\\w+) \\1" );
+
+    SECTION( "Default" )
+    {
+        const auto lines = rawLines().buildUtf8View();
+        const DefaultRegularExpressionMatcher matcher( { regex } );
+
+        BENCHMARK( "default/regex" )
+        {
+            return countMatchingLines( matcher, lines );
+        };
+    }
+
+    // Without hyperscan these are default matchers as well
+    SECTION( "Hyperscan" )
+    {
+        benchmarkMatcher( "hs single/plain text", { plainText } );
+        benchmarkMatcher( "hs single/regex", { regex } );
+        benchmarkMatcher( "hs multi/3 patterns", { plainText, regex, caseInsensitive } );
+        benchmarkMatcher( "hs prefilter/back reference", { backReference } );
+    }
+}
+
+TEST_CASE( "Boolean expression evaluator", "[matching]" )
+{
+    const klogg::vector<RegularExpressionPattern> patterns
+        = { RegularExpressionPattern( "ERROR" ), RegularExpressionPattern( "billing" ),
+            RegularExpressionPattern( "retry" ), RegularExpressionPattern( "timeout" ),
+            RegularExpressionPattern( "token" ) };
+
+    // All the combinations of matched patterns, in an order the branch
+    // predictor can't learn
+    auto makeVariables = []( std::size_t numberOfPatterns ) {
+        klogg::vector<MatchedPatterns> variables;
+        const auto combinations = 1u << numberOfPatterns;
+        for ( auto i = 0u; i < combinations; ++i ) {
+            const auto combination = ( i * 7919u ) % combinations;
+            MatchedPatterns matched( numberOfPatterns, '\0' );
+            for ( auto p = 0u; p < numberOfPatterns; ++p ) {
+                matched[ p ] = static_cast<char>( ( combination >> p ) & 1u );
+            }
+            variables.push_back( matched );
+        }
+        return variables;
+    };
+
+    auto benchmarkExpression = [ &patterns ]( const std::string& name, std::size_t numberOfPatterns,
+                                              const std::string& expression,
+                                              const klogg::vector<MatchedPatterns>& variables ) {
+        const klogg::vector<RegularExpressionPattern> usedPatterns(
+            patterns.begin(), patterns.begin() + static_cast<std::ptrdiff_t>( numberOfPatterns ) );
+
+        BooleanExpressionEvaluator evaluator( expression, usedPatterns );
+        REQUIRE( evaluator.isValid() );
+
+        BENCHMARK( name )
+        {
+            uint64_t matches = 0;
+            for ( auto i = 0; i < 100; ++i ) {
+                for ( const auto& matched : variables ) {
+                    matches += evaluator.evaluate( matched );
+                }
+            }
+            return matches;
+        };
+    };
+
+    const auto id = [ &patterns ]( std::size_t index ) { return patterns[ index ].id(); };
+
+    // Up to 4 patterns the results of all combinations are precomputed
+    benchmarkExpression( "boolean/precomputed", 3,
+                         id( 0 ) + " and ( " + id( 1 ) + " or not( " + id( 2 ) + " ) )",
+                         makeVariables( 3 ) );
+    benchmarkExpression( "boolean/evaluated", 5,
+                         id( 0 ) + " and ( " + id( 1 ) + " or not( " + id( 2 ) + " ) ) or ( "
+                             + id( 3 ) + " and " + id( 4 ) + " )",
+                         makeVariables( 5 ) );
+}
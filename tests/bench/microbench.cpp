@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "microbench.h"
+
+#include "encodingdetector.h"
+#include "logdataworker.h"
+
+namespace microbench {
+
+LogData::RawLines makeRawLines( const QByteArray& data, QTextCodec* codec )
+{
+    LogData::RawLines rawLines;
+    rawLines.startLine = 0_lnum;
+    rawLines.buffer.assign( data.begin(), data.end() );
+
+    IndexingState state;
+    state.encodingParams = EncodingParameters( codec );
+    const auto linePositions = IndexOperation::parseDataBlock( 0, rawLines.buffer, state );
+
+    rawLines.endOfLines.reserve( linePositions.size().get() );
+    for ( auto line = 0u; line < linePositions.size().get(); ++line ) {
+        rawLines.endOfLines.push_back( linePositions.at( line ).get() );
+    }
+
+    rawLines.textDecoder = TextCodecHolder( codec ).makeDecoder();
+    return rawLines;
+}
+
+} // namespace microbench
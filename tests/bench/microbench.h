@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KLOGG_MICROBENCH_H
+#define KLOGG_MICROBENCH_H
+
+#include <QTextCodec>
+
+#include "benchcorpus.h"
+#include "logdata.h"
+
+namespace microbench {
+
+// Size of the blocks read from the file when indexing and searching
+constexpr qint64 BlockSize = 1024 * 1024;
+
+// Returns the lines of data as read by LogData::getLinesRaw,
+// data must end with a line feed.
+LogData::RawLines makeRawLines( const QByteArray& data, QTextCodec* codec );
+
+} // namespace microbench
+
+#endif
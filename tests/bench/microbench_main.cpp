@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// klogg_microbench measures the kernels and data structures the main data
+// paths are built on. Inputs are generated in-process from fixed seeds so
+// results of different machines are comparable.
+//   klogg_microbench                   run all benchmarks
+//   klogg_microbench "[matching]"      run the benchmarks of a group
+//   klogg_microbench --benchmark-samples 20 --reporter xml
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+#include <QCoreApplication>
+
+#include <persistentinfo.h>
+
+const bool PersistentInfo::ForcePortable = true;
+
+int main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+
+    return Catch::Session().run( argc, argv );
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <random>
+
+#include "searchresultscursor.h"
+
+namespace {
+
+constexpr uint64_t NumberOfQueries = 10'000;
+
+// Matches of a search on a 100M lines file, with dense and sparse regions
+SearchResultArray generateResults()
+{
+    std::mt19937_64 random( 42 );
+
+    SearchResultArray results;
+    uint64_t line = 0;
+    while ( line < 100'000'000 ) {
+        if ( random() % 100 == 0 ) {
+            results.addRange( line, line + 10'000 );
+            line += 10'000;
+        }
+        line += 1 + random() % 200;
+        results.add( line );
+    }
+    results.runOptimize();
+    return results;
+}
+
+} // namespace
+
+TEST_CASE( "Search results", "[results]" )
+{
+    const auto results = generateResults();
+    const auto cardinality = results.cardinality();
+    const auto maximum = results.maximum();
+
+    std::mt19937_64 random( 7 );
+    klogg::vector<uint64_t> randomRanks;
+    klogg::vector<uint64_t> randomLines;
+    for ( auto i = 0u; i < NumberOfQueries; ++i ) {
+        randomRanks.push_back( random() % cardinality );
+        randomLines.push_back( random() % maximum );
+    }
+
+    BENCHMARK( "bitmap/select random" )
+    {
+        uint64_t sum = 0;
+        for ( const auto rank : randomRanks ) {
+            uint64_t line = 0;
+            results.select( rank, &line );
+            sum += line;
+        }
+        return sum;
+    };
+
+    BENCHMARK( "bitmap/rank random" )
+    {
+        uint64_t sum = 0;
+        for ( const auto line : randomLines ) {
+            sum += results.rank( line );
+        }
+        return sum;
+    };
+
+    // Scrolling the filtered view one line at a time
+    BENCHMARK( "bitmap/select sequential" )
+    {
+        uint64_t sum = 0;
+        for ( auto rank = cardinality / 2; rank < cardinality / 2 + NumberOfQueries; ++rank ) {
+            uint64_t line = 0;
+            results.select( rank, &line );
+            sum += line;
+        }
+        return sum;
+    };
+
+    BENCHMARK( "cursor/select random" )
+    {
+        SearchResultsCursor cursor;
+        uint64_t sum = 0;
+        for ( const auto rank : randomRanks ) {
+            uint64_t line = 0;
+            cursor.select( results, rank, &line );
+            sum += line;
+        }
+        return sum;
+    };
+
+    BENCHMARK( "cursor/rank random" )
+    {
+        SearchResultsCursor cursor;
+        uint64_t sum = 0;
+        for ( const auto line : randomLines ) {
+            sum += cursor.rank( results, line );
+        }
+        return sum;
+    };
+
+    BENCHMARK( "cursor/select sequential" )
+    {
+        SearchResultsCursor cursor;
+        uint64_t sum = 0;
+        for ( auto rank = cardinality / 2; rank < cardinality / 2 + NumberOfQueries; ++rank ) {
+            uint64_t line = 0;
+            cursor.select( results, rank, &line );
+            sum += line;
+        }
+        return sum;
+    };
+}
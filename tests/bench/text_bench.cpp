@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include "wrappedstring.h"
+
+#include "microbench.h"
+
+TEST_CASE( "Untabified length", "[text]" )
+{
+    for ( const auto tabs : { false, true } ) {
+        CorpusOptions options;
+        options.sizeBytes = microbench::BlockSize;
+        options.tabs = tabs;
+
+        const auto rawLines = microbench::makeRawLines( generateCorpus( options ),
+                                                        QTextCodec::codecForName( "UTF-8" ) );
+        const auto lines = rawLines.buildUtf8View();
+
+        BENCHMARK( std::string{ "untabified length/" } + ( tabs ? "tabs" : "spaces" ) )
+        {
+            LineLength::UnderlyingType totalLength = 0;
+            for ( const auto& line : lines ) {
+                totalLength += getUntabifiedLength( line ).get();
+            }
+            return totalLength;
+        };
+    }
+}
+
+TEST_CASE( "Wrapped string", "[text]" )
+{
+    CorpusOptions options;
+    options.sizeBytes = microbench::BlockSize;
+    options.longLineLength = 10'000;
+
+    const auto rawLines = microbench::makeRawLines( generateCorpus( options ),
+                                                    QTextCodec::codecForName( "UTF-8" ) );
+    const auto lines = rawLines.decodeLines();
+    const auto visibleColumns = 120_length;
+
+    BENCHMARK( "wrapped string/wrap" )
+    {
+        std::size_t wrappedLines = 0;
+        for ( const auto& line : lines ) {
+            wrappedLines += WrappedString( line, visibleColumns ).wrappedLinesCount();
+        }
+        return wrappedLines;
+    };
+
+    klogg::vector<WrappedString> wrappedStrings;
+    wrappedStrings.reserve( lines.size() );
+    for ( const auto& line : lines ) {
+        wrappedStrings.emplace_back( line, visibleColumns );
+    }
+
+    // A match highlighted in the middle of the line
+    BENCHMARK( "wrapped string/mid" )
+    {
+        std::size_t chunks = 0;
+        for ( const auto& wrappedString : wrappedStrings ) {
+            chunks += wrappedString.mid( 5000_lcol, 500_length ).size();
+        }
+        return chunks;
+    };
+}
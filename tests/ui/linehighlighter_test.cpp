@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <QFileInfo>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+
+#include "test_utils.h"
+
+#include "highlighterset.h"
+#include "linehighlighter.h"
+#include "logdata.h"
+
+namespace {
+// A set with a single highlighter coloring the lines it matches
+HighlighterSet lineHighlighterSet( const QTemporaryDir& dir, const QString& pattern )
+{
+    QSettings settings( dir.filePath( "highlighters.ini" ), QSettings::IniFormat );
+    settings.beginGroup( "HighlighterSet" );
+    settings.setValue( "version", 3 );
+    settings.setValue( "name", "long lines" );
+    settings.beginWriteArray( "highlighters" );
+    settings.setArrayIndex( 0 );
+    settings.setValue( "regexp", pattern );
+    settings.setValue( "match_only", false );
+    settings.setValue( "fore_colour", "white" );
+    settings.setValue( "back_colour", "red" );
+    settings.endArray();
+    settings.endGroup();
+
+    auto highlighterSet = HighlighterSet::createNewSet( "long lines" );
+    highlighterSet.retrieveFromStorage( settings );
+    highlighterSet.compile();
+    return highlighterSet;
+}
+} // namespace
+
+SCENARIO( "Colors of long lines read by windows", "[linehighlighter]" )
+{
+    QTemporaryDir dir;
+    REQUIRE( dir.isValid() );
+
+    QTemporaryFile file{ "linehighlighter_test_XXXXXX" };
+    REQUIRE( file.open() );
+
+    QByteArray longLine = "ERROR ";
+    while ( longLine.size() < 3 * 1024 * 1024 ) {
+        longLine.append( QByteArray( "some details, " ).repeated( 1024 ) );
+    }
+
+    file.write( "INFO short line\n" );
+    file.write( longLine );
+    file.write( "\n" );
+    file.flush();
+
+    LogData logData;
+    SafeQSignalSpy finishedSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( QFileInfo{ file }.absoluteFilePath() );
+    REQUIRE( finishedSpy.safeWait() );
+    REQUIRE( logData.isLongLine( 1_lnum ) );
+
+    const auto highlighterSet = lineHighlighterSet( dir, "^ERROR" );
+    LineHighlighter lineHighlighter;
+
+    THEN( "A window away from the start of the line doesn't tell its colors" )
+    {
+        const auto window = logData.getExpandedLineWindow( 1_lnum, 100000_lcol, 300_length );
+        REQUIRE_FALSE(
+            lineHighlighter.highlight( window, highlighterSet, ViewHighlighters{} ).lineColors );
+    }
+
+    THEN( "The colors of the whole line are matched on the full line" )
+    {
+        const auto lineColors
+            = lineHighlighter.lineColors( logData.getLineString( 1_lnum ), highlighterSet );
+        REQUIRE( lineColors );
+        REQUIRE( lineColors->first == QColor( "white" ) );
+        REQUIRE( lineColors->second == QColor( "red" ) );
+
+        REQUIRE_FALSE(
+            lineHighlighter.lineColors( logData.getLineString( 0_lnum ), highlighterSet ) );
+    }
+}
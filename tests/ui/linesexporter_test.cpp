@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <QTemporaryFile>
+#include <QTimer>
+
+#include "test_utils.h"
+
+#include "linesexporter.h"
+#include "logdata.h"
+#include "logfiltereddata.h"
+
+namespace {
+constexpr int NbLines = 300;
+
+// Lines of the file with their line endings, which vary from line to line
+QList<QByteArray> makeLines()
+{
+    QList<QByteArray> lines;
+    for ( int i = 0; i < NbLines; ++i ) {
+        auto line = QByteArray( "export test\tline " ) + QByteArray::number( i );
+        if ( i % 7 == 0 ) {
+            line.append( " match" );
+        }
+        if ( i != NbLines - 1 ) {
+            line.append( i % 3 == 0 ? "\r\n" : "\n" );
+        }
+        lines.append( line );
+    }
+    return lines;
+}
+
+QByteArray exportLines( const AbstractLogData& logData, LineNumber first, LinesCount number )
+{
+    QTemporaryFile destination{ "linesexporter_out_XXXXXX" };
+    REQUIRE( destination.open() );
+
+    int lastProgress = 0;
+    AtomicFlag interruptRequest;
+    const LinesExporter exporter( logData, first, number );
+    REQUIRE( exporter.isSupported() );
+    REQUIRE( exporter.exportTo( destination, interruptRequest,
+                                [ &lastProgress ]( int percent ) { lastProgress = percent; } )
+             == LinesExporter::Result::Done );
+    REQUIRE( lastProgress == 100 );
+
+    destination.seek( 0 );
+    return destination.readAll();
+}
+} // namespace
+
+SCENARIO( "Exporting lines as they are in the file", "[linesexporter]" )
+{
+    const auto lines = makeLines();
+
+    QTemporaryFile file{ "linesexporter_test_XXXXXX" };
+    REQUIRE( file.open() );
+    for ( const auto& line : lines ) {
+        file.write( line );
+    }
+    file.flush();
+
+    LogData logData;
+    SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( file.fileName() );
+    REQUIRE( loadEndSpy.safeWait( 10000 ) );
+    REQUIRE( logData.getNbLine() == LinesCount( NbLines ) );
+
+    GIVEN( "All the lines of the file" )
+    {
+        THEN( "The copy is identical to the file" )
+        {
+            REQUIRE( exportLines( logData, 0_lnum, logData.getNbLine() ) == lines.join() );
+        }
+    }
+
+    GIVEN( "A range of lines" )
+    {
+        THEN( "The lines keep their line endings" )
+        {
+            REQUIRE( exportLines( logData, 10_lnum, 20_lcount )
+                     == lines.mid( 10, 20 ).join() );
+        }
+    }
+
+    GIVEN( "The lines of a search" )
+    {
+        auto filteredData = logData.getNewFilteredData();
+        SafeQSignalSpy searchProgressSpy{ filteredData.get(), &LogFilteredData::searchProgressed };
+        QTimer::singleShot(
+            50, [ & ]() { filteredData->runSearch( RegularExpressionPattern( "match" ) ); } );
+
+        int progress = 0;
+        do {
+            REQUIRE( searchProgressSpy.wait() );
+            progress = searchProgressSpy.last().at( 1 ).toInt();
+        } while ( progress < 100 );
+
+        THEN( "Only the matching lines are written" )
+        {
+            QByteArray expected;
+            for ( int i = 0; i < NbLines; i += 7 ) {
+                expected.append( lines.at( i ) );
+            }
+
+            REQUIRE( exportLines( *filteredData, 0_lnum, filteredData->getNbLine() )
+                     == expected );
+        }
+
+        THEN( "A range of the matching lines is written" )
+        {
+            REQUIRE( exportLines( *filteredData, 2_lnum, 3_lcount )
+                     == lines.at( 14 ) + lines.at( 21 ) + lines.at( 28 ) );
+        }
+
+        THEN( "The lines written are the ones matched when the export was created" )
+        {
+            QByteArray expected;
+            for ( int i = 0; i < NbLines; i += 7 ) {
+                expected.append( lines.at( i ) );
+            }
+
+            const LinesExporter exporter( *filteredData, 0_lnum, filteredData->getNbLine() );
+            filteredData->clearSearch();
+            filteredData->addMark( 1_lnum );
+            filteredData->addMark( 2_lnum );
+
+            QTemporaryFile destination{ "linesexporter_out_XXXXXX" };
+            REQUIRE( destination.open() );
+            AtomicFlag interruptRequest;
+            REQUIRE( exporter.exportTo( destination, interruptRequest, {} )
+                     == LinesExporter::Result::Done );
+
+            destination.seek( 0 );
+            REQUIRE( destination.readAll() == expected );
+        }
+    }
+
+    GIVEN( "A prefilter" )
+    {
+        logData.setPrefilter( "line" );
+
+        THEN( "The lines can't be copied as they are" )
+        {
+            REQUIRE_FALSE( LinesExporter( logData, 0_lnum, 10_lcount ).isSupported() );
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+
+#include <QTemporaryFile>
+#include <QTest>
+
+#include "test_utils.h"
+
+#include "highlighterset.h"
+#include "linehighlighter.h"
+#include "linesprefetcher.h"
+#include "logdata.h"
+
+namespace {
+constexpr int NbLines = 1000;
+
+void generateDataFile( QTemporaryFile& file )
+{
+    REQUIRE( file.open() );
+    for ( int i = 0; i < NbLines; i++ ) {
+        file.write(
+            QString( "prefetch test, line %1\n" ).arg( i, 6, 10, QChar( '0' ) ).toLatin1() );
+    }
+    file.flush();
+}
+
+bool waitForLines( const LinesPrefetcher& prefetcher, LineNumber firstLine, LinesCount nbLines,
+                   uint64_t generation, klogg::vector<LinesPrefetcher::PrefetchedLine>& lines )
+{
+    for ( int i = 0; i < 100; ++i ) {
+        if ( prefetcher.getLines( firstLine, nbLines, generation, lines ) ) {
+            return true;
+        }
+        QTest::qWait( 100 );
+    }
+    return false;
+}
+} // namespace
+
+SCENARIO( "Prefetching lines while scrolling", "[prefetch]" )
+{
+    QTemporaryFile file{ "prefetch_test_XXXXXX" };
+    generateDataFile( file );
+
+    LogData logData;
+    SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( file.fileName() );
+    REQUIRE( loadEndSpy.safeWait( 10000 ) );
+
+    auto highlighterSet = HighlighterSet::createNewSet( "prefetch" );
+    highlighterSet.compile();
+    const auto viewHighlighters = std::make_shared<const ViewHighlighters>();
+
+    LinesPrefetcher prefetcher( logData );
+    klogg::vector<LinesPrefetcher::PrefetchedLine> lines;
+
+    GIVEN( "A view scrolling down" )
+    {
+        prefetcher.viewMoved( 100_lnum, 50_lcount, 1, highlighterSet, viewHighlighters );
+        prefetcher.viewMoved( 110_lnum, 50_lcount, 1, highlighterSet, viewHighlighters );
+
+        THEN( "The lines of the next screen are prefetched" )
+        {
+            REQUIRE( waitForLines( prefetcher, 160_lnum, 50_lcount, 1, lines ) );
+            REQUIRE( lines.size() == 50 );
+            REQUIRE( lines.front().text == "prefetch test, line 000160" );
+            REQUIRE( lines.back().text == "prefetch test, line 000209" );
+        }
+
+        THEN( "Lines of another generation are not returned" )
+        {
+            REQUIRE( waitForLines( prefetcher, 110_lnum, 50_lcount, 1, lines ) );
+            REQUIRE_FALSE( prefetcher.getLines( 110_lnum, 50_lcount, 2, lines ) );
+        }
+
+        THEN( "Invalidated lines are not returned" )
+        {
+            REQUIRE( waitForLines( prefetcher, 110_lnum, 50_lcount, 1, lines ) );
+            prefetcher.invalidate();
+            REQUIRE_FALSE( prefetcher.getLines( 110_lnum, 50_lcount, 1, lines ) );
+        }
+    }
+
+    GIVEN( "A view scrolling up" )
+    {
+        prefetcher.viewMoved( 500_lnum, 50_lcount, 1, highlighterSet, viewHighlighters );
+        prefetcher.viewMoved( 490_lnum, 50_lcount, 1, highlighterSet, viewHighlighters );
+
+        THEN( "The lines of the previous screen are prefetched" )
+        {
+            REQUIRE( waitForLines( prefetcher, 440_lnum, 50_lcount, 1, lines ) );
+            REQUIRE( lines.front().text == "prefetch test, line 000440" );
+        }
+    }
+}
@@ -133,6 +133,44 @@ TEST_CASE( "Logdata decoding lines", "[logdata]" )
     REQUIRE( rawLines.endOfLines.size() == utf8View.size() );
 }
 
+TEST_CASE( "Logdata reading windows of long lines", "[logdata]" )
+{
+    QTemporaryFile file{ "testlonglines_XXXXXX" };
+    REQUIRE( file.open() );
+
+    const QString longLinePart = QString::fromUtf8( "{\"k\u00e9y\":\t\"v\u00e2lue\"}," );
+    QString longLine;
+    while ( longLine.toUtf8().size() < 3 * 1024 * 1024 ) {
+        longLine.append( longLinePart.repeated( 1024 ) );
+    }
+
+    file.write( "short line\n" );
+    file.write( longLine.toUtf8() );
+    file.write( "\nlast line\n" );
+    file.flush();
+
+    LogData logData;
+    SafeQSignalSpy finishedSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( QFileInfo{ file }.absoluteFilePath() );
+    REQUIRE( finishedSpy.safeWait() );
+    REQUIRE( logData.getNbLine() == 3_lcount );
+
+    REQUIRE_FALSE( logData.isLongLine( 0_lnum ) );
+    REQUIRE( logData.isLongLine( 1_lnum ) );
+
+    const auto expandedLine = logData.getExpandedLineString( 1_lnum );
+    REQUIRE( logData.getLineLength( 1_lnum ) == LineLength{ expandedLine.size() } );
+
+    // Around the checkpoints, in the middle of multibyte characters and tabs, and at the end
+    const auto lastColumn = LineColumn{ expandedLine.size() - 10 };
+    for ( const auto column : { 0_lcol, 17_lcol, 65530_lcol, 1000003_lcol, lastColumn } ) {
+        const auto window = logData.getExpandedLineWindow( 1_lnum, column, 300_length );
+        REQUIRE( window == expandedLine.mid( column.get(), 300 ) );
+    }
+
+    REQUIRE( logData.getExpandedLineWindow( 0_lnum, 6_lcol, 4_length ) == "line" );
+}
+
 TEST_CASE( "Logdata reading changing file", "[logdata]" )
 {
 
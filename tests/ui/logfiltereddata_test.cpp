@@ -25,6 +25,9 @@
 #include <QTimer>
 #include <qglobal.h>
 
+#include <atomic>
+#include <thread>
+
 #include "configuration.h"
 #include "log.h"
 #include "test_utils.h"
@@ -254,6 +257,346 @@ SCENARIO( "search for regex", "[logdata]" )
     }
 }
 
+SCENARIO( "reading lines from filtered log data", "[logdata]" )
+{
+    LogDataLoader logDataLoader;
+
+    GIVEN( "filtered log data with both nearby and distant matches" )
+    {
+        auto filtered_data = logDataLoader.log_data.getNewFilteredData();
+        SafeQSignalSpy searchProgressSpy{ filtered_data.get(),
+                                          &LogFilteredData::searchProgressed };
+
+        runSearch( filtered_data.get(), "this is line (0000[0-9]|000[0-9]00)$",
+                   searchProgressSpy );
+        REQUIRE( filtered_data->getNbMatches() == 14_lcount );
+
+        WHEN( "Getting several lines at once" )
+        {
+            const auto lines = filtered_data->getLines( 2_lnum, 12_lcount );
+            const auto expandedLines = filtered_data->getExpandedLines( 2_lnum, 12_lcount );
+
+            THEN( "They are the same as the lines got one by one" )
+            {
+                REQUIRE( lines.size() == 12 );
+                REQUIRE( expandedLines.size() == 12 );
+                for ( auto i = 0u; i < lines.size(); ++i ) {
+                    const auto index = LineNumber( 2 + i );
+                    REQUIRE( lines[ i ] == filtered_data->getLineString( index ) );
+                    REQUIRE( expandedLines[ i ]
+                             == filtered_data->getExpandedLineString( index ) );
+                }
+                REQUIRE( lines.back().endsWith( "line 000400" ) );
+            }
+        }
+
+        WHEN( "Getting more lines than matched" )
+        {
+            const auto lines = filtered_data->getLines( 10_lnum, 10_lcount );
+
+            THEN( "The missing lines are empty" )
+            {
+                REQUIRE( lines.size() == 10 );
+                REQUIRE( lines[ 2 ].endsWith( "line 000300" ) );
+                REQUIRE( lines[ 3 ].endsWith( "line 000400" ) );
+                REQUIRE( lines[ 4 ].isEmpty() );
+            }
+        }
+
+        WHEN( "Reading lines in another thread while marks are changed" )
+        {
+            AtomicFlag stopReading;
+            std::atomic<int> nbBadLines{ 0 };
+            std::thread reader( [ & ] {
+                while ( !stopReading ) {
+                    const auto nbLines = filtered_data->getNbLine();
+                    for ( const auto& line : filtered_data->getLines( 0_lnum, nbLines ) ) {
+                        // Lines removed since the count was read are empty
+                        if ( !line.isEmpty() && !line.startsWith( "LOGDATA" ) ) {
+                            ++nbBadLines;
+                        }
+                    }
+                }
+            } );
+
+            for ( auto i = 0; i < 20; ++i ) {
+                for ( auto line = 100_lnum; line < 300_lnum; line = line + 7_lcount ) {
+                    filtered_data->toggleMark( line );
+                }
+                filtered_data->setVisibility(
+                    i % 2 == 0 ? LogFilteredData::Visibility( VisibilityFlags::Marks )
+                               : VisibilityFlags::Marks | VisibilityFlags::Matches );
+            }
+
+            stopReading.set();
+            reader.join();
+
+            THEN( "The lines read are always lines of the file" )
+            {
+                REQUIRE( nbBadLines == 0 );
+                REQUIRE( filtered_data->getNbMarks() == 0_lcount );
+            }
+        }
+    }
+}
+
+SCENARIO( "concurrent searches in the same log data", "[logdata]" )
+{
+    LogDataLoader logDataLoader;
+
+    GIVEN( "loaded log data and two filtered views" )
+    {
+        auto& config = Configuration::getSynced();
+        config.setSearchReadBufferSizeLines( 30 );
+
+        auto first_data = logDataLoader.log_data.getNewFilteredData();
+        auto second_data = logDataLoader.log_data.getNewFilteredData();
+
+        WHEN( "Both searches run at the same time" )
+        {
+            SafeQSignalSpy firstProgressSpy{ first_data.get(),
+                                             &LogFilteredData::searchProgressed };
+            SafeQSignalSpy secondProgressSpy{ second_data.get(),
+                                              &LogFilteredData::searchProgressed };
+
+            first_data->runSearch( RegularExpressionPattern( "this is line [0-9]{5}9" ) );
+            second_data->runSearch( RegularExpressionPattern( "this is line [0-9]{4}17" ) );
+
+            const auto isSearchDone = []( const SafeQSignalSpy& spy ) {
+                return !spy.isEmpty() && spy.last().at( 1 ).toInt() == 100;
+            };
+
+            REQUIRE( waitUiState( [ & ]() {
+                return isSearchDone( firstProgressSpy ) && isSearchDone( secondProgressSpy );
+            } ) );
+
+            THEN( "Each view gets its own matches" )
+            {
+                REQUIRE( first_data->getNbMatches() == 50_lcount );
+                REQUIRE( second_data->getNbMatches() == 5_lcount );
+
+                const auto lines = second_data->getExpandedLines( 0_lnum, 5_lcount );
+                for ( const auto& l : lines ) {
+                    REQUIRE( l.endsWith( "17" ) );
+                }
+            }
+        }
+
+        config.setSearchReadBufferSizeLines( Configuration{}.searchReadBufferSizeLines() );
+    }
+}
+
+SCENARIO( "search starting from a priority line", "[logdata]" )
+{
+    LogDataLoader logDataLoader;
+
+    GIVEN( "loaded log data" )
+    {
+        auto& config = Configuration::getSynced();
+        config.setSearchReadBufferSizeLines( 30 );
+
+        auto filtered_data = logDataLoader.log_data.getNewFilteredData();
+
+        WHEN( "Searching from the middle of the file" )
+        {
+            SafeQSignalSpy searchProgressSpy{ filtered_data.get(),
+                                              &LogFilteredData::searchProgressed };
+
+            filtered_data->runSearch( RegularExpressionPattern( "this is line [0-9]{5}9" ),
+                                      0_lnum, LineNumber( SL_NB_LINES ), 250_lnum );
+
+            REQUIRE( waitUiState( [ & ]() {
+                return !searchProgressSpy.isEmpty()
+                       && searchProgressSpy.last().at( 1 ).toInt() == 100;
+            } ) );
+
+            THEN( "All matches of the file are found" )
+            {
+                REQUIRE( filtered_data->getNbMatches() == 50_lcount );
+                REQUIRE( filtered_data->getMatchingLineNumber( 0_lnum ) == 9_lnum );
+                REQUIRE( filtered_data->getMatchingLineNumber( 49_lnum ) == 499_lnum );
+            }
+        }
+
+        config.setSearchReadBufferSizeLines( Configuration{}.searchReadBufferSizeLines() );
+    }
+}
+
+SCENARIO( "nested search in filtered log data", "[logdata]" )
+{
+    LogDataLoader logDataLoader;
+
+    GIVEN( "loaded log data and a nested filtered view" )
+    {
+        std::shared_ptr<LogFilteredData> parent_data
+            = logDataLoader.log_data.getNewFilteredData();
+        auto nested_data = logDataLoader.log_data.getNewNestedFilteredData( parent_data );
+
+        SafeQSignalSpy parentProgressSpy{ parent_data.get(), &LogFilteredData::searchProgressed };
+        SafeQSignalSpy nestedProgressSpy{ nested_data.get(), &LogFilteredData::searchProgressed };
+
+        runSearch( parent_data.get(), "this is line [0-9]{5}9", parentProgressSpy );
+
+        WHEN( "Searching in the parent's matches" )
+        {
+            runSearch( nested_data.get(), "this is line [0-9]{4}1", nestedProgressSpy );
+
+            THEN( "Only lines matched by the parent are found" )
+            {
+                REQUIRE( nested_data->getNbMatches() == 5_lcount );
+
+                const auto lines = nested_data->getExpandedLines( 0_lnum, 5_lcount );
+                for ( const auto& l : lines ) {
+                    REQUIRE( l.endsWith( "19" ) );
+                }
+            }
+
+            AND_WHEN( "The parent search is replaced" )
+            {
+                nestedProgressSpy.clear();
+                runSearch( parent_data.get(), "this is line [0-9]{5}7", parentProgressSpy );
+
+                THEN( "The nested search follows the new parent's matches" )
+                {
+                    REQUIRE( waitUiState( [ & ]() {
+                        return nested_data->getNbMatches() == 5_lcount
+                               && !nestedProgressSpy.isEmpty()
+                               && nestedProgressSpy.last().at( 1 ).toInt() == 100;
+                    } ) );
+
+                    const auto lines = nested_data->getExpandedLines( 0_lnum, 5_lcount );
+                    for ( const auto& l : lines ) {
+                        REQUIRE( l.endsWith( "17" ) );
+                    }
+                }
+            }
+
+            AND_WHEN( "The parent search is replaced by one with more matches" )
+            {
+                nestedProgressSpy.clear();
+                runSearch( parent_data.get(), "this is line [0-9]{5}[79]", parentProgressSpy );
+
+                THEN( "The nested results are the ones of a new nested search" )
+                {
+                    REQUIRE( waitUiState( [ & ]() {
+                        return nested_data->getNbMatches() == 10_lcount
+                               && nestedProgressSpy.size() > 1
+                               && nestedProgressSpy.last().at( 1 ).toInt() == 100;
+                    } ) );
+                    const auto lastProgress = nestedProgressSpy.last();
+                    REQUIRE( qvariant_cast<LinesCount>( lastProgress.at( 0 ) ) == 10_lcount );
+
+                    auto fresh_data
+                        = logDataLoader.log_data.getNewNestedFilteredData( parent_data );
+                    SafeQSignalSpy freshProgressSpy{ fresh_data.get(),
+                                                     &LogFilteredData::searchProgressed };
+                    runSearch( fresh_data.get(), "this is line [0-9]{4}1", freshProgressSpy );
+
+                    REQUIRE( fresh_data->getNbMatches() == nested_data->getNbMatches() );
+                    REQUIRE( fresh_data->getExpandedLines( 0_lnum, 10_lcount )
+                             == nested_data->getExpandedLines( 0_lnum, 10_lcount ) );
+                    for ( auto i = 0_lnum; i < 10_lnum; ++i ) {
+                        REQUIRE( nested_data->getMatchingLineNumber( i )
+                                 == fresh_data->getMatchingLineNumber( i ) );
+                    }
+                }
+            }
+
+            AND_WHEN( "The parent search is replaced by one without nested matches" )
+            {
+                nestedProgressSpy.clear();
+                runSearch( parent_data.get(), "this is line [0-9]{4}2[0-9]", parentProgressSpy );
+
+                THEN( "No previous match is kept" )
+                {
+                    REQUIRE( waitUiState( [ & ]() {
+                        return nestedProgressSpy.size() > 1
+                               && nestedProgressSpy.last().at( 1 ).toInt() == 100;
+                    } ) );
+                    const auto lastProgress = nestedProgressSpy.last();
+                    REQUIRE( qvariant_cast<LinesCount>( lastProgress.at( 0 ) ) == 0_lcount );
+                    REQUIRE( nested_data->getNbMatches() == 0_lcount );
+                    REQUIRE( nested_data->getNbLine() == 0_lcount );
+                }
+            }
+        }
+    }
+}
+
+SCENARIO( "bulk marks in filtered log data", "[logdata]" )
+{
+    LogDataLoader logDataLoader;
+
+    GIVEN( "filtered log data with matches" )
+    {
+        auto filtered_data = logDataLoader.log_data.getNewFilteredData();
+        SafeQSignalSpy searchProgressSpy{ filtered_data.get(),
+                                          &LogFilteredData::searchProgressed };
+
+        runSearch( filtered_data.get(), "this is line [0-9]{5}9", searchProgressSpy );
+        REQUIRE( filtered_data->getNbMatches() == 50_lcount );
+
+        WHEN( "Marking a range of lines" )
+        {
+            filtered_data->addMarks( 10_lnum, 20_lcount );
+
+            THEN( "All lines of the range are marked and shown with the matches" )
+            {
+                REQUIRE( filtered_data->getNbMarks() == 20_lcount );
+                REQUIRE( filtered_data->getNbLine() == 68_lcount );
+                REQUIRE( filtered_data->getMatchingLineNumber( 1_lnum ) == 10_lnum );
+                REQUIRE( filtered_data->getMarkAfter( 10_lnum ) == OptionalLineNumber( 11_lnum ) );
+            }
+
+            AND_WHEN( "Deleting some of the marks" )
+            {
+                filtered_data->deleteMarks( { 19_lnum, 20_lnum, 100_lnum } );
+
+                THEN( "Matched lines are still shown" )
+                {
+                    REQUIRE( filtered_data->getNbMarks() == 18_lcount );
+                    REQUIRE( filtered_data->getNbLine() == 67_lcount );
+                    REQUIRE( filtered_data->lineTypeByLine( 19_lnum ).testFlag(
+                        LineTypeFlags::Match ) );
+                }
+            }
+
+            AND_WHEN( "Clearing the marks" )
+            {
+                filtered_data->clearMarks();
+
+                THEN( "Only matched lines are shown" )
+                {
+                    REQUIRE( filtered_data->getNbMarks() == 0_lcount );
+                    REQUIRE( filtered_data->getNbLine() == 50_lcount );
+                }
+            }
+        }
+
+        WHEN( "Marking a list of lines, some outside the file" )
+        {
+            filtered_data->addMarks( { 9_lnum, 15_lnum, LineNumber( SL_NB_LINES + 10 ) } );
+
+            THEN( "Lines in the file are marked" )
+            {
+                REQUIRE( filtered_data->getNbMarks() == 2_lcount );
+                REQUIRE( filtered_data->getNbLine() == 51_lcount );
+            }
+
+            AND_WHEN( "Toggling a mark on a matched line" )
+            {
+                filtered_data->toggleMark( 9_lnum );
+
+                THEN( "The line is still shown as a match" )
+                {
+                    REQUIRE( filtered_data->getNbMarks() == 1_lcount );
+                    REQUIRE( filtered_data->getNbLine() == 51_lcount );
+                }
+            }
+        }
+    }
+}
+
 SCENARIO( "marks and matches in filtered log data", "[logdata]" )
 {
     LogDataLoader logDataLoader;
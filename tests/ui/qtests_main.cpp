@@ -22,12 +22,14 @@
 
 #include <QApplication>
 #include <QMetaType>
+#include <QTemporaryDir>
 #include <QtConcurrent>
 
 #include <configuration.h>
 #include <linetypes.h>
 #include <highlighterset.h>
 #include <persistentinfo.h>
+#include <searchresultscache.h>
 
 #include <logger.h>
 
@@ -82,6 +84,10 @@ int main( int argc, char* argv[] )
     config.setIndexReadBufferSizeMb( 1 );
     config.setUseSearchResultsCache( false );
 
+    // Search results are never saved to the user's cache directory
+    QTemporaryDir searchResultsRoot;
+    SearchResultsCache::setDefaultStorageRoot( searchResultsRoot.path() );
+
     auto higthlighters = HighlighterSetCollection::getSynced();
 
 #if defined( Q_OS_WIN ) || defined( Q_OS_MAC )
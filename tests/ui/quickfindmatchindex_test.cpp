@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+
+#include "test_utils.h"
+
+#include "logdata.h"
+#include "quickfindmatchindex.h"
+#include "quickfindpattern.h"
+
+namespace {
+constexpr int NbLines = 500;
+
+void writeLines( QTemporaryFile& file, int firstLine, int nbLines )
+{
+    for ( int i = firstLine; i < firstLine + nbLines; i++ ) {
+        file.write( QString( "quickfind index test, line %1\n" )
+                        .arg( i, 6, 10, QChar( '0' ) )
+                        .toLatin1() );
+    }
+    file.flush();
+}
+
+void generateDataFile( QTemporaryFile& file )
+{
+    REQUIRE( file.open() );
+    writeLines( file, 0, NbLines );
+}
+
+bool waitUntilReady( const QuickFindMatchIndex& index, const QuickFindMatcher& matcher )
+{
+    for ( int i = 0; i < 100 && !index.isReady( matcher ); ++i ) {
+        QTest::qWait( 100 );
+    }
+    return index.isReady( matcher );
+}
+} // namespace
+
+SCENARIO( "QuickFind match index", "[quickfind]" )
+{
+    QTemporaryFile file{ "quickfind_test_XXXXXX" };
+    generateDataFile( file );
+
+    LogData logData;
+    SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( file.fileName() );
+    REQUIRE( loadEndSpy.safeWait( 10000 ) );
+
+    QuickFindMatchIndex index( logData );
+    const QuickFindMatcher matcher( true, QRegularExpression( "line 0000[0-9]5" ) );
+
+    GIVEN( "An index built for a pattern" )
+    {
+        index.build( matcher );
+        REQUIRE( waitUntilReady( index, matcher ) );
+
+        THEN( "All matching lines are indexed" )
+        {
+            REQUIRE( index.nbMatches() == 10_lcount );
+        }
+
+        THEN( "Next and previous matches are found" )
+        {
+            REQUIRE( index.nextMatch( 5_lnum ) == OptionalLineNumber( 15_lnum ) );
+            REQUIRE( index.nextMatch( 0_lnum ) == OptionalLineNumber( 5_lnum ) );
+            REQUIRE_FALSE( index.nextMatch( 95_lnum ).has_value() );
+
+            REQUIRE( index.previousMatch( 20_lnum ) == OptionalLineNumber( 15_lnum ) );
+            REQUIRE( index.previousMatch( 15_lnum ) == OptionalLineNumber( 5_lnum ) );
+            REQUIRE_FALSE( index.previousMatch( 5_lnum ).has_value() );
+        }
+
+        THEN( "The position of a match is known" )
+        {
+            REQUIRE( index.matchPosition( 5_lnum ) == 1_lcount );
+            REQUIRE( index.matchPosition( 95_lnum ) == 10_lcount );
+        }
+
+        THEN( "The index is not ready for another pattern" )
+        {
+            REQUIRE_FALSE(
+                index.isReady( QuickFindMatcher( true, QRegularExpression( "line 0001" ) ) ) );
+        }
+
+        WHEN( "The index is invalidated" )
+        {
+            index.invalidate();
+
+            THEN( "It is not ready anymore" )
+            {
+                REQUIRE_FALSE( index.isReady( matcher ) );
+                REQUIRE( index.nbMatches() == 0_lcount );
+            }
+        }
+
+        WHEN( "The last lines are invalidated" )
+        {
+            index.invalidateFrom( 50_lnum );
+
+            THEN( "The matches before them are kept" )
+            {
+                REQUIRE_FALSE( index.isReady( matcher ) );
+                REQUIRE( index.indexedLines( matcher ) == 50_lcount );
+                REQUIRE( index.nbMatches() == 5_lcount );
+            }
+
+            AND_THEN( "They are indexed again by the next build" )
+            {
+                index.build( matcher );
+                REQUIRE( waitUntilReady( index, matcher ) );
+                REQUIRE( index.nbMatches() == 10_lcount );
+            }
+        }
+
+        WHEN( "Lines are appended to the file" )
+        {
+            // The first lines again, with 10 matches
+            writeLines( file, 0, 100 );
+            REQUIRE( waitUiState( [ &logData ] {
+                return logData.getNbLine() == LinesCount( NbLines + 100 );
+            } ) );
+
+            THEN( "The index is extended with their matches" )
+            {
+                REQUIRE( index.indexedLines( matcher ) == LinesCount( NbLines ) );
+                REQUIRE( index.nextMatch( 95_lnum ) == OptionalLineNumber{} );
+
+                index.build( matcher );
+                REQUIRE( waitUntilReady( index, matcher ) );
+                REQUIRE( index.nbMatches() == 20_lcount );
+                REQUIRE( index.nextMatch( 95_lnum ) == OptionalLineNumber( 505_lnum ) );
+            }
+        }
+    }
+}
+
+SCENARIO( "QuickFind line scanner", "[quickfind]" )
+{
+    GIVEN( "A case insensitive pattern" )
+    {
+        const QRegularExpression regexp( "error [0-9]+",
+                                         QRegularExpression::CaseInsensitiveOption );
+        const QuickFindLineScanner scanner( QuickFindMatcher( true, regexp ) );
+
+        THEN( "Lines are matched by the search engine" )
+        {
+            REQUIRE( scanner.isLineMatching( "some ERROR 42 happened" ) );
+            REQUIRE_FALSE( scanner.isLineMatching( "some warning 42 happened" ) );
+        }
+    }
+
+    GIVEN( "A pattern matching the spaces of an expanded tab" )
+    {
+        const QuickFindLineScanner scanner(
+            QuickFindMatcher( true, QRegularExpression( "a {7}b" ) ) );
+
+        THEN( "Lines with tabs are matched once expanded" )
+        {
+            REQUIRE( scanner.isLineMatching( "a\tb" ) );
+            REQUIRE_FALSE( scanner.isLineMatching( "a b" ) );
+        }
+    }
+
+    GIVEN( "Lines of a file with tabs, non ascii text and CRLF line endings" )
+    {
+        QTemporaryFile file{ "quickfind_scanner_test_XXXXXX" };
+        REQUIRE( file.open() );
+        for ( int i = 0; i < NbLines; i++ ) {
+            file.write( QString::fromUtf8( "d\xc3\xa9j\xc3\xa0 vu%1line %2\r\n" )
+                            .arg( i % 3 == 0 ? "\t" : " " )
+                            .arg( i, 6, 10, QChar( '0' ) )
+                            .toUtf8() );
+        }
+        file.flush();
+
+        LogData logData;
+        SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+        logData.attachFile( file.fileName() );
+        REQUIRE( loadEndSpy.safeWait( 10000 ) );
+
+        const QuickFindLineScanner scanner(
+            QuickFindMatcher( true, QRegularExpression( "vu\\s+line 0000[0-9]5$" ) ) );
+
+        klogg::vector<size_t> expectedMatches;
+        const auto lines = logData.getLines( 0_lnum, logData.getNbLine() );
+        for ( auto index = 0u; index < lines.size(); ++index ) {
+            if ( scanner.isLineMatching( lines[ index ] ) ) {
+                expectedMatches.push_back( index );
+            }
+        }
+
+        THEN( "Raw lines are matched as their decoded text" )
+        {
+            REQUIRE( expectedMatches.size() == 10 );
+
+            klogg::vector<size_t> matches;
+            scanner.scanLines( logData, 0_lnum, logData.getNbLine(), false,
+                               [ &matches ]( size_t index ) {
+                                   matches.push_back( index );
+                                   return true;
+                               } );
+            REQUIRE( matches == expectedMatches );
+        }
+
+        THEN( "Lines are scanned backward until asked to stop" )
+        {
+            klogg::vector<size_t> matches;
+            scanner.scanLines( logData, 0_lnum, logData.getNbLine(), true,
+                               [ &matches ]( size_t index ) {
+                                   matches.push_back( index );
+                                   return matches.size() < 2;
+                               } );
+            REQUIRE( matches
+                     == klogg::vector<size_t>{ expectedMatches[ 9 ], expectedMatches[ 8 ] } );
+        }
+    }
+}
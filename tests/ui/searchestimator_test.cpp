@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <cstdlib>
+#include <functional>
+#include <optional>
+
+#include <QTemporaryFile>
+
+#include "test_utils.h"
+
+#include "logdata.h"
+#include "searchestimator.h"
+
+namespace {
+constexpr int NbLines = 6400;
+
+// Parameters sampling 64 chunks of 10 lines from the 6400 lines file
+SearchEstimateParameters testParameters()
+{
+    SearchEstimateParameters parameters;
+    parameters.minLines = 0_lcount;
+    parameters.sampledFraction = 0.1;
+    parameters.nbStrata = 64;
+    parameters.seed = 42;
+    return parameters;
+}
+
+struct EstimatorFile {
+    EstimatorFile( int nbLines, const std::function<bool( int )>& isMatch )
+    {
+        REQUIRE( file.open() );
+        for ( int i = 0; i < nbLines; ++i ) {
+            file.write( QByteArray( "estimator test line " ) + QByteArray::number( i )
+                        + ( isMatch( i ) ? " match\n" : "\n" ) );
+        }
+        file.flush();
+
+        SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+        logData.attachFile( file.fileName() );
+        REQUIRE( loadEndSpy.safeWait( 10000 ) );
+        REQUIRE( logData.getNbLine() == LinesCount( static_cast<uint64_t>( nbLines ) ) );
+    }
+
+    std::optional<SearchEstimate>
+    estimate( const SearchEstimateParameters& parameters,
+              const AtomicFlag& interruptRequested = AtomicFlag{} ) const
+    {
+        return estimateMatches( logData, RegularExpressionPattern( "match" ), 0_lnum,
+                                LineNumber( logData.getNbLine().get() ), interruptRequested,
+                                parameters );
+    }
+
+    QTemporaryFile file{ "searchestimator_test_XXXXXX" };
+    LogData logData;
+};
+} // namespace
+
+SCENARIO( "Estimating the matches of small files", "[searchestimator]" )
+{
+    GIVEN( "An empty file" )
+    {
+        const EstimatorFile file( 0, []( int ) { return true; } );
+
+        THEN( "There is no estimate" )
+        {
+            REQUIRE_FALSE( file.estimate( testParameters() ).has_value() );
+        }
+    }
+
+    GIVEN( "A file with fewer lines than strata" )
+    {
+        const EstimatorFile file( 10, []( int ) { return true; } );
+
+        THEN( "There is no estimate" )
+        {
+            REQUIRE_FALSE( file.estimate( testParameters() ).has_value() );
+        }
+    }
+
+    GIVEN( "A file below the default minimum size" )
+    {
+        const EstimatorFile file( NbLines, []( int ) { return true; } );
+
+        THEN( "There is no estimate" )
+        {
+            REQUIRE_FALSE( file.estimate( SearchEstimateParameters{} ).has_value() );
+        }
+    }
+}
+
+SCENARIO( "Estimating the matches of a file", "[searchestimator]" )
+{
+    GIVEN( "A file with every tenth line matching" )
+    {
+        const EstimatorFile file( NbLines, []( int line ) { return line % 10 == 0; } );
+
+        WHEN( "Sampling chunks of ten lines" )
+        {
+            const auto estimate = file.estimate( testParameters() );
+
+            THEN( "The sample is extrapolated to the whole file" )
+            {
+                REQUIRE( estimate.has_value() );
+                REQUIRE( estimate->sampledLines == 640_lcount );
+                REQUIRE( estimate->estimate == 640_lcount );
+                REQUIRE( estimate->margin > 0_lcount );
+            }
+        }
+
+        WHEN( "Sampling less than a line per stratum" )
+        {
+            auto parameters = testParameters();
+            parameters.sampledFraction = 0.0;
+            const auto estimate = file.estimate( parameters );
+
+            THEN( "One line of each stratum is sampled" )
+            {
+                REQUIRE( estimate.has_value() );
+                REQUIRE( estimate->sampledLines == 64_lcount );
+            }
+        }
+
+        WHEN( "Sampling more than the whole stratum" )
+        {
+            auto parameters = testParameters();
+            parameters.sampledFraction = 2.0;
+            const auto estimate = file.estimate( parameters );
+
+            THEN( "The whole file is sampled and the estimate is exact" )
+            {
+                REQUIRE( estimate.has_value() );
+                REQUIRE( estimate->sampledLines == LinesCount( NbLines ) );
+                REQUIRE( estimate->estimate == 640_lcount );
+            }
+        }
+
+        WHEN( "The estimation is interrupted" )
+        {
+            AtomicFlag interruptRequested;
+            interruptRequested.set();
+
+            THEN( "There is no estimate" )
+            {
+                REQUIRE_FALSE( file.estimate( testParameters(), interruptRequested ).has_value() );
+            }
+        }
+    }
+
+    GIVEN( "A file with all the matches in its first half" )
+    {
+        const EstimatorFile file( NbLines, []( int line ) { return line < NbLines / 2; } );
+
+        THEN( "The exact count is within the margin of the estimate" )
+        {
+            const auto estimate = file.estimate( testParameters() );
+            REQUIRE( estimate.has_value() );
+
+            const auto exactCount = static_cast<int64_t>( NbLines / 2 );
+            const auto error = std::abs( static_cast<int64_t>( estimate->estimate.get() )
+                                         - exactCount );
+            REQUIRE( error <= static_cast<int64_t>( estimate->margin.get() ) );
+        }
+    }
+
+    GIVEN( "A file with irregularly spaced matches" )
+    {
+        const EstimatorFile file( NbLines, []( int line ) { return ( line * 7919 ) % 13 < 3; } );
+
+        THEN( "The same seed gives the same estimate" )
+        {
+            const auto first = file.estimate( testParameters() );
+            const auto second = file.estimate( testParameters() );
+            REQUIRE( first.has_value() );
+            REQUIRE( second.has_value() );
+            REQUIRE( first->estimate == second->estimate );
+            REQUIRE( first->margin == second->margin );
+        }
+    }
+}
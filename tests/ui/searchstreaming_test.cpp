@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <QTemporaryFile>
+#include <QTest>
+
+#include "configuration.h"
+#include "test_utils.h"
+
+#include "logdata.h"
+#include "logfiltereddata.h"
+#include "logfiltereddataworker.h"
+
+namespace {
+constexpr int NbLines = 500;
+// Updates of up to this number of lines are matched inline
+constexpr int ReadBufferSizeLines = 100;
+
+const auto Pattern = RegularExpressionPattern( "line [0-9]{5}[37]" );
+const auto OtherPattern = RegularExpressionPattern( "line [0-9]{4}1[0-9]" );
+
+QByteArray lineText( int index )
+{
+    return QString( "streaming test, line %1" ).arg( index, 6, 10, QChar( '0' ) ).toLatin1();
+}
+
+void writeLines( QTemporaryFile& file, int firstLine, int nbLines )
+{
+    for ( int i = firstLine; i < firstLine + nbLines; i++ ) {
+        file.write( lineText( i ) );
+        file.write( "\n" );
+    }
+    file.flush();
+}
+
+bool waitForNbLines( const LogData& logData, int nbLines )
+{
+    const auto expectedLines = LinesCount( static_cast<LinesCount::UnderlyingType>( nbLines ) );
+    return waitUiState( [ &logData, expectedLines ] {
+        return logData.getNbLine() == expectedLines;
+    } );
+}
+
+bool waitForSearchEnd( SafeQSignalSpy& progressSpy )
+{
+    return waitUiState( [ &progressSpy ] {
+        return !progressSpy.isEmpty() && progressSpy.last().at( 1 ).toInt() == 100;
+    } );
+}
+
+SearchResultArray matchingLines( const LogFilteredData& filteredData )
+{
+    SearchResultArray lines;
+    for ( auto index = 0_lnum; index < LineNumber( filteredData.getNbMatches().get() ); ++index ) {
+        lines.add( filteredData.getMatchingLineNumber( index ).get() );
+    }
+    return lines;
+}
+
+SearchResultArray fullSearch( LogData& logData, const RegularExpressionPattern& pattern )
+{
+    auto filteredData = logData.getNewFilteredData();
+    SafeQSignalSpy progressSpy{ filteredData.get(), &LogFilteredData::searchProgressed };
+    filteredData->runSearch( pattern );
+    REQUIRE( waitForSearchEnd( progressSpy ) );
+
+    REQUIRE( qvariant_cast<LinesCount>( progressSpy.last().at( 0 ) )
+             == filteredData->getNbMatches() );
+    return matchingLines( *filteredData );
+}
+
+void checkMatches( LogData& logData, const LogFilteredData& filteredData,
+                   SafeQSignalSpy& progressSpy )
+{
+    const auto expectedMatches = fullSearch( logData, Pattern );
+    REQUIRE( matchingLines( filteredData ) == expectedMatches );
+    REQUIRE( filteredData.getNbMatches()
+             == LinesCount( static_cast<LinesCount::UnderlyingType>(
+                 expectedMatches.cardinality() ) ) );
+    REQUIRE( qvariant_cast<LinesCount>( progressSpy.last().at( 0 ) )
+             == filteredData.getNbMatches() );
+}
+} // namespace
+
+SCENARIO( "Matching lines with a streaming session", "[searchstreaming]" )
+{
+    auto& config = Configuration::getSynced();
+    config.setUseSearchResultsCache( false );
+
+    QTemporaryFile file{ "searchstreaming_test_XXXXXX" };
+    REQUIRE( file.open() );
+    writeLines( file, 0, NbLines );
+
+    LogData logData;
+    SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( file.fileName() );
+    REQUIRE( loadEndSpy.safeWait( 10000 ) );
+
+    SearchStreamingSession session;
+
+    GIVEN( "The lines of the file matched in small chunks" )
+    {
+        SearchData searchData;
+        for ( int firstLine = 0; firstLine < NbLines; firstLine += 37 ) {
+            const auto lastLine = qMin( firstLine + 37, NbLines );
+            session.matchLines( logData, Pattern,
+                                LineNumber( static_cast<LineNumber::UnderlyingType>( firstLine ) ),
+                                LineNumber( static_cast<LineNumber::UnderlyingType>( lastLine ) ),
+                                searchData );
+        }
+
+        THEN( "The results are the ones of a full search" )
+        {
+            const auto results = searchData.takeCurrentResults();
+            REQUIRE( results.processedLines == LinesCount( NbLines ) );
+            REQUIRE( results.newMatches == fullSearch( logData, Pattern ) );
+            REQUIRE( searchData.getNbMatches()
+                     == LinesCount( static_cast<LinesCount::UnderlyingType>(
+                         results.newMatches.cardinality() ) ) );
+            REQUIRE( results.maxLength == LineLength( lineText( 0 ).size() ) );
+        }
+
+        AND_WHEN( "The session matches another pattern" )
+        {
+            SearchData otherSearchData;
+            session.matchLines( logData, OtherPattern, 0_lnum, LineNumber( NbLines ),
+                                otherSearchData );
+
+            THEN( "The lines are matched with the new pattern" )
+            {
+                REQUIRE( otherSearchData.takeCurrentResults().newMatches
+                         == fullSearch( logData, OtherPattern ) );
+            }
+        }
+    }
+
+    config.setUseSearchResultsCache( Configuration{}.useSearchResultsCache() );
+}
+
+SCENARIO( "Updating a search of a growing file", "[searchstreaming]" )
+{
+    auto& config = Configuration::getSynced();
+    config.setUseSearchResultsCache( false );
+    config.setSearchReadBufferSizeLines( ReadBufferSizeLines );
+
+    QTemporaryFile file{ "searchstreaming_test_XXXXXX" };
+    REQUIRE( file.open() );
+    writeLines( file, 0, NbLines );
+
+    LogData logData;
+    SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( file.fileName() );
+    REQUIRE( loadEndSpy.safeWait( 10000 ) );
+
+    auto filteredData = logData.getNewFilteredData();
+    SafeQSignalSpy progressSpy{ filteredData.get(), &LogFilteredData::searchProgressed };
+    filteredData->runSearch( Pattern );
+    REQUIRE( waitForSearchEnd( progressSpy ) );
+
+    const auto updateSearch = [ & ]( int nbLines ) {
+        REQUIRE( waitForNbLines( logData, nbLines ) );
+        progressSpy.clear();
+        filteredData->updateSearch(
+            0_lnum, LineNumber( static_cast<LineNumber::UnderlyingType>( nbLines ) ) );
+        REQUIRE( waitForSearchEnd( progressSpy ) );
+    };
+
+    GIVEN( "Lines appended in batches matched inline" )
+    {
+        int nbLines = NbLines;
+        // The first batches end with a matching line, which is searched again
+        // with the next batch. The last batch fills a read buffer.
+        for ( const auto batchSize : { 4, 20, ReadBufferSizeLines - 3 } ) {
+            writeLines( file, nbLines, batchSize );
+            nbLines += batchSize;
+            updateSearch( nbLines );
+        }
+
+        THEN( "The results are the ones of a full search" )
+        {
+            checkMatches( logData, *filteredData, progressSpy );
+        }
+
+        AND_WHEN( "More lines than a read buffer are appended" )
+        {
+            writeLines( file, nbLines, 3 * ReadBufferSizeLines );
+            nbLines += 3 * ReadBufferSizeLines;
+            updateSearch( nbLines );
+
+            THEN( "The results are the ones of a full search" )
+            {
+                checkMatches( logData, *filteredData, progressSpy );
+            }
+        }
+    }
+
+    GIVEN( "A matching line written in two parts" )
+    {
+        const auto line = lineText( 1003 );
+        file.write( line.left( line.size() - 3 ) );
+        file.flush();
+        updateSearch( NbLines + 1 );
+
+        REQUIRE_FALSE( filteredData->lineTypeByLine( LineNumber( NbLines ) )
+                           .testFlag( LogFilteredData::LineTypeFlags::Match ) );
+
+        file.write( line.right( 3 ) );
+        file.write( "\n" );
+        writeLines( file, NbLines + 1, 10 );
+        updateSearch( NbLines + 11 );
+
+        THEN( "The completed line is matched once" )
+        {
+            REQUIRE( filteredData->lineTypeByLine( LineNumber( NbLines ) )
+                         .testFlag( LogFilteredData::LineTypeFlags::Match ) );
+            checkMatches( logData, *filteredData, progressSpy );
+        }
+    }
+
+    GIVEN( "A truncated file" )
+    {
+        file.resize( 0 );
+        file.seek( 0 );
+        file.flush();
+        REQUIRE( waitForNbLines( logData, 0 ) );
+
+        writeLines( file, 0, NbLines / 2 );
+        REQUIRE( waitForNbLines( logData, NbLines / 2 ) );
+
+        WHEN( "The search is restarted and the file grows again" )
+        {
+            progressSpy.clear();
+            filteredData->runSearch( Pattern );
+            REQUIRE( waitForSearchEnd( progressSpy ) );
+
+            writeLines( file, NbLines / 2, 30 );
+            updateSearch( NbLines / 2 + 30 );
+
+            THEN( "The results are the ones of a full search" )
+            {
+                checkMatches( logData, *filteredData, progressSpy );
+            }
+        }
+    }
+
+    config.setSearchReadBufferSizeLines( Configuration{}.searchReadBufferSizeLines() );
+    config.setUseSearchResultsCache( Configuration{}.useSearchResultsCache() );
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <limits>
+
+#include <QTemporaryFile>
+
+#include "configuration.h"
+#include "test_utils.h"
+
+#include "logdata.h"
+#include "logfiltereddata.h"
+#include "selection.h"
+#include "selectionmimedata.h"
+
+namespace {
+constexpr int NbLines = 1000;
+
+#if defined( Q_OS_WIN )
+const QString LineSeparator = QStringLiteral( "\r\n" );
+#else
+const QString LineSeparator = QStringLiteral( "\n" );
+#endif
+
+QString lineText( int index )
+{
+    return QString( "selection test, line %1" ).arg( index );
+}
+
+QString expectedText( int first, int last, bool lineNumbers )
+{
+    QStringList lines;
+    for ( int i = first; i <= last; ++i ) {
+        lines.append( lineNumbers ? QString( "%1: %2" ).arg( i + 1 ).arg( lineText( i ) )
+                                  : lineText( i ) );
+    }
+    return lines.join( LineSeparator );
+}
+
+struct ReadBufferSizeGuard {
+    explicit ReadBufferSizeGuard( int sizeLines )
+        : initialSizeLines( Configuration::getSynced().searchReadBufferSizeLines() )
+    {
+        Configuration::getSynced().setSearchReadBufferSizeLines( sizeLines );
+    }
+
+    ~ReadBufferSizeGuard()
+    {
+        Configuration::getSynced().setSearchReadBufferSizeLines( initialSizeLines );
+    }
+
+    ReadBufferSizeGuard( const ReadBufferSizeGuard& ) = delete;
+    ReadBufferSizeGuard& operator=( const ReadBufferSizeGuard& ) = delete;
+
+    int initialSizeLines;
+};
+} // namespace
+
+SCENARIO( "Copying the text of a selection", "[selection]" )
+{
+    QTemporaryFile file{ "selection_test_XXXXXX" };
+    REQUIRE( file.open() );
+    for ( int i = 0; i < NbLines; ++i ) {
+        file.write( lineText( i ).toLatin1() );
+        file.write( "\n" );
+    }
+    file.flush();
+
+    LogData logData;
+    SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( file.fileName() );
+    REQUIRE( loadEndSpy.safeWait( 10000 ) );
+
+    // Read the selection by several chunks
+    const ReadBufferSizeGuard readBufferSizeGuard( 64 );
+
+    Selection selection;
+    selection.selectRange( 10_lnum, 509_lnum );
+
+    GIVEN( "A range of lines read by chunks" )
+    {
+        const auto lineNumbers = GENERATE( false, true );
+
+        THEN( "The text is the same as the lines" )
+        {
+            int lastProgress = 0;
+            const auto text = selection.getSelectedText(
+                &logData, lineNumbers, std::numeric_limits<qint64>::max(), AtomicFlag{},
+                [ &lastProgress ]( int percent ) { lastProgress = percent; } );
+
+            REQUIRE( text.has_value() );
+            REQUIRE( *text == expectedText( 10, 509, lineNumbers ) );
+            REQUIRE( *text == selection.getSelectedText( &logData, lineNumbers ) );
+            REQUIRE( lastProgress == 100 );
+        }
+    }
+
+    GIVEN( "A size limit smaller than the selection" )
+    {
+        THEN( "No text is returned" )
+        {
+            REQUIRE_FALSE(
+                selection.getSelectedText( &logData, false, 1000, AtomicFlag{}, {} ).has_value() );
+        }
+    }
+
+    GIVEN( "An interrupted copy" )
+    {
+        THEN( "No text is returned" )
+        {
+            REQUIRE_FALSE( selection
+                               .getSelectedText( &logData, false, 1000000, AtomicFlag{ true }, {} )
+                               .has_value() );
+        }
+    }
+
+    GIVEN( "A selection sent to the clipboard lazily" )
+    {
+        SelectionMimeData mimeData( &logData, selection, false, 1000000 );
+        SafeQSignalSpy readSpy( &mimeData, &SelectionMimeData::textRead );
+        SafeQSignalSpy unavailableSpy( &mimeData, &SelectionMimeData::textUnavailable );
+
+        THEN( "The text asked for while it is read is sent once read" )
+        {
+            REQUIRE( mimeData.hasText() );
+            REQUIRE( mimeData.text().isEmpty() );
+            REQUIRE( readSpy.safeWait( 10000 ) );
+            REQUIRE( readSpy.first().at( 0 ).toString() == expectedText( 10, 509, false ) );
+            REQUIRE( mimeData.text() == expectedText( 10, 509, false ) );
+            REQUIRE( unavailableSpy.count() == 0 );
+        }
+
+        WHEN( "The text of the file changes before it is read" )
+        {
+            logData.setPrefilter( "line" );
+
+            THEN( "The user is told the text can't be pasted" )
+            {
+                REQUIRE( mimeData.text().isEmpty() );
+                REQUIRE( unavailableSpy.safeWait( 10000 ) );
+                REQUIRE( unavailableSpy.count() == 1 );
+                REQUIRE( readSpy.count() == 0 );
+            }
+        }
+    }
+
+    GIVEN( "A lazy selection larger than the size limit" )
+    {
+        SelectionMimeData mimeData( &logData, selection, false, 1000 );
+        SafeQSignalSpy unavailableSpy( &mimeData, &SelectionMimeData::textUnavailable );
+
+        THEN( "The user is told each time it is pasted" )
+        {
+            REQUIRE( mimeData.text().isEmpty() );
+            REQUIRE( unavailableSpy.safeWait( 10000 ) );
+            REQUIRE( mimeData.text().isEmpty() );
+            REQUIRE( unavailableSpy.count() == 2 );
+        }
+    }
+
+    GIVEN( "A selection of marked lines sent to the clipboard lazily" )
+    {
+        auto filteredData = logData.getNewFilteredData();
+        for ( const auto line : { 100_lnum, 200_lnum, 300_lnum, 301_lnum, 302_lnum } ) {
+            filteredData->addMark( line );
+        }
+
+        Selection filteredSelection;
+        filteredSelection.selectRange( 1_lnum, 4_lnum );
+        SelectionMimeData mimeData( filteredData.get(), filteredSelection, true, 1000000 );
+        SafeQSignalSpy readSpy( &mimeData, &SelectionMimeData::textRead );
+
+        WHEN( "Lines are marked before the copied ones" )
+        {
+            filteredData->addMark( 5_lnum );
+            filteredData->addMark( 6_lnum );
+
+            THEN( "The lines pasted are the ones copied" )
+            {
+                REQUIRE( mimeData.text().isEmpty() );
+                REQUIRE( readSpy.safeWait( 10000 ) );
+                REQUIRE( mimeData.text()
+                         == QStringList{ expectedText( 200, 200, true ),
+                                         expectedText( 300, 302, true ) }
+                                .join( LineSeparator ) );
+            }
+        }
+    }
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+
+#include <QTemporaryFile>
+#include <QTest>
+
+#include "test_utils.h"
+
+#include "logdata.h"
+#include "wrappedlinesindex.h"
+#include "wrappedstring.h"
+
+namespace {
+constexpr int NbLines = 500;
+constexpr auto VisibleColumns = LineLength{ 40 };
+
+QString lineText( int index )
+{
+    auto text = QString( "wrap test, line %1" ).arg( index );
+    // Every fifth line wraps on several rows
+    for ( int word = 0; index % 5 == 0 && word < index % 30; ++word ) {
+        text.append( " wrapped" );
+    }
+    return text;
+}
+
+void writeLines( QTemporaryFile& file, int firstLine, int nbLines )
+{
+    for ( int i = firstLine; i < firstLine + nbLines; i++ ) {
+        file.write( lineText( i ).toLatin1() );
+        file.write( "\n" );
+    }
+    file.flush();
+}
+
+void generateDataFile( QTemporaryFile& file )
+{
+    REQUIRE( file.open() );
+    writeLines( file, 0, NbLines );
+}
+
+bool waitForIndex( const WrappedLinesIndex& index, LineLength visibleColumns )
+{
+    for ( int i = 0; i < 100 && !index.isReady( visibleColumns ); ++i ) {
+        QTest::qWait( 100 );
+    }
+    return index.isReady( visibleColumns );
+}
+
+bool waitForReadyCount( const std::atomic<int>& readyCount, int expectedCount )
+{
+    for ( int i = 0; i < 100 && readyCount < expectedCount; ++i ) {
+        QTest::qWait( 100 );
+    }
+    return readyCount == expectedCount;
+}
+
+void checkRows( const WrappedLinesIndex& index, int nbLines,
+                LineLength visibleColumns = VisibleColumns )
+{
+    auto row = 0_lcount;
+    for ( int i = 0; i < nbLines; ++i ) {
+        const auto line = LineNumber( static_cast<LineNumber::UnderlyingType>( i ) );
+        REQUIRE( index.rowOfLine( line ) == row );
+
+        const WrappedString wrappedLine{ lineText( i ), visibleColumns };
+        for ( auto wrappedRow = 0u; wrappedRow < wrappedLine.wrappedLinesCount(); ++wrappedRow ) {
+            const auto position = index.lineAtRow( row + LinesCount( wrappedRow ) );
+            REQUIRE( position.line == line );
+            REQUIRE( position.wrappedRow == LinesCount( wrappedRow ) );
+        }
+
+        row = row
+              + LinesCount( static_cast<LinesCount::UnderlyingType>(
+                  wrappedLine.wrappedLinesCount() ) );
+    }
+}
+} // namespace
+
+SCENARIO( "Counting rows of wrapped lines", "[wrappedlines]" )
+{
+    QTemporaryFile file{ "wrappedlines_test_XXXXXX" };
+    generateDataFile( file );
+
+    LogData logData;
+    SafeQSignalSpy loadEndSpy( &logData, SIGNAL( loadingFinished( LoadingStatus ) ) );
+    logData.attachFile( file.fileName() );
+    REQUIRE( loadEndSpy.safeWait( 10000 ) );
+
+    std::atomic<int> readyCount{ 0 };
+    WrappedLinesIndex index( logData, [ &readyCount ] { ++readyCount; } );
+
+    GIVEN( "An index not built yet" )
+    {
+        THEN( "Each line takes one row" )
+        {
+            REQUIRE_FALSE( index.isReady( VisibleColumns ) );
+            REQUIRE( index.rowOfLine( 10_lnum ) == 10_lcount );
+            REQUIRE( index.lineAtRow( 10_lcount ).line == 10_lnum );
+        }
+    }
+
+    GIVEN( "An index built for a width" )
+    {
+        index.build( VisibleColumns );
+        REQUIRE( waitForIndex( index, VisibleColumns ) );
+        REQUIRE( readyCount == 1 );
+
+        THEN( "Rows of lines are the rows of their wrapped strings" )
+        {
+            checkRows( index, NbLines );
+        }
+
+        THEN( "It is not ready for another width" )
+        {
+            REQUIRE_FALSE( index.isReady( VisibleColumns + 10_length ) );
+        }
+
+        WHEN( "It is invalidated" )
+        {
+            index.invalidate();
+
+            THEN( "The last index is still used" )
+            {
+                REQUIRE( index.isReady( VisibleColumns ) );
+            }
+
+            THEN( "Building it again starts over" )
+            {
+                index.build( VisibleColumns );
+                REQUIRE( waitForReadyCount( readyCount, 2 ) );
+                checkRows( index, NbLines );
+            }
+        }
+
+        WHEN( "Lines are appended to the data" )
+        {
+            constexpr int NbAppendedLines = 250;
+            writeLines( file, NbLines, NbAppendedLines );
+            REQUIRE( waitUiState( [ &logData ] {
+                return logData.getNbLine()
+                       == LinesCount( static_cast<LinesCount::UnderlyingType>(
+                           NbLines + NbAppendedLines ) );
+            } ) );
+
+            index.update( LineNumber( static_cast<LineNumber::UnderlyingType>( NbLines - 1 ) ) );
+
+            THEN( "The appended lines are counted after the ones already known" )
+            {
+                index.build( VisibleColumns );
+                REQUIRE( waitForReadyCount( readyCount, 2 ) );
+                checkRows( index, NbLines + NbAppendedLines );
+            }
+
+            THEN( "Updating while building does not wait for the stopped build" )
+            {
+                index.build( VisibleColumns );
+                index.update( 100_lnum );
+                index.build( VisibleColumns );
+                REQUIRE( waitUiState( [ &readyCount ] { return readyCount >= 2; } ) );
+                QTest::qWait( 500 );
+                checkRows( index, NbLines + NbAppendedLines );
+            }
+        }
+
+        WHEN( "It is built for a width most of the lines are wider than" )
+        {
+            const auto narrowColumns = LineLength{ 15 };
+            index.build( narrowColumns );
+            REQUIRE( waitForReadyCount( readyCount, 2 ) );
+
+            THEN( "Rows of lines are the rows of their wrapped strings for that width" )
+            {
+                checkRows( index, NbLines, narrowColumns );
+            }
+        }
+
+        WHEN( "It is built for another width" )
+        {
+            index.build( VisibleColumns + 10_length );
+            REQUIRE( waitForReadyCount( readyCount, 2 ) );
+
+            THEN( "Rows of lines are the rows of their wrapped strings for that width" )
+            {
+                checkRows( index, NbLines, VisibleColumns + 10_length );
+            }
+
+            THEN( "It is built again for the first width" )
+            {
+                REQUIRE_FALSE( index.isReady( VisibleColumns ) );
+                index.build( VisibleColumns );
+                REQUIRE( waitForReadyCount( readyCount, 3 ) );
+                checkRows( index, NbLines );
+            }
+        }
+    }
+}
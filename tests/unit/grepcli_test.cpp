@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "grepcli.h"
+
+namespace {
+
+struct GrepResult {
+    int exitStatus;
+    std::string out;
+    std::string err;
+};
+
+GrepResult grep( const QStringList& arguments, qint64 blockSize = 1024 * 1024 )
+{
+    GrepParameters parameters;
+    const auto error = parameters.parse( QStringList{ "klogg_grep" } + arguments );
+    REQUIRE_FALSE( error.has_value() );
+
+    GrepResources resources;
+    resources.threads = 2;
+    resources.blockSize = blockSize;
+
+    std::ostringstream out;
+    std::ostringstream err;
+    const auto exitStatus = runGrep( parameters, resources, out, err );
+    return { exitStatus, out.str(), err.str() };
+}
+
+QString writeFile( const QTemporaryDir& dir, const QString& name, const QByteArray& content )
+{
+    const auto path = dir.filePath( name );
+    QFile file( path );
+    REQUIRE( file.open( QIODevice::WriteOnly ) );
+    file.write( content );
+    return path;
+}
+
+// Lines 5, 7 and 15 of the 20 lines contain "error"
+QByteArray logContent()
+{
+    QByteArray content;
+    for ( int line = 1; line <= 20; ++line ) {
+        content += "line " + QByteArray::number( line );
+        if ( line == 5 || line == 7 || line == 15 ) {
+            content += " error";
+        }
+        content += "\n";
+    }
+    return content;
+}
+
+} // namespace
+
+SCENARIO( "Parsing klogg_grep arguments", "[grepcli]" )
+{
+    GrepParameters parameters;
+    const auto parse = [ &parameters ]( const QStringList& arguments ) {
+        return !parameters.parse( QStringList{ "klogg_grep" } + arguments ).has_value();
+    };
+
+    WHEN( "Context options are combined" )
+    {
+        REQUIRE( parse( { "-C", "2", "-A", "4", "error", "app.log" } ) );
+
+        THEN( "The more specific option wins" )
+        {
+            REQUIRE( parameters.beforeContext == 2 );
+            REQUIRE( parameters.afterContext == 4 );
+            REQUIRE( parameters.pattern == "error" );
+            REQUIRE( parameters.files.size() == 1 );
+            REQUIRE_FALSE( parameters.withFilename );
+        }
+    }
+
+    WHEN( "Several files are searched" )
+    {
+        REQUIRE( parse( { "-e", "error", "a.log", "b.log" } ) );
+
+        THEN( "File names are printed" )
+        {
+            REQUIRE( parameters.files.size() == 2 );
+            REQUIRE( parameters.withFilename );
+        }
+    }
+
+    THEN( "Invalid arguments are reported" )
+    {
+        REQUIRE_FALSE( parse( {} ) );
+        REQUIRE_FALSE( parse( { "error" } ) );
+        REQUIRE_FALSE( parse( { "-A", "x", "error", "app.log" } ) );
+        REQUIRE_FALSE( parse( { "-C", "-1", "error", "app.log" } ) );
+        REQUIRE_FALSE( parse( { "--engine", "sed", "error", "app.log" } ) );
+        REQUIRE_FALSE( parse( { "--no-such-option", "error", "app.log" } ) );
+        REQUIRE( GrepParameters::UsageError == GrepExitError );
+    }
+}
+
+SCENARIO( "Printing the selected lines with klogg_grep", "[grepcli]" )
+{
+    QTemporaryDir dir;
+    REQUIRE( dir.isValid() );
+    const auto logFile = writeFile( dir, "app.log", logContent() );
+
+    WHEN( "Searching without context" )
+    {
+        const auto result = grep( { "-n", "error", logFile } );
+
+        THEN( "Only the selected lines are printed" )
+        {
+            REQUIRE( result.exitStatus == GrepExitSelected );
+            REQUIRE( result.out == "5:line 5 error\n7:line 7 error\n15:line 15 error\n" );
+            REQUIRE( result.err.empty() );
+        }
+    }
+
+    WHEN( "Searching with -C" )
+    {
+        const auto result = grep( { "-n", "-C", "1", "error", logFile } );
+
+        THEN( "Groups of lines are separated by --" )
+        {
+            REQUIRE( result.exitStatus == GrepExitSelected );
+            REQUIRE( result.out
+                     == "4-line 4\n5:line 5 error\n6-line 6\n7:line 7 error\n8-line 8\n"
+                        "--\n"
+                        "14-line 14\n15:line 15 error\n16-line 16\n" );
+        }
+    }
+
+    WHEN( "Searching with -A" )
+    {
+        const auto result = grep( { "-A", "1", "error", logFile } );
+
+        THEN( "The lines after each selected line are printed" )
+        {
+            REQUIRE( result.out
+                     == "line 5 error\nline 6\nline 7 error\nline 8\n"
+                        "--\n"
+                        "line 15 error\nline 16\n" );
+        }
+    }
+
+    WHEN( "Searching with -B" )
+    {
+        const auto result = grep( { "-n", "-B", "2", "error", logFile } );
+
+        THEN( "The lines before each selected line are printed" )
+        {
+            REQUIRE( result.out
+                     == "3-line 3\n4-line 4\n5:line 5 error\n6-line 6\n7:line 7 error\n"
+                        "--\n"
+                        "13-line 13\n14-line 14\n15:line 15 error\n" );
+        }
+    }
+
+    WHEN( "Context lines are in other blocks than the selected lines" )
+    {
+        THEN( "The output doesn't depend on the size of the blocks read" )
+        {
+            for ( const auto& arguments :
+                  { QStringList{ "-n", "-C", "2", "error", logFile },
+                    QStringList{ "-n", "-B", "3", "error", logFile },
+                    QStringList{ "-n", "-A", "9", "error", logFile } } ) {
+                const auto expected = grep( arguments );
+                // Blocks smaller than a line hold one line each
+                for ( const auto blockSize : { 4, 13, 32 } ) {
+                    const auto result = grep( arguments, blockSize );
+                    REQUIRE( result.exitStatus == expected.exitStatus );
+                    REQUIRE( result.out == expected.out );
+                }
+            }
+
+            REQUIRE( grep( { "-n", "-B", "3", "error", logFile }, 4 ).out
+                     == "2-line 2\n3-line 3\n4-line 4\n5:line 5 error\n6-line 6\n"
+                        "7:line 7 error\n"
+                        "--\n"
+                        "12-line 12\n13-line 13\n14-line 14\n15:line 15 error\n" );
+        }
+    }
+
+    WHEN( "Counting the selected lines" )
+    {
+        const auto emptyFile = writeFile( dir, "empty.log", "nothing here\n" );
+
+        THEN( "One count is printed for each file" )
+        {
+            REQUIRE( grep( { "-c", "error", logFile } ).out == "3\n" );
+
+            const auto result = grep( { "-c", "error", logFile, emptyFile } );
+            REQUIRE( result.exitStatus == GrepExitSelected );
+            REQUIRE( result.out == ( logFile + ":3\n" + emptyFile + ":0\n" ).toStdString() );
+
+            const auto emptyResult = grep( { "-c", "error", emptyFile } );
+            REQUIRE( emptyResult.exitStatus == GrepExitNotSelected );
+            REQUIRE( emptyResult.out == "0\n" );
+        }
+    }
+
+    WHEN( "Searching quietly" )
+    {
+        THEN( "Only the exit status tells if a line is selected" )
+        {
+            const auto result = grep( { "-q", "error", logFile } );
+            REQUIRE( result.exitStatus == GrepExitSelected );
+            REQUIRE( result.out.empty() );
+
+            const auto notSelected = grep( { "-q", "warning", logFile } );
+            REQUIRE( notSelected.exitStatus == GrepExitNotSelected );
+            REQUIRE( notSelected.out.empty() );
+        }
+    }
+
+    WHEN( "Printing JSON lines" )
+    {
+        const auto quotesFile = writeFile( dir, "quotes.log", "say \"error\"\there\nok\n" );
+        const auto fileName = logFile.toStdString();
+
+        THEN( "Each line is an object" )
+        {
+            REQUIRE( grep( { "--json", "-C", "1", "line 15", logFile } ).out
+                     == "{\"file\":\"" + fileName
+                            + "\",\"line\":14,\"type\":\"context\",\"text\":\"line 14\"}\n"
+                              "{\"file\":\""
+                            + fileName
+                            + "\",\"line\":15,\"type\":\"match\",\"text\":\"line 15 error\"}\n"
+                              "{\"file\":\""
+                            + fileName
+                            + "\",\"line\":16,\"type\":\"context\",\"text\":\"line 16\"}\n" );
+
+            REQUIRE( grep( { "--json", "-c", "error", logFile } ).out
+                     == "{\"file\":\"" + fileName + "\",\"count\":3}\n" );
+
+            REQUIRE( grep( { "--json", "error", quotesFile } ).out
+                     == "{\"file\":\"" + quotesFile.toStdString()
+                            + "\",\"line\":1,\"type\":\"match\",\"text\":"
+                              "\"say \\\"error\\\"\\there\"}\n" );
+        }
+    }
+
+    WHEN( "Printing the bytes of the lines" )
+    {
+        const auto latin1File = writeFile( dir, "latin1.log", "caf\xe9 error\r\nok\nend error" );
+
+        THEN( "Raw lines are printed as they are in the file" )
+        {
+            REQUIRE( grep( { "--raw", "--encoding", "ISO-8859-1", "error", latin1File } ).out
+                     == "caf\xe9 error\r\nend error\n" );
+            REQUIRE( grep( { "--encoding", "ISO-8859-1", "end", latin1File } ).out
+                     == "end error\n" );
+            REQUIRE( grep( { "--encoding", "ISO-8859-1", "^ok", latin1File } ).out == "ok\n" );
+            REQUIRE( grep( { "--json", "--raw", "--encoding", "ISO-8859-1", "end", latin1File } )
+                         .out
+                     == "{\"file\":\"" + latin1File.toStdString()
+                            + "\",\"line\":3,\"type\":\"match\",\"text\":\"end error\"}\n" );
+        }
+    }
+}
+
+SCENARIO( "Exit status of klogg_grep", "[grepcli]" )
+{
+    QTemporaryDir dir;
+    REQUIRE( dir.isValid() );
+    const auto logFile = writeFile( dir, "app.log", logContent() );
+    const auto missingFile = dir.filePath( "missing.log" );
+
+    THEN( "It is 0 when a line is selected" )
+    {
+        REQUIRE( grep( { "error", logFile } ).exitStatus == GrepExitSelected );
+        REQUIRE( grep( { "-v", "error", logFile } ).exitStatus == GrepExitSelected );
+    }
+
+    THEN( "It is 1 when no line is selected" )
+    {
+        const auto result = grep( { "warning", logFile } );
+        REQUIRE( result.exitStatus == GrepExitNotSelected );
+        REQUIRE( result.out.empty() );
+        REQUIRE( result.err.empty() );
+    }
+
+    THEN( "It is 2 on errors" )
+    {
+        const auto missingResult = grep( { "error", missingFile } );
+        REQUIRE( missingResult.exitStatus == GrepExitError );
+        REQUIRE( missingResult.err.find( "missing.log" ) != std::string::npos );
+
+        REQUIRE( grep( { "error", logFile, missingFile } ).exitStatus == GrepExitError );
+        REQUIRE( grep( { "(", logFile } ).exitStatus == GrepExitError );
+        REQUIRE( grep( { "--encoding", "no-such-encoding", "error", logFile } ).exitStatus
+                 == GrepExitError );
+    }
+
+    THEN( "It is 0 for a quiet search with a selected line despite errors" )
+    {
+        REQUIRE( grep( { "-q", "error", logFile, missingFile } ).exitStatus == GrepExitSelected );
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include "linehighlightscache.h"
+
+namespace {
+LineHighlights highlightsOfSize( int size )
+{
+    LineHighlights highlights;
+    highlights.matches.emplace_back( 0_lcol, LineLength{ size }, Qt::black, Qt::yellow );
+    return highlights;
+}
+} // namespace
+
+SCENARIO( "Line highlights cache", "[linehighlightscache]" )
+{
+    LineHighlightsCache cache( 3 );
+
+    cache.insert( 1_lnum, 0, highlightsOfSize( 1 ) );
+    cache.insert( 2_lnum, 0, highlightsOfSize( 2 ) );
+    cache.insert( 3_lnum, 0, highlightsOfSize( 3 ) );
+
+    WHEN( "Looking up a line of the same generation" )
+    {
+        const auto* highlights = cache.find( 2_lnum, 0 );
+
+        THEN( "The computed highlights are returned" )
+        {
+            REQUIRE( highlights != nullptr );
+            REQUIRE( highlights->matches.front().size() == 2_length );
+        }
+    }
+
+    WHEN( "Looking up a line of an older generation" )
+    {
+        THEN( "Nothing is returned" )
+        {
+            REQUIRE( cache.find( 2_lnum, 1 ) == nullptr );
+            REQUIRE( cache.find( 4_lnum, 0 ) == nullptr );
+        }
+    }
+
+    WHEN( "Inserting more lines than the capacity" )
+    {
+        // Line 1 becomes the most recently used, line 2 the least
+        REQUIRE( cache.find( 1_lnum, 0 ) != nullptr );
+        cache.insert( 4_lnum, 0, highlightsOfSize( 4 ) );
+
+        THEN( "The least recently used line is evicted" )
+        {
+            REQUIRE( cache.size() == 3 );
+            REQUIRE( cache.find( 2_lnum, 0 ) == nullptr );
+            REQUIRE( cache.find( 1_lnum, 0 ) != nullptr );
+            REQUIRE( cache.find( 3_lnum, 0 ) != nullptr );
+            REQUIRE( cache.find( 4_lnum, 0 ) != nullptr );
+        }
+    }
+
+    WHEN( "Inserting a line of a new generation" )
+    {
+        cache.insert( 3_lnum, 1, highlightsOfSize( 5 ) );
+
+        THEN( "It replaces the old entry" )
+        {
+            REQUIRE( cache.size() == 3 );
+            REQUIRE( cache.find( 3_lnum, 0 ) == nullptr );
+            REQUIRE( cache.find( 3_lnum, 1 )->matches.front().size() == 5_length );
+        }
+    }
+
+    WHEN( "Clearing the cache" )
+    {
+        cache.clear();
+
+        THEN( "Nothing is returned" )
+        {
+            REQUIRE( cache.size() == 0 );
+            REQUIRE( cache.find( 1_lnum, 0 ) == nullptr );
+        }
+    }
+}
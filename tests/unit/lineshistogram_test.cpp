@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <numeric>
+
+#include "lineshistogram.h"
+
+namespace {
+uint64_t sum( const klogg::vector<uint64_t>& bins )
+{
+    return std::accumulate( bins.begin(), bins.end(), uint64_t{ 0 } );
+}
+} // namespace
+
+SCENARIO( "Lines histogram", "[lineshistogram]" )
+{
+    LinesHistogram histogram;
+
+    WHEN( "Adding and removing lines" )
+    {
+        histogram.add( 5_lnum );
+        histogram.add( 10_lnum );
+        histogram.add( 1000_lnum );
+        histogram.remove( 10_lnum );
+
+        THEN( "The lines are counted in their bin" )
+        {
+            REQUIRE( histogram.totalCount() == 2 );
+            REQUIRE( histogram.bucketSize() == 1_lcount );
+
+            const auto bins = histogram.rescale( 2000_lcount, 2 );
+            REQUIRE( bins.size() == 2 );
+            REQUIRE( bins[ 0 ] == 1 );
+            REQUIRE( bins[ 1 ] == 1 );
+        }
+    }
+
+    WHEN( "Adding lines past the last bucket" )
+    {
+        histogram.add( 1_lnum );
+        histogram.add( LineNumber( LinesHistogram::NbBuckets * 3 ) );
+
+        THEN( "The buckets grow and keep the lines already counted" )
+        {
+            REQUIRE( histogram.bucketSize() == 4_lcount );
+            REQUIRE( histogram.totalCount() == 2 );
+
+            const auto bins = histogram.rescale( LinesCount( LinesHistogram::NbBuckets * 4 ), 4 );
+            REQUIRE( bins[ 0 ] == 1 );
+            REQUIRE( bins[ 1 ] == 0 );
+            REQUIRE( bins[ 2 ] == 0 );
+            REQUIRE( bins[ 3 ] == 1 );
+        }
+    }
+
+    WHEN( "Adding a set of lines" )
+    {
+        SearchResultArray lines;
+        lines.addRange( 0, 100'000 );
+        lines.add( 10'000'000 );
+        histogram.add( lines );
+
+        THEN( "All the lines are counted once" )
+        {
+            REQUIRE( histogram.totalCount() == lines.cardinality() );
+            REQUIRE( sum( histogram.rescale( 10'000'001_lcount, 768 ) ) == lines.cardinality() );
+        }
+
+        AND_WHEN( "Removing a subset" )
+        {
+            SearchResultArray removed;
+            removed.addRange( 0, 50'000 );
+            histogram.remove( removed );
+
+            THEN( "The lines removed are not counted" )
+            {
+                REQUIRE( histogram.totalCount() == lines.cardinality() - removed.cardinality() );
+                REQUIRE( sum( histogram.rescale( 10'000'001_lcount, 1000 ) )
+                         == histogram.totalCount() );
+            }
+        }
+
+        AND_WHEN( "Rebuilding from another set" )
+        {
+            SearchResultArray other;
+            other.add( 42 );
+            histogram.assign( other );
+
+            THEN( "Only the new set is counted" )
+            {
+                REQUIRE( histogram.totalCount() == 1 );
+                REQUIRE( histogram.bucketSize() == 1_lcount );
+            }
+        }
+    }
+
+    WHEN( "The histogram is empty" )
+    {
+        THEN( "Rescaling gives empty bins" )
+        {
+            const auto bins = histogram.rescale( 1000_lcount, 10 );
+            REQUIRE( bins.size() == 10 );
+            REQUIRE( sum( bins ) == 0 );
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+#include "lrucache.h"
+
+SCENARIO( "Least recently used cache", "[lrucache]" )
+{
+    LruCache<int, std::string> cache( 3 );
+
+    cache.insert( 1, "one" );
+    cache.insert( 2, "two" );
+    cache.insert( 3, "three" );
+
+    WHEN( "An entry is looked up before the cache is full" )
+    {
+        REQUIRE( *cache.find( 1 ) == "one" );
+        cache.insert( 4, "four" );
+
+        THEN( "The least recently used entry is evicted" )
+        {
+            REQUIRE( cache.size() == 3 );
+            REQUIRE( cache.find( 2 ) == nullptr );
+            REQUIRE( cache.contains( 1 ) );
+            REQUIRE( cache.contains( 4 ) );
+        }
+    }
+
+    WHEN( "An entry is replaced" )
+    {
+        cache.insert( 1, "first" );
+
+        THEN( "It becomes the most recently used one" )
+        {
+            REQUIRE( cache.size() == 3 );
+            REQUIRE( *cache.find( 1 ) == "first" );
+            REQUIRE( cache.leastRecent().first == 2 );
+        }
+    }
+
+    WHEN( "The least recent entries are removed" )
+    {
+        cache.removeLeastRecent();
+        REQUIRE( cache.erase( 3 ) );
+        REQUIRE_FALSE( cache.erase( 3 ) );
+
+        THEN( "Only the other entries are kept" )
+        {
+            REQUIRE( cache.size() == 1 );
+            REQUIRE( cache.leastRecent().first == 2 );
+        }
+    }
+}
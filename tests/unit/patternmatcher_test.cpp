@@ -19,6 +19,7 @@
 
 #include <catch2/catch.hpp>
 
+#include "highlighterset.h"
 #include "regularexpression.h"
 
 SCENARIO( "Pattern matcher in boolean mode", "[patternmatcher]" )
@@ -65,3 +66,144 @@ SCENARIO( "Pattern matcher in boolean mode", "[patternmatcher]" )
         REQUIRE_FALSE( expression.isValid() );
     }
 }
+
+SCENARIO( "Locating matches of several patterns", "[patternmatcher]" )
+{
+    const klogg::vector<RegularExpressionPattern> patterns
+        = { RegularExpressionPattern( "a+", true, false, false, false ),
+            RegularExpressionPattern( "\\d{2}", true, false, false, false ),
+            RegularExpressionPattern( "(?<=x)y", true, false, false, false ),
+            RegularExpressionPattern( "error", false, false, false, true ) };
+
+    HsRangesRegularExpression expression( patterns );
+    const auto matcher = expression.createMatcher();
+
+    klogg::vector<PatternMatchRange> ranges;
+
+#ifdef KLOGG_HAS_HS
+    WHEN( "Patterns can be located" )
+    {
+        REQUIRE( expression.canLocate( 0 ) );
+        REQUIRE( expression.canLocate( 1 ) );
+        REQUIRE( expression.canLocate( 3 ) );
+
+        matcher.match( "aaa 1234 ba ERROR", ranges );
+
+        THEN( "Longest non-overlapping matches are reported in order" )
+        {
+            REQUIRE( ranges.size() == 5 );
+
+            REQUIRE( ranges[ 0 ].patternIndex == 0 );
+            REQUIRE( ranges[ 0 ].start == 0 );
+            REQUIRE( ranges[ 0 ].end == 3 );
+
+            REQUIRE( ranges[ 1 ].patternIndex == 0 );
+            REQUIRE( ranges[ 1 ].start == 10 );
+            REQUIRE( ranges[ 1 ].end == 11 );
+
+            REQUIRE( ranges[ 2 ].patternIndex == 1 );
+            REQUIRE( ranges[ 2 ].start == 4 );
+            REQUIRE( ranges[ 2 ].end == 6 );
+
+            REQUIRE( ranges[ 3 ].patternIndex == 1 );
+            REQUIRE( ranges[ 3 ].start == 6 );
+            REQUIRE( ranges[ 3 ].end == 8 );
+
+            REQUIRE( ranges[ 4 ].patternIndex == 3 );
+            REQUIRE( ranges[ 4 ].start == 12 );
+            REQUIRE( ranges[ 4 ].end == 17 );
+        }
+    }
+
+    WHEN( "Line has multibyte characters" )
+    {
+        matcher.match( "\xc3\xa9t\xc3\xa9 aa", ranges );
+
+        THEN( "Ranges are utf8 offsets" )
+        {
+            REQUIRE( ranges.size() == 1 );
+            REQUIRE( ranges[ 0 ].start == 6 );
+            REQUIRE( ranges[ 0 ].end == 8 );
+        }
+    }
+#endif
+
+    WHEN( "Pattern has a lookbehind" )
+    {
+        THEN( "It is left to QRegularExpression" )
+        {
+            REQUIRE_FALSE( expression.canLocate( 2 ) );
+        }
+
+#ifdef KLOGG_HAS_HS
+        THEN( "Lines it can't match are rejected by the prefilter" )
+        {
+            matcher.match( "aaa 1234", ranges );
+            REQUIRE_FALSE( matcher.mayMatch( 2 ) );
+
+            matcher.match( "aaa xy", ranges );
+            REQUIRE( matcher.mayMatch( 2 ) );
+        }
+#endif
+    }
+}
+
+#ifdef KLOGG_HAS_HS
+SCENARIO( "Locating matches like QRegularExpression", "[patternmatcher]" )
+{
+    const QString line = "ab abc error errors a-b x|y";
+
+    // Ranges of the matches as QRegularExpression finds them
+    const auto regexpRanges = [ &line ]( const QString& pattern ) {
+        klogg::vector<std::pair<size_t, size_t>> ranges;
+        auto matches = QRegularExpression( pattern ).globalMatch( line );
+        while ( matches.hasNext() ) {
+            const auto match = matches.next();
+            ranges.emplace_back( static_cast<size_t>( match.capturedStart() ),
+                                 static_cast<size_t>( match.capturedEnd() ) );
+        }
+        return ranges;
+    };
+
+    const auto engineRanges = [ &line ]( const QString& pattern ) {
+        HsRangesRegularExpression expression(
+            { RegularExpressionPattern( pattern, true, false, false, false ) } );
+        REQUIRE( expression.canLocate( 0 ) );
+
+        klogg::vector<PatternMatchRange> matches;
+        expression.createMatcher().match( line.toStdString(), matches );
+
+        klogg::vector<std::pair<size_t, size_t>> ranges;
+        for ( const auto& match : matches ) {
+            ranges.emplace_back( match.start, match.end );
+        }
+        return ranges;
+    };
+
+    const auto needsRegexpRanges = []( const QString& pattern ) {
+        return Highlighter( pattern, false, true, Qt::black, Qt::white ).needsRegexpRanges();
+    };
+
+    GIVEN( "Patterns with alternations" )
+    {
+        const auto pattern = GENERATE( as<QString>{}, "a|ab", "(?:error|errors)", "x|x\\|y" );
+
+        THEN( "The ranges differ, so highlighters use QRegularExpression" )
+        {
+            REQUIRE( engineRanges( pattern ) != regexpRanges( pattern ) );
+            REQUIRE( needsRegexpRanges( pattern ) );
+        }
+    }
+
+    GIVEN( "Patterns without alternations" )
+    {
+        const auto pattern = GENERATE( as<QString>{}, "ab+c?", "errors?", "[a|b]-b", "x\\|y" );
+
+        THEN( "The ranges are the same, so highlighters use the engine ranges" )
+        {
+            REQUIRE( engineRanges( pattern ) == regexpRanges( pattern ) );
+            REQUIRE_FALSE( needsRegexpRanges( pattern ) );
+        }
+    }
+}
+#endif
@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "configuration.h"
+#include "searchresultscache.h"
+
+namespace {
+// Every other line is a match, so the bitmap can't be stored as runs
+SearchResultArray sparseMatches( LineNumber::UnderlyingType nbLines )
+{
+    SearchResultArray matches;
+    for ( auto line = 0u; line < nbLines; line += 2 ) {
+        matches.add( line );
+    }
+    return matches;
+}
+
+SearchResultsCache::Entry makeEntry( SearchResultArray matches, LineNumber searchedUntil )
+{
+    return { std::move( matches ), 10_length, searchedUntil };
+}
+
+struct CacheConfigGuard {
+    CacheConfigGuard()
+    {
+        auto& config = Configuration::getSynced();
+        useCache = config.useSearchResultsCache();
+        persist = config.persistSearchResults();
+        sizeMb = config.searchResultsCacheSizeMb();
+
+        config.setUseSearchResultsCache( true );
+        config.setPersistSearchResults( true );
+    }
+
+    ~CacheConfigGuard()
+    {
+        auto& config = Configuration::getSynced();
+        config.setUseSearchResultsCache( useCache );
+        config.setPersistSearchResults( persist );
+        config.setSearchResultsCacheSizeMb( sizeMb );
+    }
+
+    bool useCache;
+    bool persist;
+    unsigned sizeMb;
+};
+
+// Saves results of the given size in a directory of storageRoot
+void writeSavedResults( const QTemporaryDir& storageRoot, const QString& name, int size,
+                        const QDateTime& lastSaved )
+{
+    QDir( storageRoot.path() ).mkpath( name );
+    QFile file( QDir( storageRoot.filePath( name ) ).filePath( "0.results" ) );
+    REQUIRE( file.open( QIODevice::WriteOnly ) );
+    file.write( QByteArray( size, 'x' ) );
+    file.flush();
+    REQUIRE( file.setFileTime( lastSaved, QFileDevice::FileModificationTime ) );
+}
+
+bool hasSavedResults( const QTemporaryDir& storageRoot, const QString& name )
+{
+    return QDir( storageRoot.filePath( name ) ).exists();
+}
+} // namespace
+
+SCENARIO( "Search results cache", "[searchresultscache]" )
+{
+    CacheConfigGuard configGuard;
+    const RegularExpressionPattern pattern( "error" );
+    const RegularExpressionPattern otherPattern( "warning" );
+
+    GIVEN( "A cache limited to 1 MiB" )
+    {
+        Configuration::getSynced().setSearchResultsCacheSizeMb( 1 );
+        SearchResultsCache cache;
+
+        WHEN( "Results bigger than half the budget are inserted twice" )
+        {
+            cache.insert( pattern, 0_lnum,
+                          makeEntry( sparseMatches( 5'000'000 ), 5'000'000_lnum ) );
+            cache.insert( otherPattern, 0_lnum,
+                          makeEntry( sparseMatches( 5'000'000 ), 5'000'000_lnum ) );
+
+            THEN( "The least recently used results are evicted" )
+            {
+                REQUIRE( cache.size() == 1 );
+                REQUIRE( cache.sizeInBytes() <= 1024 * 1024 );
+                REQUIRE_FALSE( cache.find( pattern, 0_lnum, 5'000'000_lnum ).has_value() );
+                REQUIRE( cache.find( otherPattern, 0_lnum, 5'000'000_lnum ).has_value() );
+            }
+        }
+
+        WHEN( "Results are looked up before inserting new ones" )
+        {
+            cache.insert( pattern, 0_lnum, makeEntry( sparseMatches( 1000 ), 1000_lnum ) );
+            cache.insert( otherPattern, 0_lnum, makeEntry( sparseMatches( 1000 ), 1000_lnum ) );
+            REQUIRE( cache.find( pattern, 0_lnum, 1000_lnum ).has_value() );
+
+            cache.insert( RegularExpressionPattern( "big" ), 0_lnum,
+                          makeEntry( sparseMatches( 5'000'000 ), 5'000'000_lnum ) );
+            cache.insert( RegularExpressionPattern( "bigger" ), 0_lnum,
+                          makeEntry( sparseMatches( 5'000'000 ), 5'000'000_lnum ) );
+
+            THEN( "The recently used results are kept longer" )
+            {
+                REQUIRE_FALSE( cache.find( otherPattern, 0_lnum, 1000_lnum ).has_value() );
+            }
+        }
+
+        WHEN( "Results are too big for the whole budget" )
+        {
+            cache.insert( pattern, 0_lnum,
+                          makeEntry( sparseMatches( 20'000'000 ), 20'000'000_lnum ) );
+
+            THEN( "They are not cached" )
+            {
+                REQUIRE( cache.size() == 0 );
+                REQUIRE( cache.sizeInBytes() == 0 );
+            }
+        }
+    }
+
+    GIVEN( "Cached results of a search" )
+    {
+        SearchResultsCache cache;
+        cache.insert( pattern, 0_lnum, makeEntry( sparseMatches( 1000 ), 1000_lnum ) );
+
+        WHEN( "Searching fewer lines" )
+        {
+            const auto results = cache.find( pattern, 0_lnum, 100_lnum );
+
+            THEN( "The results are limited to the searched lines" )
+            {
+                REQUIRE( results.has_value() );
+                REQUIRE( results->matchingLines.cardinality() == 50 );
+                REQUIRE( results->searchedUntil == 100_lnum );
+            }
+        }
+
+        WHEN( "Searching more lines" )
+        {
+            const auto results = cache.find( pattern, 0_lnum, 2000_lnum );
+
+            THEN( "The results tell where to resume the search" )
+            {
+                REQUIRE( results.has_value() );
+                REQUIRE( results->matchingLines.cardinality() == 500 );
+                REQUIRE( results->searchedUntil == 1000_lnum );
+            }
+        }
+
+        WHEN( "Searching from another line" )
+        {
+            THEN( "Nothing is found" )
+            {
+                REQUIRE_FALSE( cache.find( pattern, 10_lnum, 1000_lnum ).has_value() );
+            }
+        }
+
+        WHEN( "Searching the inverse pattern" )
+        {
+            const RegularExpressionPattern inversePattern( "error", true, true, false, false );
+
+            THEN( "Nothing is found" )
+            {
+                REQUIRE_FALSE( cache.find( inversePattern, 0_lnum, 1000_lnum ).has_value() );
+            }
+        }
+
+        WHEN( "Searching with another encoding" )
+        {
+            cache.setSearchContext( 1015, {} );
+
+            THEN( "Nothing is found" )
+            {
+                REQUIRE_FALSE( cache.find( pattern, 0_lnum, 1000_lnum ).has_value() );
+            }
+        }
+
+        WHEN( "Searching with a prefilter" )
+        {
+            cache.setSearchContext( 0, "session=42" );
+
+            THEN( "Nothing is found until the prefilter is removed" )
+            {
+                REQUIRE_FALSE( cache.find( pattern, 0_lnum, 1000_lnum ).has_value() );
+
+                cache.setSearchContext( 0, {} );
+                REQUIRE( cache.find( pattern, 0_lnum, 1000_lnum ).has_value() );
+            }
+        }
+
+        WHEN( "The cache is cleared" )
+        {
+            cache.clear();
+
+            THEN( "Nothing is found" )
+            {
+                REQUIRE( cache.size() == 0 );
+                REQUIRE_FALSE( cache.find( pattern, 0_lnum, 1000_lnum ).has_value() );
+            }
+        }
+    }
+
+    GIVEN( "Results saved for a file" )
+    {
+        QTemporaryDir storageRoot;
+        REQUIRE( storageRoot.isValid() );
+
+        {
+            SearchResultsCache cache( storageRoot.path() );
+            cache.setFileDigest( "app.log", 4096, 0x1234 );
+            cache.insert( pattern, 0_lnum, makeEntry( sparseMatches( 1000 ), 1000_lnum ) );
+            cache.insert( otherPattern, 0_lnum, makeEntry( sparseMatches( 10 ), 1000_lnum ) );
+        }
+
+        WHEN( "The same file is opened again" )
+        {
+            SearchResultsCache cache( storageRoot.path() );
+            cache.setFileDigest( "app.log", 4096, 0x1234 );
+
+            THEN( "The results are loaded" )
+            {
+                REQUIRE( cache.size() == 2 );
+
+                const auto results = cache.find( pattern, 0_lnum, 1000_lnum );
+                REQUIRE( results.has_value() );
+                REQUIRE( results->matchingLines == sparseMatches( 1000 ) );
+                REQUIRE( results->maxLength == 10_length );
+                REQUIRE( results->searchedUntil == 1000_lnum );
+            }
+        }
+
+        WHEN( "A file with another content is opened" )
+        {
+            SearchResultsCache cache( storageRoot.path() );
+            cache.setFileDigest( "app.log", 4096, 0x4321 );
+
+            THEN( "No results are loaded" )
+            {
+                REQUIRE( cache.size() == 0 );
+            }
+        }
+
+        WHEN( "A copy of the file is opened" )
+        {
+            {
+                SearchResultsCache cache( storageRoot.path() );
+                cache.setFileDigest( "copy.log", 4096, 0x1234 );
+                cache.insert( pattern, 0_lnum, makeEntry( sparseMatches( 10 ), 1000_lnum ) );
+            }
+
+            SearchResultsCache cache( storageRoot.path() );
+            cache.setFileDigest( "app.log", 4096, 0x1234 );
+
+            THEN( "The results of the first file are kept" )
+            {
+                REQUIRE( cache.size() == 2 );
+
+                const auto results = cache.find( pattern, 0_lnum, 1000_lnum );
+                REQUIRE( results.has_value() );
+                REQUIRE( results->matchingLines == sparseMatches( 1000 ) );
+            }
+        }
+
+        WHEN( "The file is opened with another encoding" )
+        {
+            SearchResultsCache cache( storageRoot.path() );
+            cache.setSearchContext( 1015, {} );
+            cache.setFileDigest( "app.log", 4096, 0x1234 );
+
+            THEN( "The results are loaded for their own encoding" )
+            {
+                REQUIRE( cache.size() == 2 );
+                REQUIRE_FALSE( cache.find( pattern, 0_lnum, 1000_lnum ).has_value() );
+
+                cache.setSearchContext( 0, {} );
+                REQUIRE( cache.find( pattern, 0_lnum, 1000_lnum ).has_value() );
+            }
+        }
+
+        WHEN( "Persistence is disabled" )
+        {
+            Configuration::getSynced().setPersistSearchResults( false );
+            SearchResultsCache cache( storageRoot.path() );
+            cache.setFileDigest( "app.log", 4096, 0x1234 );
+
+            THEN( "No results are loaded" )
+            {
+                REQUIRE( cache.size() == 0 );
+            }
+        }
+    }
+}
+
+SCENARIO( "Eviction of saved search results", "[searchresultscache]" )
+{
+    QTemporaryDir storageRoot;
+    REQUIRE( storageRoot.isValid() );
+
+    const auto now = QDateTime::currentDateTime();
+    writeSavedResults( storageRoot, "expired", 100, now.addDays( -40 ) );
+    writeSavedResults( storageRoot, "old", 1000, now.addDays( -3 ) );
+    writeSavedResults( storageRoot, "recent", 1000, now.addDays( -2 ) );
+    writeSavedResults( storageRoot, "current", 1000, now.addDays( -10 ) );
+
+    WHEN( "The saved results fit in the budget" )
+    {
+        SearchResultsCache::evictSavedResults( storageRoot.path(), 10000, 30 );
+
+        THEN( "Only the expired results are removed" )
+        {
+            REQUIRE_FALSE( hasSavedResults( storageRoot, "expired" ) );
+            REQUIRE( hasSavedResults( storageRoot, "old" ) );
+            REQUIRE( hasSavedResults( storageRoot, "recent" ) );
+            REQUIRE( hasSavedResults( storageRoot, "current" ) );
+        }
+    }
+
+    WHEN( "The saved results exceed the budget" )
+    {
+        SearchResultsCache::evictSavedResults( storageRoot.path(), 2000, 30,
+                                               storageRoot.filePath( "current" ) );
+
+        THEN( "The least recently saved ones are removed first" )
+        {
+            REQUIRE_FALSE( hasSavedResults( storageRoot, "expired" ) );
+            REQUIRE_FALSE( hasSavedResults( storageRoot, "old" ) );
+            REQUIRE( hasSavedResults( storageRoot, "recent" ) );
+            REQUIRE( hasSavedResults( storageRoot, "current" ) );
+        }
+    }
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <random>
+
+#include "searchresultscursor.h"
+
+namespace {
+SearchResultArray generateResults()
+{
+    SearchResultArray results;
+    std::mt19937_64 generator( 42 );
+    std::uniform_int_distribution<uint64_t> gap( 1, 100 );
+
+    // Dense and sparse regions, spanning several high 32-bit words
+    uint64_t line = 0;
+    for ( auto i = 0; i < 100'000; ++i ) {
+        line += gap( generator );
+        results.add( line );
+    }
+    results.addRange( 1ULL << 32, ( 1ULL << 32 ) + 50'000 );
+    results.add( ( 1ULL << 33 ) + 7 );
+    return results;
+}
+} // namespace
+
+SCENARIO( "Search results cursor", "[searchresultscursor]" )
+{
+    const auto results = generateResults();
+    const auto cardinality = results.cardinality();
+
+    SearchResultsCursor cursor;
+
+    WHEN( "Selecting consecutive lines" )
+    {
+        THEN( "The lines are the same as the ones of the results" )
+        {
+            for ( uint64_t rank = 0; rank < cardinality; rank += 7 ) {
+                uint64_t expected = 0;
+                uint64_t line = 0;
+                REQUIRE( results.select( rank, &expected ) );
+                REQUIRE( cursor.select( results, rank, &line ) );
+                REQUIRE( line == expected );
+            }
+
+            for ( uint64_t rank = cardinality; rank-- > cardinality - 1000; ) {
+                uint64_t expected = 0;
+                uint64_t line = 0;
+                REQUIRE( results.select( rank, &expected ) );
+                REQUIRE( cursor.select( results, rank, &line ) );
+                REQUIRE( line == expected );
+            }
+        }
+    }
+
+    WHEN( "Jumping around" )
+    {
+        std::mt19937_64 generator( 7 );
+        std::uniform_int_distribution<uint64_t> randomRank( 0, cardinality + 10 );
+        std::uniform_int_distribution<uint64_t> randomLine( 0, ( 1ULL << 33 ) + 10 );
+
+        THEN( "Rank and select are the same as the ones of the results" )
+        {
+            for ( auto i = 0; i < 2000; ++i ) {
+                const auto rank = randomRank( generator );
+                uint64_t expected = 0;
+                uint64_t line = 0;
+                const auto found = cursor.select( results, rank, &line );
+                REQUIRE( found == results.select( rank, &expected ) );
+                if ( rank < cardinality ) {
+                    REQUIRE( line == expected );
+                }
+
+                const auto someLine = randomLine( generator );
+                REQUIRE( cursor.rank( results, someLine ) == results.rank( someLine ) );
+                REQUIRE( cursor.rank( results, someLine + 1 ) == results.rank( someLine + 1 ) );
+            }
+        }
+    }
+
+    WHEN( "Looking for lines before and after the results" )
+    {
+        THEN( "Rank is the same as the one of the results" )
+        {
+            REQUIRE( cursor.rank( results, 0 ) == results.rank( 0 ) );
+            REQUIRE( cursor.rank( results, results.maximum() + 1 ) == cardinality );
+            REQUIRE( cursor.rank( results, 0 ) == 0 );
+        }
+    }
+
+    WHEN( "The results are modified" )
+    {
+        uint64_t line = 0;
+        REQUIRE( cursor.select( results, 10, &line ) );
+
+        auto modifiedResults = results;
+        modifiedResults.remove( line );
+        cursor.invalidate();
+
+        THEN( "The cursor follows the modified results" )
+        {
+            uint64_t expected = 0;
+            REQUIRE( modifiedResults.select( 10, &expected ) );
+            REQUIRE( cursor.select( modifiedResults, 10, &line ) );
+            REQUIRE( line == expected );
+        }
+    }
+
+    WHEN( "Results are appended while jumping around" )
+    {
+        SearchResultArray growingResults;
+        std::mt19937_64 generator( 11 );
+
+        THEN( "Rank and select are the same as the ones of the results" )
+        {
+            auto line = results.begin();
+            const auto end = results.end();
+            while ( line != end ) {
+                const auto firstNewLine = *line;
+                for ( auto i = 0; i < 10'000 && line != end; ++i, ++line ) {
+                    growingResults.add( *line );
+                }
+                cursor.invalidateFrom( firstNewLine );
+
+                std::uniform_int_distribution<uint64_t> randomRank(
+                    0, growingResults.cardinality() - 1 );
+                for ( auto i = 0; i < 20; ++i ) {
+                    const auto rank = randomRank( generator );
+                    uint64_t expected = 0;
+                    uint64_t selected = 0;
+                    REQUIRE( growingResults.select( rank, &expected ) );
+                    REQUIRE( cursor.select( growingResults, rank, &selected ) );
+                    REQUIRE( selected == expected );
+                    REQUIRE( cursor.rank( growingResults, expected )
+                             == growingResults.rank( expected ) );
+                }
+            }
+        }
+    }
+
+    WHEN( "Lines are removed in the middle of the results" )
+    {
+        auto modifiedResults = results;
+        std::mt19937_64 generator( 3 );
+        std::uniform_int_distribution<uint64_t> randomRank( 0, cardinality - 1 );
+        for ( auto i = 0; i < 100; ++i ) {
+            uint64_t line = 0;
+            REQUIRE( cursor.select( modifiedResults, randomRank( generator ), &line ) );
+        }
+
+        uint64_t removedLine = 0;
+        REQUIRE( modifiedResults.select( cardinality / 2, &removedLine ) );
+        modifiedResults.remove( removedLine );
+        cursor.invalidateFrom( removedLine );
+
+        THEN( "The cursor follows the modified results" )
+        {
+            for ( auto i = 0; i < 100; ++i ) {
+                const auto rank = randomRank( generator ) % modifiedResults.cardinality();
+                uint64_t expected = 0;
+                uint64_t line = 0;
+                REQUIRE( modifiedResults.select( rank, &expected ) );
+                REQUIRE( cursor.select( modifiedResults, rank, &line ) );
+                REQUIRE( line == expected );
+            }
+        }
+    }
+
+    WHEN( "The results are empty" )
+    {
+        const SearchResultArray emptyResults;
+        uint64_t line = 0;
+
+        THEN( "Nothing is found" )
+        {
+            REQUIRE_FALSE( cursor.select( emptyResults, 0, &line ) );
+            REQUIRE( cursor.rank( emptyResults, 10 ) == 0 );
+        }
+    }
+}
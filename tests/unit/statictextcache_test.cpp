@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <QFont>
+
+#include "statictextcache.h"
+
+SCENARIO( "Static text cache", "[statictextcache]" )
+{
+    StaticTextCache cache( 2 );
+    const QFont font;
+
+    cache.get( QStringLiteral( "first" ), font );
+    cache.get( QStringLiteral( "second" ), font );
+
+    WHEN( "Getting a cached text" )
+    {
+        const auto& text = cache.get( QStringLiteral( "first" ), font );
+
+        THEN( "It is not laid out again" )
+        {
+            REQUIRE( text.text() == "first" );
+            REQUIRE( cache.size() == 2 );
+        }
+    }
+
+    WHEN( "Getting more texts than the capacity" )
+    {
+        cache.get( QStringLiteral( "first" ), font );
+        cache.get( QStringLiteral( "third" ), font );
+
+        THEN( "The cache does not grow over its capacity" )
+        {
+            REQUIRE( cache.size() == 2 );
+        }
+    }
+
+    WHEN( "Getting a text with another font" )
+    {
+        QFont otherFont = font;
+        otherFont.setPointSize( font.pointSize() + 2 );
+        const auto& text = cache.get( QStringLiteral( "first" ), otherFont );
+
+        THEN( "The cache is emptied" )
+        {
+            REQUIRE( text.text() == "first" );
+            REQUIRE( cache.size() == 1 );
+        }
+    }
+}
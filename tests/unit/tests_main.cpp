@@ -21,10 +21,12 @@
 #include <catch2/catch.hpp>
 
 #include <QApplication>
+#include <QTemporaryDir>
 
 #include <logger.h>
 
 #include "configuration.h"
+#include "searchresultscache.h"
 #include <persistentinfo.h>
 
 const bool PersistentInfo::ForcePortable = true;
@@ -37,5 +39,9 @@ int main( int argc, char* argv[] )
 
     Configuration::getSynced();
 
+    // Search results are never saved to the user's cache directory
+    QTemporaryDir searchResultsRoot;
+    SearchResultsCache::setDefaultStorageRoot( searchResultsRoot.path() );
+
     return Catch::Session().run( argc, argv );
 }
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2024 Anton Filimonov and other contributors
+ *
+ * This file is part of klogg.
+ *
+ * klogg is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * klogg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klogg.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <thread>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include "tracing.h"
+
+namespace {
+QJsonArray spans( const QString& fileName, const QString& name )
+{
+    QFile file( fileName );
+    REQUIRE( file.open( QIODevice::ReadOnly ) );
+
+    QJsonParseError error;
+    const auto trace = QJsonDocument::fromJson( file.readAll(), &error );
+    REQUIRE( error.error == QJsonParseError::NoError );
+
+    QJsonArray matchingSpans;
+    for ( const auto& event : trace.object()[ "traceEvents" ].toArray() ) {
+        const auto object = event.toObject();
+        if ( object[ "ph" ].toString() == "X" && object[ "name" ].toString() == name ) {
+            matchingSpans.append( object );
+        }
+    }
+    return matchingSpans;
+}
+} // namespace
+
+SCENARIO( "Tracing spans", "[tracing]" )
+{
+    QTemporaryDir directory;
+    const auto traceFile = directory.filePath( "trace.json" );
+
+    tracing::clear();
+
+    WHEN( "Tracing is disabled" )
+    {
+        tracing::setEnabled( false );
+        {
+            KLOGG_TRACE_SCOPE( "disabled span" );
+        }
+
+        THEN( "Nothing is recorded" )
+        {
+            REQUIRE( tracing::writeChromeTrace( traceFile ) );
+            REQUIRE( spans( traceFile, "disabled span" ).isEmpty() );
+        }
+    }
+
+    WHEN( "Tracing is enabled" )
+    {
+        tracing::setEnabled( true );
+        {
+            KLOGG_TRACE_SCOPE( "outer span" );
+            KLOGG_TRACE_SCOPE( "inner span" );
+        }
+        std::thread( [] { KLOGG_TRACE_SCOPE( "thread span" ); } ).join();
+        tracing::setEnabled( false );
+
+        THEN( "Spans of all threads are recorded" )
+        {
+            REQUIRE( tracing::writeChromeTrace( traceFile ) );
+
+            const auto outer = spans( traceFile, "outer span" );
+            const auto inner = spans( traceFile, "inner span" );
+            const auto thread = spans( traceFile, "thread span" );
+            REQUIRE( outer.size() == 1 );
+            REQUIRE( inner.size() == 1 );
+            REQUIRE( thread.size() == 1 );
+
+            REQUIRE( outer[ 0 ][ "ts" ].toDouble() <= inner[ 0 ][ "ts" ].toDouble() );
+            REQUIRE( outer[ 0 ][ "dur" ].toDouble() >= inner[ 0 ][ "dur" ].toDouble() );
+            REQUIRE( outer[ 0 ][ "tid" ] != thread[ 0 ][ "tid" ] );
+        }
+    }
+
+    WHEN( "A span name has characters to escape" )
+    {
+        tracing::setEnabled( true );
+        {
+            KLOGG_TRACE_SCOPE( "quoted \"span\"\twith\\controls\x01\n" );
+        }
+        tracing::setEnabled( false );
+
+        THEN( "The trace is valid JSON holding the name" )
+        {
+            REQUIRE( tracing::writeChromeTrace( traceFile ) );
+            REQUIRE( spans( traceFile, "quoted \"span\"\twith\\controls\x01\n" ).size() == 1 );
+        }
+    }
+
+    WHEN( "Recording more events than a buffer holds" )
+    {
+        tracing::setEnabled( true );
+        for ( auto i = 0; i < 100'000; ++i ) {
+            KLOGG_TRACE_SCOPE( "repeated span" );
+        }
+        tracing::setEnabled( false );
+
+        THEN( "Only the latest events are kept" )
+        {
+            REQUIRE( tracing::writeChromeTrace( traceFile ) );
+
+            const auto repeated = spans( traceFile, "repeated span" );
+            REQUIRE( !repeated.isEmpty() );
+            REQUIRE( repeated.size() < 100'000 );
+        }
+    }
+}
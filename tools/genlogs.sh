@@ -1,14 +1,26 @@
 #!/bin/bash
 
-# Generate a set of test logs
+# Generate a set of test logs with klogg_gencorpus (built with the tests)
+# Usage: genlogs.sh [output directory], set KLOGG_GENCORPUS to the tool path
 
-# 5 million lines - 1, 429Mb
-perl -e 'for ($i = 0; $i < 4999999; $i++)
-    { printf "LOGDATA is a part of LogCrawler, we are going to test it thoroughly, this is line %06d\n", $i; }'\
-    >/tmp/verybiglog.txt
+GENCORPUS=${KLOGG_GENCORPUS:-klogg_gencorpus}
+OUTPUT=${1:-/tmp}
 
-# 100 million lines - 1, Mb
-# perl -e 'for ($i = 0; $i < 100000000; $i++)
-#     { printf "LOGDATA is a part of LogCrawler, we are going to test it thoroughly, this is line %07d\n", $i; }'\
-#     >~/stupidlybiglog.txt
+set -e
 
+# Plain utf8, about 4 million lines
+"$GENCORPUS" --size 512M "$OUTPUT/verybiglog.txt"
+
+# Search selectivity: a token on 1 line out of 10000, a few very long lines
+"$GENCORPUS" --size 1G --token-density 0.0001 --huge-lines 5 "$OUTPUT/sparse.log"
+
+# Encodings and line endings
+"$GENCORPUS" --size 256M --encoding utf16le --non-ascii "$OUTPUT/utf16.log"
+"$GENCORPUS" --size 256M --encoding windows-1251 --non-ascii --crlf "$OUTPUT/cp1251.log"
+"$GENCORPUS" --size 256M --tabs "$OUTPUT/tabs.log"
+
+# JSON lines
+"$GENCORPUS" --size 256M --format json "$OUTPUT/json.log"
+
+# Growing file for follow mode, 1 MiB per second for 10 minutes
+# "$GENCORPUS" --size 64M --rate 1M --duration 600 "$OUTPUT/growing.log"